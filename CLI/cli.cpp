@@ -44,8 +44,7 @@ int main(int argc, const char** argv)
 
 		if (subcommand == "bench")
 		{
-			cli_bench();
-			return 0;
+			return cli_bench(argc - 2, &argv[2]);
 		}
 
 		if (subcommand == "cat2json")
@@ -497,15 +496,15 @@ int main(int argc, const char** argv)
 				std::cout << "Failed to load\n";
 				return 1;
 			}
-			auto code = scr.getExportedFuntion("_start");
-			if (!code)
+			const auto func_index = scr.getExportedFunctionIndex("_start");
+			if (func_index == -1)
 			{
 				std::cout << "WASM file has loaded but \"_start\" function not found in exports.\n";
 				return 2;
 			}
 			scr.linkWasiPreview1();
 			WasmVm vm(scr);
-			if (!vm.run(*code))
+			if (!vm.run(func_index))
 			{
 				std::cout << "A runtime error occurred.\n";
 				return 3;
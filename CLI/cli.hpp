@@ -1,7 +1,7 @@
 #pragma once
 
 void cli_3d();
-void cli_bench();
+int cli_bench(int argc, const char** argv);
 int cli_cat2json(int argc, const char** argv);
 void cli_chatgpt(int argc, const char** argv);
 void cli_datareflection();
@@ -2,16 +2,102 @@
 
 #include <cstring> // memcmp
 
+#include <iostream>
+
 #include <aes.hpp>
+#include <AtomicDeque.hpp>
+#include <base64.hpp>
 #include <Benchmark.hpp>
+#include <chacha20poly1305.hpp>
+#include <Curve25519.hpp>
+#include <deflate.hpp>
+#include <dnsCacheResolver.hpp>
+#include <dnsHeader.hpp>
+#include <dnsQuestion.hpp>
+#include <dnsZone.hpp>
+#include <ecc.hpp>
+#include <memPoolAllocator.hpp>
 #include <rand.hpp>
+#include <Regex.hpp>
+#include <RegexSet.hpp>
+#include <rsa.hpp>
+#include <SegmentedMpmcQueue.hpp>
+#include <sha256.hpp>
+#include <SharedPtr.hpp>
+#include <string.hpp>
+#include <StringWriter.hpp>
+#include <wasm.hpp>
+
+using namespace soup;
+
+// The compute kernels from the "Native Code" test in cli_test.cpp.
+static void bench_wasm(Benchmark::State& _benchmark_state, const char* name, WasmValue arg, uint32_t jit_threshold)
+{
+	WasmScript scr;
+	SOUP_ASSERT(scr.load(base64::decode("AGFzbQEAAAABCwJgAX8Bf2ABfAF8AwcGAAAAAAABBQMBAAEHMwYDc3VtAAADZmliAAEIY2hlY2tzdW0AAgdjb2xsYXR6AAMDbGNnAAQIaGFybW9uaWMABQrDAgYhAQF/AkADQCAARQ0BIAEgAGohASAAQQFrIQAMAAsLIAELHAAgAEECSAR/IAAFIABBAWsQASAAQQJrEAFqCwtKAQJ/AkADQCABIABPDQEgASABQQdsOgAAIAFBAWohAQwACwtBACEBAkADQCABIABPDQEgAiABLQAAaiECIAFBAWohAQwACwsgAgsyAQF/AkADQCAAQQFGDQEgAEECbiAAQQNsQQFqIABBAnBFGyEAIAFBAWohAQwACwsgAQtIAgF+AX8gAK0hAQJAA0AgAiAATw0BIAFCrf7V5NSF/ajYAH5Cz4Keu+/v3oIUfCEBIAJBAWohAgwACwsgAUIhiCABQgeBhacLOwEBfAJAA0AgAEQAAAAAAAAAAGUNASABRAAAAAAAAPA/IACjoCEBIABEAAAAAAAA8D+hIQAMAAsLIAEL")));
+	scr.jit_threshold = jit_threshold;
+	const auto func_index = scr.getExportedFunctionIndex(name);
+	BENCHMARK_LOOP({
+		WasmVm vm(scr);
+		vm.locals.emplace_back(arg);
+		SOUP_ASSERT(vm.run(func_index));
+	});
+}
 
-void cli_bench()
+static void print_usage()
 {
+	std::cout << "Syntax: bench [--filter=<wildcard>] [--format=text|json|csv] [--samples=<n>] [--baseline=<results.json>] [--threshold=<percent>]" << std::endl;
+}
+
+int cli_bench(int argc, const char** argv)
+{
+	for (int i = 0; i != argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg.substr(0, 9) == "--filter=")
+		{
+			Benchmark::config.filter = arg.substr(9);
+		}
+		else if (arg == "--format=json")
+		{
+			Benchmark::config.format = Benchmark::JSON;
+		}
+		else if (arg == "--format=csv")
+		{
+			Benchmark::config.format = Benchmark::CSV;
+		}
+		else if (arg == "--format=text")
+		{
+			Benchmark::config.format = Benchmark::TEXT;
+		}
+		else if (arg.substr(0, 10) == "--samples=")
+		{
+			Benchmark::config.num_samples = string::toInt<unsigned int>(arg.substr(10), 15);
+		}
+		else if (arg.substr(0, 11) == "--baseline=")
+		{
+			if (!Benchmark::loadBaseline(string::fromFile(arg.substr(11))))
+			{
+				std::cout << "Failed to load baseline from " << arg.substr(11) << std::endl;
+				return 1;
+			}
+		}
+		else if (arg.substr(0, 12) == "--threshold=")
+		{
+			Benchmark::config.regression_threshold = string::toInt<unsigned int>(arg.substr(12), 5) / 100.0;
+		}
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
 	BENCHMARK("AES-ECB-128", {
 		uint8_t og_data[0x10'000];
 		soup::rand.fill(og_data);
 		uint8_t data[sizeof(og_data)];
+		BENCHMARK_BYTES(sizeof(data));
 		const char key[] = "Super Secret Key";
 		BENCHMARK_LOOP({
 			memcpy(data, og_data, sizeof(data));
@@ -24,6 +110,7 @@ void cli_bench()
 		uint8_t og_data[0x10'000];
 		soup::rand.fill(og_data);
 		uint8_t data[sizeof(og_data)];
+		BENCHMARK_BYTES(sizeof(data));
 		const char key[] = "Super Secret 192-Bit Key";
 		BENCHMARK_LOOP({
 			memcpy(data, og_data, sizeof(data));
@@ -36,6 +123,7 @@ void cli_bench()
 		uint8_t og_data[0x10'000];
 		soup::rand.fill(og_data);
 		uint8_t data[sizeof(og_data)];
+		BENCHMARK_BYTES(sizeof(data));
 		const char key[] = "My Super Secret Key For 256-Bit";
 		BENCHMARK_LOOP({
 			memcpy(data, og_data, sizeof(data));
@@ -48,6 +136,7 @@ void cli_bench()
 		uint8_t og_data[0x10'000];
 		soup::rand.fill(og_data);
 		uint8_t data[sizeof(og_data)];
+		BENCHMARK_BYTES(sizeof(data));
 		const char key[] = "Super Secret Key";
 		const char iv[] = "Super Secret IV";
 		BENCHMARK_LOOP({
@@ -61,6 +150,7 @@ void cli_bench()
 		uint8_t og_data[0x10'000];
 		soup::rand.fill(og_data);
 		uint8_t data[sizeof(og_data)];
+		BENCHMARK_BYTES(sizeof(data));
 		const char key[] = "Super Secret 192-Bit Key";
 		const char iv[] = "Super Secret IV";
 		BENCHMARK_LOOP({
@@ -74,6 +164,7 @@ void cli_bench()
 		uint8_t og_data[0x10'000];
 		soup::rand.fill(og_data);
 		uint8_t data[sizeof(og_data)];
+		BENCHMARK_BYTES(sizeof(data));
 		const char key[] = "My Super Secret Key For 256-Bit";
 		const char iv[] = "Super Secret IV";
 		BENCHMARK_LOOP({
@@ -83,4 +174,319 @@ void cli_bench()
 			SOUP_ASSERT(memcmp(data, og_data, sizeof(data)) == 0);
 		});
 	});
+	BENCHMARK("AES-GCM-128", {
+		uint8_t og_data[0x10'000];
+		soup::rand.fill(og_data);
+		uint8_t data[sizeof(og_data)];
+		BENCHMARK_BYTES(sizeof(data));
+		const char key[] = "Super Secret Key";
+		const char iv[] = "Super Secret";
+		const char aad[] = "Additional Data";
+		soup::aes::GcmContext ctx(reinterpret_cast<const uint8_t*>(key), 16);
+		BENCHMARK_LOOP({
+			memcpy(data, og_data, sizeof(data));
+			uint8_t tag[16];
+			ctx.encrypt(data, sizeof(data), reinterpret_cast<const uint8_t*>(aad), sizeof(aad), reinterpret_cast<const uint8_t*>(iv), 12, tag);
+			SOUP_ASSERT(ctx.decrypt(data, sizeof(data), reinterpret_cast<const uint8_t*>(aad), sizeof(aad), reinterpret_cast<const uint8_t*>(iv), 12, tag));
+			SOUP_ASSERT(memcmp(data, og_data, sizeof(data)) == 0);
+		});
+	});
+
+	BENCHMARK("ChaCha20-Poly1305", {
+		uint8_t og_data[0x10'000];
+		soup::rand.fill(og_data);
+		uint8_t data[sizeof(og_data)];
+		BENCHMARK_BYTES(sizeof(data));
+		const char key[] = "Super Secret Key Super Secret Ke";
+		const char nonce[] = "Super Secret";
+		const char aad[] = "Additional Data";
+		BENCHMARK_LOOP({
+			memcpy(data, og_data, sizeof(data));
+			uint8_t tag[16];
+			soup::chacha20poly1305::encrypt(data, sizeof(data), reinterpret_cast<const uint8_t*>(aad), sizeof(aad), reinterpret_cast<const uint8_t*>(key), reinterpret_cast<const uint8_t*>(nonce), tag);
+			SOUP_ASSERT(soup::chacha20poly1305::decrypt(data, sizeof(data), reinterpret_cast<const uint8_t*>(aad), sizeof(aad), reinterpret_cast<const uint8_t*>(key), reinterpret_cast<const uint8_t*>(nonce), tag));
+			SOUP_ASSERT(memcmp(data, og_data, sizeof(data)) == 0);
+		});
+	});
+
+	BENCHMARK("Curve25519::x25519", {
+		uint8_t my_priv[Curve25519::KEY_SIZE];
+		uint8_t their_pub[Curve25519::KEY_SIZE];
+		Curve25519::generatePrivate(my_priv);
+		{
+			uint8_t their_priv[Curve25519::KEY_SIZE];
+			Curve25519::generatePrivate(their_priv);
+			Curve25519::derivePublic(their_pub, their_priv);
+		}
+		uint8_t shared[Curve25519::SHARED_SIZE];
+		BENCHMARK_LOOP({
+			Curve25519::x25519(shared, my_priv, their_pub);
+		});
+	});
+
+	BENCHMARK("EccCurve::derivePublic (P-256)", {
+		const auto& curve = EccCurve::secp256r1();
+		const auto d = curve.generatePrivate();
+		BENCHMARK_LOOP({
+			SOUP_ASSERT(!curve.derivePublic(d).isPointAtInfinity());
+		});
+	});
+
+	BENCHMARK("EccCurve::multiply (P-256)", {
+		const auto& curve = EccCurve::secp256r1();
+		const auto their_pub = curve.derivePublic(curve.generatePrivate());
+		const auto d = curve.generatePrivate();
+		BENCHMARK_LOOP({
+			SOUP_ASSERT(!curve.multiply(their_pub, d).isPointAtInfinity());
+		});
+	});
+
+	BENCHMARK("EccCurve::verify (P-256)", {
+		const auto& curve = EccCurve::secp256r1();
+		const auto d = curve.generatePrivate();
+		const auto pub = curve.derivePublic(d);
+		const auto hash = sha256::hash("Soup");
+		const auto [r, s] = curve.sign(d, hash);
+		BENCHMARK_LOOP({
+			SOUP_ASSERT(curve.verify(pub, hash, r, s));
+		});
+	});
+
+	BENCHMARK("RsaPrivateKey::sign (2048-bit)", {
+		const auto priv = RsaPrivateKey::fromPrimes(
+			Bigint::fromStringHex("FAAAE64DC1ED9F2E0E3D8F133E586805A5D19C0A9BA8703690886561D36DF9861CEA6D0A23B3F7FEBD032DC89C6E33C4E588598C142912272C1856B2F98A4AB52AAA34BE56DA224D0119F9E1502CDAE53BCF64AA83DADB3CDD73357A573BA38F4E42BBBD2B8DD787B2580D00D643CDEE5BC785728BD25C1EEC58EA26E5901BA9", 256),
+			Bigint::fromStringHex("BCC738E0230210FD151FA5829B48FC24B7616E4B7A7D8BF47B655791BDB676CCAA0C7672CB0C3D2FD0427220E7336D995062FCE427E308B2F01ED41FA201AEF496D5DAB67D6DA56FC23AF91A1ED4B7782A912FB220101FC346F14E269EBD92F176F756366B1E9E4B1C38B5837019D986E92388E42931637AE3B7ED3483362003", 256)
+		);
+		BENCHMARK_LOOP({
+			SOUP_ASSERT(!priv.sign<sha256>("Soup").isZero());
+		});
+	});
+
+	BENCHMARK("deflate::decompress", {
+		// Text-like data: words from a small vocabulary with some numbers mixed in.
+		static const char* const words[] = { "the", "of", "and", "to", "in", "is", "that", "for", "it", "as", "with", "was", "on", "be", "at", "by", "this", "had", "not", "are", "but", "from", "or", "have", "an", "they", "which", "one", "you", "were", "her", "all", "she", "there", "would", "their", "we", "him", "been", "has", "when", "who", "will", "more", "no", "if", "out", "so", "said", "what" };
+		std::string data{};
+		while (data.size() < 0x400'000)
+		{
+			data.append(words[soup::rand.t<size_t>(0, 49)]);
+			if (soup::rand.one_in(16))
+			{
+				data.append(std::to_string(soup::rand.t<uint32_t>(0, 100'000)));
+			}
+			data.push_back(soup::rand.one_in(12) ? '\n' : ' ');
+		}
+		const std::string compressed = deflate::compress(data, 6, deflate::GZIP);
+		BENCHMARK_BYTES(data.size());
+		BENCHMARK_LOOP({
+			SOUP_ASSERT(deflate::decompress(compressed, data.size()).decompressed.size() == data.size());
+		});
+	});
+
+	BENCHMARK("Regex::search", {
+		// Log lines, most of which don't match any of the patterns.
+		static const char* const levels[] = { "DEBUG", "INFO", "INFO", "INFO", "WARN", "ERROR" };
+		static const char* const messages[] = { "request completed", "cache miss for key", "connection reset by peer", "retrying after timeout", "user logged in", "slow query detected" };
+		std::vector<std::string> lines{};
+		size_t bytes = 0;
+		while (bytes < 0x10'000)
+		{
+			std::string line = "2024-05-01T12:";
+			line.append(std::to_string(soup::rand.t<uint32_t>(10, 59)));
+			line.push_back(' ');
+			line.append(levels[soup::rand.t<size_t>(0, 5)]);
+			line.append(" worker-");
+			line.append(std::to_string(soup::rand.t<uint32_t>(0, 15)));
+			line.append(": ");
+			line.append(messages[soup::rand.t<size_t>(0, 5)]);
+			line.append(" id=");
+			line.append(std::to_string(soup::rand.t<uint32_t>(0, 100'000)));
+			bytes += line.size();
+			lines.emplace_back(std::move(line));
+		}
+		const Regex patterns[] = {
+			Regex(R"(\b(?:ERROR|FATAL)\b.*timeout)"),
+			Regex(R"(worker-1[0-5]: .*reset)"),
+			Regex(R"(id=\d{6,})"),
+			Regex(R"(slow (?:query|request) .* id=9\d+$)"),
+		};
+		BENCHMARK_BYTES(bytes * std::size(patterns));
+		BENCHMARK_LOOP({
+			size_t matches = 0;
+			for (const auto& line : lines)
+			{
+				for (const auto& r : patterns)
+				{
+					matches += r.search(line).isSuccess();
+				}
+			}
+			SOUP_ASSERT(matches != 0);
+		});
+	});
+
+	BENCHMARK("RegexSet::matches", {
+		// Log lines, most of which don't match any of the patterns.
+		static const char* const levels[] = { "DEBUG", "INFO", "INFO", "INFO", "WARN", "ERROR" };
+		static const char* const messages[] = { "request completed", "cache miss for key", "connection reset by peer", "retrying after timeout", "user logged in", "slow query detected" };
+		std::vector<std::string> lines{};
+		size_t bytes = 0;
+		while (bytes < 0x10'000)
+		{
+			std::string line = "2024-05-01T12:";
+			line.append(std::to_string(soup::rand.t<uint32_t>(10, 59)));
+			line.push_back(' ');
+			line.append(levels[soup::rand.t<size_t>(0, 5)]);
+			line.append(" worker-");
+			line.append(std::to_string(soup::rand.t<uint32_t>(0, 15)));
+			line.append(": ");
+			line.append(messages[soup::rand.t<size_t>(0, 5)]);
+			line.append(" id=");
+			line.append(std::to_string(soup::rand.t<uint32_t>(0, 100'000)));
+			bytes += line.size();
+			lines.emplace_back(std::move(line));
+		}
+		const RegexSet set({
+			R"(\b(?:ERROR|FATAL)\b.*timeout)",
+			R"(worker-1[0-5]: .*reset)",
+			R"(id=\d{6,})",
+			R"(slow (?:query|request) .* id=9\d+$)",
+		});
+		BENCHMARK_BYTES(bytes * set.size());
+		BENCHMARK_LOOP({
+			size_t matches = 0;
+			for (const auto& line : lines)
+			{
+				matches += set.matches(line).size();
+			}
+			SOUP_ASSERT(matches != 0);
+		});
+	});
+
+	BENCHMARK("dnsCacheResolver::findInCache", {
+		dnsCacheResolver resolver({});
+		for (int i = 0; i != 1000; ++i)
+		{
+			std::vector<SharedPtr<dnsRecord>> records;
+			records.emplace_back(soup::make_shared<dnsARecord>("host" + std::to_string(i) + ".example.com", 3600, SOUP_IPV4_NWE(1, 3, 3, 7)));
+			resolver.addToCache(DNS_A, records.at(0)->name, records);
+		}
+		const std::string name = "host500.example.com";
+		BENCHMARK_LOOP({
+			SOUP_ASSERT(resolver.findInCache(DNS_A, name));
+		});
+	});
+
+	BENCHMARK("dnsZone::answer", {
+		std::unordered_map<std::string, std::vector<SharedPtr<dnsRecord>>> records;
+		for (int i = 0; i != 1000; ++i)
+		{
+			std::string name = "host" + std::to_string(i) + ".example.com";
+			records[name].emplace_back(soup::make_shared<dnsARecord>(name, 3600, SOUP_IPV4_NWE(1, 3, 3, 7)));
+		}
+		dnsZone zone;
+		zone.compile(records);
+		dnsHeader dh{};
+		dh.qdcount = 1;
+		dnsQuestion dq;
+		dq.name.name = { "host500", "example", "com" };
+		dq.qtype = DNS_A;
+		StringWriter sw;
+		dh.write(sw);
+		dq.write(sw);
+		std::string res;
+		BENCHMARK_LOOP({
+			SOUP_ASSERT(zone.answer(sw.data.data(), sw.data.size(), res));
+		});
+	});
+
+	BENCHMARK("memPoolAllocator", {
+		void* blocks[64];
+		BENCHMARK_LOOP({
+			for (auto& block : blocks)
+			{
+				block = g_pool_allocator.allocate(32);
+			}
+			for (auto& block : blocks)
+			{
+				g_pool_allocator.deallocate(block);
+			}
+		});
+	});
+
+	BENCHMARK("memCAllocator", {
+		void* blocks[64];
+		BENCHMARK_LOOP({
+			for (auto& block : blocks)
+			{
+				block = g_default_allocator.allocate(32);
+			}
+			for (auto& block : blocks)
+			{
+				g_default_allocator.deallocate(block);
+			}
+		});
+	});
+
+	// Handing over a batch of workers the way Scheduler::addWorker and Scheduler::tick do.
+	BENCHMARK("AtomicDeque", {
+		AtomicDeque<SharedPtr<int>> q;
+		auto value = soup::make_shared<int>(0);
+		BENCHMARK_LOOP({
+			for (int i = 0; i != 64; ++i)
+			{
+				q.emplace_front(SharedPtr<int>(value));
+			}
+			while (auto node = q.pop_back())
+			{
+			}
+		});
+	});
+
+	BENCHMARK("SegmentedMpmcQueue", {
+		SegmentedMpmcQueue<SharedPtr<int>> q;
+		auto value = soup::make_shared<int>(0);
+		BENCHMARK_LOOP({
+			for (int i = 0; i != 64; ++i)
+			{
+				q.push(SharedPtr<int>(value));
+			}
+			q.popAll([](SharedPtr<int>&&)
+			{
+			});
+		});
+	});
+
+	BENCHMARK("WasmVm::run", {
+		// (func $sum (param i32) (result i32) (local i32)
+		//   (block (loop
+		//     (br_if 1 (i32.eqz (local.get 0)))
+		//     (local.set 1 (i32.add (local.get 1) (local.get 0)))
+		//     (local.set 0 (i32.sub (local.get 0) (i32.const 1)))
+		//     (br 0)
+		//   ))
+		//   local.get 1
+		// )
+		WasmScript scr;
+		SOUP_ASSERT(scr.load(base64::decode("AGFzbQEAAAABBgFgAX8BfwMDAgAABw0CA3N1bQAAA2ZhYwABCjkCIQEBfwJAA0AgAEUNASABIABqIQEgAEEBayEADAALCyABCxUAIABFBH9BAQUgACAAQQFrEAFsCws=")));
+		const auto func_index = scr.getExportedFunctionIndex("sum");
+		BENCHMARK_LOOP({
+			WasmVm vm(scr);
+			vm.locals.emplace_back(100'000);
+			SOUP_ASSERT(vm.run(func_index));
+			SOUP_ASSERT(vm.stack.top().i32 == 705'082'704); // 5'000'050'000 truncated to 32 bits
+		});
+	});
+
+	// Each kernel runs in the interpreter and as native code.
+	BENCHMARK("WasmVm::run sum (interpreter)", bench_wasm(_benchmark_state, "sum", 100'000, -1););
+	BENCHMARK("WasmVm::run sum (native)", bench_wasm(_benchmark_state, "sum", 100'000, 0););
+	BENCHMARK("WasmVm::run fib (interpreter)", bench_wasm(_benchmark_state, "fib", 20, -1););
+	BENCHMARK("WasmVm::run fib (native)", bench_wasm(_benchmark_state, "fib", 20, 0););
+	BENCHMARK("WasmVm::run checksum (interpreter)", bench_wasm(_benchmark_state, "checksum", 60'000, -1););
+	BENCHMARK("WasmVm::run checksum (native)", bench_wasm(_benchmark_state, "checksum", 60'000, 0););
+	BENCHMARK("WasmVm::run lcg (interpreter)", bench_wasm(_benchmark_state, "lcg", 100'000, -1););
+	BENCHMARK("WasmVm::run lcg (native)", bench_wasm(_benchmark_state, "lcg", 100'000, 0););
+	BENCHMARK("WasmVm::run harmonic (interpreter)", bench_wasm(_benchmark_state, "harmonic", 100'000.0, -1););
+	BENCHMARK("WasmVm::run harmonic (native)", bench_wasm(_benchmark_state, "harmonic", 100'000.0, 0););
+
+	return Benchmark::finish() == 0 ? 0 : 1;
 }
@@ -4,6 +4,7 @@
 #include <unordered_map>
 
 #include <dnsServerService.hpp>
+#include <dnsZone.hpp>
 #include <FileReader.hpp>
 #include <json.hpp>
 #include <netMesh.hpp>
@@ -15,6 +16,7 @@
 using namespace soup;
 
 static std::unordered_map<std::string, std::vector<SharedPtr<dnsRecord>>> records{};
+static dnsZone zone{};
 
 static void add_record(UniquePtr<dnsRecord>&& rec)
 {
@@ -80,6 +82,8 @@ void cli_dnsserver(int argc, const char** argv)
 		res.emplace_back(soup::make_unique<dnsTxtRecord>(name, 60, name));
 		return res;*/
 	});
+	zone.compile(records);
+	dns_srv.zone = &zone;
 
 	if (argc > 1)
 	{
@@ -125,6 +129,7 @@ void cli_dnsserver(int argc, const char** argv)
 						if (auto factory = dnsRecord::getFactory((dnsType)type))
 						{
 							add_record(factory(std::move(name), 60, std::move(value)));
+							zone.compile(records);
 							netMeshService::replyAffirmative(s);
 							return;
 						}
@@ -161,6 +166,7 @@ void cli_dnsserver(int argc, const char** argv)
 									{
 										records.erase(vec);
 									}
+									zone.compile(records);
 									netMeshService::replyAffirmative(s);
 								}
 								return;
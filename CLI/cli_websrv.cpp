@@ -153,6 +153,7 @@ int cli_websrv(const char* dir)
 	base_dir.push_back('/');
 
 	soup::Server serv{};
+	serv.setUseEpoll();
 	serv.on_work_done = [](soup::Worker& w, soup::Scheduler&)
 	{
 		std::cout << reinterpret_cast<soup::Socket&>(w).peer.toString() << " - work done" << std::endl;
@@ -3,6 +3,7 @@
 #include <atomic>
 
 #include "base.hpp" // SOUP_EXCAL
+#include "memPoolAllocator.hpp"
 #include "PoppedNode.hpp"
 
 NAMESPACE_SOUP
@@ -10,7 +11,7 @@ NAMESPACE_SOUP
 	template <typename Data>
 	struct AtomicDeque
 	{
-		struct Node
+		struct Node : public memPooled
 		{
 			std::atomic<Node*> next = nullptr;
 			Data data;
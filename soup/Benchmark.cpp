@@ -1,13 +1,284 @@
 #include "Benchmark.hpp"
 
+#include <algorithm> // sort
 #include <iostream>
 
+#include "format.hpp"
+#include "json.hpp"
+#include "JsonArray.hpp"
+#include "JsonFloat.hpp"
+#include "JsonInt.hpp"
+#include "JsonObject.hpp"
+#include "JsonString.hpp"
+#include "StringMatch.hpp"
+
 NAMESPACE_SOUP
 {
+	Benchmark::Config Benchmark::config{};
+	std::vector<Benchmark::Result> Benchmark::results{};
+	std::unordered_map<std::string, double> Benchmark::baseline{};
+
+	bool Benchmark::State::canContinueSlow() noexcept
+	{
+		if (its == 0)
+		{
+			its = 1;
+			start_nanos = time::nanos();
+			if (target_its == 0)
+			{
+				deadline += start_nanos;
+				max_its = 1;
+			}
+			else
+			{
+				max_its = target_its;
+			}
+			return true;
+		}
+		if (target_its == 0)
+		{
+			const auto now = time::nanos();
+			if (now < deadline)
+			{
+				// Only check the time every quarter of the iterations done so far.
+				max_its += (its / 4) + 1;
+				++its;
+				return true;
+			}
+			end_nanos = now;
+			return false;
+		}
+		end_nanos = time::nanos();
+		return false;
+	}
+
+	double Benchmark::Result::getBytesPerSecond() const noexcept
+	{
+		return (static_cast<double>(bytes_per_iteration) * 1'000'000'000.0) / median_ns;
+	}
+
+	static std::string formatNanos(double ns)
+	{
+		if (ns >= 1'000'000.0)
+		{
+			return format("{} ms", ns / 1'000'000.0);
+		}
+		if (ns >= 1'000.0)
+		{
+			return format("{} us", ns / 1'000.0);
+		}
+		return format("{} ns", ns);
+	}
+
+	static std::string formatBytesPerSecond(double bps)
+	{
+		if (bps >= 1'000'000'000.0)
+		{
+			return format("{} GB/s", bps / 1'000'000'000.0);
+		}
+		if (bps >= 1'000'000.0)
+		{
+			return format("{} MB/s", bps / 1'000'000.0);
+		}
+		return format("{} KB/s", bps / 1'000.0);
+	}
+
 	void Benchmark::run(const std::string& name, benchmark_t bm) noexcept
 	{
-		Benchmark::State state;
-		bm(state);
-		std::cout << name << ": " << ((float)state.its / num_millis) << " iterations/ms\n";
+		if (!config.filter.empty()
+			&& !StringMatch::wildcard(config.filter, name)
+			)
+		{
+			return;
+		}
+
+		// Warmup & calibration
+		State warmup;
+		warmup.deadline = static_cast<time_t>(config.warmup_millis) * 1'000'000;
+		bm(warmup);
+		if (warmup.its == 0)
+		{
+			return; // Benchmark doesn't have a loop?
+		}
+		const auto warmup_ns_per_it = static_cast<double>(warmup.end_nanos - warmup.start_nanos) / warmup.its;
+		size_t its_per_sample = 1;
+		if (warmup_ns_per_it > 0.0)
+		{
+			its_per_sample = static_cast<size_t>((config.sample_millis * 1'000'000.0) / warmup_ns_per_it);
+			if (its_per_sample == 0)
+			{
+				its_per_sample = 1;
+			}
+		}
+
+		// Sampling
+		std::vector<double> samples{};
+		samples.reserve(config.num_samples);
+		size_t bytes_per_iteration = warmup.bytes_per_iteration;
+		for (unsigned int i = 0; i != config.num_samples; ++i)
+		{
+			State state;
+			state.target_its = its_per_sample;
+			bm(state);
+			samples.emplace_back(static_cast<double>(state.end_nanos - state.start_nanos) / state.its);
+		}
+		if (samples.empty())
+		{
+			samples.emplace_back(warmup_ns_per_it);
+		}
+		std::sort(samples.begin(), samples.end());
+
+		Result res;
+		res.name = name;
+		res.iterations_per_sample = its_per_sample;
+		res.min_ns = samples.front();
+		res.median_ns = (samples.size() % 2) ? samples[samples.size() / 2] : ((samples[(samples.size() / 2) - 1] + samples[samples.size() / 2]) / 2.0);
+		res.p99_ns = samples[((samples.size() * 99) + 99) / 100 - 1]; // nearest-rank
+		res.mean_ns = 0.0;
+		for (const auto& sample : samples)
+		{
+			res.mean_ns += sample;
+		}
+		res.mean_ns /= samples.size();
+		res.bytes_per_iteration = bytes_per_iteration;
+		if (auto e = baseline.find(name); e != baseline.end())
+		{
+			res.baseline_median_ns = e->second;
+			res.regressed = (res.median_ns > res.baseline_median_ns * (1.0 + config.regression_threshold));
+		}
+
+		if (config.format == TEXT)
+		{
+			std::string line = name;
+			line.append(": median ");
+			line.append(formatNanos(res.median_ns));
+			line.append(", min ");
+			line.append(formatNanos(res.min_ns));
+			line.append(", p99 ");
+			line.append(formatNanos(res.p99_ns));
+			if (res.bytes_per_iteration != 0)
+			{
+				line.append(", ");
+				line.append(formatBytesPerSecond(res.getBytesPerSecond()));
+			}
+			if (res.baseline_median_ns != 0.0)
+			{
+				line.append(format(" ({}% vs. baseline)", static_cast<int>(((res.median_ns / res.baseline_median_ns) - 1.0) * 100.0)));
+				if (res.regressed)
+				{
+					line.append(" REGRESSION");
+				}
+			}
+			std::cout << line << "\n";
+		}
+
+		results.emplace_back(std::move(res));
+	}
+
+	bool Benchmark::loadBaseline(const std::string& data) SOUP_EXCAL
+	{
+		auto root = json::decode(data);
+		if (!root || !root->isArr())
+		{
+			return false;
+		}
+		for (const auto& elm : root->asArr())
+		{
+			if (elm.isObj())
+			{
+				auto name = elm.asObj().find("name");
+				auto median_ns = elm.asObj().find("median_ns");
+				if (name && name->isStr()
+					&& median_ns && (median_ns->isInt() || median_ns->isFloat())
+					)
+				{
+					baseline.emplace(name->asStr().value, median_ns->toFloat());
+				}
+			}
+		}
+		return true;
+	}
+
+	size_t Benchmark::finish() noexcept
+	{
+		if (config.format == JSON)
+		{
+			std::cout << toJson() << "\n";
+		}
+		else if (config.format == CSV)
+		{
+			std::cout << toCsv();
+		}
+		size_t regressions = 0;
+		for (const auto& res : results)
+		{
+			regressions += res.regressed;
+		}
+		return regressions;
+	}
+
+	std::string Benchmark::toJson() SOUP_EXCAL
+	{
+		JsonArray arr;
+		for (const auto& res : results)
+		{
+			auto obj = soup::make_unique<JsonObject>();
+			obj->add("name", res.name);
+			obj->add("iterations_per_sample", static_cast<int64_t>(res.iterations_per_sample));
+			obj->add("min_ns", res.min_ns);
+			obj->add("median_ns", res.median_ns);
+			obj->add("p99_ns", res.p99_ns);
+			obj->add("mean_ns", res.mean_ns);
+			if (res.bytes_per_iteration != 0)
+			{
+				obj->add("bytes_per_second", res.getBytesPerSecond());
+			}
+			if (res.baseline_median_ns != 0.0)
+			{
+				obj->add("baseline_median_ns", res.baseline_median_ns);
+				obj->add("regressed", res.regressed);
+			}
+			arr.children.emplace_back(std::move(obj));
+		}
+		return arr.encodePretty();
+	}
+
+	std::string Benchmark::toCsv() SOUP_EXCAL
+	{
+		std::string str = "name,iterations_per_sample,min_ns,median_ns,p99_ns,mean_ns,bytes_per_second,baseline_median_ns,regressed\n";
+		for (const auto& res : results)
+		{
+			str.append(res.name);
+			str.push_back(',');
+			str.append(std::to_string(res.iterations_per_sample));
+			str.push_back(',');
+			str.append(std::to_string(res.min_ns));
+			str.push_back(',');
+			str.append(std::to_string(res.median_ns));
+			str.push_back(',');
+			str.append(std::to_string(res.p99_ns));
+			str.push_back(',');
+			str.append(std::to_string(res.mean_ns));
+			str.push_back(',');
+			if (res.bytes_per_iteration != 0)
+			{
+				str.append(std::to_string(res.getBytesPerSecond()));
+			}
+			str.push_back(',');
+			if (res.baseline_median_ns != 0.0)
+			{
+				str.append(std::to_string(res.baseline_median_ns));
+			}
+			str.push_back(',');
+			str.append(res.regressed ? "1" : "0");
+			str.push_back('\n');
+		}
+		return str;
+	}
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	void Benchmark::useCharPointer(const volatile char*) noexcept
+	{
 	}
+#endif
 }
@@ -1,37 +1,127 @@
 #pragma once
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "base.hpp"
 #include "time.hpp"
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h> // _ReadWriteBarrier
+#endif
+
 NAMESPACE_SOUP
 {
 	struct Benchmark
 	{
-		static constexpr auto num_millis = 100;
+		enum Format : uint8_t
+		{
+			TEXT,
+			JSON,
+			CSV,
+		};
+
+		struct Config
+		{
+			unsigned int warmup_millis = 20; // also used to calibrate the number of iterations per sample
+			unsigned int sample_millis = 10; // targeted duration of a single sample
+			unsigned int num_samples = 15;
+			std::string filter{}; // wildcard pattern for benchmark names, empty = run everything
+			Format format = TEXT;
+			double regression_threshold = 0.05; // relative slowdown of the median compared to the baseline that is considered a regression
+		};
+
+		struct Result
+		{
+			std::string name;
+			size_t iterations_per_sample;
+			double min_ns; // per iteration
+			double median_ns; // per iteration
+			double p99_ns; // per iteration
+			double mean_ns; // per iteration
+			size_t bytes_per_iteration;
+			double baseline_median_ns = 0.0; // 0 if the benchmark is not in the baseline
+			bool regressed = false;
+
+			[[nodiscard]] double getBytesPerSecond() const noexcept;
+		};
 
 		struct State
 		{
 			size_t its = 0;
+			size_t max_its = 0; // iterations until the next call to canContinueSlow
+			size_t target_its = 0; // if 0, iterations continue until the deadline
 			time_t deadline = 0;
+			time_t start_nanos = 0;
+			time_t end_nanos = 0;
+			size_t bytes_per_iteration = 0;
+
+			// Enables throughput reporting.
+			void setBytesPerIteration(size_t bytes) noexcept
+			{
+				bytes_per_iteration = bytes;
+			}
 
 			[[nodiscard]] SOUP_FORCEINLINE bool canContinue() noexcept
 			{
-				SOUP_IF_UNLIKELY (its == 0)
+				SOUP_IF_LIKELY (its < max_its)
 				{
-					its = 1;
-					deadline = time::millis() + num_millis;
+					++its;
 					return true;
 				}
-				++its;
-				return time::millis() < deadline;
+				return canContinueSlow();
 			}
+
+			[[nodiscard]] bool canContinueSlow() noexcept;
 		};
 
 		using benchmark_t = void(*)(Benchmark::State&);
 
+		static Config config;
+		static std::vector<Result> results;
+		static std::unordered_map<std::string, double> baseline; // name -> median_ns
+
 		static void run(const std::string& name, benchmark_t bm) noexcept;
+
+		// Loads results previously produced with Format::JSON to compare against.
+		static bool loadBaseline(const std::string& json) SOUP_EXCAL;
+
+		// Prints all results in JSON or CSV format (in TEXT format, results are printed as they come in), and returns the number of regressions.
+		static size_t finish() noexcept;
+
+		[[nodiscard]] static std::string toJson() SOUP_EXCAL;
+		[[nodiscard]] static std::string toCsv() SOUP_EXCAL;
+
+		// Prevents the compiler from optimising away the computation of a value.
+		template <typename T>
+		static SOUP_FORCEINLINE void doNotOptimise(const T& value) noexcept
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			useCharPointer(&reinterpret_cast<const volatile char&>(value));
+			_ReadWriteBarrier();
+#else
+			asm volatile("" : : "r,m"(value) : "memory");
+#endif
+		}
+
+		// Forces the compiler to assume that all memory may have been read and written.
+		static SOUP_FORCEINLINE void clobberMemory() noexcept
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			_ReadWriteBarrier();
+#else
+			asm volatile("" : : : "memory");
+#endif
+		}
+
+	private:
+#if defined(_MSC_VER) && !defined(__clang__)
+		static void useCharPointer(const volatile char*) noexcept;
+#endif
 	};
 }
 
 #define BENCHMARK(name, ...) ::soup::Benchmark::run(name, [](::soup::Benchmark::State& _benchmark_state) { __VA_ARGS__ });
 #define BENCHMARK_LOOP(...) while (true) { SOUP_IF_UNLIKELY (!_benchmark_state.canContinue()) { break; } __VA_ARGS__ }
+#define BENCHMARK_BYTES(bytes) _benchmark_state.setBytesPerIteration(bytes);
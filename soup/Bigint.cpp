@@ -6,6 +6,7 @@
 #include "CpuInfo.hpp"
 #include "Endian.hpp"
 #include "Exception.hpp"
+#include "MontgomeryContext.hpp"
 #include "ObfusString.hpp"
 #include "rand.hpp"
 #include "RngInterface.hpp"
@@ -1795,11 +1796,7 @@ NAMESPACE_SOUP
 
 	Bigint Bigint::modPowMontgomery(const Bigint& e, const Bigint& m) const
 	{
-		auto re = m.montgomeryREFromM();
-		auto r = montgomeryRFromRE(re);
-		Bigint m_mod_mul_inv, r_mod_mul_inv;
-		modMulInv2Coprimes(m, r, m_mod_mul_inv, r_mod_mul_inv);
-		return modPowMontgomery(e, re, r, m, r_mod_mul_inv, m_mod_mul_inv, r.modUnsignedNotpowerof2(m));
+		return MontgomeryContext(m).modPow(*this, e);
 	}
 
 	Bigint Bigint::modPowMontgomery(const Bigint& e, size_t re, const Bigint& r, const Bigint& m, const Bigint& r_mod_mul_inv, const Bigint& m_mod_mul_inv, const Bigint& one_mont) const SOUP_EXCAL
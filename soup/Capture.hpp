@@ -1,10 +1,15 @@
 #pragma once
 
+#include <cstddef> // max_align_t
 #include <cstdint> // uintptr_t
+#include <exception> // rethrow_exception
+#include <memory> // destroy_at
 #include <utility> // move
 
 #include "base.hpp" // SOUP_EXCAL
 #include "deleter.hpp"
+#include "memory.hpp" // construct_at
+#include "memPoolAllocator.hpp"
 #include "type_traits.hpp"
 
 NAMESPACE_SOUP
@@ -31,21 +36,21 @@ NAMESPACE_SOUP
 
 		template <typename T, SOUP_RESTRICT(!std::is_pointer_v<std::remove_reference_t<T>>)>
 		Capture(const T& v) SOUP_EXCAL
-			: data(new std::remove_reference_t<T>(v)), deleter(&deleter_impl<std::remove_reference_t<T>>)
 		{
+			create<std::remove_reference_t<T>>(v);
 		}
 
 		template <typename T, SOUP_RESTRICT(!std::is_pointer_v<std::remove_reference_t<T>>)>
 		Capture(T&& v) SOUP_EXCAL
-			: data(new std::remove_reference_t<T>(std::move(v))), deleter(&deleter_impl<std::remove_reference_t<T>>)
 		{
+			create<std::remove_reference_t<T>>(std::move(v));
 		}
 
 		// For some reason, C++ thinks it can call the T&& overload for non-const SharedPtr references...
 		template <typename T, SOUP_RESTRICT(!std::is_pointer_v<std::remove_reference_t<T>>)>
 		Capture(T& v) SOUP_EXCAL
-			: data(new std::remove_reference_t<T>(v)), deleter(&deleter_impl<std::remove_reference_t<T>>)
 		{
+			create<std::remove_reference_t<T>>(v);
 		}
 
 		template <typename T, SOUP_RESTRICT(std::is_pointer_v<std::remove_reference_t<T>>)>
@@ -74,6 +79,40 @@ NAMESPACE_SOUP
 		}
 
 	protected:
+		template <typename T, typename Arg>
+		void create(Arg&& arg) SOUP_EXCAL
+		{
+#if SOUP_USE_POOL_ALLOCATOR
+			if constexpr (alignof(T) <= alignof(std::max_align_t))
+			{
+				void* const ptr = memPoolAllocator::allocateBlock(sizeof(T));
+				SOUP_TRY
+				{
+					soup::construct_at<>(reinterpret_cast<T*>(ptr), std::forward<Arg>(arg));
+				}
+				SOUP_CATCH_ANY
+				{
+					memPoolAllocator::deallocateBlock(ptr);
+					std::rethrow_exception(std::current_exception());
+				}
+				data = ptr;
+				deleter = &pooled_deleter_impl<T>;
+			}
+			else
+#endif
+			{
+				data = new T(std::forward<Arg>(arg));
+				deleter = &deleter_impl<T>;
+			}
+		}
+
+		template <typename T>
+		static void pooled_deleter_impl(void* ptr)
+		{
+			std::destroy_at<>(reinterpret_cast<T*>(ptr));
+			memPoolAllocator::deallocateBlock(ptr);
+		}
+
 		void free() noexcept
 		{
 			if (deleter != nullptr)
@@ -103,16 +142,14 @@ NAMESPACE_SOUP
 		void operator =(const T& v) SOUP_EXCAL
 		{
 			free();
-			data = new std::remove_reference_t<T>(v);
-			deleter = &deleter_impl<std::remove_reference_t<T>>;
+			create<std::remove_reference_t<T>>(v);
 		}
 
 		template <typename T, SOUP_RESTRICT(!std::is_pointer_v<std::remove_reference_t<T>>)>
 		void operator =(T&& v) SOUP_EXCAL
 		{
 			free();
-			data = new std::remove_reference_t<T>(std::move(v));
-			deleter = &deleter_impl<std::remove_reference_t<T>>;
+			create<std::remove_reference_t<T>>(std::move(v));
 		}
 
 		template <typename T, SOUP_RESTRICT(std::is_pointer_v<std::remove_reference_t<T>>)>
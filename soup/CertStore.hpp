@@ -3,6 +3,9 @@
 #include "base.hpp"
 
 #include "rsa.hpp"
+#if !SOUP_WASM
+#include "TlsSessionCache.hpp"
+#endif
 #include "X509Certchain.hpp"
 
 NAMESPACE_SOUP
@@ -21,6 +24,9 @@ NAMESPACE_SOUP
 		};
 
 		std::vector<Entry> entries{};
+#if !SOUP_WASM
+		TlsSessionCache session_cache{}; // Used by Socket::enableCryptoServer so clients can resume sessions. Set its capacity to 0 to disable this.
+#endif
 
 		void add(X509Certchain&& certchain, RsaPrivateKey&& private_key)
 		{
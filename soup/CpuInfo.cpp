@@ -151,6 +151,7 @@ NAMESPACE_SOUP
 
 		std::string misc_features{};
 		if (supportsPCLMULQDQ()) { string::listAppend(misc_features, "PCLMULQDQ"); }
+		if (supportsPOPCNT()) { string::listAppend(misc_features, "POPCNT"); }
 		if (supportsAESNI()) { string::listAppend(misc_features, "AESNI"); }
 		if (supportsRDRAND()) { string::listAppend(misc_features, "RDRAND"); }
 		if (supportsRDSEED()) { string::listAppend(misc_features, "RDSEED"); }
@@ -88,6 +88,11 @@ NAMESPACE_SOUP
 			return (feature_flags_ecx >> 20) & 1;
 		}
 
+		[[nodiscard]] bool supportsPOPCNT() const noexcept
+		{
+			return (feature_flags_ecx >> 23) & 1;
+		}
+
 		[[nodiscard]] bool supportsAESNI() const noexcept
 		{
 			return (feature_flags_ecx >> 25) & 1;
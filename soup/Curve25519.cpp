@@ -2,14 +2,20 @@
 
 #include <cstring> // memcpy
 
+#include "limbutil.hpp"
 #include "rand.hpp"
 
 NAMESPACE_SOUP
 {
-#define F25519_SIZE 32
+#define F25519_LIMBS 4
 
-	static const uint8_t f25519_one[F25519_SIZE] = { 1 };
-	const uint8_t c25519_base_x[F25519_SIZE] = { 9 };
+	/* Field elements are 4 little-endian 64-bit limbs. They are kept below
+	 * 2^256 but are only fully reduced by f25519_normalize, since
+	 * 2^256 = 38 mod p lets everything else fold carries back in cheaply.
+	 */
+
+	static const uint64_t f25519_one[F25519_LIMBS] = { 1 };
+	static const uint8_t c25519_base_x[32] = { 9 };
 
 	/* Having generated 32 random bytes, you should call this function to
 	 * finalize the generated key.
@@ -21,55 +27,91 @@ NAMESPACE_SOUP
 		key[31] |= 0x40;
 	}
 
+	static void f25519_load(uint64_t* x, const uint8_t* in)
+	{
+		int i;
+
+		for (i = 0; i < F25519_LIMBS; i++) {
+			uint64_t limb = 0;
+			int j;
+
+			for (j = 7; j >= 0; j--)
+				limb = (limb << 8) | in[i * 8 + j];
+
+			x[i] = limb;
+		}
+	}
+
+	static void f25519_store(uint8_t* out, const uint64_t* x)
+	{
+		int i;
+
+		for (i = 0; i < 32; i++)
+			out[i] = static_cast<uint8_t>(x[i / 8] >> ((i % 8) * 8));
+	}
+
 	/* Copy two points */
-	static inline void f25519_copy(uint8_t* x, const uint8_t* a)
+	static inline void f25519_copy(uint64_t* x, const uint64_t* a)
 	{
-		memcpy(x, a, F25519_SIZE);
+		memcpy(x, a, F25519_LIMBS * sizeof(uint64_t));
 	}
 
-	static void f25519_select(uint8_t* dst,
-		const uint8_t* zero, const uint8_t* one,
-		uint8_t condition)
+	static void f25519_select(uint64_t* dst,
+		const uint64_t* zero, const uint64_t* one,
+		uint64_t condition)
 	{
-		const uint8_t mask = -condition;
+		const uint64_t mask = 0 - condition;
 		int i;
 
-		for (i = 0; i < F25519_SIZE; i++)
+		for (i = 0; i < F25519_LIMBS; i++)
 			dst[i] = zero[i] ^ (mask & (one[i] ^ zero[i]));
 	}
 
-	static void f25519_mul__distinct(uint8_t* r, const uint8_t* a, const uint8_t* b)
+	/* Add c * 2^256 back in, using 2^256 = 38 mod p. c must be less than
+	 * 2^58.
+	 */
+	static void f25519_fold(uint64_t* r, uint64_t c)
 	{
-		uint32_t c = 0;
+		uint64_t carry = 0;
 		int i;
 
-		for (i = 0; i < F25519_SIZE; i++) {
-			int j;
+		r[0] = limbutil::addCarry(r[0], c * 38, carry);
+		for (i = 1; i < F25519_LIMBS; i++)
+			r[i] = limbutil::addCarry(r[i], 0, carry);
+
+		/* If that carried as well, the result is now tiny, so this can't
+		 * carry again.
+		 */
+		r[0] += carry * 38;
+	}
+
+	static void f25519_mul(uint64_t* r, const uint64_t* a, const uint64_t* b)
+	{
+		uint64_t t[F25519_LIMBS * 2] = { 0 };
+		uint64_t c;
+		int i;
 
-			c >>= 8;
-			for (j = 0; j <= i; j++)
-				c += ((uint32_t)a[j]) * ((uint32_t)b[i - j]);
+		for (i = 0; i < F25519_LIMBS; i++) {
+			int j;
 
-			for (; j < F25519_SIZE; j++)
-				c += ((uint32_t)a[j]) *
-				((uint32_t)b[i + F25519_SIZE - j]) * 38;
+			c = 0;
+			for (j = 0; j < F25519_LIMBS; j++)
+				t[i + j] = limbutil::mulAdd(a[i], b[j], t[i + j], c, c);
 
-			r[i] = c;
+			t[i + F25519_LIMBS] = c;
 		}
 
-		r[31] &= 127;
-		c = (c >> 7) * 19;
+		/* Reduce with 2^256 = 38 mod p */
+		c = 0;
+		for (i = 0; i < F25519_LIMBS; i++)
+			r[i] = limbutil::mulAdd(t[i + F25519_LIMBS], 38, t[i], c, c);
 
-		for (i = 0; i < F25519_SIZE; i++) {
-			c += r[i];
-			r[i] = c;
-			c >>= 8;
-		}
+		f25519_fold(r, c);
 	}
 
-	static void f25519_inv__distinct(uint8_t* r, const uint8_t* x)
+	static void f25519_inv(uint64_t* r, const uint64_t* x)
 	{
-		uint8_t s[F25519_SIZE];
+		uint64_t s[F25519_LIMBS];
 		int i;
 
 		/* This is a prime field, so by Fermat's little theorem:
@@ -89,121 +131,97 @@ NAMESPACE_SOUP
 		 */
 
 		 /* 1 1 */
-		f25519_mul__distinct(s, x, x);
-		f25519_mul__distinct(r, s, x);
+		f25519_mul(s, x, x);
+		f25519_mul(r, s, x);
 
 		/* 1 x 248 */
 		for (i = 0; i < 248; i++) {
-			f25519_mul__distinct(s, r, r);
-			f25519_mul__distinct(r, s, x);
+			f25519_mul(s, r, r);
+			f25519_mul(r, s, x);
 		}
 
 		/* 0 */
-		f25519_mul__distinct(s, r, r);
+		f25519_mul(s, r, r);
 
 		/* 1 */
-		f25519_mul__distinct(r, s, s);
-		f25519_mul__distinct(s, r, x);
+		f25519_mul(r, s, s);
+		f25519_mul(s, r, x);
 
 		/* 0 */
-		f25519_mul__distinct(r, s, s);
+		f25519_mul(r, s, s);
 
 		/* 1 */
-		f25519_mul__distinct(s, r, r);
-		f25519_mul__distinct(r, s, x);
+		f25519_mul(s, r, r);
+		f25519_mul(r, s, x);
 
 		/* 1 */
-		f25519_mul__distinct(s, r, r);
-		f25519_mul__distinct(r, s, x);
+		f25519_mul(s, r, r);
+		f25519_mul(r, s, x);
 	}
 
-	static void f25519_normalize(uint8_t* x)
+	static void f25519_normalize(uint64_t* x)
 	{
-		uint8_t minusp[F25519_SIZE];
-		uint16_t c;
+		uint64_t minusp[F25519_LIMBS];
+		uint64_t c = 0;
 		int i;
 
 		/* Reduce using 2^255 = 19 mod p */
-		c = (x[31] >> 7) * 19;
-		x[31] &= 127;
-
-		for (i = 0; i < F25519_SIZE; i++) {
-			c += x[i];
-			x[i] = static_cast<uint8_t>(c);
-			c >>= 8;
-		}
-
-		/* The number is now less than 2^255 + 18, and therefore less than
-		 * 2p. Try subtracting p, and conditionally load the subtracted
-		 * value if underflow did not occur.
+		const uint64_t top = x[3] >> 63;
+		x[3] &= 0x7fffffffffffffff;
+		x[0] = limbutil::addCarry(x[0], top * 19, c);
+		for (i = 1; i < F25519_LIMBS; i++)
+			x[i] = limbutil::addCarry(x[i], 0, c);
+
+		/* The number is now less than 2^255 + 19, and therefore less than
+		 * 2p. Try subtracting p, which is adding 19 and then 2^255 less,
+		 * and load the subtracted value if that didn't underflow.
 		 */
-		c = 19;
-
-		for (i = 0; i + 1 < F25519_SIZE; i++) {
-			c += x[i];
-			minusp[i] = static_cast<uint8_t>(c);
-			c >>= 8;
-		}
-
-		c += ((uint16_t)x[i]) - 128;
-		minusp[31] = static_cast<uint8_t>(c);
-
-		/* Load x-p if no underflow */
-		f25519_select(x, minusp, x, (c >> 15) & 1);
+		c = 0;
+		minusp[0] = limbutil::addCarry(x[0], 19, c);
+		for (i = 1; i < F25519_LIMBS; i++)
+			minusp[i] = limbutil::addCarry(x[i], 0, c);
+
+		c = minusp[3] >> 63;
+		minusp[3] &= 0x7fffffffffffffff;
+		f25519_select(x, x, minusp, c);
 	}
 
-	static void f25519_add(uint8_t* r, const uint8_t* a, const uint8_t* b)
+	static void f25519_add(uint64_t* r, const uint64_t* a, const uint64_t* b)
 	{
-		uint16_t c = 0;
+		uint64_t c = 0;
 		int i;
 
-		/* Add */
-		for (i = 0; i < F25519_SIZE; i++) {
-			c >>= 8;
-			c += ((uint16_t)a[i]) + ((uint16_t)b[i]);
-			r[i] = static_cast<uint8_t>(c);
-		}
-
-		/* Reduce with 2^255 = 19 mod p */
-		r[31] &= 127;
-		c = (c >> 7) * 19;
+		for (i = 0; i < F25519_LIMBS; i++)
+			r[i] = limbutil::addCarry(a[i], b[i], c);
 
-		for (i = 0; i < F25519_SIZE; i++) {
-			c += r[i];
-			r[i] = static_cast<uint8_t>(c);
-			c >>= 8;
-		}
+		f25519_fold(r, c);
 	}
 
-	static void f25519_sub(uint8_t* r, const uint8_t* a, const uint8_t* b)
+	static void f25519_sub(uint64_t* r, const uint64_t* a, const uint64_t* b)
 	{
-		uint32_t c = 0;
+		uint64_t c = 0;
+		uint64_t c2 = 0;
 		int i;
 
-		/* Calculate a + 2p - b, to avoid underflow */
-		c = 218;
-		for (i = 0; i + 1 < F25519_SIZE; i++) {
-			c += 65280 + ((uint32_t)a[i]) - ((uint32_t)b[i]);
-			r[i] = c;
-			c >>= 8;
-		}
+		for (i = 0; i < F25519_LIMBS; i++)
+			r[i] = limbutil::subBorrow(a[i], b[i], c);
 
-		c += ((uint32_t)a[31]) - ((uint32_t)b[31]);
-		r[31] = c & 127;
-		c = (c >> 7) * 19;
+		/* An underflow added 2^256, so take away 38 to make up for it. If
+		 * that underflows too, the result is now close to 2^256, so this
+		 * can't underflow again.
+		 */
+		r[0] = limbutil::subBorrow(r[0], c * 38, c2);
+		for (i = 1; i < F25519_LIMBS; i++)
+			r[i] = limbutil::subBorrow(r[i], 0, c2);
 
-		for (i = 0; i < F25519_SIZE; i++) {
-			c += r[i];
-			r[i] = c;
-			c >>= 8;
-		}
+		r[0] -= c2 * 38;
 	}
 
 	/* Differential addition */
-	static void xc_diffadd(uint8_t* x5, uint8_t* z5,
-		const uint8_t* x1, const uint8_t* z1,
-		const uint8_t* x2, const uint8_t* z2,
-		const uint8_t* x3, const uint8_t* z3)
+	static void xc_diffadd(uint64_t* x5, uint64_t* z5,
+		const uint64_t* x1, const uint64_t* z1,
+		const uint64_t* x2, const uint64_t* z2,
+		const uint64_t* x3, const uint64_t* z3)
 	{
 		/* Explicit formulas database: dbl-1987-m3
 		 *
@@ -219,53 +237,42 @@ NAMESPACE_SOUP
 		 * compute X5 = Z1(DA+CB)^2
 		 * compute Z5 = X1(DA-CB)^2
 		 */
-		uint8_t da[F25519_SIZE];
-		uint8_t cb[F25519_SIZE];
-		uint8_t a[F25519_SIZE];
-		uint8_t b[F25519_SIZE];
+		uint64_t da[F25519_LIMBS];
+		uint64_t cb[F25519_LIMBS];
+		uint64_t a[F25519_LIMBS];
+		uint64_t b[F25519_LIMBS];
 
 		f25519_add(a, x2, z2);
 		f25519_sub(b, x3, z3); /* D */
-		f25519_mul__distinct(da, a, b);
+		f25519_mul(da, a, b);
 
 		f25519_sub(b, x2, z2);
 		f25519_add(a, x3, z3); /* C */
-		f25519_mul__distinct(cb, a, b);
+		f25519_mul(cb, a, b);
 
 		f25519_add(a, da, cb);
-		f25519_mul__distinct(b, a, a);
-		f25519_mul__distinct(x5, z1, b);
+		f25519_mul(b, a, a);
+		f25519_mul(x5, z1, b);
 
 		f25519_sub(a, da, cb);
-		f25519_mul__distinct(b, a, a);
-		f25519_mul__distinct(z5, x1, b);
+		f25519_mul(b, a, a);
+		f25519_mul(z5, x1, b);
 	}
 
-	static void f25519_mul_c(uint8_t* r, const uint8_t* a, uint32_t b)
+	static void f25519_mul_c(uint64_t* r, const uint64_t* a, uint32_t b)
 	{
-		uint32_t c = 0;
+		uint64_t c = 0;
 		int i;
 
-		for (i = 0; i < F25519_SIZE; i++) {
-			c >>= 8;
-			c += b * ((uint32_t)a[i]);
-			r[i] = c;
-		}
-
-		r[31] &= 127;
-		c >>= 7;
-		c *= 19;
+		for (i = 0; i < F25519_LIMBS; i++)
+			r[i] = limbutil::mulAdd(a[i], b, 0, c, c);
 
-		for (i = 0; i < F25519_SIZE; i++) {
-			c += r[i];
-			r[i] = c;
-			c >>= 8;
-		}
+		f25519_fold(r, c);
 	}
 
 	/* Double an X-coordinate */
-	static void xc_double(uint8_t* x3, uint8_t* z3,
-		const uint8_t* x1, const uint8_t* z1)
+	static void xc_double(uint64_t* x3, uint64_t* z3,
+		const uint64_t* x1, const uint64_t* z1)
 	{
 		/* Explicit formulas database: dbl-1987-m
 		 *
@@ -274,44 +281,48 @@ NAMESPACE_SOUP
 		 * compute X3 = (X1^2-Z1^2)^2
 		 * compute Z3 = 4 X1 Z1 (X1^2 + a X1 Z1 + Z1^2)
 		 */
-		uint8_t x1sq[F25519_SIZE];
-		uint8_t z1sq[F25519_SIZE];
-		uint8_t x1z1[F25519_SIZE];
-		uint8_t a[F25519_SIZE];
+		uint64_t x1sq[F25519_LIMBS];
+		uint64_t z1sq[F25519_LIMBS];
+		uint64_t x1z1[F25519_LIMBS];
+		uint64_t a[F25519_LIMBS];
 
-		f25519_mul__distinct(x1sq, x1, x1);
-		f25519_mul__distinct(z1sq, z1, z1);
-		f25519_mul__distinct(x1z1, x1, z1);
+		f25519_mul(x1sq, x1, x1);
+		f25519_mul(z1sq, z1, z1);
+		f25519_mul(x1z1, x1, z1);
 
 		f25519_sub(a, x1sq, z1sq);
-		f25519_mul__distinct(x3, a, a);
+		f25519_mul(x3, a, a);
 
 		f25519_mul_c(a, x1z1, 486662);
 		f25519_add(a, x1sq, a);
 		f25519_add(a, z1sq, a);
-		f25519_mul__distinct(x1sq, x1z1, a);
+		f25519_mul(x1sq, x1z1, a);
 		f25519_mul_c(z3, x1sq, 4);
 	}
 
-	void c25519_smult(uint8_t* result, const uint8_t* q, const uint8_t* e)
+	void c25519_smult(uint8_t* result, const uint8_t* q_bytes, const uint8_t* e)
 	{
+		uint64_t q[F25519_LIMBS];
+
 		/* Current point: P_m */
-		uint8_t xm[F25519_SIZE];
-		uint8_t zm[F25519_SIZE] = { 1 };
+		uint64_t xm[F25519_LIMBS];
+		uint64_t zm[F25519_LIMBS] = { 1 };
 
 		/* Predecessor: P_(m-1) */
-		uint8_t xm1[F25519_SIZE] = { 1 };
-		uint8_t zm1[F25519_SIZE] = { 0 };
+		uint64_t xm1[F25519_LIMBS] = { 1 };
+		uint64_t zm1[F25519_LIMBS] = { 0 };
 
 		int i;
 
+		f25519_load(q, q_bytes);
+
 		/* Note: bit 254 is assumed to be 1 */
 		f25519_copy(xm, q);
 
 		for (i = 253; i >= 0; i--) {
 			const int bit = (e[i >> 3] >> (i & 7)) & 1;
-			uint8_t xms[F25519_SIZE];
-			uint8_t zms[F25519_SIZE];
+			uint64_t xms[F25519_LIMBS];
+			uint64_t zms[F25519_LIMBS];
 
 			/* From P_m and P_(m-1), compute P_(2m) and P_(2m-1) */
 			xc_diffadd(xm1, zm1, q, f25519_one, xm, zm, xm1, zm1);
@@ -331,9 +342,10 @@ NAMESPACE_SOUP
 		}
 
 		/* Freeze out of projective coordinates */
-		f25519_inv__distinct(zm1, zm);
-		f25519_mul__distinct(result, zm1, xm);
-		f25519_normalize(result);
+		f25519_inv(zm1, zm);
+		f25519_mul(xm1, zm1, xm);
+		f25519_normalize(xm1);
+		f25519_store(result, xm1);
 	}
 
 	void Curve25519::generatePrivate(uint8_t(&private_key)[KEY_SIZE])
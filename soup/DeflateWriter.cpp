@@ -0,0 +1,794 @@
+#include "DeflateWriter.hpp"
+
+#include <algorithm> // sort
+#include <cstring> // memcpy
+
+#include "adler32.hpp"
+#include "crc32.hpp"
+
+NAMESPACE_SOUP
+{
+	struct DeflateLevelParams
+	{
+		uint16_t good_len; // reduce the chain length if we already have a match this long
+		uint16_t max_lazy; // don't look for a better match if we already have one this long; for greedy levels, don't insert the hashes of matches longer than this
+		uint16_t nice_len; // stop searching once we found a match this long
+		uint16_t max_chain;
+		bool lazy;
+	};
+
+	// Same trade-offs as zlib.
+	static constexpr DeflateLevelParams level_params[10] = {
+		{ 0, 0, 0, 0, false },
+		{ 4, 4, 8, 4, false },
+		{ 4, 5, 16, 8, false },
+		{ 4, 6, 32, 32, false },
+		{ 4, 4, 16, 16, true },
+		{ 8, 16, 32, 32, true },
+		{ 8, 16, 128, 128, true },
+		{ 8, 32, 128, 256, true },
+		{ 32, 128, 258, 1024, true },
+		{ 32, 258, 258, 4096, true },
+	};
+
+	static constexpr uint16_t length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static constexpr uint8_t length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static constexpr uint16_t dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static constexpr uint8_t dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	static constexpr uint8_t codelen_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	static constexpr unsigned LITLEN_SYMS = 286;
+	static constexpr unsigned DIST_SYMS = 30;
+	static constexpr unsigned CODELEN_SYMS = 19;
+	static constexpr unsigned END_OF_BLOCK = 256;
+
+	struct DeflateCodeTables
+	{
+		uint8_t length_code[DeflateWriter::MAX_MATCH + 1]; // length -> index into length_base
+		uint8_t dist_code_low[256]; // dist - 1 -> code, for dist <= 256
+		uint8_t dist_code_high[256]; // (dist - 1) >> 7 -> code, for dist > 256
+
+		DeflateCodeTables() noexcept
+		{
+			for (unsigned code = 0; code != 29; ++code)
+			{
+				const unsigned end = (code == 28 ? 259 : length_base[code + 1]);
+				for (unsigned len = length_base[code]; len != end; ++len)
+				{
+					length_code[len] = static_cast<uint8_t>(code);
+				}
+			}
+			length_code[258] = 28; // 258 has its own code even though 227 + 31 could express it
+			for (unsigned code = 0; code != 30; ++code)
+			{
+				const unsigned end = (code == 29 ? 32769 : dist_base[code + 1]);
+				for (unsigned dist = dist_base[code]; dist != end; ++dist)
+				{
+					if (dist <= 256)
+					{
+						dist_code_low[dist - 1] = static_cast<uint8_t>(code);
+					}
+					else
+					{
+						dist_code_high[(dist - 1) >> 7] = static_cast<uint8_t>(code);
+					}
+				}
+			}
+		}
+
+		[[nodiscard]] uint8_t getDistCode(unsigned dist) const noexcept
+		{
+			return dist <= 256 ? dist_code_low[dist - 1] : dist_code_high[(dist - 1) >> 7];
+		}
+	};
+	static const DeflateCodeTables code_tables{};
+
+	// Assigns code lengths of at most max_bits to the symbols with non-zero frequency.
+	// The tree is built as per Huffman and then overlong codes are shortened, as zlib does.
+	static void buildLengths(const uint32_t* freqs, unsigned num_syms, uint8_t max_bits, uint8_t* lengths) SOUP_EXCAL
+	{
+		struct HeapNode
+		{
+			uint32_t freq;
+			uint16_t id; // < num_syms for leaves
+		};
+
+		memset(lengths, 0, num_syms);
+
+		std::vector<uint16_t> used{};
+		for (unsigned i = 0; i != num_syms; ++i)
+		{
+			if (freqs[i] != 0)
+			{
+				used.emplace_back(static_cast<uint16_t>(i));
+			}
+		}
+		if (used.empty())
+		{
+			return;
+		}
+		if (used.size() == 1)
+		{
+			lengths[used[0]] = 1;
+			return;
+		}
+
+		// Build the tree; parent[] links every node to its parent so we can compute depths afterwards.
+		std::vector<HeapNode> heap{};
+		std::vector<uint16_t> parent(num_syms + used.size(), 0);
+		for (const auto& sym : used)
+		{
+			heap.emplace_back(HeapNode{ freqs[sym], sym });
+		}
+		auto cmp = [](const HeapNode& a, const HeapNode& b)
+		{
+			return a.freq > b.freq || (a.freq == b.freq && a.id > b.id);
+		};
+		std::make_heap(heap.begin(), heap.end(), cmp);
+		uint16_t next_id = static_cast<uint16_t>(num_syms);
+		while (heap.size() > 1)
+		{
+			std::pop_heap(heap.begin(), heap.end(), cmp);
+			const HeapNode a = heap.back();
+			heap.pop_back();
+			std::pop_heap(heap.begin(), heap.end(), cmp);
+			const HeapNode b = heap.back();
+			heap.pop_back();
+			parent[a.id] = next_id;
+			parent[b.id] = next_id;
+			heap.emplace_back(HeapNode{ a.freq + b.freq, next_id });
+			std::push_heap(heap.begin(), heap.end(), cmp);
+			++next_id;
+		}
+		const uint16_t root = next_id - 1;
+
+		// Internal nodes are created in order, so a parent always has a higher id than its children.
+		std::vector<uint8_t> depth(next_id, 0);
+		for (uint16_t id = root; id-- != num_syms; )
+		{
+			depth[id] = depth[parent[id]] + 1;
+		}
+		uint16_t bl_count[16]{};
+		int overflow = 0;
+		for (const auto& sym : used)
+		{
+			uint8_t d = static_cast<uint8_t>(depth[parent[sym]] + 1);
+			if (d > max_bits)
+			{
+				d = max_bits;
+				++overflow;
+			}
+			++bl_count[d];
+		}
+
+		if (overflow != 0)
+		{
+			// Move leaves from the overflowing level up: take a leaf at depth bits, make it a node with the overflowing leaf and one from bits + 1.
+			do
+			{
+				uint8_t bits = max_bits - 1;
+				while (bl_count[bits] == 0)
+				{
+					--bits;
+				}
+				--bl_count[bits];
+				bl_count[bits + 1] += 2;
+				--bl_count[max_bits];
+				overflow -= 2;
+			} while (overflow > 0);
+		}
+
+		// Give the longest codes to the least frequent symbols.
+		std::sort(used.begin(), used.end(), [freqs](uint16_t a, uint16_t b)
+		{
+			return freqs[a] < freqs[b] || (freqs[a] == freqs[b] && a < b);
+		});
+		auto it = used.begin();
+		for (uint8_t bits = max_bits; bits != 0; --bits)
+		{
+			for (uint16_t n = bl_count[bits]; n != 0; --n)
+			{
+				lengths[*it++] = bits;
+			}
+		}
+	}
+
+	// Turns code lengths into canonical codes as per RFC 1951, bit-reversed since DEFLATE is written starting from the least significant bit.
+	static void buildCodes(const uint8_t* lengths, unsigned num_syms, uint16_t* codes) noexcept
+	{
+		uint16_t bl_count[16]{};
+		for (unsigned i = 0; i != num_syms; ++i)
+		{
+			++bl_count[lengths[i]];
+		}
+		bl_count[0] = 0;
+		uint16_t next_code[16]{};
+		uint16_t code = 0;
+		for (unsigned bits = 1; bits != 16; ++bits)
+		{
+			code = (code + bl_count[bits - 1]) << 1;
+			next_code[bits] = code;
+		}
+		for (unsigned i = 0; i != num_syms; ++i)
+		{
+			const uint8_t len = lengths[i];
+			if (len != 0)
+			{
+				uint16_t c = next_code[len]++;
+				uint16_t rev = 0;
+				for (uint8_t b = 0; b != len; ++b)
+				{
+					rev = (rev << 1) | (c & 1);
+					c >>= 1;
+				}
+				codes[i] = rev;
+			}
+		}
+	}
+
+	// The fixed code as per RFC 1951 section 3.2.6.
+	struct DeflateFixedCode
+	{
+		uint8_t litlen_lengths[288];
+		uint8_t dist_lengths[30];
+		uint16_t litlen_codes[288];
+		uint16_t dist_codes[30];
+
+		DeflateFixedCode() noexcept
+		{
+			for (unsigned i = 0; i != 288; ++i)
+			{
+				litlen_lengths[i] = (i < 144 ? 8 : (i < 256 ? 9 : (i < 280 ? 7 : 8)));
+			}
+			memset(dist_lengths, 5, sizeof(dist_lengths));
+			buildCodes(litlen_lengths, 288, litlen_codes);
+			buildCodes(dist_lengths, 30, dist_codes);
+		}
+	};
+	static const DeflateFixedCode fixed_code{};
+
+	DeflateWriter::DeflateWriter(Writer& out, int level, deflate::Format format) SOUP_EXCAL
+		: out(out), level(static_cast<uint8_t>(level < 0 ? 6 : (level > 9 ? 9 : level))), format(format), checksum(format == deflate::ZLIB ? adler32::INITIAL : crc32::INITIAL)
+	{
+		if (this->level != 0)
+		{
+			head.resize(size_t(1) << HASH_BITS, 0);
+			prev.resize(WINDOW_SIZE, 0);
+		}
+		writeHeader();
+	}
+
+	bool DeflateWriter::raw(void* data, size_t size) noexcept
+	{
+		if (finalised)
+		{
+			return false;
+		}
+		SOUP_TRY
+		{
+			if (format == deflate::ZLIB)
+			{
+				checksum = adler32::hash(reinterpret_cast<const uint8_t*>(data), size, checksum);
+			}
+			else if (format == deflate::GZIP)
+			{
+				checksum = crc32::hash(reinterpret_cast<const uint8_t*>(data), size, checksum);
+			}
+			total_in += size;
+			buf.append(reinterpret_cast<const char*>(data), size);
+			if (buf_base + buf.size() - pos >= BLOCK_INPUT_SIZE)
+			{
+				process(false);
+				return flushOutput();
+			}
+		}
+		SOUP_CATCH_ANY
+		{
+			return false;
+		}
+		return true;
+	}
+
+	bool DeflateWriter::flush() noexcept
+	{
+		if (finalised)
+		{
+			return false;
+		}
+		SOUP_TRY
+		{
+			process(true);
+			emitBlock(false);
+			// An empty stored block to get to a byte boundary, like zlib's Z_SYNC_FLUSH.
+			emitStored(nullptr, 0, false);
+		}
+		SOUP_CATCH_ANY
+		{
+			return false;
+		}
+		return flushOutput();
+	}
+
+	bool DeflateWriter::finalise() noexcept
+	{
+		if (finalised)
+		{
+			return false;
+		}
+		finalised = true;
+		SOUP_TRY
+		{
+			process(true);
+			emitBlock(true);
+			alignToByte();
+			if (format == deflate::ZLIB)
+			{
+				pending_out.push_back(static_cast<char>(checksum >> 24));
+				pending_out.push_back(static_cast<char>(checksum >> 16));
+				pending_out.push_back(static_cast<char>(checksum >> 8));
+				pending_out.push_back(static_cast<char>(checksum));
+			}
+			else if (format == deflate::GZIP)
+			{
+				for (const uint32_t val : { checksum, static_cast<uint32_t>(total_in) })
+				{
+					pending_out.push_back(static_cast<char>(val));
+					pending_out.push_back(static_cast<char>(val >> 8));
+					pending_out.push_back(static_cast<char>(val >> 16));
+					pending_out.push_back(static_cast<char>(val >> 24));
+				}
+			}
+		}
+		SOUP_CATCH_ANY
+		{
+			return false;
+		}
+		return flushOutput();
+	}
+
+	void DeflateWriter::writeHeader() SOUP_EXCAL
+	{
+		if (format == deflate::ZLIB)
+		{
+			// CMF: deflate with a 32K window. FLG: compression level hint, with check bits so that the header is a multiple of 31.
+			const uint8_t flevel = (level < 2 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3)));
+			uint16_t header = (0x78 << 8) | (flevel << 6);
+			header += 31 - (header % 31);
+			pending_out.push_back(static_cast<char>(header >> 8));
+			pending_out.push_back(static_cast<char>(header));
+		}
+		else if (format == deflate::GZIP)
+		{
+			// ID1, ID2, CM = deflate, FLG = 0, MTIME = 0, XFL, OS = unknown
+			pending_out.append("\x1F\x8B\x08\x00\x00\x00\x00\x00", 8);
+			pending_out.push_back(level == 9 ? 2 : (level == 1 ? 4 : 0));
+			pending_out.push_back('\xFF');
+		}
+	}
+
+	void DeflateWriter::process(bool final) SOUP_EXCAL
+	{
+		const size_t end = buf_base + buf.size();
+		// Unless this is the end of the input, keep enough lookahead for the longest possible match.
+		const size_t limit = (final ? end : (end > MAX_MATCH ? end - MAX_MATCH : 0));
+
+		if (level == 0)
+		{
+			processStored(limit);
+			return;
+		}
+
+		const DeflateLevelParams& params = level_params[level];
+		const auto* data = reinterpret_cast<const uint8_t*>(buf.data());
+		while (pos < limit)
+		{
+			if (pos + MIN_MATCH <= end)
+			{
+				insertHash(pos);
+			}
+
+			size_t dist = 0;
+			size_t len = 0;
+			if (params.lazy)
+			{
+				if (!lazy_pending || lazy_len < params.max_lazy)
+				{
+					const unsigned chain = (lazy_pending && lazy_len >= params.good_len ? params.max_chain >> 2 : params.max_chain);
+					len = longestMatch(pos, end, lazy_pending && lazy_len >= MIN_MATCH ? lazy_len : MIN_MATCH - 1, dist, chain, params.nice_len);
+					if (len == MIN_MATCH && dist > 4096)
+					{
+						len = 0; // Too far away to be worth it.
+					}
+				}
+				if (lazy_pending && lazy_len >= MIN_MATCH && len <= lazy_len)
+				{
+					// The match at the previous position is at least as good, so use that.
+					addMatch(lazy_len, lazy_dist);
+					const size_t match_end = pos - 1 + lazy_len;
+					for (++pos; pos != match_end; ++pos)
+					{
+						if (pos + MIN_MATCH <= end)
+						{
+							insertHash(pos);
+						}
+					}
+					lazy_pending = false;
+					continue;
+				}
+				if (lazy_pending)
+				{
+					addLiteral(data[pos - 1 - buf_base]);
+				}
+				lazy_pending = true;
+				lazy_len = static_cast<uint16_t>(len);
+				lazy_dist = static_cast<uint16_t>(dist);
+				++pos;
+			}
+			else
+			{
+				len = longestMatch(pos, end, MIN_MATCH - 1, dist, params.max_chain, params.nice_len);
+				if (len >= MIN_MATCH)
+				{
+					addMatch(len, dist);
+					const size_t match_end = pos + len;
+					if (len <= params.max_lazy)
+					{
+						for (++pos; pos != match_end; ++pos)
+						{
+							if (pos + MIN_MATCH <= end)
+							{
+								insertHash(pos);
+							}
+						}
+					}
+					pos = match_end;
+				}
+				else
+				{
+					addLiteral(data[pos - buf_base]);
+					++pos;
+				}
+			}
+		}
+		if (final && lazy_pending)
+		{
+			// The lookahead is exhausted, so the pending position can only be a literal.
+			addLiteral(data[pos - 1 - buf_base]);
+			lazy_pending = false;
+		}
+		trimBuffer();
+	}
+
+	void DeflateWriter::processStored(size_t limit) SOUP_EXCAL
+	{
+		while (covered < limit)
+		{
+			const size_t chunk = std::min<size_t>(limit - covered, 0xFFFF);
+			emitStored(buf.data() + (covered - buf_base), chunk, false);
+			covered += chunk;
+			pos = covered;
+			block_start = covered;
+		}
+		trimBuffer();
+	}
+
+	void DeflateWriter::insertHash(size_t p) noexcept
+	{
+		const auto* data = reinterpret_cast<const uint8_t*>(buf.data()) + (p - buf_base);
+		const uint32_t h = ((static_cast<uint32_t>(data[0]) << 10) ^ (static_cast<uint32_t>(data[1]) << 5) ^ data[2]) & ((1u << HASH_BITS) - 1);
+		prev[p % WINDOW_SIZE] = head[h];
+		head[h] = p + 1;
+	}
+
+	size_t DeflateWriter::longestMatch(size_t p, size_t limit, size_t prev_len, size_t& match_dist, unsigned max_chain, size_t nice_len) const noexcept
+	{
+		const size_t max_len = std::min(MAX_MATCH, limit - p);
+		if (max_len < MIN_MATCH || max_len <= prev_len)
+		{
+			return 0;
+		}
+		const auto* data = reinterpret_cast<const uint8_t*>(buf.data());
+		const uint8_t* const cur = data + (p - buf_base);
+		size_t best_len = prev_len;
+		size_t cand = prev[p % WINDOW_SIZE]; // head[] now points at p itself
+		for (; cand != 0 && max_chain != 0; --max_chain)
+		{
+			const size_t c = cand - 1;
+			if (c >= p || p - c > WINDOW_SIZE || c < buf_base)
+			{
+				break;
+			}
+			const uint8_t* const m = data + (c - buf_base);
+			if (m[best_len] == cur[best_len] && m[0] == cur[0] && m[1] == cur[1])
+			{
+				size_t len = 2;
+				while (len + 8 <= max_len)
+				{
+					uint64_t a, b;
+					memcpy(&a, m + len, 8);
+					memcpy(&b, cur + len, 8);
+					if (a != b)
+					{
+						break;
+					}
+					len += 8;
+				}
+				while (len < max_len && m[len] == cur[len])
+				{
+					++len;
+				}
+				if (len > best_len)
+				{
+					best_len = len;
+					match_dist = p - c;
+					if (len >= nice_len || len == max_len)
+					{
+						break;
+					}
+				}
+			}
+			cand = prev[c % WINDOW_SIZE];
+		}
+		return best_len > prev_len ? best_len : 0;
+	}
+
+	void DeflateWriter::addLiteral(uint8_t c) SOUP_EXCAL
+	{
+		tokens.emplace_back(Token{ c, 0 });
+		++covered;
+		if (tokens.size() == MAX_BLOCK_TOKENS)
+		{
+			emitBlock(false);
+		}
+	}
+
+	void DeflateWriter::addMatch(size_t len, size_t dist) SOUP_EXCAL
+	{
+		tokens.emplace_back(Token{ static_cast<uint16_t>(len), static_cast<uint16_t>(dist) });
+		covered += len;
+		if (tokens.size() == MAX_BLOCK_TOKENS)
+		{
+			emitBlock(false);
+		}
+	}
+
+	void DeflateWriter::emitBlock(bool last) SOUP_EXCAL
+	{
+		if (level == 0)
+		{
+			emitStored(nullptr, 0, last);
+			return;
+		}
+		if (tokens.empty() && !last)
+		{
+			return;
+		}
+
+		uint32_t litlen_freqs[LITLEN_SYMS]{};
+		uint32_t dist_freqs[DIST_SYMS]{};
+		for (const auto& t : tokens)
+		{
+			if (t.dist == 0)
+			{
+				++litlen_freqs[t.len_or_lit];
+			}
+			else
+			{
+				++litlen_freqs[257 + code_tables.length_code[t.len_or_lit]];
+				++dist_freqs[code_tables.getDistCode(t.dist)];
+			}
+		}
+		litlen_freqs[END_OF_BLOCK] = 1;
+
+		uint8_t litlen_lengths[LITLEN_SYMS];
+		uint8_t dist_lengths[DIST_SYMS];
+		buildLengths(litlen_freqs, LITLEN_SYMS, 15, litlen_lengths);
+		buildLengths(dist_freqs, DIST_SYMS, 15, dist_lengths);
+
+		unsigned hlit = LITLEN_SYMS;
+		while (hlit > 257 && litlen_lengths[hlit - 1] == 0)
+		{
+			--hlit;
+		}
+		unsigned hdist = DIST_SYMS;
+		while (hdist > 1 && dist_lengths[hdist - 1] == 0)
+		{
+			--hdist;
+		}
+
+		// Run-length encode the code lengths: 16 repeats the previous length 3-6 times, 17 and 18 encode runs of zeroes.
+		uint8_t all_lengths[LITLEN_SYMS + DIST_SYMS];
+		memcpy(all_lengths, litlen_lengths, hlit);
+		memcpy(all_lengths + hlit, dist_lengths, hdist);
+		const unsigned num_lengths = hlit + hdist;
+		std::vector<std::pair<uint8_t, uint8_t>> rle{}; // symbol, extra bits value
+		uint32_t codelen_freqs[CODELEN_SYMS]{};
+		for (unsigned i = 0; i != num_lengths; )
+		{
+			const uint8_t len = all_lengths[i];
+			unsigned run = 1;
+			while (i + run != num_lengths && all_lengths[i + run] == len)
+			{
+				++run;
+			}
+			i += run;
+			if (len == 0)
+			{
+				while (run >= 11)
+				{
+					const unsigned n = std::min(run, 138u);
+					rle.emplace_back(18, static_cast<uint8_t>(n - 11));
+					run -= n;
+				}
+				if (run >= 3)
+				{
+					rle.emplace_back(17, static_cast<uint8_t>(run - 3));
+					run = 0;
+				}
+			}
+			else
+			{
+				rle.emplace_back(len, 0);
+				--run;
+				while (run >= 3)
+				{
+					const unsigned n = std::min(run, 6u);
+					rle.emplace_back(16, static_cast<uint8_t>(n - 3));
+					run -= n;
+				}
+			}
+			for (; run != 0; --run)
+			{
+				rle.emplace_back(len, 0);
+			}
+		}
+		for (const auto& e : rle)
+		{
+			++codelen_freqs[e.first];
+		}
+		uint8_t codelen_lengths[CODELEN_SYMS];
+		buildLengths(codelen_freqs, CODELEN_SYMS, 7, codelen_lengths);
+		unsigned hclen = CODELEN_SYMS;
+		while (hclen > 4 && codelen_lengths[codelen_order[hclen - 1]] == 0)
+		{
+			--hclen;
+		}
+
+		// Work out which block type is the smallest.
+		size_t dynamic_bits = 5 + 5 + 4 + (3 * hclen);
+		for (const auto& e : rle)
+		{
+			dynamic_bits += codelen_lengths[e.first];
+			dynamic_bits += (e.first == 16 ? 2 : (e.first == 17 ? 3 : (e.first == 18 ? 7 : 0)));
+		}
+		size_t fixed_bits = 0;
+		for (unsigned i = 0; i != LITLEN_SYMS; ++i)
+		{
+			const size_t extra = (i >= 257 ? length_extra[i - 257] : 0);
+			dynamic_bits += litlen_freqs[i] * (litlen_lengths[i] + extra);
+			fixed_bits += litlen_freqs[i] * (fixed_code.litlen_lengths[i] + extra);
+		}
+		for (unsigned i = 0; i != DIST_SYMS; ++i)
+		{
+			dynamic_bits += dist_freqs[i] * (dist_lengths[i] + dist_extra[i]);
+			fixed_bits += dist_freqs[i] * (5 + dist_extra[i]);
+		}
+		const size_t block_size = covered - block_start;
+		const size_t stored_bits = ((block_size / 0xFFFF) + 1) * (3 + 7 + 32) + (block_size * 8);
+
+		if (stored_bits < dynamic_bits && stored_bits < fixed_bits)
+		{
+			const char* data = buf.data() + (block_start - buf_base);
+			size_t remaining = block_size;
+			do
+			{
+				const size_t chunk = std::min<size_t>(remaining, 0xFFFF);
+				emitStored(data, chunk, last && chunk == remaining);
+				data += chunk;
+				remaining -= chunk;
+			} while (remaining != 0);
+		}
+		else if (fixed_bits <= dynamic_bits)
+		{
+			putBits(last ? 1 : 0, 1);
+			putBits(1, 2);
+			emitTokens(fixed_code.litlen_lengths, fixed_code.litlen_codes, fixed_code.dist_lengths, fixed_code.dist_codes);
+		}
+		else
+		{
+			uint16_t litlen_codes[LITLEN_SYMS];
+			uint16_t dist_codes[DIST_SYMS];
+			uint16_t codelen_codes[CODELEN_SYMS];
+			buildCodes(litlen_lengths, LITLEN_SYMS, litlen_codes);
+			buildCodes(dist_lengths, DIST_SYMS, dist_codes);
+			buildCodes(codelen_lengths, CODELEN_SYMS, codelen_codes);
+
+			putBits(last ? 1 : 0, 1);
+			putBits(2, 2);
+			putBits(hlit - 257, 5);
+			putBits(hdist - 1, 5);
+			putBits(hclen - 4, 4);
+			for (unsigned i = 0; i != hclen; ++i)
+			{
+				putBits(codelen_lengths[codelen_order[i]], 3);
+			}
+			for (const auto& e : rle)
+			{
+				putBits(codelen_codes[e.first], codelen_lengths[e.first]);
+				if (e.first == 16)
+				{
+					putBits(e.second, 2);
+				}
+				else if (e.first == 17)
+				{
+					putBits(e.second, 3);
+				}
+				else if (e.first == 18)
+				{
+					putBits(e.second, 7);
+				}
+			}
+			emitTokens(litlen_lengths, litlen_codes, dist_lengths, dist_codes);
+		}
+
+		tokens.clear();
+		block_start = covered;
+	}
+
+	void DeflateWriter::emitStored(const char* data, size_t size, bool last) SOUP_EXCAL
+	{
+		putBits(last ? 1 : 0, 1);
+		putBits(0, 2);
+		alignToByte();
+		putBits(static_cast<uint16_t>(size), 16);
+		putBits(static_cast<uint16_t>(~size), 16);
+		pending_out.append(data, size);
+	}
+
+	void DeflateWriter::emitTokens(const uint8_t* litlen_lengths, const uint16_t* litlen_codes, const uint8_t* dist_lengths, const uint16_t* dist_codes) SOUP_EXCAL
+	{
+		for (const auto& t : tokens)
+		{
+			if (t.dist == 0)
+			{
+				putBits(litlen_codes[t.len_or_lit], litlen_lengths[t.len_or_lit]);
+			}
+			else
+			{
+				const uint8_t lc = code_tables.length_code[t.len_or_lit];
+				putBits(litlen_codes[257 + lc], litlen_lengths[257 + lc]);
+				putBits(t.len_or_lit - length_base[lc], length_extra[lc]);
+				const uint8_t dc = code_tables.getDistCode(t.dist);
+				putBits(dist_codes[dc], dist_lengths[dc]);
+				putBits(t.dist - dist_base[dc], dist_extra[dc]);
+			}
+		}
+		putBits(litlen_codes[END_OF_BLOCK], litlen_lengths[END_OF_BLOCK]);
+	}
+
+	void DeflateWriter::trimBuffer() SOUP_EXCAL
+	{
+		// Keep the window for matches and everything that might still need to go into a stored block.
+		size_t keep_from = (pos > WINDOW_SIZE ? pos - WINDOW_SIZE : 0);
+		if (keep_from > block_start)
+		{
+			keep_from = block_start;
+		}
+		if (keep_from > buf_base + (buf.size() / 2))
+		{
+			buf.erase(0, keep_from - buf_base);
+			buf_base = keep_from;
+		}
+	}
+
+	bool DeflateWriter::flushOutput() noexcept
+	{
+		if (pending_out.empty())
+		{
+			return true;
+		}
+		const bool ret = out.raw(pending_out.data(), pending_out.size());
+		pending_out.clear();
+		return ret;
+	}
+}
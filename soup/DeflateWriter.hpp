@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "deflate.hpp"
+#include "Writer.hpp"
+
+NAMESPACE_SOUP
+{
+	// Compresses everything written to it and passes the result on to another Writer.
+	// Input is buffered until enough has accumulated for a block, so call flush() if the peer needs to see the data now, and finalise() at the end.
+	class DeflateWriter final : public Writer
+	{
+	public:
+		static constexpr size_t WINDOW_SIZE = 0x8000;
+		static constexpr size_t MIN_MATCH = 3;
+		static constexpr size_t MAX_MATCH = 258;
+
+	protected:
+		static constexpr unsigned HASH_BITS = 15;
+		static constexpr size_t BLOCK_INPUT_SIZE = 0x20000; // How much input we buffer before compressing it.
+		static constexpr size_t MAX_BLOCK_TOKENS = 0x4000;
+
+		struct Token
+		{
+			uint16_t len_or_lit;
+			uint16_t dist; // 0 for literals
+		};
+
+		Writer& out;
+		uint8_t level;
+		deflate::Format format;
+		bool finalised = false;
+		uint32_t checksum;
+		size_t total_in = 0;
+
+		// Matcher state. Positions are absolute, i.e. counted from the start of the stream.
+		std::string buf{};
+		size_t buf_base = 0; // absolute position of buf[0]
+		size_t pos = 0; // next position to be processed
+		size_t covered = 0; // end of the data that has been turned into tokens
+		size_t block_start = 0;
+		std::vector<size_t> head; // hash -> 1 + position, or 0
+		std::vector<size_t> prev; // position % WINDOW_SIZE -> 1 + previous position with the same hash, or 0
+		bool lazy_pending = false;
+		uint16_t lazy_len = 0;
+		uint16_t lazy_dist = 0;
+		std::vector<Token> tokens{};
+
+		// Bit output
+		uint64_t bit_buf = 0;
+		uint8_t bit_count = 0;
+		std::string pending_out{};
+
+	public:
+		DeflateWriter(Writer& out, int level = 6, deflate::Format format = deflate::ZLIB) SOUP_EXCAL;
+
+		~DeflateWriter() final = default;
+
+		bool raw(void* data, size_t size) noexcept final;
+
+		[[nodiscard]] size_t getPosition() final
+		{
+			return total_in;
+		}
+
+		// Compresses all buffered input and aligns the output to a byte boundary, so everything written so far can be decompressed by the peer.
+		bool flush() noexcept;
+
+		// Compresses all buffered input, terminates the stream, and writes the checksum if the format has one. No more data can be written afterwards.
+		bool finalise() noexcept;
+
+	protected:
+		void writeHeader() SOUP_EXCAL;
+		void process(bool final) SOUP_EXCAL;
+		void processStored(size_t limit) SOUP_EXCAL;
+		void insertHash(size_t p) noexcept;
+		[[nodiscard]] size_t longestMatch(size_t p, size_t limit, size_t prev_len, size_t& match_dist, unsigned max_chain, size_t nice_len) const noexcept;
+		void addLiteral(uint8_t c) SOUP_EXCAL;
+		void addMatch(size_t len, size_t dist) SOUP_EXCAL;
+		void emitBlock(bool last) SOUP_EXCAL;
+		void emitStored(const char* data, size_t size, bool last) SOUP_EXCAL;
+		void emitTokens(const uint8_t* litlen_lengths, const uint16_t* litlen_codes, const uint8_t* dist_lengths, const uint16_t* dist_codes) SOUP_EXCAL;
+		void trimBuffer() SOUP_EXCAL;
+		[[nodiscard]] bool flushOutput() noexcept;
+
+		void putBits(uint32_t value, uint8_t count) SOUP_EXCAL
+		{
+			bit_buf |= (static_cast<uint64_t>(value) << bit_count);
+			bit_count += count;
+			while (bit_count >= 8)
+			{
+				pending_out.push_back(static_cast<char>(bit_buf));
+				bit_buf >>= 8;
+				bit_count -= 8;
+			}
+		}
+
+		void alignToByte() SOUP_EXCAL
+		{
+			if (bit_count != 0)
+			{
+				putBits(0, 8 - bit_count);
+			}
+		}
+	};
+}
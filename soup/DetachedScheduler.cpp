@@ -106,7 +106,7 @@ NAMESPACE_SOUP
 		{
 			netConfig::get() = std::move(conf);
 			run();
-			workers.clear();
+			clearWorkers();
 			passive_workers = 0;
 			conf = std::move(netConfig::get());
 		} while (!pending_workers.empty());
@@ -59,6 +59,19 @@ NAMESPACE_SOUP
 			return s.rdstate() == 0;
 		}
 
+		[[nodiscard]] size_t read(void* data, size_t max) noexcept final
+		{
+			SOUP_TRY
+			{
+				s.read(reinterpret_cast<char*>(data), max);
+				return static_cast<size_t>(s.gcount());
+			}
+			SOUP_CATCH_ANY
+			{
+			}
+			return 0;
+		}
+
 		bool getLine(std::string& line) SOUP_EXCAL final
 		{
 			if (Reader::getLine(line))
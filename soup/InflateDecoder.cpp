@@ -0,0 +1,1092 @@
+#include "InflateDecoder.hpp"
+
+#include <cstring> // memcpy, memset
+
+/*
+Original source: https://github.com/Artexety/inflatecpp
+Original licence follows.
+
+Copyright (c) 2020 Artexety
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#if SOUP_BITS >= 64
+#define X64BIT_SHIFTER
+#endif
+
+NAMESPACE_SOUP
+{
+	#define MATCHLEN_PAIR(__base,__dispbits) ((__base) | ((__dispbits) << 16) | 0x8000)
+	#define OFFSET_PAIR(__base,__dispbits) ((__base) | ((__dispbits) << 16))
+
+	constexpr auto kCodeLenBits = 3;
+	constexpr auto kLiteralSyms = 288;
+	constexpr auto kEODMarkerSym = 256;
+	constexpr auto kMatchLenSymStart = 257;
+	constexpr auto kMatchLenSyms = 29;
+	constexpr auto kOffsetSyms = 32;
+	constexpr auto kMinMatchSize = 3;
+
+	constexpr unsigned int kMatchLenCode[kMatchLenSyms] = {
+	   MATCHLEN_PAIR(kMinMatchSize + 0, 0), MATCHLEN_PAIR(kMinMatchSize + 1, 0), MATCHLEN_PAIR(kMinMatchSize + 2, 0), MATCHLEN_PAIR(kMinMatchSize + 3, 0), MATCHLEN_PAIR(kMinMatchSize + 4, 0),
+	   MATCHLEN_PAIR(kMinMatchSize + 5, 0), MATCHLEN_PAIR(kMinMatchSize + 6, 0), MATCHLEN_PAIR(kMinMatchSize + 7, 0), MATCHLEN_PAIR(kMinMatchSize + 8, 1), MATCHLEN_PAIR(kMinMatchSize + 10, 1),
+	   MATCHLEN_PAIR(kMinMatchSize + 12, 1), MATCHLEN_PAIR(kMinMatchSize + 14, 1), MATCHLEN_PAIR(kMinMatchSize + 16, 2), MATCHLEN_PAIR(kMinMatchSize + 20, 2), MATCHLEN_PAIR(kMinMatchSize + 24, 2),
+	   MATCHLEN_PAIR(kMinMatchSize + 28, 2), MATCHLEN_PAIR(kMinMatchSize + 32, 3), MATCHLEN_PAIR(kMinMatchSize + 40, 3), MATCHLEN_PAIR(kMinMatchSize + 48, 3), MATCHLEN_PAIR(kMinMatchSize + 56, 3),
+	   MATCHLEN_PAIR(kMinMatchSize + 64, 4), MATCHLEN_PAIR(kMinMatchSize + 80, 4), MATCHLEN_PAIR(kMinMatchSize + 96, 4), MATCHLEN_PAIR(kMinMatchSize + 112, 4), MATCHLEN_PAIR(kMinMatchSize + 128, 5),
+	   MATCHLEN_PAIR(kMinMatchSize + 160, 5), MATCHLEN_PAIR(kMinMatchSize + 192, 5), MATCHLEN_PAIR(kMinMatchSize + 224, 5), MATCHLEN_PAIR(kMinMatchSize + 255, 0),
+	};
+
+	constexpr unsigned int kOffsetCode[kOffsetSyms] = {
+	   OFFSET_PAIR(1, 0), OFFSET_PAIR(2, 0), OFFSET_PAIR(3, 0), OFFSET_PAIR(4, 0), OFFSET_PAIR(5, 1), OFFSET_PAIR(7, 1), OFFSET_PAIR(9, 2), OFFSET_PAIR(13, 2), OFFSET_PAIR(17, 3), OFFSET_PAIR(25, 3),
+	   OFFSET_PAIR(33, 4), OFFSET_PAIR(49, 4), OFFSET_PAIR(65, 5), OFFSET_PAIR(97, 5), OFFSET_PAIR(129, 6), OFFSET_PAIR(193, 6), OFFSET_PAIR(257, 7), OFFSET_PAIR(385, 7), OFFSET_PAIR(513, 8), OFFSET_PAIR(769, 8),
+	   OFFSET_PAIR(1025, 9), OFFSET_PAIR(1537, 9), OFFSET_PAIR(2049, 10), OFFSET_PAIR(3073, 10), OFFSET_PAIR(4097, 11), OFFSET_PAIR(6145, 11), OFFSET_PAIR(8193, 12), OFFSET_PAIR(12289, 12), OFFSET_PAIR(16385, 13), OFFSET_PAIR(24577, 13),
+	};
+
+	constexpr auto kMaxSymbols = 288;
+	constexpr auto kCodeLenSyms = 19;
+
+	/**
+	 * Prepare huffman tables
+	 *
+	 * @param rev_symbol_table array of 2 * symbols entries for storing the reverse lookup table
+	 * @param code_length codeword lengths table
+	 */
+	bool InflateDecoder::HuffmanDecoder::prepareTable(unsigned int* rev_symbol_table, const int read_symbols, const int symbols, unsigned char* code_length)
+	{
+		int num_symbols_per_len[16];
+		int i;
+
+		if (read_symbols < 0 || read_symbols > kMaxSymbols || symbols < 0 || symbols > kMaxSymbols || read_symbols > symbols)
+		{
+			return false;
+		}
+		this->symbols_ = symbols;
+
+
+		for (i = 0; i < 16; ++i)
+			num_symbols_per_len[i] = 0;
+
+		for (i = 0; i < read_symbols; ++i)
+		{
+			if (code_length[i] >= 16)
+			{
+				return false;
+			}
+			num_symbols_per_len[code_length[i]]++;
+		}
+
+		this->starting_pos_[0] = 0;
+		this->num_sorted_ = 0;
+		for (i = 1; i != 16; ++i)
+		{
+			this->starting_pos_[i] = this->num_sorted_;
+			this->num_sorted_ += num_symbols_per_len[i];
+		}
+
+		for (i = 0; i < symbols; ++i)
+			rev_symbol_table[i] = -1;
+
+		for (i = 0; i < read_symbols; ++i)
+		{
+			if (code_length[i])
+				rev_symbol_table[this->starting_pos_[code_length[i]]++] = i;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Finalize huffman codewords for decoding
+	 *
+	 * @param rev_symbol_table array of 2 * symbols entries that contains the reverse lookup table
+	 */
+	bool InflateDecoder::HuffmanDecoder::finaliseTable(unsigned int* rev_symbol_table)
+	{
+		const int symbols = this->symbols_;
+		unsigned int canonical_code_word = 0;
+		unsigned int* rev_code_length_table = rev_symbol_table + symbols;
+		int canonical_length = 1;
+		int i;
+
+		for (i = 0; i != (1 << kFastSymbolBits); ++i)
+		{
+			this->fast_symbol_[i] = 0;
+		}
+		for (i = 0; i != 16; ++i)
+		{
+			this->start_index_[i] = 0;
+		}
+
+		i = 0;
+		while (i < this->num_sorted_)
+		{
+			if (canonical_length >= 16)
+			{
+				return false;
+			}
+			this->start_index_[canonical_length] = i - canonical_code_word;
+
+			while (i < this->starting_pos_[canonical_length])
+			{
+				if (i >= symbols)
+				{
+					return false;
+				}
+				rev_code_length_table[i] = canonical_length;
+
+				if (canonical_code_word >= (1U << canonical_length))
+				{
+					return false;
+				}
+
+				if (canonical_length <= kFastSymbolBits)
+				{
+					unsigned int rev_word;
+
+					/* Get upside down codeword (branchless method by Eric Biggers) */
+					rev_word = ((canonical_code_word & 0x5555) << 1) | ((canonical_code_word & 0xaaaa) >> 1);
+					rev_word = ((rev_word & 0x3333) << 2) | ((rev_word & 0xcccc) >> 2);
+					rev_word = ((rev_word & 0x0f0f) << 4) | ((rev_word & 0xf0f0) >> 4);
+					rev_word = ((rev_word & 0x00ff) << 8) | ((rev_word & 0xff00) >> 8);
+					rev_word = rev_word >> (16 - canonical_length);
+
+					int slots = 1 << (kFastSymbolBits - canonical_length);
+					while (slots)
+					{
+						this->fast_symbol_[rev_word] = (rev_symbol_table[i] & 0xffffff) | (canonical_length << 24);
+						rev_word += (1 << canonical_length);
+						slots--;
+					}
+				}
+
+				i++;
+				canonical_code_word++;
+			}
+			canonical_length++;
+			canonical_code_word <<= 1;
+		}
+
+		while (i < symbols)
+		{
+			rev_symbol_table[i] = -1;
+			rev_code_length_table[i++] = 0;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Read fixed bit size code lengths
+	 *
+	 * @param len_bits number of bits per code length
+	 * @param read_symbols number of symbols actually read
+	 * @param symbols number of symbols to build codes for
+	 * @param code_length output code lengths table
+	 * @param bit_reader bit reader context
+	 */
+	bool InflateDecoder::HuffmanDecoder::readRawLengths(const int len_bits, const int read_symbols, const int symbols, unsigned char* code_length, DeflateBitReader& bit_reader)
+	{
+		const unsigned char code_len_syms[kCodeLenSyms] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+		int i;
+
+		if (read_symbols < 0 || read_symbols > kMaxSymbols || symbols < 0 || symbols > kMaxSymbols || read_symbols > symbols)
+			return false;
+
+		i = 0;
+		while (i < read_symbols)
+		{
+			unsigned int length = bit_reader.getBits(len_bits);
+			if (length == (unsigned int)-1)
+				return false;
+
+			code_length[code_len_syms[i++]] = length;
+		}
+
+		while (i < symbols)
+		{
+			code_length[code_len_syms[i++]] = 0;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Read huffman-encoded code lengths
+	 *
+	 * @param tables_rev_symbol_table reverse lookup table for code lengths
+	 * @param read_symbols number of symbols actually read
+	 * @param symbols number of symbols to build codes for
+	 * @param code_length output code lengths table
+	 * @param bit_reader bit reader context
+	 */
+	bool InflateDecoder::HuffmanDecoder::readLength(const unsigned int* tables_rev_symbol_table, const int read_symbols, const int symbols, unsigned char* code_length, DeflateBitReader& bit_reader)
+	{
+		int i;
+		if (read_symbols < 0 || symbols < 0 || read_symbols > symbols)
+			return false;
+
+		i = 0;
+		unsigned int previous_length = 0;
+
+		while (i < read_symbols)
+		{
+			unsigned int length = this->readValue(tables_rev_symbol_table, bit_reader);
+			if (length == (unsigned int)-1)
+				return false;
+
+			if (length < 16)
+			{
+				previous_length = length;
+				code_length[i++] = previous_length;
+			}
+			else
+			{
+				unsigned int run_length = 0;
+
+				if (length == 16)
+				{
+					int extra_run_length = bit_reader.getBits(2);
+					if (extra_run_length == -1)
+						return false;
+					run_length = 3 + extra_run_length;
+				}
+				else if (length == 17)
+				{
+					int extra_run_length = bit_reader.getBits(3);
+					if (extra_run_length == -1)
+						return false;
+					previous_length = 0;
+					run_length = 3 + extra_run_length;
+				}
+				else if (length == 18)
+				{
+					int extra_run_length = bit_reader.getBits(7);
+					if (extra_run_length == -1)
+						return false;
+					previous_length = 0;
+					run_length = 11 + extra_run_length;
+				}
+
+				while (run_length && i < read_symbols)
+				{
+					code_length[i++] = previous_length;
+					run_length--;
+				}
+			}
+		}
+
+		while (i < symbols)
+			code_length[i++] = 0;
+		return true;
+	}
+
+	/**
+	 * Decode next symbol
+	 *
+	 * @param rev_symbol_table reverse lookup table
+	 * @param bit_reader bit reader context
+	 *
+	 * @return symbol, or -1 for error
+	 */
+	unsigned int InflateDecoder::HuffmanDecoder::readValue(const unsigned int* rev_symbol_table, DeflateBitReader& bit_reader)
+	{
+		unsigned int stream = bit_reader.peekBits();
+		unsigned int fast_sym_bits = this->fast_symbol_[stream & ((1 << kFastSymbolBits) - 1)];
+		if (fast_sym_bits)
+		{
+			bit_reader.consumeBits(fast_sym_bits >> 24);
+			return fast_sym_bits & 0xffffff;
+		}
+		const unsigned int* rev_code_length_table = rev_symbol_table + this->symbols_;
+		unsigned int code_word = 0;
+		int bits = 1;
+
+		do
+		{
+			code_word |= (stream & 1);
+
+			unsigned int table_index = this->start_index_[bits] + code_word;
+			if (table_index < this->symbols_)
+			{
+				if ((unsigned int)bits == rev_code_length_table[table_index])
+				{
+					bit_reader.consumeBits(bits);
+					return rev_symbol_table[table_index];
+				}
+			}
+			code_word <<= 1;
+			stream >>= 1;
+			bits++;
+		} while (bits < 16);
+
+		return -1;
+	}
+
+#ifdef X64BIT_SHIFTER
+	// Table-driven decoding: a single lookup resolves a codeword to its literal, or to its length/distance base and number of extra bits.
+	// Codewords longer than the primary table's bits are resolved through a second-level table.
+	// Entry layout: bits 0-3 = codeword length, bits 4-7 = extra bits (subtable bits for subtable pointers), bits 8-15 = flags, bits 16-31 = value.
+
+	constexpr unsigned int kFastEntryLiteral = 0x100;
+	constexpr unsigned int kFastEntryEndOfBlock = 0x200;
+	constexpr unsigned int kFastEntrySubtable = 0x400;
+	constexpr unsigned int kFastEntryInvalid = 0x800;
+
+	constexpr auto kFastLiteralBits = 10;
+	constexpr auto kFastLiteralTableSize = (1 << kFastLiteralBits) + 1024;
+	constexpr auto kFastOffsetBits = 8;
+	constexpr auto kFastOffsetTableSize = (1 << kFastOffsetBits) + 512;
+
+	struct FastSymbolValues
+	{
+		unsigned int literals[kLiteralSyms];
+		unsigned int offsets[kOffsetSyms];
+
+		FastSymbolValues() noexcept
+		{
+			for (unsigned int i = 0; i != 256; ++i)
+			{
+				literals[i] = (i << 16) | kFastEntryLiteral;
+			}
+			literals[kEODMarkerSym] = kFastEntryEndOfBlock;
+			for (unsigned int i = 0; i != kMatchLenSyms; ++i)
+			{
+				literals[kMatchLenSymStart + i] = ((kMatchLenCode[i] & 0x7fff) << 16) | (((kMatchLenCode[i] >> 16) & 15) << 4);
+			}
+			literals[286] = kFastEntryInvalid;
+			literals[287] = kFastEntryInvalid;
+			for (unsigned int i = 0; i != 30; ++i)
+			{
+				offsets[i] = ((kOffsetCode[i] & 0x7fff) << 16) | (((kOffsetCode[i] >> 16) & 15) << 4);
+			}
+			offsets[30] = kFastEntryInvalid;
+			offsets[31] = kFastEntryInvalid;
+		}
+	};
+	static const FastSymbolValues fast_symbol_values{};
+
+	// Returns false if the code is over-subscribed or would need more subtable space than we have; the slow path can deal with the latter.
+	static bool buildFastTable(const unsigned char* code_length, const unsigned int symbols, const unsigned int* values, const unsigned int primary_bits, unsigned int* table, const unsigned int table_size)
+	{
+		unsigned int num_symbols_per_len[16] = {};
+		for (unsigned int i = 0; i != symbols; ++i)
+		{
+			num_symbols_per_len[code_length[i]]++;
+		}
+		num_symbols_per_len[0] = 0;
+
+		int left = 1;
+		unsigned int next_code[16];
+		unsigned int code = 0;
+		for (unsigned int len = 1; len != 16; ++len)
+		{
+			left = (left << 1) - num_symbols_per_len[len];
+			if (left < 0)
+			{
+				return false;
+			}
+			code = (code + num_symbols_per_len[len - 1]) << 1;
+			next_code[len] = code;
+		}
+
+		const unsigned int primary_size = (1 << primary_bits);
+		for (unsigned int i = 0; i != primary_size; ++i)
+		{
+			table[i] = kFastEntryInvalid;
+		}
+
+		unsigned short rev_codes[kLiteralSyms];
+		unsigned char subtable_bits[1 << kFastLiteralBits] = {};
+		for (unsigned int i = 0; i != symbols; ++i)
+		{
+			const unsigned int len = code_length[i];
+			if (len != 0)
+			{
+				unsigned int c = next_code[len]++;
+				unsigned int rev = 0;
+				for (unsigned int b = 0; b != len; ++b)
+				{
+					rev = (rev << 1) | (c & 1);
+					c >>= 1;
+				}
+				rev_codes[i] = rev;
+				if (len > primary_bits && (len - primary_bits) > subtable_bits[rev & (primary_size - 1)])
+				{
+					subtable_bits[rev & (primary_size - 1)] = len - primary_bits;
+				}
+			}
+		}
+
+		unsigned int next_free = primary_size;
+		for (unsigned int i = 0; i != primary_size; ++i)
+		{
+			if (subtable_bits[i] != 0)
+			{
+				const unsigned int size = (1 << subtable_bits[i]);
+				if (next_free + size > table_size)
+				{
+					return false;
+				}
+				table[i] = (next_free << 16) | kFastEntrySubtable | (subtable_bits[i] << 4) | primary_bits;
+				for (unsigned int j = 0; j != size; ++j)
+				{
+					table[next_free + j] = kFastEntryInvalid;
+				}
+				next_free += size;
+			}
+		}
+
+		for (unsigned int i = 0; i != symbols; ++i)
+		{
+			const unsigned int len = code_length[i];
+			if (len == 0)
+			{
+				continue;
+			}
+			const unsigned int rev = rev_codes[i];
+			if (len <= primary_bits)
+			{
+				for (unsigned int j = rev; j < primary_size; j += (1 << len))
+				{
+					table[j] = values[i] | len;
+				}
+			}
+			else
+			{
+				const unsigned int pointer = table[rev & (primary_size - 1)];
+				const unsigned int sub_len = len - primary_bits;
+				for (unsigned int j = (rev >> primary_bits); j < (1u << ((pointer >> 4) & 15)); j += (1 << sub_len))
+				{
+					table[(pointer >> 16) + j] = values[i] | sub_len;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	struct FastFixedTables
+	{
+		unsigned int literals[kFastLiteralTableSize];
+		unsigned int offsets[kFastOffsetTableSize];
+
+		FastFixedTables() noexcept
+		{
+			unsigned char code_length[kLiteralSyms + kOffsetSyms];
+			int i;
+			for (i = 0; i < 144; i++)
+				code_length[i] = 8;
+			for (; i < 256; i++)
+				code_length[i] = 9;
+			for (; i < 280; i++)
+				code_length[i] = 7;
+			for (; i < kLiteralSyms; i++)
+				code_length[i] = 8;
+			for (; i < kLiteralSyms + kOffsetSyms; i++)
+				code_length[i] = 5;
+
+			buildFastTable(code_length, kLiteralSyms, fast_symbol_values.literals, kFastLiteralBits, literals, kFastLiteralTableSize);
+			buildFastTable(code_length + kLiteralSyms, kOffsetSyms, fast_symbol_values.offsets, kFastOffsetBits, offsets, kFastOffsetTableSize);
+		}
+	};
+
+	InflateDecoder::Status InflateDecoder::decodeSymbolsFast(uint8_t* out, size_t& out_pos, size_t out_size) noexcept
+	{
+		const unsigned int* const literal_table = fast_literal_table;
+		const unsigned int* const offset_table = fast_offset_table;
+		shifter_t bits = br.getShifterData();
+		unsigned int bit_count = br.getShifterBitCount();
+		const unsigned char* in = br.getInBlock();
+		const unsigned char* const in_end = br.getInBlockEnd();
+		unsigned char* current_out = out + out_pos;
+		unsigned char* const out_end = out + out_size;
+		Status status = CORRUPT;
+		bool short_input = false;
+
+		while (true)
+		{
+			// A length/distance pair needs at most 15 + 5 + 15 + 13 bits.
+			if (bit_count < 48)
+			{
+				SOUP_IF_LIKELY ((in_end - in) >= 8)
+				{
+					// Branchless refill: load 8 bytes, but only count the whole bytes that fit. The bits of the partial byte are loaded again next time.
+					uint64_t word;
+					if constexpr (ENDIAN_NATIVE == ENDIAN_LITTLE)
+					{
+						memcpy(&word, in, 8);
+					}
+					else
+					{
+						word = 0;
+						for (int i = 0; i != 8; ++i)
+						{
+							word |= ((uint64_t)in[i] << (i * 8));
+						}
+					}
+					bits |= (word << bit_count);
+					in += (63 - bit_count) >> 3;
+					bit_count |= 56;
+				}
+				else
+				{
+					while (bit_count <= 56 && in != in_end)
+					{
+						bits |= ((shifter_t)*in++ << bit_count);
+						bit_count += 8;
+					}
+					if (bit_count < 48 && more_input)
+					{
+						status = NEED_INPUT;
+						break;
+					}
+				}
+			}
+
+			// Where to resume if the symbol doesn't fit into the output.
+			const shifter_t symbol_bits = bits;
+			const unsigned int symbol_bit_count = bit_count;
+
+			unsigned int entry = literal_table[bits & ((1 << kFastLiteralBits) - 1)];
+			if (entry & kFastEntrySubtable)
+			{
+				SOUP_IF_UNLIKELY (bit_count < kFastLiteralBits)
+				{
+					bits = symbol_bits;
+					bit_count = symbol_bit_count;
+					short_input = true;
+					break;
+				}
+				bits >>= kFastLiteralBits;
+				bit_count -= kFastLiteralBits;
+				entry = literal_table[(entry >> 16) + (bits & ((1 << ((entry >> 4) & 15)) - 1))];
+			}
+			SOUP_IF_UNLIKELY (entry & kFastEntryInvalid)
+			{
+				break;
+			}
+			unsigned int len = (entry & 15);
+			SOUP_IF_UNLIKELY (len > bit_count)
+			{
+				bits = symbol_bits;
+				bit_count = symbol_bit_count;
+				short_input = true;
+				break;
+			}
+			bits >>= len;
+			bit_count -= len;
+
+			if (entry & kFastEntryLiteral)
+			{
+				SOUP_IF_UNLIKELY (current_out == out_end)
+				{
+					bits = symbol_bits;
+					bit_count = symbol_bit_count;
+					status = OUTPUT_FULL;
+					break;
+				}
+				*current_out++ = (unsigned char)(entry >> 16);
+				continue;
+			}
+			if (entry & kFastEntryEndOfBlock)
+			{
+				status = END_OF_BLOCK;
+				break;
+			}
+
+			unsigned int extra = ((entry >> 4) & 15);
+			SOUP_IF_UNLIKELY (extra > bit_count)
+			{
+				bits = symbol_bits;
+				bit_count = symbol_bit_count;
+				short_input = true;
+				break;
+			}
+			const size_t match_length = (entry >> 16) + (bits & ((1 << extra) - 1));
+			bits >>= extra;
+			bit_count -= extra;
+
+			entry = offset_table[bits & ((1 << kFastOffsetBits) - 1)];
+			if (entry & kFastEntrySubtable)
+			{
+				SOUP_IF_UNLIKELY (bit_count < kFastOffsetBits)
+				{
+					bits = symbol_bits;
+					bit_count = symbol_bit_count;
+					short_input = true;
+					break;
+				}
+				bits >>= kFastOffsetBits;
+				bit_count -= kFastOffsetBits;
+				entry = offset_table[(entry >> 16) + (bits & ((1 << ((entry >> 4) & 15)) - 1))];
+			}
+			SOUP_IF_UNLIKELY (entry & kFastEntryInvalid)
+			{
+				break;
+			}
+			len = (entry & 15);
+			extra = ((entry >> 4) & 15);
+			SOUP_IF_UNLIKELY (len + extra > bit_count)
+			{
+				bits = symbol_bits;
+				bit_count = symbol_bit_count;
+				short_input = true;
+				break;
+			}
+			bits >>= len;
+			const size_t match_offset = (entry >> 16) + (bits & ((1 << extra) - 1));
+			bits >>= extra;
+			bit_count -= len + extra;
+
+			SOUP_IF_UNLIKELY (match_offset > (size_t)(current_out - out))
+			{
+				break;
+			}
+			SOUP_IF_UNLIKELY (match_length > (size_t)(out_end - current_out))
+			{
+				bits = symbol_bits;
+				bit_count = symbol_bit_count;
+				status = OUTPUT_FULL;
+				break;
+			}
+
+			const unsigned char* src = current_out - match_offset;
+			unsigned char* dst = current_out;
+			current_out += match_length;
+			if ((size_t)(out_end - current_out) >= 16)
+			{
+				// Wide copies may write past the end of the match, which is fine since the space is free and will be overwritten.
+				if (match_offset >= 16)
+				{
+					do
+					{
+						memcpy(dst, src, 16);
+						src += 16;
+						dst += 16;
+					} while (dst < current_out);
+					continue;
+				}
+				if (match_offset >= 8)
+				{
+					do
+					{
+						memcpy(dst, src, 8);
+						src += 8;
+						dst += 8;
+					} while (dst < current_out);
+					continue;
+				}
+				if (match_offset == 1)
+				{
+					memset(dst, *src, match_length);
+					continue;
+				}
+			}
+			while (dst != current_out)
+			{
+				*dst++ = *src++;
+			}
+		}
+
+		// Hand the reader back a state where the bits beyond the count are zero.
+		if (bit_count < 64)
+		{
+			bits &= (((shifter_t)1 << bit_count) - 1);
+		}
+		br.setState(bits, bit_count, in);
+		out_pos = (current_out - out);
+
+		if (short_input)
+		{
+			// The input ends within the next symbol, so the rest of the block is left to the slow path, which checks every read.
+			fast_literal_table = nullptr;
+			SOUP_IF_UNLIKELY (!prepareSlowTables())
+			{
+				return CORRUPT;
+			}
+			return decodeSymbolsSlow(out, out_pos, out_size);
+		}
+		return status;
+	}
+#endif
+
+	void InflateDecoder::reset() noexcept
+	{
+		br = DeflateBitReader(nullptr, nullptr);
+		block_type = 0;
+		stored_remaining = 0;
+		final_block = false;
+		more_input = false;
+	}
+
+	void InflateDecoder::setInput(const void* data, size_t size, bool more_input) noexcept
+	{
+		br.setInput(reinterpret_cast<const unsigned char*>(data), reinterpret_cast<const unsigned char*>(data) + size);
+		this->more_input = more_input;
+	}
+
+	size_t InflateDecoder::getUnusedInput() noexcept
+	{
+		br.unreadBytes();
+		return br.getInBlockEnd() - br.getInBlock();
+	}
+
+	bool InflateDecoder::readBlockHeader() noexcept
+	{
+		const unsigned int final_bit = br.getBits(1);
+		const unsigned int type = br.getBits(2);
+		SOUP_IF_UNLIKELY (final_bit == (unsigned int)-1 || type == (unsigned int)-1)
+		{
+			return false;
+		}
+		final_block = final_bit;
+		block_type = type;
+
+		switch (type)
+		{
+		case 0:
+			{
+				SOUP_IF_UNLIKELY (!br.alignToByte())
+				{
+					return false;
+				}
+
+				SOUP_IF_UNLIKELY ((br.getInBlock() + 4) > br.getInBlockEnd())
+				{
+					return false;
+				}
+
+				uint16_t stored_length = ((unsigned short)br.getInBlock()[0]) | (((unsigned short)br.getInBlock()[1]) << 8);
+				br.modifyInBlock(2);
+
+				uint16_t neg_stored_length = ((unsigned short)br.getInBlock()[0]) | (((unsigned short)br.getInBlock()[1]) << 8);
+				br.modifyInBlock(2);
+
+				SOUP_IF_UNLIKELY (stored_length != (uint16_t)~neg_stored_length)
+				{
+					return false;
+				}
+
+				stored_remaining = stored_length;
+			}
+			return true;
+
+		case 1:
+#ifdef X64BIT_SHIFTER
+			{
+				static const FastFixedTables fast_fixed_tables{};
+				fast_literal_table = fast_fixed_tables.literals;
+				fast_offset_table = fast_fixed_tables.offsets;
+			}
+			return true;
+#else
+			return prepareSlowTables();
+#endif
+
+		case 2:
+			return readDynamicTables();
+		}
+		return false;
+	}
+
+	bool InflateDecoder::readDynamicTables() noexcept
+	{
+		HuffmanDecoder tables_decoder;
+		unsigned int tables_rev_sym_table[kCodeLenSyms * 2];
+
+		literal_syms = br.getBits(5);
+		SOUP_IF_UNLIKELY (literal_syms == (unsigned int)-1)
+		{
+			return false;
+		}
+		literal_syms += 257;
+		SOUP_IF_UNLIKELY (literal_syms > kLiteralSyms)
+		{
+			return false;
+		}
+
+		offset_syms = br.getBits(5);
+		SOUP_IF_UNLIKELY (offset_syms == (unsigned int)-1)
+		{
+			return false;
+		}
+		offset_syms += 1;
+		SOUP_IF_UNLIKELY (offset_syms > kOffsetSyms)
+		{
+			return false;
+		}
+
+		unsigned int code_len_syms = br.getBits(4);
+		SOUP_IF_UNLIKELY (code_len_syms == (unsigned int)-1)
+		{
+			return false;
+		}
+		code_len_syms += 4;
+		SOUP_IF_UNLIKELY (code_len_syms > kCodeLenSyms)
+		{
+			return false;
+		}
+
+		SOUP_IF_UNLIKELY (!HuffmanDecoder::readRawLengths(kCodeLenBits, code_len_syms, kCodeLenSyms, code_length, br))
+		{
+			return false;
+		}
+		SOUP_IF_UNLIKELY (!tables_decoder.prepareTable(tables_rev_sym_table, kCodeLenSyms, kCodeLenSyms, code_length))
+		{
+			return false;
+		}
+		SOUP_IF_UNLIKELY (!tables_decoder.finaliseTable(tables_rev_sym_table))
+		{
+			return false;
+		}
+
+		SOUP_IF_UNLIKELY (!tables_decoder.readLength(tables_rev_sym_table, literal_syms + offset_syms, kLiteralSyms + kOffsetSyms, code_length, br))
+		{
+			return false;
+		}
+
+#ifdef X64BIT_SHIFTER
+		if (buildFastTable(code_length, literal_syms, fast_symbol_values.literals, kFastLiteralBits, fast_literals, kFastLiteralTableSize)
+			&& buildFastTable(code_length + literal_syms, offset_syms, fast_symbol_values.offsets, kFastOffsetBits, fast_offsets, kFastOffsetTableSize)
+			)
+		{
+			fast_literal_table = fast_literals;
+			fast_offset_table = fast_offsets;
+			return true;
+		}
+		fast_literal_table = nullptr;
+#endif
+		return prepareSlowTables();
+	}
+
+	bool InflateDecoder::prepareSlowTables() noexcept
+	{
+		int i;
+
+		if (block_type == 1)
+		{
+			for (i = 0; i < 144; i++)
+				code_length[i] = 8;
+			for (; i < 256; i++)
+				code_length[i] = 9;
+			for (; i < 280; i++)
+				code_length[i] = 7;
+			for (; i < kLiteralSyms; i++)
+				code_length[i] = 8;
+			for (; i < kLiteralSyms + kOffsetSyms; i++)
+				code_length[i] = 5;
+
+			literal_syms = kLiteralSyms;
+			offset_syms = kOffsetSyms;
+		}
+
+		SOUP_IF_UNLIKELY (!literals_decoder.prepareTable(literals_rev_sym_table, literal_syms, kLiteralSyms, code_length))
+		{
+			return false;
+		}
+		SOUP_IF_UNLIKELY (!offset_decoder.prepareTable(offset_rev_sym_table, offset_syms, kOffsetSyms, code_length + literal_syms))
+		{
+			return false;
+		}
+
+		for (i = 0; i < kOffsetSyms; i++)
+		{
+			unsigned int n = offset_rev_sym_table[i];
+			if (n < kOffsetSyms)
+			{
+				offset_rev_sym_table[i] = kOffsetCode[n];
+			}
+		}
+
+		for (i = 0; i < kLiteralSyms; i++)
+		{
+			unsigned int n = literals_rev_sym_table[i];
+			if (n >= kMatchLenSymStart && n < kLiteralSyms)
+			{
+				literals_rev_sym_table[i] = kMatchLenCode[n - kMatchLenSymStart];
+			}
+		}
+
+		return literals_decoder.finaliseTable(literals_rev_sym_table)
+			&& offset_decoder.finaliseTable(offset_rev_sym_table)
+			;
+	}
+
+	InflateDecoder::Status InflateDecoder::decodeBlock(uint8_t* out, size_t& out_pos, size_t out_size) noexcept
+	{
+		if (block_type == 0)
+		{
+			return copyStored(out, out_pos, out_size);
+		}
+#ifdef X64BIT_SHIFTER
+		if (fast_literal_table)
+		{
+			return decodeSymbolsFast(out, out_pos, out_size);
+		}
+#endif
+		return decodeSymbolsSlow(out, out_pos, out_size);
+	}
+
+	InflateDecoder::Status InflateDecoder::copyStored(uint8_t* out, size_t& out_pos, size_t out_size) noexcept
+	{
+		// The header was read with byte alignment, so the data can be copied straight from the input.
+		while (stored_remaining != 0)
+		{
+			size_t n = br.getInBlockEnd() - br.getInBlock();
+			if (n == 0)
+			{
+				return more_input ? NEED_INPUT : CORRUPT;
+			}
+			if (n > stored_remaining)
+			{
+				n = stored_remaining;
+			}
+			if (n > out_size - out_pos)
+			{
+				n = out_size - out_pos;
+				if (n == 0)
+				{
+					return OUTPUT_FULL;
+				}
+			}
+			memcpy(out + out_pos, br.getInBlock(), n);
+			br.modifyInBlock(static_cast<int>(n));
+			out_pos += n;
+			stored_remaining -= static_cast<uint16_t>(n);
+		}
+		return END_OF_BLOCK;
+	}
+
+	InflateDecoder::Status InflateDecoder::decodeSymbolsSlow(uint8_t* out, size_t& out_pos, size_t out_size) noexcept
+	{
+		unsigned char* current_out = out + out_pos;
+		const unsigned char* out_end = out + out_size;
+		const unsigned char* out_fast_end = out_end - 15;
+		Status status;
+
+		while (true)
+		{
+			// A length/distance pair needs at most 15 + 5 + 15 + 13 bits.
+			if (more_input && br.getAvailableBits() < 48)
+			{
+				status = NEED_INPUT;
+				break;
+			}
+
+			br.refill32();
+
+			// Where to resume if the symbol doesn't fit into the output.
+			const shifter_t symbol_shifter_data = br.getShifterData();
+			const int symbol_shifter_bit_count = br.getShifterBitCount();
+			const unsigned char* const symbol_in_block = br.getInBlock();
+
+			unsigned int literals_code_word = literals_decoder.readValue(literals_rev_sym_table, br);
+			SOUP_IF_UNLIKELY (literals_code_word == (unsigned int)-1 || br.getShifterBitCount() < 0)
+			{
+				status = CORRUPT;
+				break;
+			}
+
+			if (literals_code_word < 256)
+			{
+				SOUP_IF_UNLIKELY (current_out >= out_end)
+				{
+					br.setState(symbol_shifter_data, symbol_shifter_bit_count, symbol_in_block);
+					status = OUTPUT_FULL;
+					break;
+				}
+				*current_out++ = literals_code_word;
+			}
+			else
+			{
+				if (literals_code_word == kEODMarkerSym)
+				{
+					status = END_OF_BLOCK;
+					break;
+				}
+
+				unsigned int match_length = br.getBits((literals_code_word >> 16) & 15);
+				SOUP_IF_UNLIKELY (match_length == (unsigned int)-1)
+				{
+					status = CORRUPT;
+					break;
+				}
+
+				match_length += (literals_code_word & 0x7fff);
+
+				unsigned int offset_code_word = offset_decoder.readValue(offset_rev_sym_table, br);
+				SOUP_IF_UNLIKELY (offset_code_word == (unsigned int)-1)
+				{
+					status = CORRUPT;
+					break;
+				}
+
+				unsigned int match_offset = br.getBits((offset_code_word >> 16) & 15);
+				SOUP_IF_UNLIKELY (match_offset == (unsigned int)-1 || br.getShifterBitCount() < 0)
+				{
+					status = CORRUPT;
+					break;
+				}
+
+				match_offset += (offset_code_word & 0x7fff);
+
+				const unsigned char* src = current_out - match_offset;
+				SOUP_IF_UNLIKELY (match_offset > (size_t)(current_out - out))
+				{
+					status = CORRUPT;
+					break;
+				}
+
+				SOUP_IF_UNLIKELY (match_length > (size_t)(out_end - current_out))
+				{
+					br.setState(symbol_shifter_data, symbol_shifter_bit_count, symbol_in_block);
+					status = OUTPUT_FULL;
+					break;
+				}
+
+				if (match_offset >= 16 && (current_out + match_length) <= out_fast_end)
+				{
+					const unsigned char* copy_src = src;
+					unsigned char* copy_dst = current_out;
+					const unsigned char* copy_end_dst = current_out + match_length;
+
+					do
+					{
+						memcpy(copy_dst, copy_src, 16);
+						copy_src += 16;
+						copy_dst += 16;
+					} while (copy_dst < copy_end_dst);
+
+					current_out += match_length;
+				}
+				else
+				{
+					while (match_length--)
+					{
+						*current_out++ = *src++;
+					}
+				}
+			}
+		}
+
+		out_pos = (current_out - out);
+		return status;
+	}
+}
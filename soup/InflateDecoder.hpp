@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "base.hpp"
+#include "Endian.hpp"
+
+NAMESPACE_SOUP
+{
+	// Decodes the blocks of a DEFLATE stream, leaving the zlib or gzip framing to the caller. Used by deflate::decompress and InflateReader.
+	// Decoding can stop at any symbol when the input or output runs out, and resumes from there once the caller has provided more.
+	class InflateDecoder
+	{
+	public:
+#if SOUP_BITS >= 64
+		using shifter_t = uint64_t;
+#else
+		using shifter_t = uint32_t;
+#endif
+
+		enum Status : uint8_t
+		{
+			END_OF_BLOCK,
+			NEED_INPUT, // only returned while more_input is set
+			OUTPUT_FULL, // the next symbol doesn't fit into the output
+			CORRUPT,
+		};
+
+		// Enough input for any block header, including the code lengths of a dynamic block.
+		static constexpr size_t MAX_BLOCK_HEADER_SIZE = 600;
+
+	protected:
+		static constexpr auto kLiteralSyms = 288;
+		static constexpr auto kOffsetSyms = 32;
+		static constexpr auto kFastSymbolBits = 10;
+		static constexpr auto kFastLiteralBits = 10;
+		static constexpr auto kFastLiteralTableSize = (1 << kFastLiteralBits) + 1024;
+		static constexpr auto kFastOffsetBits = 8;
+		static constexpr auto kFastOffsetTableSize = (1 << kFastOffsetBits) + 512;
+
+		class DeflateBitReader
+		{
+		private:
+			int shifter_bit_count_ = 0;
+			shifter_t shifter_data_ = 0;
+			const unsigned char* in_block_;
+			const unsigned char* in_block_end_;
+			const unsigned char* in_block_start_;
+
+		public:
+			/**
+			 * Initialize bit reader
+			 *
+			 * @param in_block pointer to the start of the compressed block
+			 * @param in_block_end pointer to the end of the compressed block + 1
+			 */
+			explicit DeflateBitReader(const unsigned char* in_block, const unsigned char* in_block_end)
+				: in_block_(in_block), in_block_end_(in_block_end), in_block_start_(in_block)
+			{
+			}
+
+			/** Refill 32 bits at a time if the architecture allows it, otherwise do nothing. */
+			void refill32()
+			{
+#if SOUP_BITS == 64
+				if (this->shifter_bit_count_ <= 32 && (this->in_block_ + 4) <= this->in_block_end_)
+				{
+					if constexpr (ENDIAN_NATIVE == ENDIAN_LITTLE)
+					{
+						this->shifter_data_ |= (((shifter_t)(*((const unsigned int*)this->in_block_))) << this->shifter_bit_count_);
+						this->shifter_bit_count_ += 32;
+						this->in_block_ += 4;
+					}
+					else
+					{
+						this->shifter_data_ |= (((shifter_t)(*this->in_block_++)) << this->shifter_bit_count_);
+						this->shifter_bit_count_ += 8;
+						this->shifter_data_ |= (((shifter_t)(*this->in_block_++)) << this->shifter_bit_count_);
+						this->shifter_bit_count_ += 8;
+						this->shifter_data_ |= (((shifter_t)(*this->in_block_++)) << this->shifter_bit_count_);
+						this->shifter_bit_count_ += 8;
+						this->shifter_data_ |= (((shifter_t)(*this->in_block_++)) << this->shifter_bit_count_);
+						this->shifter_bit_count_ += 8;
+					}
+				}
+#endif
+			}
+
+			/**
+			 * Consume variable bit-length value, after reading it with PeekBits()
+			 *
+			 * @param n size of value to consume, in bits
+			 */
+			void consumeBits(const int n)
+			{
+				this->shifter_data_ >>= n;
+				this->shifter_bit_count_ -= n;
+			}
+
+			void modifyInBlock(const int v)
+			{
+				this->in_block_ += v;
+			}
+
+			/**
+			 * Read variable bit-length value
+			 *
+			 * @param n size of value in bits (number of bits to read), 0..16
+			 *
+			 * @return value, or -1 for failure
+			 */
+			unsigned int getBits(const int n)
+			{
+				if (this->shifter_bit_count_ < n)
+				{
+					SOUP_IF_LIKELY (this->in_block_ < this->in_block_end_)
+					{
+						this->shifter_data_ |= (((shifter_t)(*this->in_block_++)) << this->shifter_bit_count_);
+						this->shifter_bit_count_ += 8;
+
+						if (this->in_block_ < this->in_block_end_)
+						{
+							this->shifter_data_ |= (((shifter_t)(*this->in_block_++)) << this->shifter_bit_count_);
+							this->shifter_bit_count_ += 8;
+						}
+					}
+					SOUP_IF_UNLIKELY (this->shifter_bit_count_ < n)
+					{
+						return -1;
+					}
+				}
+
+				unsigned int value = this->shifter_data_ & ((1 << n) - 1);
+				this->shifter_data_ >>= n;
+				this->shifter_bit_count_ -= n;
+				return value;
+			}
+
+			/**
+			 * Peek at a 16-bit value in the bitstream (lookahead)
+			 *
+			 * @return value
+			 */
+			unsigned int peekBits()
+			{
+				if (this->shifter_bit_count_ < 16)
+				{
+					if (this->in_block_ < this->in_block_end_)
+					{
+						this->shifter_data_ |= (((shifter_t)(*this->in_block_++)) << this->shifter_bit_count_);
+						this->shifter_bit_count_ += 8;
+						if (this->in_block_ < this->in_block_end_)
+						{
+							this->shifter_data_ |= (((shifter_t)(*this->in_block_++)) << this->shifter_bit_count_);
+							this->shifter_bit_count_ += 8;
+						}
+					}
+				}
+
+				return this->shifter_data_ & 0xffff;
+			}
+
+			/** Re-align bitstream on a byte */
+			bool alignToByte()
+			{
+				while (this->shifter_bit_count_ >= 8) {
+					this->shifter_bit_count_ -= 8;
+					this->in_block_--;
+					if (this->in_block_ < this->in_block_start_)
+					{
+						return false;
+					}
+				}
+
+				this->shifter_bit_count_ = 0;
+				this->shifter_data_ = 0;
+				return true;
+			}
+
+			/** Put the whole bytes in the shifter back into the input, so nothing before getInBlock() is needed anymore */
+			void unreadBytes()
+			{
+				this->in_block_ -= (this->shifter_bit_count_ >> 3);
+				this->shifter_bit_count_ &= 7;
+				this->shifter_data_ &= (((shifter_t)1 << this->shifter_bit_count_) - 1);
+			}
+
+			shifter_t getShifterData() const noexcept { return this->shifter_data_; }
+			int getShifterBitCount() const noexcept { return this->shifter_bit_count_; }
+			size_t getAvailableBits() const noexcept { return this->shifter_bit_count_ + ((this->in_block_end_ - this->in_block_) * 8); }
+
+			void setState(shifter_t shifter_data, int shifter_bit_count, const unsigned char* in_block)
+			{
+				this->shifter_data_ = shifter_data;
+				this->shifter_bit_count_ = shifter_bit_count;
+				this->in_block_ = in_block;
+			}
+
+			void setInput(const unsigned char* in_block, const unsigned char* in_block_end)
+			{
+				this->in_block_ = in_block;
+				this->in_block_end_ = in_block_end;
+				this->in_block_start_ = in_block;
+			}
+
+			const unsigned char* getInBlock() { return this->in_block_; };
+			const unsigned char* getInBlockEnd() { return this->in_block_end_; };
+			const unsigned char* getInBlockStart() { return this->in_block_start_; };
+		};
+
+		class HuffmanDecoder
+		{
+		private:
+			unsigned int fast_symbol_[1 << kFastSymbolBits];
+			unsigned int start_index_[16];
+			unsigned int symbols_;
+			int num_sorted_;
+			int starting_pos_[16];
+
+		public:
+			bool prepareTable(unsigned int* rev_symbol_table, const int read_symbols, const int symbols, unsigned char* code_length);
+			bool finaliseTable(unsigned int* rev_symbol_table);
+			static bool readRawLengths(const int len_bits, const int read_symbols, const int symbols, unsigned char* code_length, DeflateBitReader& bit_reader);
+			bool readLength(const unsigned int* tables_rev_symbol_table, const int read_symbols, const int symbols, unsigned char* code_length, DeflateBitReader& bit_reader);
+			unsigned int readValue(const unsigned int* rev_symbol_table, DeflateBitReader& bit_reader);
+		};
+
+		DeflateBitReader br{ nullptr, nullptr };
+
+		// State of the current block
+		uint8_t block_type = 0;
+		uint16_t stored_remaining = 0;
+		unsigned int literal_syms = 0;
+		unsigned int offset_syms = 0;
+		unsigned char code_length[kLiteralSyms + kOffsetSyms];
+#if SOUP_BITS >= 64
+		const unsigned int* fast_literal_table = nullptr; // nullptr if the block has to be decoded by decodeSymbolsSlow
+		const unsigned int* fast_offset_table = nullptr;
+		unsigned int fast_literals[kFastLiteralTableSize];
+		unsigned int fast_offsets[kFastOffsetTableSize];
+#endif
+		HuffmanDecoder literals_decoder;
+		HuffmanDecoder offset_decoder;
+		unsigned int literals_rev_sym_table[kLiteralSyms * 2];
+		unsigned int offset_rev_sym_table[kLiteralSyms * 2];
+
+	public:
+		bool final_block = false;
+		bool more_input = false; // if set, decoding stops when the input might not hold the next symbol, instead of treating that as truncation
+
+		InflateDecoder() noexcept = default;
+
+		// Resets the bit buffer and block state, e.g. to start decoding another stream.
+		void reset() noexcept;
+
+		// If there is unused input, getUnusedInput must be called first and those bytes must be at the start of the new input.
+		void setInput(const void* data, size_t size, bool more_input) noexcept;
+
+		// Returns how many bytes at the end of the current input have not been consumed.
+		[[nodiscard]] size_t getUnusedInput() noexcept;
+
+		[[nodiscard]] size_t getAvailableBits() const noexcept
+		{
+			return br.getAvailableBits();
+		}
+
+		// Reads n (0..16) bits, e.g. for the framing. Returns -1 if there is not enough input.
+		[[nodiscard]] unsigned int getBits(int n) noexcept
+		{
+			return br.getBits(n);
+		}
+
+		// Discards bits up to the next byte boundary, e.g. before reading a trailer.
+		bool alignToByte() noexcept
+		{
+			return br.alignToByte();
+		}
+
+		// Reads the BFINAL and BTYPE bits and, depending on the block type, the code lengths or stored length. The whole header must be in the input.
+		[[nodiscard]] bool readBlockHeader() noexcept;
+
+		// Decodes the rest of the current block into out, where out_pos is the number of bytes already in it and out_size its capacity.
+		// The data before out_pos is used for back-references, so it must hold at least the last 32 KiB that were decoded.
+		[[nodiscard]] Status decodeBlock(uint8_t* out, size_t& out_pos, size_t out_size) noexcept;
+
+	protected:
+		[[nodiscard]] bool readDynamicTables() noexcept;
+		[[nodiscard]] bool prepareSlowTables() noexcept;
+		[[nodiscard]] Status copyStored(uint8_t* out, size_t& out_pos, size_t out_size) noexcept;
+		[[nodiscard]] Status decodeSymbolsSlow(uint8_t* out, size_t& out_pos, size_t out_size) noexcept;
+#if SOUP_BITS >= 64
+		[[nodiscard]] Status decodeSymbolsFast(uint8_t* out, size_t& out_pos, size_t out_size) noexcept;
+#endif
+	};
+}
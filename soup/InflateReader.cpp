@@ -0,0 +1,372 @@
+#include "InflateReader.hpp"
+
+#include <cstring> // memcpy, memmove, memset
+
+#include "adler32.hpp"
+#include "crc32.hpp"
+#include "Writer.hpp"
+
+NAMESPACE_SOUP
+{
+	InflateReader::InflateReader(Reader& in, deflate::Format format, size_t compressed_size) SOUP_EXCAL
+		: Reader(), in(in), format(format), in_start(in.getPosition()), in_limit(compressed_size), in_remaining(compressed_size), chunk(CHUNK_SIZE, '\0'), buf(BUFFER_SIZE, '\0')
+	{
+		dec.setInput(chunk.data(), 0, true);
+		checksum = (format == deflate::ZLIB ? adler32::INITIAL : crc32::INITIAL);
+	}
+
+	bool InflateReader::hasMore() noexcept
+	{
+		if (buf_begin == buf_end)
+		{
+			fill();
+		}
+		return buf_begin != buf_end;
+	}
+
+	bool InflateReader::raw(void* data, size_t len) noexcept
+	{
+		return read(data, len) == len;
+	}
+
+	void InflateReader::seek(size_t pos) noexcept
+	{
+		if (pos < out_pos)
+		{
+			reset();
+		}
+		while (out_pos != pos)
+		{
+			if (buf_begin == buf_end)
+			{
+				fill();
+				if (buf_begin == buf_end)
+				{
+					break;
+				}
+			}
+			size_t n = buf_end - buf_begin;
+			if (n > pos - out_pos)
+			{
+				n = pos - out_pos;
+			}
+			buf_begin += n;
+			out_pos += n;
+		}
+	}
+
+	void InflateReader::seekEnd() noexcept
+	{
+		seek(-1);
+	}
+
+	size_t InflateReader::read(void* data, size_t max) noexcept
+	{
+		size_t done = 0;
+		while (done != max)
+		{
+			if (buf_begin == buf_end)
+			{
+				fill();
+				if (buf_begin == buf_end)
+				{
+					break;
+				}
+			}
+			size_t n = buf_end - buf_begin;
+			if (n > max - done)
+			{
+				n = max - done;
+			}
+			memcpy(reinterpret_cast<char*>(data) + done, &buf[buf_begin], n);
+			buf_begin += n;
+			done += n;
+		}
+		out_pos += done;
+		return done;
+	}
+
+	bool InflateReader::inflateTo(Writer& w) noexcept
+	{
+		while (hasMore())
+		{
+			const size_t n = buf_end - buf_begin;
+			if (!w.raw(&buf[buf_begin], n))
+			{
+				return false;
+			}
+			buf_begin = buf_end;
+			out_pos += n;
+		}
+		return state == STATE_DONE;
+	}
+
+	bool InflateReader::inflateTo(void(*callback)(const char* data, size_t size, const Capture&), const Capture& cap) noexcept
+	{
+		while (hasMore())
+		{
+			const size_t n = buf_end - buf_begin;
+			callback(&buf[buf_begin], n, cap);
+			buf_begin = buf_end;
+			out_pos += n;
+		}
+		return state == STATE_DONE;
+	}
+
+	void InflateReader::reset() noexcept
+	{
+		in.seek(in_start);
+		in_remaining = in_limit;
+		chunk_size = 0;
+		dec.reset();
+		dec.setInput(chunk.data(), 0, true);
+		state = STATE_HEADER;
+		buf_begin = 0;
+		buf_end = 0;
+		checksum_pos = 0;
+		checksum = (format == deflate::ZLIB ? adler32::INITIAL : crc32::INITIAL);
+		total_out = 0;
+		out_pos = 0;
+	}
+
+	void InflateReader::fill() noexcept
+	{
+		// Only called once everything has been read, so all we need to keep is the window.
+		if (buf_end > WINDOW_SIZE)
+		{
+			updateChecksum();
+			memmove(&buf[0], &buf[buf_end - WINDOW_SIZE], WINDOW_SIZE);
+			buf_begin = WINDOW_SIZE;
+			buf_end = WINDOW_SIZE;
+			checksum_pos = WINDOW_SIZE;
+		}
+
+		while (true)
+		{
+			switch (state)
+			{
+			case STATE_HEADER:
+				state = (readHeader() ? STATE_BLOCK_HEADER : STATE_ERROR);
+				continue;
+
+			case STATE_BLOCK_HEADER:
+				if (dec.final_block)
+				{
+					state = STATE_TRAILER;
+					continue;
+				}
+				// The decoder can't stop in the middle of a block header, so it all needs to be in the input.
+				if (dec.more_input
+					&& dec.getAvailableBits() < InflateDecoder::MAX_BLOCK_HEADER_SIZE * 8
+					)
+				{
+					(void)refillInput();
+				}
+				state = (dec.readBlockHeader() ? STATE_BLOCK : STATE_ERROR);
+				continue;
+
+			case STATE_BLOCK:
+				switch (dec.decodeBlock(reinterpret_cast<uint8_t*>(buf.data()), buf_end, BUFFER_SIZE))
+				{
+				case InflateDecoder::END_OF_BLOCK:
+					state = STATE_BLOCK_HEADER;
+					continue;
+
+				case InflateDecoder::NEED_INPUT:
+					if (refillInput())
+					{
+						continue;
+					}
+					state = STATE_ERROR;
+					break;
+
+				case InflateDecoder::OUTPUT_FULL:
+					break;
+
+				case InflateDecoder::CORRUPT:
+					state = STATE_ERROR;
+					break;
+				}
+				break;
+
+			case STATE_TRAILER:
+				updateChecksum();
+				state = (readTrailer() ? STATE_DONE : STATE_ERROR);
+				break;
+
+			case STATE_DONE:
+			case STATE_ERROR:
+				break;
+			}
+			break;
+		}
+		updateChecksum();
+		if (state == STATE_ERROR)
+		{
+			// Don't hand out data that we can't vouch for.
+			buf_begin = buf_end;
+		}
+	}
+
+	void InflateReader::updateChecksum() noexcept
+	{
+		const auto* data = reinterpret_cast<const uint8_t*>(buf.data()) + checksum_pos;
+		const size_t size = buf_end - checksum_pos;
+		if (format == deflate::ZLIB)
+		{
+			checksum = adler32::hash(data, size, checksum);
+		}
+		else if (format == deflate::GZIP || check_crc32)
+		{
+			checksum = crc32::hash(data, size, checksum);
+		}
+		total_out += size;
+		checksum_pos = buf_end;
+	}
+
+	bool InflateReader::refillInput() noexcept
+	{
+		if (!dec.more_input)
+		{
+			return false;
+		}
+		const size_t unused = dec.getUnusedInput();
+		memmove(chunk.data(), chunk.data() + (chunk_size - unused), unused);
+		size_t size = CHUNK_SIZE - unused;
+		bool more;
+		if (in_limit == static_cast<size_t>(-1))
+		{
+			size = in.read(chunk.data() + unused, size);
+			more = (size == CHUNK_SIZE - unused);
+		}
+		else
+		{
+			if (size > in_remaining)
+			{
+				size = in_remaining;
+			}
+			if (!in.raw(chunk.data() + unused, size))
+			{
+				size = 0;
+				in_remaining = 0;
+			}
+			in_remaining -= size;
+			more = (in_remaining != 0);
+		}
+		chunk_size = unused + size;
+		dec.setInput(chunk.data(), chunk_size, more);
+		return true;
+	}
+
+	bool InflateReader::getBits(uint8_t n, uint32_t& out) noexcept
+	{
+		if (dec.getAvailableBits() < n)
+		{
+			(void)refillInput();
+		}
+		out = dec.getBits(n);
+		return out != static_cast<uint32_t>(-1);
+	}
+
+	bool InflateReader::readHeader() noexcept
+	{
+		uint32_t b0, b1;
+		if (format == deflate::ZLIB)
+		{
+			if (!getBits(8, b0) || !getBits(8, b1))
+			{
+				return false;
+			}
+			// Deflate method, window of at most 32K, valid check bits, no preset dictionary.
+			return (b0 & 0x0F) == 8
+				&& (b0 >> 4) <= 7
+				&& ((b0 << 8) | b1) % 31 == 0
+				&& !(b1 & 0x20)
+				;
+		}
+		if (format == deflate::GZIP)
+		{
+			uint32_t cm, flags, tmp;
+			if (!getBits(8, b0) || !getBits(8, b1) || !getBits(8, cm) || !getBits(8, flags)
+				|| b0 != 0x1F || b1 != 0x8B || cm != 8
+				)
+			{
+				return false;
+			}
+			for (int i = 0; i != 6; ++i) // MTIME, XFL, OS
+			{
+				if (!getBits(8, tmp))
+				{
+					return false;
+				}
+			}
+			if (flags & 0x04) // FEXTRA
+			{
+				uint32_t xlen_lo, xlen_hi;
+				if (!getBits(8, xlen_lo) || !getBits(8, xlen_hi))
+				{
+					return false;
+				}
+				for (uint32_t i = 0; i != (xlen_lo | (xlen_hi << 8)); ++i)
+				{
+					if (!getBits(8, tmp))
+					{
+						return false;
+					}
+				}
+			}
+			for (const uint32_t flag : { 0x08, 0x10 }) // FNAME, FCOMMENT
+			{
+				if (flags & flag)
+				{
+					do
+					{
+						if (!getBits(8, tmp))
+						{
+							return false;
+						}
+					} while (tmp != 0);
+				}
+			}
+			if (flags & 0x02) // FHCRC
+			{
+				if (!getBits(16, tmp))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool InflateReader::readTrailer() noexcept
+	{
+		dec.alignToByte();
+		uint32_t b[8];
+		if (format == deflate::ZLIB)
+		{
+			for (int i = 0; i != 4; ++i)
+			{
+				if (!getBits(8, b[i]))
+				{
+					return false;
+				}
+			}
+			return ((b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3]) == checksum;
+		}
+		if (format == deflate::GZIP)
+		{
+			for (int i = 0; i != 8; ++i)
+			{
+				if (!getBits(8, b[i]))
+				{
+					return false;
+				}
+			}
+			return (b[0] | (b[1] << 8) | (b[2] << 16) | (b[3] << 24)) == checksum
+				&& (b[4] | (b[5] << 8) | (b[6] << 16) | (b[7] << 24)) == static_cast<uint32_t>(total_out)
+				;
+		}
+		return !check_crc32 || checksum == expected_crc32;
+	}
+}
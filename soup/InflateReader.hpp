@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Capture.hpp"
+#include "deflate.hpp"
+#include "InflateDecoder.hpp"
+#include "Reader.hpp"
+
+NAMESPACE_SOUP
+{
+	// Decompresses a DEFLATE, zlib, or gzip stream incrementally, so memory usage doesn't depend on the size of the data.
+	// The underlying Reader is read in chunks, so it should not be used by anything else while this is in use.
+	// Seeking forwards decompresses and discards data. Seeking backwards restarts from the beginning of the stream.
+	class InflateReader final : public Reader
+	{
+	public:
+		static constexpr size_t WINDOW_SIZE = 0x8000;
+
+	protected:
+		static constexpr size_t BUFFER_SIZE = 0x20000;
+		static constexpr size_t CHUNK_SIZE = 0x4000;
+
+		enum State : uint8_t
+		{
+			STATE_HEADER,
+			STATE_BLOCK_HEADER,
+			STATE_BLOCK,
+			STATE_TRAILER,
+			STATE_DONE,
+			STATE_ERROR,
+		};
+
+		Reader& in;
+		deflate::Format format;
+		size_t in_start;
+		size_t in_limit; // -1 if the compressed stream extends to the end of the Reader
+		size_t in_remaining;
+		std::string chunk;
+		size_t chunk_size = 0;
+		InflateDecoder dec;
+		State state = STATE_HEADER;
+		bool check_crc32 = false;
+		uint32_t expected_crc32 = 0;
+
+		// The last WINDOW_SIZE bytes before buf_begin are kept for back-references.
+		std::string buf;
+		size_t buf_begin = 0; // start of the data that has not been read yet
+		size_t buf_end = 0;
+		size_t checksum_pos = 0; // end of the data that has been included in the checksum
+		uint32_t checksum;
+		size_t total_out = 0; // number of bytes decompressed
+		size_t out_pos = 0; // number of bytes read
+
+	public:
+		// If compressed_size is not given, the Reader is read until it runs out of data, so it doesn't need to support seeking, unless we have to seek backwards.
+		InflateReader(Reader& in, deflate::Format format, size_t compressed_size = -1) SOUP_EXCAL;
+
+		// RAW streams carry no checksum, but the container may have one, e.g. ZIP. If set, the stream is considered corrupted if the CRC32 of the data doesn't match.
+		void setExpectedCrc32(uint32_t crc) noexcept
+		{
+			check_crc32 = true;
+			expected_crc32 = crc;
+		}
+
+		~InflateReader() final = default;
+
+		bool hasMore() noexcept final;
+		bool raw(void* data, size_t len) noexcept final;
+
+		[[nodiscard]] size_t getPosition() noexcept final
+		{
+			return out_pos;
+		}
+
+		void seek(size_t pos) noexcept final;
+		void seekEnd() noexcept final;
+
+		// Reads up to max bytes and returns how many were read. Returns 0 once the stream is exhausted or an error occurred.
+		[[nodiscard]] size_t read(void* data, size_t max) noexcept final;
+
+		// Passes the remaining data on in chunks. Returns true if the stream was decompressed completely and the checksum matched.
+		bool inflateTo(Writer& w) noexcept;
+		bool inflateTo(void(*callback)(const char* data, size_t size, const Capture&), const Capture& cap = {}) noexcept;
+
+		// True if the end of the stream was reached, the checksum matched, and everything has been read.
+		[[nodiscard]] bool isFinished() const noexcept
+		{
+			return state == STATE_DONE && buf_begin == buf_end;
+		}
+
+		// True if the stream is corrupted, truncated, or the checksum didn't match.
+		[[nodiscard]] bool hasError() const noexcept
+		{
+			return state == STATE_ERROR;
+		}
+
+	protected:
+		void reset() noexcept;
+		void fill() noexcept;
+		void updateChecksum() noexcept;
+		[[nodiscard]] bool refillInput() noexcept;
+		[[nodiscard]] bool getBits(uint8_t n, uint32_t& out) noexcept;
+		[[nodiscard]] bool readHeader() noexcept;
+		[[nodiscard]] bool readTrailer() noexcept;
+	};
+}
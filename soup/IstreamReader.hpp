@@ -43,6 +43,19 @@ NAMESPACE_SOUP
 			return is.rdstate() == 0;
 		}
 
+		[[nodiscard]] size_t read(void* data, size_t max) noexcept final
+		{
+			SOUP_TRY
+			{
+				is.read(reinterpret_cast<char*>(data), max);
+				return static_cast<size_t>(is.gcount());
+			}
+			SOUP_CATCH_ANY
+			{
+			}
+			return 0;
+		}
+
 		bool getLine(std::string& line) SOUP_EXCAL final
 		{
 			std::getline(is, line);
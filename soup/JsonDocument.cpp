@@ -0,0 +1,767 @@
+#include "JsonDocument.hpp"
+
+#include <cstdlib> // strtod
+#include <cstring> // strncmp
+
+#include "Exception.hpp"
+#include "json.hpp"
+#include "JsonArray.hpp"
+#include "JsonBool.hpp"
+#include "JsonFloat.hpp"
+#include "JsonInt.hpp"
+#include "JsonNull.hpp"
+#include "JsonObject.hpp"
+#include "JsonString.hpp"
+#include "string.hpp"
+#include "unicode.hpp"
+
+NAMESPACE_SOUP
+{
+	[[nodiscard]] static uint32_t hashKey(std::string_view key) noexcept
+	{
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		for (const auto& c : key)
+		{
+			hash ^= (uint8_t)c;
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	std::string_view JsonDocument::Value::asStr() const
+	{
+		if (!isStr())
+		{
+			throwTypeError();
+		}
+		return doc->getString(i);
+	}
+
+	int64_t JsonDocument::Value::asInt() const
+	{
+		if (!isInt())
+		{
+			throwTypeError();
+		}
+		return getNode().int_val;
+	}
+
+	double JsonDocument::Value::asFloat() const
+	{
+		if (!isFloat())
+		{
+			throwTypeError();
+		}
+		return getNode().float_val;
+	}
+
+	bool JsonDocument::Value::asBool() const
+	{
+		if (!isBool())
+		{
+			throwTypeError();
+		}
+		return getNode().bool_val;
+	}
+
+	double JsonDocument::Value::toFloat() const
+	{
+		if (isFloat())
+		{
+			return getNode().float_val;
+		}
+		return static_cast<double>(asInt());
+	}
+
+	size_t JsonDocument::Value::size() const noexcept
+	{
+		if (isArr() || isObj())
+		{
+			return getNode().len;
+		}
+		return 0;
+	}
+
+	JsonDocument::Value JsonDocument::Value::at(size_t idx) const
+	{
+		if (!isArr())
+		{
+			throwTypeError();
+		}
+		if (idx >= getNode().len)
+		{
+			SOUP_THROW(Exception("Array index out of range"));
+		}
+		uint32_t child = i + 1;
+		for (; idx != 0; --idx)
+		{
+			child = doc->nodes[child].end;
+		}
+		return Value(doc, child);
+	}
+
+	JsonDocument::Value JsonDocument::Value::find(std::string_view key) const noexcept
+	{
+		if (!isObj())
+		{
+			return {};
+		}
+		const Node& node = getNode();
+		if (node.hash.mask != 0)
+		{
+			for (uint32_t slot = hashKey(key) & node.hash.mask; ; slot = (slot + 1) & node.hash.mask)
+			{
+				const uint32_t entry = doc->hash_slots[node.hash.offset + slot];
+				if (entry == 0)
+				{
+					break;
+				}
+				if (doc->getString(entry - 1) == key)
+				{
+					return Value(doc, entry);
+				}
+			}
+			return {};
+		}
+		for (uint32_t k = i + 1; k != node.end; k = doc->nodes[k + 1].end)
+		{
+			if (doc->getString(k) == key)
+			{
+				return Value(doc, k + 1);
+			}
+		}
+		return {};
+	}
+
+	JsonDocument::Value JsonDocument::Value::at(std::string_view key) const
+	{
+		if (!isObj())
+		{
+			throwTypeError();
+		}
+		if (auto val = find(key))
+		{
+			return val;
+		}
+		std::string err = "JsonObject has no member with key ";
+		err.append(key.data(), key.size());
+		SOUP_THROW(Exception(std::move(err)));
+	}
+
+	UniquePtr<JsonNode> JsonDocument::Value::toNode() const SOUP_EXCAL
+	{
+		switch (getType())
+		{
+		case JSON_INT:
+			return soup::make_unique<JsonInt>(getNode().int_val);
+
+		case JSON_FLOAT:
+			return soup::make_unique<JsonFloat>(getNode().float_val);
+
+		case JSON_STRING:
+			{
+				const auto str = doc->getString(i);
+				return soup::make_unique<JsonString>(std::string(str.data(), str.size()));
+			}
+
+		case JSON_BOOL:
+			return soup::make_unique<JsonBool>(getNode().bool_val);
+
+		case JSON_NULL:
+			return soup::make_unique<JsonNull>();
+
+		case JSON_ARRAY:
+			{
+				auto arr = soup::make_unique<JsonArray>();
+				arr->children.reserve(getNode().len);
+				for (const auto elm : *this)
+				{
+					arr->children.emplace_back(elm.toNode());
+				}
+				return arr;
+			}
+
+		case JSON_OBJECT:
+			{
+				auto obj = soup::make_unique<JsonObject>();
+				obj->children.reserve(getNode().len);
+				for (const auto& [key, val] : members())
+				{
+					obj->children.emplace_back(soup::make_unique<JsonString>(std::string(key.data(), key.size())), val.toNode());
+				}
+				return obj;
+			}
+		}
+		return {};
+	}
+
+	std::string JsonDocument::Value::encode() const SOUP_EXCAL
+	{
+		std::string str;
+		encodeAndAppendTo(str);
+		return str;
+	}
+
+	static void encodeStringAndAppendTo(std::string& str, std::string_view value) SOUP_EXCAL
+	{
+		str.reserve(str.size() + value.size() + 2);
+		str.push_back('"');
+		for (const auto& c : value)
+		{
+			switch (c)
+			{
+			default:
+				str.push_back(c);
+				break;
+
+			case '\\':
+				str.append("\\\\");
+				break;
+
+			case '\"':
+				str.append("\\\"");
+				break;
+
+			case '\r':
+				str.append("\\r");
+				break;
+
+			case '\n':
+				str.append("\\n");
+				break;
+
+			case '\t':
+				str.append("\\t");
+				break;
+			}
+		}
+		str.push_back('"');
+	}
+
+	void JsonDocument::Value::encodeAndAppendTo(std::string& str) const SOUP_EXCAL
+	{
+		switch (getType())
+		{
+		case JSON_INT:
+			str.append(std::to_string(getNode().int_val));
+			break;
+
+		case JSON_FLOAT:
+			str.append(string::fdecimal(getNode().float_val));
+			break;
+
+		case JSON_STRING:
+			encodeStringAndAppendTo(str, doc->getString(i));
+			break;
+
+		case JSON_BOOL:
+			str.append(getNode().bool_val ? "true" : "false");
+			break;
+
+		case JSON_NULL:
+			str.append("null");
+			break;
+
+		case JSON_ARRAY:
+			{
+				str.push_back('[');
+				bool first = true;
+				for (const auto elm : *this)
+				{
+					if (!first)
+					{
+						str.push_back(',');
+					}
+					first = false;
+					elm.encodeAndAppendTo(str);
+				}
+				str.push_back(']');
+			}
+			break;
+
+		case JSON_OBJECT:
+			{
+				str.push_back('{');
+				bool first = true;
+				for (const auto& [key, val] : members())
+				{
+					if (!first)
+					{
+						str.push_back(',');
+					}
+					first = false;
+					encodeStringAndAppendTo(str, key);
+					str.push_back(':');
+					val.encodeAndAppendTo(str);
+				}
+				str.push_back('}');
+			}
+			break;
+		}
+	}
+
+	void JsonDocument::Value::throwTypeError()
+	{
+		SOUP_THROW(Exception("JsonNode has unexpected type"));
+	}
+
+	bool JsonDocument::decode(const std::string& data, int max_depth) SOUP_EXCAL
+	{
+		clear();
+		if (data.size() >= UINT32_MAX)
+		{
+			return false;
+		}
+		input = data.c_str();
+
+		// Rough guess so the node vector rarely needs to grow.
+		nodes.reserve(data.size() / 8);
+
+		const char* c = input;
+		if (!parseValue(c, max_depth))
+		{
+			clear();
+			return false;
+		}
+		return true;
+	}
+
+	bool JsonDocument::decode(std::string&& data, int max_depth) SOUP_EXCAL
+	{
+		std::string owned = std::move(data);
+		if (!decode(owned, max_depth))
+		{
+			return false;
+		}
+		owned_input = std::move(owned);
+		input = nullptr;
+		return true;
+	}
+
+	void JsonDocument::fromNode(const JsonNode& node) SOUP_EXCAL
+	{
+		clear();
+		addFromNode(node);
+	}
+
+	void JsonDocument::clear() noexcept
+	{
+		owned_input.clear();
+		input = nullptr;
+		nodes.clear();
+		strings.clear();
+		hash_slots.clear();
+	}
+
+	bool JsonDocument::parseValue(const char*& c, int max_depth) SOUP_EXCAL
+	{
+		if (max_depth == 0)
+		{
+			return false;
+		}
+		json::handleLeadingSpace(c);
+
+		const uint32_t idx = static_cast<uint32_t>(nodes.size());
+		switch (*c)
+		{
+		case '"':
+			++c;
+			return parseString(c);
+
+		case '[':
+			{
+				++c;
+				nodes.emplace_back().type = JSON_ARRAY;
+				uint32_t len = 0;
+				while (true)
+				{
+					json::handleLeadingSpace(c);
+					if (*c == ']')
+					{
+						++c;
+						break;
+					}
+					if (!parseValue(c, max_depth - 1))
+					{
+						return false;
+					}
+					++len;
+					json::handleLeadingSpace(c);
+					if (*c == ',')
+					{
+						++c;
+					}
+					else if (*c != ']')
+					{
+						return false;
+					}
+				}
+				finishContainer(idx, len);
+			}
+			return true;
+
+		case '{':
+			{
+				++c;
+				nodes.emplace_back().type = JSON_OBJECT;
+				uint32_t len = 0;
+				while (true)
+				{
+					json::handleLeadingSpace(c);
+					if (*c == '}')
+					{
+						++c;
+						break;
+					}
+					if (*c != '"')
+					{
+						return false;
+					}
+					++c;
+					if (!parseString(c))
+					{
+						return false;
+					}
+					json::handleLeadingSpace(c);
+					if (*c != ':')
+					{
+						return false;
+					}
+					++c;
+					if (!parseValue(c, max_depth - 1))
+					{
+						return false;
+					}
+					++len;
+					json::handleLeadingSpace(c);
+					if (*c == ',')
+					{
+						++c;
+					}
+					else if (*c != '}')
+					{
+						return false;
+					}
+				}
+				finishContainer(idx, len);
+			}
+			return true;
+
+		case 't':
+			if (strncmp(c, "true", 4) == 0)
+			{
+				c += 4;
+				Node& node = nodes.emplace_back();
+				node.type = JSON_BOOL;
+				node.end = idx + 1;
+				node.bool_val = true;
+				return true;
+			}
+			return false;
+
+		case 'f':
+			if (strncmp(c, "false", 5) == 0)
+			{
+				c += 5;
+				Node& node = nodes.emplace_back();
+				node.type = JSON_BOOL;
+				node.end = idx + 1;
+				node.bool_val = false;
+				return true;
+			}
+			return false;
+
+		case 'n':
+			if (strncmp(c, "null", 4) == 0)
+			{
+				c += 4;
+				Node& node = nodes.emplace_back();
+				node.type = JSON_NULL;
+				node.end = idx + 1;
+				return true;
+			}
+			return false;
+		}
+		return parseNumber(c);
+	}
+
+	bool JsonDocument::parseString(const char*& c) SOUP_EXCAL
+	{
+		const char* const start = c;
+		while (*c != '"' && *c != '\\')
+		{
+			if (*c == 0)
+			{
+				return false;
+			}
+			++c;
+		}
+
+		Node& node = nodes.emplace_back();
+		node.type = JSON_STRING;
+		node.end = static_cast<uint32_t>(nodes.size());
+
+		if (*c == '"')
+		{
+			// No escape sequences, so we can just point into the input.
+			node.str_in_input = true;
+			node.str_offset = static_cast<uint32_t>(start - input);
+			node.len = static_cast<uint32_t>(c - start);
+			++c;
+			return true;
+		}
+
+		node.str_in_input = false;
+		node.str_offset = static_cast<uint32_t>(strings.size());
+		strings.append(start, c);
+		while (true)
+		{
+			if (*c == 0)
+			{
+				return false;
+			}
+			if (*c == '"')
+			{
+				++c;
+				break;
+			}
+			if (*c != '\\')
+			{
+				strings.push_back(*c++);
+				continue;
+			}
+			++c;
+			switch (*c)
+			{
+			case 0:
+				return false;
+
+			default:
+				strings.push_back(*c);
+				break;
+
+			case 'b': strings.push_back('\b'); break;
+			case 'f': strings.push_back('\f'); break;
+			case 'n': strings.push_back('\n'); break;
+			case 'r': strings.push_back('\r'); break;
+			case 't': strings.push_back('\t'); break;
+
+			case 'u':
+				{
+					char32_t w1 = 0;
+					for (int i = 0; i != 4; ++i)
+					{
+						++c;
+						if (!string::isHexDigitChar(*c))
+						{
+							return false;
+						}
+						w1 = (w1 << 4) | (*c <= '9' ? *c - '0' : (*c | 0x20) - 'a' + 10);
+					}
+					if ((w1 >> 10) == 0x36) // Surrogate pair?
+					{
+						if (c[1] != '\\' || c[2] != 'u')
+						{
+							return false;
+						}
+						c += 2;
+						char32_t w2 = 0;
+						for (int i = 0; i != 4; ++i)
+						{
+							++c;
+							if (!string::isHexDigitChar(*c))
+							{
+								return false;
+							}
+							w2 = (w2 << 4) | (*c <= '9' ? *c - '0' : (*c | 0x20) - 'a' + 10);
+						}
+						w1 = unicode::utf16_to_utf32(w1, w2);
+					}
+					strings.append(unicode::utf32_to_utf8(w1));
+				}
+				break;
+			}
+			++c;
+		}
+		node.len = static_cast<uint32_t>(strings.size() - node.str_offset);
+		return true;
+	}
+
+	bool JsonDocument::parseNumber(const char*& c) SOUP_EXCAL
+	{
+		const char* const start = c;
+		const bool negative = (*c == '-');
+		if (negative)
+		{
+			++c;
+		}
+		if (!string::isNumberChar(*c))
+		{
+			return false;
+		}
+		uint64_t val = 0;
+		bool overflow = false;
+		for (; string::isNumberChar(*c); ++c)
+		{
+			if (val > (UINT64_MAX - 9) / 10)
+			{
+				overflow = true;
+			}
+			val = (val * 10) + (*c - '0');
+		}
+
+		Node& node = nodes.emplace_back();
+		node.end = static_cast<uint32_t>(nodes.size());
+		if (*c != '.' && *c != 'e' && *c != 'E'
+			&& !overflow
+			&& val <= (negative ? static_cast<uint64_t>(INT64_MAX) + 1 : static_cast<uint64_t>(INT64_MAX))
+			)
+		{
+			node.type = JSON_INT;
+			node.int_val = negative ? static_cast<int64_t>(0 - val) : static_cast<int64_t>(val);
+			return true;
+		}
+
+		char* str_end;
+		node.type = JSON_FLOAT;
+		node.float_val = std::strtod(start, &str_end);
+		if (str_end == start)
+		{
+			return false;
+		}
+		c = str_end;
+		return true;
+	}
+
+	void JsonDocument::addFromNode(const JsonNode& node) SOUP_EXCAL
+	{
+		const uint32_t idx = static_cast<uint32_t>(nodes.size());
+		switch (node.type)
+		{
+		case JSON_INT:
+			{
+				Node& n = nodes.emplace_back();
+				n.type = JSON_INT;
+				n.end = idx + 1;
+				n.int_val = node.reinterpretAsInt().value;
+			}
+			break;
+
+		case JSON_FLOAT:
+			{
+				Node& n = nodes.emplace_back();
+				n.type = JSON_FLOAT;
+				n.end = idx + 1;
+				n.float_val = node.reinterpretAsFloat().value;
+			}
+			break;
+
+		case JSON_STRING:
+			addString(node.reinterpretAsStr().value);
+			break;
+
+		case JSON_BOOL:
+			{
+				Node& n = nodes.emplace_back();
+				n.type = JSON_BOOL;
+				n.end = idx + 1;
+				n.bool_val = node.reinterpretAsBool().value;
+			}
+			break;
+
+		case JSON_NULL:
+			{
+				Node& n = nodes.emplace_back();
+				n.type = JSON_NULL;
+				n.end = idx + 1;
+			}
+			break;
+
+		case JSON_ARRAY:
+			nodes.emplace_back().type = JSON_ARRAY;
+			for (const auto& child : node.reinterpretAsArr().children)
+			{
+				addFromNode(*child);
+			}
+			finishContainer(idx, static_cast<uint32_t>(node.reinterpretAsArr().children.size()));
+			break;
+
+		case JSON_OBJECT:
+			nodes.emplace_back().type = JSON_OBJECT;
+			for (const auto& e : node.reinterpretAsObj().children)
+			{
+				if (e.first->isStr())
+				{
+					addString(e.first->reinterpretAsStr().value);
+				}
+				else
+				{
+					addString(e.first->encode());
+				}
+				addFromNode(*e.second);
+			}
+			finishContainer(idx, static_cast<uint32_t>(node.reinterpretAsObj().children.size()));
+			break;
+		}
+	}
+
+	void JsonDocument::addString(const std::string& str) SOUP_EXCAL
+	{
+		Node& n = nodes.emplace_back();
+		n.type = JSON_STRING;
+		n.str_in_input = false;
+		n.len = static_cast<uint32_t>(str.size());
+		n.end = static_cast<uint32_t>(nodes.size());
+		n.str_offset = static_cast<uint32_t>(strings.size());
+		strings.append(str);
+	}
+
+	void JsonDocument::finishContainer(uint32_t idx, uint32_t len) SOUP_EXCAL
+	{
+		Node& node = nodes[idx];
+		node.len = len;
+		node.end = static_cast<uint32_t>(nodes.size());
+		node.hash.offset = 0;
+		node.hash.mask = 0;
+		if (node.type == JSON_OBJECT && len >= HASH_INDEX_THRESHOLD)
+		{
+			buildHashIndex(idx);
+		}
+	}
+
+	void JsonDocument::buildHashIndex(uint32_t idx) SOUP_EXCAL
+	{
+		const Node& node = nodes[idx];
+
+		uint32_t size = 1;
+		while (size < node.len * 2)
+		{
+			size <<= 1;
+		}
+		const uint32_t offset = static_cast<uint32_t>(hash_slots.size());
+		const uint32_t mask = size - 1;
+		hash_slots.resize(hash_slots.size() + size, 0);
+
+		for (uint32_t k = idx + 1; k != node.end; k = nodes[k + 1].end)
+		{
+			const auto key = getString(k);
+			for (uint32_t slot = hashKey(key) & mask; ; slot = (slot + 1) & mask)
+			{
+				uint32_t& entry = hash_slots[offset + slot];
+				if (entry == 0)
+				{
+					entry = k + 1;
+					break;
+				}
+				if (getString(entry - 1) == key)
+				{
+					break; // Like JsonObject::find, the first member with a given key wins.
+				}
+			}
+		}
+
+		nodes[idx].hash.offset = offset;
+		nodes[idx].hash.mask = mask;
+	}
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility> // pair
+#include <vector>
+
+#include "JsonNode.hpp"
+#include "UniquePtr.hpp"
+
+NAMESPACE_SOUP
+{
+	// Alternative to the JsonNode tree where a whole document lives in a few flat buffers:
+	// Nodes are stored in document order in a single vector, so a container is followed by its children and can be skipped in one step.
+	// Strings point into the input unless they had escape sequences, in which case they are decoded into a shared buffer.
+	// Objects with many members also get a hash index, so lookups don't need a linear scan.
+	class JsonDocument
+	{
+	public:
+		static constexpr uint32_t HASH_INDEX_THRESHOLD = 16; // Objects with at least this many members get a hash index.
+
+		struct Node
+		{
+			JsonNodeType type;
+			bool str_in_input; // for strings: true if str_offset is relative to the input, false if relative to the string buffer
+			uint32_t len; // for strings: length in bytes; for arrays: number of elements; for objects: number of members
+			uint32_t end; // index of the node after this one and its children
+			union
+			{
+				int64_t int_val;
+				double float_val;
+				bool bool_val;
+				uint32_t str_offset;
+				struct
+				{
+					uint32_t offset; // into hash_slots
+					uint32_t mask; // 0 if there is no index
+				} hash;
+			};
+		};
+
+		class Value
+		{
+		public:
+			const JsonDocument* doc = nullptr;
+			uint32_t i = 0;
+
+			Value() noexcept = default;
+
+			Value(const JsonDocument* doc, uint32_t i) noexcept
+				: doc(doc), i(i)
+			{
+			}
+
+			// A default-constructed Value, e.g. from find, is invalid.
+			[[nodiscard]] explicit operator bool() const noexcept
+			{
+				return doc != nullptr;
+			}
+
+			[[nodiscard]] const Node& getNode() const noexcept
+			{
+				return doc->nodes[i];
+			}
+
+			[[nodiscard]] JsonNodeType getType() const noexcept
+			{
+				return getNode().type;
+			}
+
+			[[nodiscard]] bool isArr() const noexcept { return getType() == JSON_ARRAY; }
+			[[nodiscard]] bool isBool() const noexcept { return getType() == JSON_BOOL; }
+			[[nodiscard]] bool isFloat() const noexcept { return getType() == JSON_FLOAT; }
+			[[nodiscard]] bool isInt() const noexcept { return getType() == JSON_INT; }
+			[[nodiscard]] bool isNull() const noexcept { return getType() == JSON_NULL; }
+			[[nodiscard]] bool isObj() const noexcept { return getType() == JSON_OBJECT; }
+			[[nodiscard]] bool isStr() const noexcept { return getType() == JSON_STRING; }
+
+			// Type casts; will throw if node is of different type.
+			[[nodiscard]] std::string_view asStr() const;
+			[[nodiscard]] int64_t asInt() const;
+			[[nodiscard]] double asFloat() const;
+			[[nodiscard]] bool asBool() const;
+			[[nodiscard]] double toFloat() const; // valid for int & float
+
+			// Number of elements or members for arrays and objects, 0 for anything else.
+			[[nodiscard]] size_t size() const noexcept;
+
+			// Element access for arrays; will throw if out of range.
+			[[nodiscard]] Value at(size_t idx) const;
+
+			// Member access for objects.
+			[[nodiscard]] Value find(std::string_view key) const noexcept;
+			[[nodiscard]] Value at(std::string_view key) const;
+			[[nodiscard]] bool contains(std::string_view key) const noexcept { return (bool)find(key); }
+
+			struct ArrayIterator
+			{
+				const JsonDocument* doc;
+				uint32_t i;
+
+				[[nodiscard]] Value operator*() const noexcept { return Value(doc, i); }
+				void operator++() noexcept { i = doc->nodes[i].end; }
+				[[nodiscard]] bool operator!=(const ArrayIterator& b) const noexcept { return i != b.i; }
+			};
+
+			// Iterates the elements of an array.
+			[[nodiscard]] ArrayIterator begin() const noexcept { return ArrayIterator{ doc, i + 1 }; }
+			[[nodiscard]] ArrayIterator end() const noexcept { return ArrayIterator{ doc, getNode().end }; }
+
+			struct MemberIterator
+			{
+				const JsonDocument* doc;
+				uint32_t i; // index of the key
+
+				[[nodiscard]] std::pair<std::string_view, Value> operator*() const noexcept { return { doc->getString(i), Value(doc, i + 1) }; }
+				void operator++() noexcept { i = doc->nodes[i + 1].end; }
+				[[nodiscard]] bool operator!=(const MemberIterator& b) const noexcept { return i != b.i; }
+			};
+
+			struct Members
+			{
+				MemberIterator b;
+				MemberIterator e;
+
+				[[nodiscard]] MemberIterator begin() const noexcept { return b; }
+				[[nodiscard]] MemberIterator end() const noexcept { return e; }
+			};
+
+			// Iterates the members of an object as pairs of key and value.
+			[[nodiscard]] Members members() const noexcept { return Members{ { doc, i + 1 }, { doc, getNode().end } }; }
+
+			// Converts this value and its children to a JsonNode tree.
+			[[nodiscard]] UniquePtr<JsonNode> toNode() const SOUP_EXCAL;
+
+			[[nodiscard]] std::string encode() const SOUP_EXCAL;
+			void encodeAndAppendTo(std::string& str) const SOUP_EXCAL;
+
+		protected:
+			[[noreturn]] static void throwTypeError();
+		};
+
+		std::string owned_input{};
+		const char* input = nullptr; // only used if owned_input is empty, so the document can be moved
+		std::vector<Node> nodes{};
+		std::string strings{};
+		std::vector<uint32_t> hash_slots{}; // Each slot is 0 if empty or 1 + index of the key node.
+
+		// The data must outlive the document because strings point into it.
+		[[nodiscard]] bool decode(const std::string& data, int max_depth = 100) SOUP_EXCAL;
+		// The document takes ownership of the data.
+		[[nodiscard]] bool decode(std::string&& data, int max_depth = 100) SOUP_EXCAL;
+
+		// Creates the document from a tree. Object keys that are not strings are stored in their encoded form.
+		void fromNode(const JsonNode& node) SOUP_EXCAL;
+
+		void clear() noexcept;
+
+		// Returns an invalid Value if the document is empty.
+		[[nodiscard]] Value getRoot() const noexcept
+		{
+			if (nodes.empty())
+			{
+				return {};
+			}
+			return Value(this, 0);
+		}
+
+		[[nodiscard]] std::string_view getString(uint32_t i) const noexcept
+		{
+			const Node& node = nodes[i];
+			return std::string_view((node.str_in_input ? getInput() : strings.data()) + node.str_offset, node.len);
+		}
+
+	protected:
+		[[nodiscard]] const char* getInput() const noexcept
+		{
+			return owned_input.empty() ? input : owned_input.data();
+		}
+
+		[[nodiscard]] bool parseValue(const char*& c, int max_depth) SOUP_EXCAL;
+		[[nodiscard]] bool parseString(const char*& c) SOUP_EXCAL;
+		[[nodiscard]] bool parseNumber(const char*& c) SOUP_EXCAL;
+		void addFromNode(const JsonNode& node) SOUP_EXCAL;
+		void addString(const std::string& str) SOUP_EXCAL;
+		void finishContainer(uint32_t idx, uint32_t len) SOUP_EXCAL;
+		void buildHashIndex(uint32_t idx) SOUP_EXCAL;
+	};
+}
@@ -0,0 +1,506 @@
+#include "JsonPullParser.hpp"
+
+#include <cstdlib> // strtod
+
+#include "JsonArray.hpp"
+#include "JsonBool.hpp"
+#include "JsonFloat.hpp"
+#include "JsonInt.hpp"
+#include "JsonNull.hpp"
+#include "JsonObject.hpp"
+#include "JsonString.hpp"
+#include "Reader.hpp"
+#include "string.hpp"
+#include "unicode.hpp"
+
+NAMESPACE_SOUP
+{
+	static constexpr size_t CHUNK_SIZE = 0x4000;
+
+	JsonPullParser::JsonPullParser(Reader& r, int max_depth)
+		: c(nullptr), end(nullptr), reader(&r), max_depth(max_depth), int_val(0)
+	{
+	}
+
+	JsonPullParser::Event JsonPullParser::next() SOUP_EXCAL
+	{
+		if (event == EV_ERROR)
+		{
+			return EV_ERROR;
+		}
+		skipSpace();
+		if (event == EV_ERROR)
+		{
+			return EV_ERROR;
+		}
+
+		if (stack.empty())
+		{
+			if (top_done)
+			{
+				return event = EV_END;
+			}
+			top_done = true;
+			return event = parseValue();
+		}
+
+		Frame& f = stack.back();
+		if (f.state == FRAME_AFTER_KEY)
+		{
+			f.state = FRAME_AFTER_VALUE;
+			return event = parseValue();
+		}
+
+		int ch = peek();
+		const char closer = (f.is_object ? '}' : ']');
+		if (ch == closer)
+		{
+			return event = close(f.is_object);
+		}
+		if (f.state == FRAME_AFTER_VALUE)
+		{
+			if (ch != ',')
+			{
+				return setError();
+			}
+			++c;
+			skipSpace();
+			ch = peek();
+			if (ch == closer)
+			{
+				return event = close(f.is_object);
+			}
+		}
+
+		if (!f.is_object)
+		{
+			f.index = (f.state == FRAME_FIRST ? 0 : f.index + 1);
+			f.state = FRAME_AFTER_VALUE;
+			return event = parseValue();
+		}
+
+		if (ch != '"')
+		{
+			return setError();
+		}
+		++c;
+		f.key.clear();
+		if (!parseString(f.key))
+		{
+			return setError();
+		}
+		skipSpace();
+		if (peek() != ':')
+		{
+			return setError();
+		}
+		++c;
+		f.state = FRAME_AFTER_KEY;
+		if (!skipping)
+		{
+			str = f.key;
+		}
+		return event = EV_KEY;
+	}
+
+	bool JsonPullParser::skipValue() SOUP_EXCAL
+	{
+		if (event != EV_START_OBJECT && event != EV_START_ARRAY)
+		{
+			return true;
+		}
+		const size_t depth = stack.size();
+		skipping = true;
+		do
+		{
+			if (next() <= EV_ERROR)
+			{
+				skipping = false;
+				return false;
+			}
+		} while (stack.size() >= depth);
+		skipping = false;
+		return true;
+	}
+
+	UniquePtr<JsonNode> JsonPullParser::readValue() SOUP_EXCAL
+	{
+		switch (event)
+		{
+		case EV_STRING:
+			return soup::make_unique<JsonString>(std::move(str));
+
+		case EV_INT:
+			return soup::make_unique<JsonInt>(int_val);
+
+		case EV_FLOAT:
+			return soup::make_unique<JsonFloat>(float_val);
+
+		case EV_BOOL:
+			return soup::make_unique<JsonBool>(bool_val);
+
+		case EV_NULL:
+			return soup::make_unique<JsonNull>();
+
+		case EV_START_ARRAY:
+			{
+				auto arr = soup::make_unique<JsonArray>();
+				while (next() != EV_END_ARRAY)
+				{
+					auto val = readValue();
+					if (!val)
+					{
+						return {};
+					}
+					arr->children.emplace_back(std::move(val));
+				}
+				return arr;
+			}
+
+		case EV_START_OBJECT:
+			{
+				auto obj = soup::make_unique<JsonObject>();
+				while (next() != EV_END_OBJECT)
+				{
+					if (event != EV_KEY)
+					{
+						return {};
+					}
+					UniquePtr<JsonNode> key = soup::make_unique<JsonString>(std::move(str));
+					next();
+					auto val = readValue();
+					if (!val)
+					{
+						return {};
+					}
+					obj->children.emplace_back(std::move(key), std::move(val));
+				}
+				return obj;
+			}
+
+		default:
+			break;
+		}
+		return {};
+	}
+
+	bool JsonPullParser::findPath(const std::string& path) SOUP_EXCAL
+	{
+		std::vector<std::string> segments{};
+		if (!path.empty())
+		{
+			segments = string::explode(path, '.');
+		}
+		while (true)
+		{
+			switch (next())
+			{
+			case EV_END:
+			case EV_ERROR:
+				return false;
+
+			case EV_KEY:
+			case EV_END_OBJECT:
+			case EV_END_ARRAY:
+				continue;
+
+			default:
+				break;
+			}
+			const bool is_container = (event == EV_START_OBJECT || event == EV_START_ARRAY);
+			const size_t depth = stack.size() - is_container; // Depth of the value itself
+			if (depth > segments.size()
+				|| !matchesPrefix(segments, depth)
+				)
+			{
+				if (!skipValue())
+				{
+					return false;
+				}
+				continue;
+			}
+			if (depth == segments.size())
+			{
+				return true;
+			}
+		}
+	}
+
+	bool JsonPullParser::refill()
+	{
+		if (reader == nullptr)
+		{
+			return false;
+		}
+		// The size of the data is not needed up-front, so readers that can't seek work as well.
+		chunk.resize(CHUNK_SIZE);
+		const size_t size = reader->read(chunk.data(), CHUNK_SIZE);
+		if (size == 0)
+		{
+			return false;
+		}
+		c = chunk.data();
+		end = c + size;
+		return true;
+	}
+
+	int JsonPullParser::peek()
+	{
+		if (c == end && !refill())
+		{
+			return -1;
+		}
+		return static_cast<unsigned char>(*c);
+	}
+
+	void JsonPullParser::skipSpace()
+	{
+		while (true)
+		{
+			const int ch = peek();
+			if (string::isSpace(ch))
+			{
+				++c;
+				continue;
+			}
+			if (ch != '/')
+			{
+				return;
+			}
+			++c;
+			const int type = peek();
+			if (type == '/')
+			{
+				for (int ch; ch = peek(), ch != -1 && ch != '\n'; )
+				{
+					++c;
+				}
+			}
+			else if (type == '*')
+			{
+				++c;
+				for (int ch; ch = peek(), ch != -1; )
+				{
+					++c;
+					if (ch == '*' && peek() == '/')
+					{
+						++c;
+						break;
+					}
+				}
+			}
+			else
+			{
+				setError();
+				return;
+			}
+		}
+	}
+
+	bool JsonPullParser::parseString(std::string& out) SOUP_EXCAL
+	{
+		while (true)
+		{
+			if (c == end && !refill())
+			{
+				return false;
+			}
+			const char* p = c;
+			while (p != end && *p != '"' && *p != '\\')
+			{
+				++p;
+			}
+			if (!skipping)
+			{
+				out.append(c, p);
+			}
+			c = p;
+			if (c == end)
+			{
+				continue;
+			}
+			if (*c++ == '"')
+			{
+				return true;
+			}
+
+			// Escape sequence
+			const int ch = peek();
+			if (ch == -1)
+			{
+				return false;
+			}
+			++c;
+			if (ch != 'u')
+			{
+				if (!skipping)
+				{
+					switch (ch)
+					{
+					default: out.push_back(static_cast<char>(ch)); break;
+					case 'b': out.push_back('\b'); break;
+					case 'f': out.push_back('\f'); break;
+					case 'n': out.push_back('\n'); break;
+					case 'r': out.push_back('\r'); break;
+					case 't': out.push_back('\t'); break;
+					}
+				}
+				continue;
+			}
+			auto read_hex4 = [this](char32_t& w) SOUP_EXCAL
+			{
+				w = 0;
+				for (int i = 0; i != 4; ++i)
+				{
+					const int ch = peek();
+					if (ch == -1 || !string::isHexDigitChar(ch))
+					{
+						return false;
+					}
+					++c;
+					w <<= 4;
+					w |= (ch <= '9' ? ch - '0' : (ch | 0x20) - 'a' + 10);
+				}
+				return true;
+			};
+			char32_t w1;
+			if (!read_hex4(w1))
+			{
+				return false;
+			}
+			if ((w1 >> 10) == 0x36) // Surrogate pair?
+			{
+				char32_t w2;
+				if (peek() != '\\'
+					|| (++c, peek() != 'u')
+					|| (++c, !read_hex4(w2))
+					)
+				{
+					return false;
+				}
+				w1 = unicode::utf16_to_utf32(w1, w2);
+			}
+			if (!skipping)
+			{
+				out.append(unicode::utf32_to_utf8(w1));
+			}
+		}
+	}
+
+	JsonPullParser::Event JsonPullParser::parseValue() SOUP_EXCAL
+	{
+		switch (peek())
+		{
+		case '"':
+			++c;
+			str.clear();
+			if (!parseString(str))
+			{
+				return setError();
+			}
+			return EV_STRING;
+
+		case '{':
+		case '[':
+			if (stack.size() >= static_cast<size_t>(max_depth))
+			{
+				return setError();
+			}
+			stack.emplace_back(Frame{ *c == '{', FRAME_FIRST, 0, {} });
+			++c;
+			return stack.back().is_object ? EV_START_OBJECT : EV_START_ARRAY;
+		}
+		return parseLiteral();
+	}
+
+	JsonPullParser::Event JsonPullParser::parseLiteral() SOUP_EXCAL
+	{
+		std::string buf{};
+		bool is_int = true;
+		for (int ch; ch = peek(), string::isAlphaNum(ch) || ch == '-' || ch == '+' || ch == '.'; ++c)
+		{
+			buf.push_back(static_cast<char>(ch));
+			if (!string::isNumberChar(ch) && ch != '-')
+			{
+				is_int = false;
+			}
+		}
+		if (buf.empty())
+		{
+			return setError();
+		}
+		if (buf == "true" || buf == "false")
+		{
+			bool_val = (buf.size() == 4);
+			return EV_BOOL;
+		}
+		if (buf == "null")
+		{
+			return EV_NULL;
+		}
+		if (is_int)
+		{
+			if (auto opt = string::toIntOpt<int64_t>(buf); opt.has_value())
+			{
+				int_val = opt.value();
+				return EV_INT;
+			}
+		}
+		char* str_end;
+		float_val = std::strtod(buf.c_str(), &str_end);
+		if (str_end != buf.c_str() + buf.size())
+		{
+			return setError();
+		}
+		return EV_FLOAT;
+	}
+
+	JsonPullParser::Event JsonPullParser::close(bool object) SOUP_EXCAL
+	{
+		++c;
+		stack.pop_back();
+		return object ? EV_END_OBJECT : EV_END_ARRAY;
+	}
+
+	JsonPullParser::Event JsonPullParser::setError() noexcept
+	{
+		return event = EV_ERROR;
+	}
+
+	bool JsonPullParser::matchesPrefix(const std::vector<std::string>& segments, size_t count) const noexcept
+	{
+		for (size_t i = 0; i != count; ++i)
+		{
+			const std::string& seg = segments[i];
+			if (seg == "*")
+			{
+				continue;
+			}
+			const Frame& f = stack[i];
+			if (f.is_object)
+			{
+				if (f.key != seg)
+				{
+					return false;
+				}
+			}
+			else
+			{
+				size_t index = 0;
+				for (const char ch : seg)
+				{
+					if (!string::isNumberChar(ch))
+					{
+						return false;
+					}
+					index = (index * 10) + (ch - '0');
+				}
+				if (seg.empty() || index != f.index)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
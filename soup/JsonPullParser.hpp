@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "fwd.hpp"
+#include "JsonNode.hpp"
+#include "UniquePtr.hpp"
+
+NAMESPACE_SOUP
+{
+	// Event-based JSON parser that doesn't build a tree, so memory usage only depends on the nesting depth of the document.
+	// Works on a contiguous buffer (which must outlive the parser) or a Reader, which is read in chunks.
+	// As with json::decode, comments are permitted, as are trailing commas.
+	class JsonPullParser
+	{
+	public:
+		enum Event : uint8_t
+		{
+			EV_END = 0, // the top-level value is done
+			EV_ERROR,
+			EV_START_OBJECT,
+			EV_END_OBJECT,
+			EV_START_ARRAY,
+			EV_END_ARRAY,
+			EV_KEY, // getString() is the key
+			EV_STRING, // getString() is the value
+			EV_INT,
+			EV_FLOAT,
+			EV_BOOL,
+			EV_NULL,
+		};
+
+	protected:
+		enum FrameState : uint8_t
+		{
+			FRAME_FIRST,
+			FRAME_AFTER_KEY,
+			FRAME_AFTER_VALUE,
+		};
+
+		struct Frame
+		{
+			bool is_object;
+			FrameState state;
+			size_t index; // for arrays: index of the current element
+			std::string key; // for objects: key of the current member
+		};
+
+		const char* c;
+		const char* end;
+		Reader* reader = nullptr;
+		std::string chunk{};
+
+		std::vector<Frame> stack{};
+		int max_depth;
+		bool top_done = false;
+		bool skipping = false; // Strings are not copied while skipping.
+		Event event = EV_END;
+
+		std::string str{};
+		union
+		{
+			int64_t int_val;
+			double float_val;
+			bool bool_val;
+		};
+
+	public:
+		explicit JsonPullParser(const std::string& data, int max_depth = 100) noexcept
+			: JsonPullParser(data.data(), data.size(), max_depth)
+		{
+		}
+
+		JsonPullParser(std::string&&, int = 100) = delete; // The data would not outlive the parser.
+
+		JsonPullParser(const char* data, size_t size, int max_depth = 100) noexcept
+			: c(data), end(data + size), max_depth(max_depth), int_val(0)
+		{
+		}
+
+		explicit JsonPullParser(Reader& r, int max_depth = 100);
+
+		// Advances to the next event.
+		Event next() SOUP_EXCAL;
+
+		[[nodiscard]] Event getEvent() const noexcept { return event; }
+		[[nodiscard]] size_t getDepth() const noexcept { return stack.size(); }
+
+		[[nodiscard]] const std::string& getString() const noexcept { return str; }
+		[[nodiscard]] std::string& getString() noexcept { return str; }
+		[[nodiscard]] int64_t getInt() const noexcept { return int_val; }
+		[[nodiscard]] double getFloat() const noexcept { return float_val; }
+		[[nodiscard]] bool getBool() const noexcept { return bool_val; }
+
+		// If the current event is EV_START_OBJECT or EV_START_ARRAY, skips until the matching end event. Otherwise, does nothing.
+		bool skipValue() SOUP_EXCAL;
+
+		// Builds a node for the value that starts at the current event, e.g. to get a subtree after findPath.
+		[[nodiscard]] UniquePtr<JsonNode> readValue() SOUP_EXCAL;
+
+		// Advances until the start of a value at the given path, e.g. "items.*.id" where '*' matches any key or array index.
+		// Subtrees that can't contain a match are skipped. Returns false once the input is exhausted.
+		// Call this in a loop to visit all matches. Use readValue, skipValue, or the accessors to process the value.
+		[[nodiscard]] bool findPath(const std::string& path) SOUP_EXCAL;
+
+	protected:
+		[[nodiscard]] bool refill();
+		[[nodiscard]] int peek();
+		void skipSpace();
+		[[nodiscard]] bool parseString(std::string& out) SOUP_EXCAL;
+		[[nodiscard]] Event parseValue() SOUP_EXCAL;
+		[[nodiscard]] Event parseLiteral() SOUP_EXCAL;
+		[[nodiscard]] Event close(bool object) SOUP_EXCAL;
+		Event setError() noexcept;
+
+		[[nodiscard]] bool matchesPrefix(const std::vector<std::string>& segments, size_t count) const noexcept;
+	};
+}
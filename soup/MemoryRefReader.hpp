@@ -44,6 +44,17 @@ NAMESPACE_SOUP
 			return true;
 		}
 
+		[[nodiscard]] size_t read(void* data, size_t max) noexcept final
+		{
+			if (max > this->size - offset)
+			{
+				max = this->size - offset;
+			}
+			memcpy(reinterpret_cast<char*>(data), this->data + offset, max);
+			offset += max;
+			return max;
+		}
+
 		[[nodiscard]] size_t getPosition() noexcept final
 		{
 			return offset;
@@ -0,0 +1,170 @@
+#include "MontgomeryContext.hpp"
+
+#include <cstring> // memcpy
+
+#include "Exception.hpp"
+#include "limbutil.hpp"
+
+NAMESPACE_SOUP
+{
+	MontgomeryContext::MontgomeryContext(const Bigint& m) SOUP_EXCAL
+		: modulus(m), num_limbs((m.getBitLength() + 63) / 64)
+	{
+		SOUP_ASSERT(m.isOdd());
+
+		this->m.resize(num_limbs);
+		load(this->m.data(), m);
+
+		// Newton's method doubles the number of correct bits with each iteration.
+		uint64_t inv = 1;
+		for (int i = 0; i != 6; ++i)
+		{
+			inv *= 2 - this->m[0] * inv;
+		}
+		m_inv = (0 - inv);
+
+		r_mod_m.resize(num_limbs);
+		load(r_mod_m.data(), Bigint::_2pow(num_limbs * 64).modUnsigned(m));
+		r2_mod_m.resize(num_limbs);
+		load(r2_mod_m.data(), Bigint::_2pow(num_limbs * 64 * 2).modUnsigned(m));
+	}
+
+	Bigint MontgomeryContext::modPow(const Bigint& x, const Bigint& e) const SOUP_EXCAL
+	{
+		const size_t n = num_limbs;
+		const size_t bits = e.getBitLength();
+
+		// Bigger windows need fewer multiplications but a bigger table of odd powers.
+		const unsigned int w = (bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : 1);
+		const size_t table_size = (1 << (w - 1));
+
+		std::vector<uint64_t> buf((table_size + 3) * n + (n + 2));
+		uint64_t* const table = buf.data(); // x, x^3, x^5, ...
+		uint64_t* const res = table + table_size * n;
+		uint64_t* const x2 = res + n;
+		uint64_t* const raw = x2 + n;
+		uint64_t* const t = raw + n;
+
+		load(raw, x.mod(modulus));
+		mul(table, raw, r2_mod_m.data(), t);
+		if (table_size != 1)
+		{
+			mul(x2, table, table, t);
+			for (size_t i = 1; i != table_size; ++i)
+			{
+				mul(table + i * n, table + (i - 1) * n, x2, t);
+			}
+		}
+
+		memcpy(res, r_mod_m.data(), n * sizeof(uint64_t));
+		bool res_is_one = true;
+		for (size_t i = bits; i != 0; )
+		{
+			if (!e.getBit(i - 1))
+			{
+				if (!res_is_one)
+				{
+					mul(res, res, res, t);
+				}
+				--i;
+				continue;
+			}
+
+			// The window covers bits i - 1 down to j, with j being the lowest set bit within w bits, so its value is odd.
+			size_t j = (i >= w ? i - w : 0);
+			while (!e.getBit(j))
+			{
+				++j;
+			}
+			unsigned int value = 0;
+			for (size_t k = i; k-- != j; )
+			{
+				value = (value << 1) | e.getBit(k);
+			}
+
+			if (res_is_one)
+			{
+				memcpy(res, table + (value / 2) * n, n * sizeof(uint64_t));
+				res_is_one = false;
+			}
+			else
+			{
+				for (size_t k = j; k != i; ++k)
+				{
+					mul(res, res, res, t);
+				}
+				mul(res, res, table + (value / 2) * n, t);
+			}
+			i = j;
+		}
+
+		// Multiplying by 1 takes the result out of Montgomery form.
+		memset(raw, 0, n * sizeof(uint64_t));
+		raw[0] = 1;
+		mul(res, res, raw, t);
+		return store(res);
+	}
+
+	// Coarsely Integrated Operand Scanning: the reduction is interleaved with the multiplication, one limb of b at a time.
+	void MontgomeryContext::mul(uint64_t* res, const uint64_t* a, const uint64_t* b, uint64_t* t) const noexcept
+	{
+		const size_t n = num_limbs;
+		memset(t, 0, (n + 2) * sizeof(uint64_t));
+		for (size_t i = 0; i != n; ++i)
+		{
+			uint64_t c = 0;
+			for (size_t j = 0; j != n; ++j)
+			{
+				t[j] = limbutil::mulAdd(a[j], b[i], t[j], c, c);
+			}
+			uint64_t carry = 0;
+			t[n] = limbutil::addCarry(t[n], c, carry);
+			t[n + 1] = carry;
+
+			// Adding u * m makes the lowest limb zero, so everything can be shifted down by one limb.
+			const uint64_t u = t[0] * m_inv;
+			(void)limbutil::mulAdd(u, m[0], t[0], 0, c);
+			for (size_t j = 1; j != n; ++j)
+			{
+				t[j - 1] = limbutil::mulAdd(u, m[j], t[j], c, c);
+			}
+			carry = 0;
+			t[n - 1] = limbutil::addCarry(t[n], c, carry);
+			t[n] = t[n + 1] + carry;
+		}
+
+		// The result is less than 2m, so subtracting m once is enough.
+		uint64_t borrow = 0;
+		for (size_t i = 0; i != n; ++i)
+		{
+			res[i] = limbutil::subBorrow(t[i], m[i], borrow);
+		}
+		if (t[n] < borrow)
+		{
+			memcpy(res, t, n * sizeof(uint64_t));
+		}
+	}
+
+	void MontgomeryContext::load(uint64_t* res, const Bigint& a) const noexcept
+	{
+		for (size_t i = 0; i != num_limbs; ++i)
+		{
+			res[i] = 0;
+		}
+		for (size_t i = 0; i != num_limbs * 64 / Bigint::getBitsPerChunk(); ++i)
+		{
+			res[i * Bigint::getBitsPerChunk() / 64] |= (static_cast<uint64_t>(a.getChunk(i)) << ((i * Bigint::getBitsPerChunk()) % 64));
+		}
+	}
+
+	Bigint MontgomeryContext::store(const uint64_t* a) const SOUP_EXCAL
+	{
+		Bigint res;
+		for (size_t i = 0; i != num_limbs * 64 / Bigint::getBitsPerChunk(); ++i)
+		{
+			res.setChunk(i, static_cast<Bigint::chunk_t>(a[i * Bigint::getBitsPerChunk() / 64] >> ((i * Bigint::getBitsPerChunk()) % 64)));
+		}
+		res.shrink();
+		return res;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Bigint.hpp"
+
+NAMESPACE_SOUP
+{
+	// Montgomery arithmetic modulo an odd number of any size, with 64-bit limbs.
+	// Everything that only depends on the modulus is computed once, and an exponentiation allocates all of its buffers up-front.
+	class MontgomeryContext
+	{
+	public:
+		Bigint modulus{};
+		size_t num_limbs = 0;
+		std::vector<uint64_t> m{};
+		uint64_t m_inv = 0; // -m^-1 mod 2^64
+		std::vector<uint64_t> r_mod_m{}; // 1 in Montgomery form
+		std::vector<uint64_t> r2_mod_m{}; // for converting into Montgomery form
+
+		MontgomeryContext() noexcept = default;
+		explicit MontgomeryContext(const Bigint& m) SOUP_EXCAL;
+
+		// x^e mod m, using a sliding window over e.
+		[[nodiscard]] Bigint modPow(const Bigint& x, const Bigint& e) const SOUP_EXCAL;
+
+	protected:
+		// res = a * b * R^-1 mod m. 't' is scratch space for num_limbs + 2 limbs. res may be the same as a or b.
+		void mul(uint64_t* res, const uint64_t* a, const uint64_t* b, uint64_t* t) const noexcept;
+
+		void load(uint64_t* res, const Bigint& a) const noexcept;
+		[[nodiscard]] Bigint store(const uint64_t* a) const SOUP_EXCAL;
+	};
+}
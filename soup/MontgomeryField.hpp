@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstring> // memcmp
+
+#include "Bigint.hpp"
+#include "limbutil.hpp"
+
+NAMESPACE_SOUP
+{
+	// Arithmetic modulo an odd number of at most LIMBS * 64 bits, on fixed-size elements that never allocate.
+	// Elements are kept in Montgomery form (a * 2^(LIMBS * 64) mod p), so multiplication needs no division.
+	template <size_t LIMBS>
+	class MontgomeryField
+	{
+	public:
+		struct Element
+		{
+			uint64_t limbs[LIMBS];
+
+			[[nodiscard]] bool operator==(const Element& b) const noexcept
+			{
+				return memcmp(limbs, b.limbs, sizeof(limbs)) == 0;
+			}
+
+			[[nodiscard]] bool operator!=(const Element& b) const noexcept
+			{
+				return !operator==(b);
+			}
+		};
+
+		Bigint modulus;
+		Element p;
+		uint64_t p_inv; // -p^-1 mod 2^64
+		Element r_mod_p; // 1 in Montgomery form
+		Element r2_mod_p; // for converting into Montgomery form
+
+		explicit MontgomeryField(const Bigint& p) SOUP_EXCAL
+			: modulus(p), p(load(p))
+		{
+			SOUP_ASSERT(p.isOdd() && p.getBitLength() <= LIMBS * 64);
+
+			// Newton's method doubles the number of correct bits with each iteration.
+			uint64_t inv = 1;
+			for (int i = 0; i != 6; ++i)
+			{
+				inv *= 2 - this->p.limbs[0] * inv;
+			}
+			p_inv = (0 - inv);
+
+			r_mod_p = load(Bigint::_2pow(LIMBS * 64).modUnsigned(p));
+			r2_mod_p = load(Bigint::_2pow(LIMBS * 64 * 2).modUnsigned(p));
+		}
+
+		[[nodiscard]] Element fromBigint(const Bigint& a) const SOUP_EXCAL
+		{
+			return mul(load(a.mod(modulus)), r2_mod_p);
+		}
+
+		[[nodiscard]] Bigint toBigint(const Element& a) const SOUP_EXCAL
+		{
+			Element one{};
+			one.limbs[0] = 1;
+			return toBigintRaw(mul(a, one));
+		}
+
+		[[nodiscard]] const Element& one() const noexcept
+		{
+			return r_mod_p;
+		}
+
+		[[nodiscard]] static bool isZero(const Element& a) noexcept
+		{
+			uint64_t acc = 0;
+			for (size_t i = 0; i != LIMBS; ++i)
+			{
+				acc |= a.limbs[i];
+			}
+			return acc == 0;
+		}
+
+		[[nodiscard]] Element add(const Element& a, const Element& b) const noexcept
+		{
+			Element res;
+			uint64_t carry = 0;
+			for (size_t i = 0; i != LIMBS; ++i)
+			{
+				res.limbs[i] = limbutil::addCarry(a.limbs[i], b.limbs[i], carry);
+			}
+			reduceOnce(res, carry);
+			return res;
+		}
+
+		[[nodiscard]] Element sub(const Element& a, const Element& b) const noexcept
+		{
+			Element res;
+			uint64_t borrow = 0;
+			for (size_t i = 0; i != LIMBS; ++i)
+			{
+				res.limbs[i] = limbutil::subBorrow(a.limbs[i], b.limbs[i], borrow);
+			}
+			if (borrow)
+			{
+				uint64_t carry = 0;
+				for (size_t i = 0; i != LIMBS; ++i)
+				{
+					res.limbs[i] = limbutil::addCarry(res.limbs[i], p.limbs[i], carry);
+				}
+			}
+			return res;
+		}
+
+		[[nodiscard]] Element neg(const Element& a) const noexcept
+		{
+			return sub(Element{}, a);
+		}
+
+		// Coarsely Integrated Operand Scanning: the reduction is interleaved with the multiplication, one limb of b at a time.
+		[[nodiscard]] Element mul(const Element& a, const Element& b) const noexcept
+		{
+			uint64_t t[LIMBS + 2] = {};
+			for (size_t i = 0; i != LIMBS; ++i)
+			{
+				uint64_t c = 0;
+				for (size_t j = 0; j != LIMBS; ++j)
+				{
+					t[j] = limbutil::mulAdd(a.limbs[j], b.limbs[i], t[j], c, c);
+				}
+				uint64_t carry = 0;
+				t[LIMBS] = limbutil::addCarry(t[LIMBS], c, carry);
+				t[LIMBS + 1] = carry;
+
+				// Adding m * p makes the lowest limb zero, so everything can be shifted down by one limb.
+				const uint64_t m = t[0] * p_inv;
+				(void)limbutil::mulAdd(m, p.limbs[0], t[0], 0, c);
+				for (size_t j = 1; j != LIMBS; ++j)
+				{
+					t[j - 1] = limbutil::mulAdd(m, p.limbs[j], t[j], c, c);
+				}
+				carry = 0;
+				t[LIMBS - 1] = limbutil::addCarry(t[LIMBS], c, carry);
+				t[LIMBS] = t[LIMBS + 1] + carry;
+			}
+			Element res;
+			for (size_t i = 0; i != LIMBS; ++i)
+			{
+				res.limbs[i] = t[i];
+			}
+			reduceOnce(res, t[LIMBS]);
+			return res;
+		}
+
+		[[nodiscard]] Element sqr(const Element& a) const noexcept
+		{
+			return mul(a, a);
+		}
+
+		// a^(p - 2), which is the inverse of a if p is prime.
+		[[nodiscard]] Element inv(const Element& a) const noexcept
+		{
+			Element e = p;
+			e.limbs[0] -= 2; // p is odd, so this can't underflow
+
+			// Fixed 4-bit window
+			Element table[16];
+			table[0] = r_mod_p;
+			for (size_t i = 1; i != 16; ++i)
+			{
+				table[i] = mul(table[i - 1], a);
+			}
+			Element res = r_mod_p;
+			for (size_t i = LIMBS * 16; i-- != 0; )
+			{
+				res = sqr(sqr(sqr(sqr(res))));
+				const auto nibble = ((e.limbs[i / 16] >> ((i % 16) * 4)) & 0xF);
+				if (nibble != 0)
+				{
+					res = mul(res, table[nibble]);
+				}
+			}
+			return res;
+		}
+
+	protected:
+		// Subtracts p if a (with 'carry' as its next limb) is not less than p. Requires a < 2p.
+		void reduceOnce(Element& a, uint64_t carry) const noexcept
+		{
+			Element diff;
+			uint64_t borrow = 0;
+			for (size_t i = 0; i != LIMBS; ++i)
+			{
+				diff.limbs[i] = limbutil::subBorrow(a.limbs[i], p.limbs[i], borrow);
+			}
+			if (carry >= borrow)
+			{
+				a = diff;
+			}
+		}
+
+		[[nodiscard]] static Element load(const Bigint& a) noexcept
+		{
+			Element res{};
+			for (size_t i = 0; i != LIMBS * 64 / Bigint::getBitsPerChunk(); ++i)
+			{
+				res.limbs[i * Bigint::getBitsPerChunk() / 64] |= (static_cast<uint64_t>(a.getChunk(i)) << ((i * Bigint::getBitsPerChunk()) % 64));
+			}
+			return res;
+		}
+
+		[[nodiscard]] static Bigint toBigintRaw(const Element& a) SOUP_EXCAL
+		{
+			Bigint res;
+			for (size_t i = 0; i != LIMBS * 64 / Bigint::getBitsPerChunk(); ++i)
+			{
+				res.setChunk(i, static_cast<Bigint::chunk_t>(a.limbs[i * Bigint::getBitsPerChunk() / 64] >> ((i * Bigint::getBitsPerChunk()) % 64)));
+			}
+			res.shrink();
+			return res;
+		}
+	};
+}
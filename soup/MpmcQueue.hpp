@@ -0,0 +1,192 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef> // size_t
+#include <cstdint> // intptr_t
+#include <memory> // destroy_at
+#include <type_traits>
+#include <utility> // move
+
+#include "base.hpp"
+#include "memory.hpp" // construct_at
+
+NAMESPACE_SOUP
+{
+	// A bounded lock-free queue for any number of producers and consumers, based on Dmitry Vyukov's design.
+	// Each cell has a sequence number which says whether it's ready to be written or read, so producers and consumers only contend on the position they advance.
+	template <typename T>
+	class MpmcQueue
+	{
+		static_assert(std::is_nothrow_move_constructible_v<T>);
+
+	protected:
+		static constexpr size_t CLOSED = (static_cast<size_t>(1) << (sizeof(size_t) * 8 - 1)); // set in enqueue_pos
+
+		struct Cell
+		{
+			std::atomic_size_t sequence;
+			alignas(T) char data[sizeof(T)];
+		};
+
+		Cell* const cells;
+		const size_t mask;
+		char pad0[64];
+		// The positions are on separate cache lines, so producers and consumers don't invalidate each other's.
+		std::atomic_size_t enqueue_pos{ 0 };
+		char pad1[64];
+		std::atomic_size_t dequeue_pos{ 0 };
+		char pad2[64];
+
+		[[nodiscard]] static size_t roundCapacity(size_t capacity) noexcept
+		{
+			size_t res = 2;
+			while (res < capacity)
+			{
+				res <<= 1;
+			}
+			return res;
+		}
+
+	public:
+		// The capacity is rounded up to a power of 2.
+		explicit MpmcQueue(size_t capacity) SOUP_EXCAL
+			: cells(new Cell[roundCapacity(capacity)]), mask(roundCapacity(capacity) - 1)
+		{
+			for (size_t i = 0; i <= mask; ++i)
+			{
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		MpmcQueue(const MpmcQueue&) = delete;
+		MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+		~MpmcQueue() noexcept
+		{
+			for (size_t pos = dequeue_pos.load(); pos != (enqueue_pos.load() & ~CLOSED); ++pos)
+			{
+				std::destroy_at<>(reinterpret_cast<T*>(cells[pos & mask].data));
+			}
+			delete[] cells;
+		}
+
+		[[nodiscard]] size_t capacity() const noexcept
+		{
+			return mask + 1;
+		}
+
+		// Only a snapshot if other threads are using the queue.
+		[[nodiscard]] size_t size() const noexcept
+		{
+			const size_t dequeued = dequeue_pos.load(std::memory_order_acquire);
+			const size_t enqueued = (enqueue_pos.load(std::memory_order_acquire) & ~CLOSED);
+			return enqueued > dequeued ? enqueued - dequeued : 0;
+		}
+
+		[[nodiscard]] bool empty() const noexcept
+		{
+			return size() == 0;
+		}
+
+		// Returns false if the queue is full or closed, in which case the value is left untouched.
+		[[nodiscard]] bool tryPush(T&& value) noexcept
+		{
+			size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+			Cell* cell;
+			while (true)
+			{
+				SOUP_IF_UNLIKELY (pos & CLOSED)
+				{
+					return false;
+				}
+				cell = &cells[pos & mask];
+				const auto diff = static_cast<intptr_t>(cell->sequence.load(std::memory_order_acquire) - pos);
+				if (diff == 0)
+				{
+					if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = enqueue_pos.load(std::memory_order_relaxed);
+				}
+			}
+			soup::construct_at<>(reinterpret_cast<T*>(cell->data), std::move(value));
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Returns false if the queue is empty.
+		[[nodiscard]] bool tryPop(T& out) noexcept(std::is_nothrow_move_assignable_v<T>)
+		{
+			size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+			Cell* cell;
+			while (true)
+			{
+				cell = &cells[pos & mask];
+				const auto diff = static_cast<intptr_t>(cell->sequence.load(std::memory_order_acquire) - (pos + 1));
+				if (diff == 0)
+				{
+					if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = dequeue_pos.load(std::memory_order_relaxed);
+				}
+			}
+			T* const value = reinterpret_cast<T*>(cell->data);
+			out = std::move(*value);
+			std::destroy_at<>(value);
+			cell->sequence.store(pos + mask + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Makes all future pushes fail, while the values that are already in the queue can still be popped.
+		void close() noexcept
+		{
+			enqueue_pos.fetch_or(CLOSED);
+		}
+
+		[[nodiscard]] bool isClosed() const noexcept
+		{
+			return enqueue_pos.load() & CLOSED;
+		}
+
+		// Whether the queue is closed and every value that was pushed has been popped, so it will never have anything to offer again.
+		[[nodiscard]] bool isDrained() const noexcept
+		{
+			const size_t enqueued = enqueue_pos.load();
+			return (enqueued & CLOSED)
+				&& dequeue_pos.load() == (enqueued & ~CLOSED)
+				;
+		}
+
+		// Calls the function for each value in the queue. This must only be done by the only thread that pops from this queue.
+		template <typename F>
+		void forEach(F&& f) const
+		{
+			const size_t enqueued = (enqueue_pos.load(std::memory_order_acquire) & ~CLOSED);
+			for (size_t pos = dequeue_pos.load(std::memory_order_relaxed); pos != enqueued; ++pos)
+			{
+				const Cell& cell = cells[pos & mask];
+				if (cell.sequence.load(std::memory_order_acquire) == pos + 1) // a producer might still be writing the value
+				{
+					f(*reinterpret_cast<const T*>(cell.data));
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,126 @@
+#include "MultiScheduler.hpp"
+#if !SOUP_WASM
+
+#include <thread>
+
+#include "CertStore.hpp"
+
+NAMESPACE_SOUP
+{
+	MultiScheduler::MultiScheduler(unsigned int num_loops) SOUP_EXCAL
+	{
+		if (num_loops == 0)
+		{
+			num_loops = std::thread::hardware_concurrency();
+			if (num_loops == 0)
+			{
+				num_loops = 1;
+			}
+		}
+		loops.reserve(num_loops);
+		loop_stats.reserve(num_loops);
+		for (unsigned int i = 0; i != num_loops; ++i)
+		{
+			auto& loop = loops.emplace_back(soup::make_unique<Server>());
+			loop->setReusePort();
+			loop_stats.emplace_back(loop->add<SchedulerStats>());
+			++loop->passive_workers; // Stats should not keep the loop alive.
+		}
+	}
+
+	void MultiScheduler::setUseEpoll() noexcept
+	{
+		for (auto& loop : loops)
+		{
+			loop->setUseEpoll();
+		}
+	}
+
+	bool MultiScheduler::bind(uint16_t port, ServerService* service) SOUP_EXCAL
+	{
+#if SOUP_LINUX
+		for (auto& loop : loops)
+		{
+			SOUP_RETHROW_FALSE(loop->bind(port, service));
+		}
+		return true;
+#else
+		return loops.at(0)->bind(port, service);
+#endif
+	}
+
+	bool MultiScheduler::bindCrypto(uint16_t port, ServerService* service, SharedPtr<CertStore> certstore, tls_server_on_client_hello_t on_client_hello) SOUP_EXCAL
+	{
+#if SOUP_LINUX
+		for (auto& loop : loops)
+		{
+			SOUP_RETHROW_FALSE(loop->bindCrypto(port, service, certstore, on_client_hello));
+		}
+		return true;
+#else
+		return loops.at(0)->bindCrypto(port, service, std::move(certstore), on_client_hello);
+#endif
+	}
+
+	bool MultiScheduler::bindOptCrypto(uint16_t port, ServerService* service, SharedPtr<CertStore> certstore, tls_server_on_client_hello_t on_client_hello) SOUP_EXCAL
+	{
+#if SOUP_LINUX
+		for (auto& loop : loops)
+		{
+			SOUP_RETHROW_FALSE(loop->bindOptCrypto(port, service, certstore, on_client_hello));
+		}
+		return true;
+#else
+		return loops.at(0)->bindOptCrypto(port, service, std::move(certstore), on_client_hello);
+#endif
+	}
+
+	bool MultiScheduler::bindUdp(uint16_t port, ServerServiceUdp* service) SOUP_EXCAL
+	{
+#if SOUP_LINUX
+		for (auto& loop : loops)
+		{
+			SOUP_RETHROW_FALSE(loop->bindUdp(port, service));
+		}
+		return true;
+#else
+		return loops.at(0)->bindUdp(port, service);
+#endif
+	}
+
+	void MultiScheduler::addWorker(SharedPtr<Worker>&& w)
+	{
+		loops[next_loop.fetch_add(1, std::memory_order_relaxed) % loops.size()]->addWorker(std::move(w));
+	}
+
+	void MultiScheduler::run()
+	{
+		for (size_t i = 1; i < loops.size(); ++i)
+		{
+			threads.emplace_back(soup::make_unique<Thread>([](Capture&& cap)
+			{
+				cap.get<Server*>()->run();
+			}, loops[i].get()));
+		}
+		loops.at(0)->run();
+		Thread::awaitCompletion(threads);
+		threads.clear();
+	}
+
+	MultiScheduler::Stats MultiScheduler::getStats() const noexcept
+	{
+		Stats res{};
+		for (const auto& stats : loop_stats)
+		{
+			// Not counting the stats task itself, which is only included once the loop has ticked.
+			if (const auto num_workers = stats->num_workers.load(std::memory_order_relaxed); num_workers != 0)
+			{
+				res.num_workers += num_workers - 1;
+			}
+			res.num_sockets += stats->num_sockets.load(std::memory_order_relaxed);
+		}
+		return res;
+	}
+}
+
+#endif
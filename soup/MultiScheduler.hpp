@@ -0,0 +1,65 @@
+#pragma once
+
+#include "base.hpp"
+#if !SOUP_WASM
+
+#include <atomic>
+#include <vector>
+
+#include "SchedulerStats.hpp"
+#include "Server.hpp"
+#include "SharedPtr.hpp"
+#include "Thread.hpp"
+#include "UniquePtr.hpp"
+
+NAMESPACE_SOUP
+{
+	// Runs a number of Server instances, each on its own thread, so that a single process can make use of all cores.
+	// On Linux, every loop binds its own SO_REUSEPORT listener, so the kernel shards incoming connections between them.
+	// On other platforms, only the first loop accepts connections, but workers added via addWorker are still distributed.
+	// Note that callbacks of services bound via this class are invoked from multiple threads.
+	class MultiScheduler
+	{
+	public:
+		struct Stats
+		{
+			size_t num_workers = 0;
+			size_t num_sockets = 0;
+		};
+
+		std::vector<UniquePtr<Server>> loops{};
+	protected:
+		std::vector<SharedPtr<SchedulerStats>> loop_stats{};
+		std::vector<UniquePtr<Thread>> threads{};
+		std::atomic_size_t next_loop = 0;
+
+	public:
+		MultiScheduler(unsigned int num_loops = 0) SOUP_EXCAL; // 0 = one loop per hardware thread
+
+		void setUseEpoll() noexcept;
+
+		bool bind(uint16_t port, ServerService* service) SOUP_EXCAL;
+		bool bindCrypto(uint16_t port, ServerService* service, SharedPtr<CertStore> certstore, tls_server_on_client_hello_t on_client_hello = nullptr) SOUP_EXCAL;
+		bool bindOptCrypto(uint16_t port, ServerService* service, SharedPtr<CertStore> certstore, tls_server_on_client_hello_t on_client_hello = nullptr) SOUP_EXCAL;
+		bool bindUdp(uint16_t port, ServerServiceUdp* service) SOUP_EXCAL;
+
+		// Thread-safe. Workers are distributed across the loops in round-robin order.
+		void addWorker(SharedPtr<Worker>&& w);
+
+		template <typename T, typename...Args>
+		SharedPtr<T> add(Args&&...args) SOUP_EXCAL
+		{
+			auto w = soup::make_shared<T>(std::forward<Args>(args)...);
+			addWorker(SharedPtr<T>(w));
+			return w;
+		}
+
+		// Runs the first loop on the calling thread and all others on their own threads. Returns once all loops are done.
+		void run();
+
+		// Thread-safe. Numbers are sampled by each loop whenever it ticks.
+		[[nodiscard]] Stats getStats() const noexcept;
+	};
+}
+
+#endif
@@ -297,6 +297,17 @@ NAMESPACE_SOUP
 		}
 
 		// Reader-specific
+		// Reads up to max bytes and returns how many were read. Unlike raw, reaching the end of the data is not an error, so data of unknown size can be read in chunks.
+		[[nodiscard]] virtual size_t read(void* data, size_t max) noexcept
+		{
+			size_t done = 0;
+			while (done != max && hasMore() && raw(reinterpret_cast<char*>(data) + done, 1))
+			{
+				++done;
+			}
+			return done;
+		}
+
 		virtual bool getLine(std::string& line) SOUP_EXCAL
 		{
 			line.clear();
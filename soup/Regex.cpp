@@ -38,6 +38,10 @@ NAMESPACE_SOUP
 
 	bool Regex::matches(const char* it, const char* end) const noexcept
 	{
+		if (dfa)
+		{
+			return dfa->matches(it, it, end);
+		}
 		return match(it, end).isSuccess();
 	}
 
@@ -68,6 +72,21 @@ NAMESPACE_SOUP
 
 	RegexMatchResult Regex::match(const char* it, const char* begin, const char* end) const noexcept
 	{
+		if (dfa)
+		{
+			const char* match_end;
+			if (!dfa->match(it, begin, end, match_end))
+			{
+				return {};
+			}
+			if (!dfa->hasCaptures())
+			{
+				RegexMatchResult res;
+				res.groups.emplace_back(RegexMatchedGroup{ {}, it, match_end });
+				return res;
+			}
+			// We know there's a match, so the backtracking matcher won't be searching in vain.
+		}
 		RegexMatcher m(*this, begin, end);
 		return match(m, it);
 	}
@@ -204,6 +223,23 @@ NAMESPACE_SOUP
 
 	RegexMatchResult Regex::search(const char* it, const char* end) const noexcept
 	{
+		if (dfa)
+		{
+			const char* match_begin;
+			const char* match_end;
+			if (!dfa->search(it, end, match_begin, match_end))
+			{
+				return {};
+			}
+			if (!dfa->hasCaptures())
+			{
+				RegexMatchResult res;
+				res.groups.emplace_back(RegexMatchedGroup{ {}, match_begin, match_end });
+				return res;
+			}
+			RegexMatcher m(*this, it, end);
+			return match(m, match_begin);
+		}
 		RegexMatcher m(*this, it, end);
 		for (; it != end; ++it)
 		{
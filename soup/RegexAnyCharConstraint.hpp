@@ -33,6 +33,25 @@ NAMESPACE_SOUP
 			return true;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			// Codepoints are of variable length, so the unicode variant is not representable as a fixed sequence.
+			return unicode ? DFA_UNSUPPORTED : DFA_BYTES;
+		}
+
+		void getDfaBytes(std::vector<BigBitset<0x100 / 8>>& seq) const SOUP_EXCAL final
+		{
+			auto& set = seq.emplace_back();
+			for (uint16_t i = 0; i != 0x100; ++i)
+			{
+				set.enable(i);
+			}
+			if constexpr (!dotall)
+			{
+				set.disable('\n');
+			}
+		}
+
 		[[nodiscard]] std::string toString() const noexcept final
 		{
 			return ".";
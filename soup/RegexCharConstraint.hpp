@@ -29,6 +29,16 @@ NAMESPACE_SOUP
 			return true;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return DFA_BYTES;
+		}
+
+		void getDfaBytes(std::vector<BigBitset<0x100 / 8>>& seq) const SOUP_EXCAL final
+		{
+			seq.emplace_back().enable(static_cast<uint8_t>(c));
+		}
+
 		[[nodiscard]] std::string toString() const noexcept final
 		{
 			std::string str(1, c);
@@ -32,6 +32,19 @@ NAMESPACE_SOUP
 			return true;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return DFA_BYTES;
+		}
+
+		void getDfaBytes(std::vector<BigBitset<0x100 / 8>>& seq) const SOUP_EXCAL final
+		{
+			for (const auto& b : c)
+			{
+				seq.emplace_back().enable(static_cast<uint8_t>(b));
+			}
+		}
+
 		[[nodiscard]] std::string toString() const noexcept final
 		{
 			return c;
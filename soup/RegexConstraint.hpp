@@ -1,9 +1,11 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "fwd.hpp"
 
+#include "BigBitset.hpp"
 #include "Exception.hpp"
 
 NAMESPACE_SOUP
@@ -14,6 +16,21 @@ NAMESPACE_SOUP
 		inline static RegexConstraint* ROLLBACK_TO_SUCCESS = reinterpret_cast<RegexConstraint*>(0b100);
 		inline static uintptr_t MASK = 0b11;
 
+		// How a constraint is represented by RegexDfa.
+		enum DfaKind : uint8_t
+		{
+			DFA_UNSUPPORTED = 0, // Requires the backtracking matcher.
+			DFA_EPSILON, // Always matches without advancing the cursor.
+			DFA_BYTES, // Matches a fixed sequence of byte sets, as given by getDfaBytes.
+			DFA_ASSERT_BEGIN,
+			DFA_ASSERT_LINE_BEGIN,
+			DFA_ASSERT_END,
+			DFA_ASSERT_END_OR_FINAL_NEWLINE,
+			DFA_ASSERT_LINE_END,
+			DFA_ASSERT_WORD_BOUNDARY,
+			DFA_ASSERT_NOT_WORD_BOUNDARY,
+		};
+
 		RegexConstraint* success_transition = nullptr;
 		RegexConstraint* rollback_transition = nullptr;
 		const RegexGroup* group = nullptr;
@@ -68,5 +85,13 @@ NAMESPACE_SOUP
 		[[nodiscard]] virtual std::string toString() const noexcept = 0;
 
 		virtual void getFlags(uint16_t& set, uint16_t& unset) const noexcept {}
+
+		[[nodiscard]] virtual DfaKind getDfaKind() const noexcept
+		{
+			return DFA_UNSUPPORTED;
+		}
+
+		// For DFA_BYTES: Appends the set of accepted values for each byte this constraint consumes.
+		virtual void getDfaBytes(std::vector<BigBitset<0x100 / 8>>& seq) const SOUP_EXCAL {}
 	};
 }
@@ -0,0 +1,764 @@
+#include "RegexDfa.hpp"
+
+#include <algorithm> // sort
+#include <cstring> // memcpy
+
+#include "RegexConstraint.hpp"
+#include "RegexGroup.hpp"
+#include "string.hpp"
+
+NAMESPACE_SOUP
+{
+	UniquePtr<RegexDfa> RegexDfa::compile(const RegexGroup& group) SOUP_EXCAL
+	{
+		return compile(std::vector<const RegexGroup*>{ &group });
+	}
+
+	UniquePtr<RegexDfa> RegexDfa::compile(const std::vector<const RegexGroup*>& groups) SOUP_EXCAL
+	{
+		auto dfa = soup::make_unique<RegexDfa>();
+		if (!dfa->build(groups))
+		{
+			return {};
+		}
+		return dfa;
+	}
+
+	bool RegexDfa::matches(const char* it, const char* begin, const char* end) const noexcept
+	{
+		const char* match_end;
+		if (mtx.tryLock())
+		{
+			const bool res = runForward(cache, it, begin, end, false, true, match_end);
+			mtx.unlock();
+			return res;
+		}
+		// Another thread is using the cache, so we'll have to build our own states.
+		Cache c;
+		return runForward(c, it, begin, end, false, true, match_end);
+	}
+
+	bool RegexDfa::match(const char* it, const char* begin, const char* end, const char*& match_end) const noexcept
+	{
+		if (mtx.tryLock())
+		{
+			const bool res = runForward(cache, it, begin, end, false, false, match_end);
+			mtx.unlock();
+			return res;
+		}
+		Cache c;
+		return runForward(c, it, begin, end, false, false, match_end);
+	}
+
+	bool RegexDfa::search(const char* begin, const char* end, const char*& match_begin, const char*& match_end) const noexcept
+	{
+		bool res;
+		if (mtx.tryLock())
+		{
+			res = runForward(cache, begin, begin, end, true, false, match_end)
+				&& runReverse(cache, match_end, begin, end, match_begin)
+				;
+			mtx.unlock();
+		}
+		else
+		{
+			Cache c;
+			res = runForward(c, begin, begin, end, true, false, match_end)
+				&& runReverse(c, match_end, begin, end, match_begin)
+				;
+		}
+		return res;
+	}
+
+	void RegexDfa::searchAll(const char* begin, const char* end, std::vector<bool>& matched) const noexcept
+	{
+		matched.assign(num_patterns, false);
+		if (mtx.tryLock())
+		{
+			runAll(cache, begin, end, matched);
+			mtx.unlock();
+		}
+		else
+		{
+			Cache c;
+			runAll(c, begin, end, matched);
+		}
+	}
+
+	bool RegexDfa::build(const std::vector<const RegexGroup*>& groups) SOUP_EXCAL
+	{
+		std::unordered_map<const RegexConstraint*, uint32_t> ids{};
+		std::vector<const RegexConstraint*> pending{};
+		std::vector<uint32_t> starts{};
+
+		num_patterns = static_cast<uint32_t>(groups.size());
+		uint32_t match_node;
+
+		auto get_node = [&](const RegexConstraint* c) -> uint32_t
+		{
+			if (c == nullptr)
+			{
+				return match_node;
+			}
+			if (auto e = ids.find(c); e != ids.end())
+			{
+				return e->second;
+			}
+			const uint32_t id = addNode(forward, NODE_SPLIT);
+			ids.emplace(c, id);
+			pending.emplace_back(c);
+			return id;
+		};
+
+		std::vector<BigBitset<0x100 / 8>> seq{};
+		for (uint32_t pattern = 0; pattern != num_patterns; ++pattern)
+		{
+			match_node = addNode(forward, NODE_MATCH);
+			forward.nodes[match_node].set = pattern;
+			starts.emplace_back(get_node(reinterpret_cast<const RegexConstraint*>(reinterpret_cast<uintptr_t>(groups[pattern]->initial) & ~RegexConstraint::MASK)));
+
+			while (!pending.empty())
+			{
+				const RegexConstraint* c = pending.back();
+				pending.pop_back();
+
+				const auto kind = c->getDfaKind();
+				if (kind == RegexConstraint::DFA_UNSUPPORTED)
+				{
+					return false;
+				}
+
+				// Lookaround is partly encoded in the transitions, e.g. a negative lookahead succeeding into a failure discards the rollback point that follows.
+				if (c->getSuccessTransition() == RegexConstraint::SUCCESS_TO_FAIL
+					|| (reinterpret_cast<uintptr_t>(c->success_transition) & 0b1)
+					)
+				{
+					return false;
+				}
+
+				for (auto g = c->group; g; g = g->parent)
+				{
+					if (g->lookahead_or_lookbehind)
+					{
+						return false;
+					}
+					if (!g->isNonCapturing() && g->index != 0)
+					{
+						captures = true;
+					}
+				}
+
+				const uint32_t id = ids.at(c);
+				const uint32_t success = get_node(c->getSuccessTransition());
+
+				// If there is a rollback transition, the constraint itself is the preferred alternative.
+				uint32_t body = id;
+				if (c->rollback_transition)
+				{
+					body = addNode(forward, NODE_SPLIT);
+					const RegexConstraint* rollback = c->getRollbackTransition();
+					const uint32_t alternative = (rollback == nullptr || rollback == RegexConstraint::ROLLBACK_TO_SUCCESS ? match_node : get_node(rollback));
+					forward.nodes[id].out = { body, alternative };
+				}
+
+				if (kind == RegexConstraint::DFA_EPSILON)
+				{
+					forward.nodes[body].out = { success };
+				}
+				else if (kind == RegexConstraint::DFA_BYTES)
+				{
+					seq.clear();
+					c->getDfaBytes(seq);
+					if (seq.empty())
+					{
+						forward.nodes[body].out = { success };
+					}
+					for (size_t i = 0; i != seq.size(); ++i)
+					{
+						forward.nodes[body].type = NODE_BYTES;
+						forward.nodes[body].set = static_cast<uint32_t>(sets.size());
+						sets.emplace_back(seq[i]);
+						const uint32_t next = ((i + 1) == seq.size() ? success : addNode(forward, NODE_BYTES));
+						forward.nodes[body].out = { next };
+						body = next;
+					}
+				}
+				else
+				{
+					forward.nodes[body].type = NODE_ASSERT;
+					forward.nodes[body].assertion = kind;
+					forward.nodes[body].out = { success };
+					switch (kind)
+					{
+					case RegexConstraint::DFA_ASSERT_BEGIN:
+					case RegexConstraint::DFA_ASSERT_END:
+						context_mask |= CTX_EOT;
+						break;
+
+					case RegexConstraint::DFA_ASSERT_LINE_BEGIN:
+					case RegexConstraint::DFA_ASSERT_LINE_END:
+						context_mask |= (CTX_EOT | CTX_NL);
+						break;
+
+					case RegexConstraint::DFA_ASSERT_END_OR_FINAL_NEWLINE:
+						context_mask |= (CTX_EOT | CTX_FINAL_NL);
+						final_newline = true;
+						break;
+
+					default:
+						context_mask |= (CTX_EOT | CTX_WORD);
+						break;
+					}
+				}
+
+				SOUP_IF_UNLIKELY (forward.nodes.size() > MAX_NODES)
+				{
+					return false;
+				}
+			}
+		}
+
+		if (num_patterns == 1)
+		{
+			forward.start = starts[0];
+			buildReverse();
+		}
+		else
+		{
+			// Patterns are only ever searched for together, so they just need to be reachable from the unanchored start.
+			forward.start = addNode(forward, NODE_SPLIT);
+			forward.nodes[forward.start].out = std::move(starts);
+		}
+
+		// Searching behaves like a lazy '.*' in front of the pattern, so earlier starts have priority.
+		unanchored_start = addNode(forward, NODE_SPLIT);
+		const uint32_t not_end = addNode(forward, NODE_ASSERT);
+		const uint32_t any = addNode(forward, NODE_BYTES);
+		forward.nodes[unanchored_start].out = { not_end, any };
+		forward.nodes[not_end].assertion = ASSERT_NOT_END;
+		forward.nodes[not_end].out = { forward.start };
+		forward.nodes[any].set = static_cast<uint32_t>(sets.size());
+		forward.nodes[any].out = { unanchored_start };
+		auto& all = sets.emplace_back();
+		for (uint16_t i = 0; i != 0x100; ++i)
+		{
+			all.enable(i);
+		}
+
+		buildClasses();
+		return true;
+	}
+
+	void RegexDfa::buildReverse() SOUP_EXCAL
+	{
+		// A reverse transition for every forward transition. Priorities don't matter here because we just want the longest match.
+		const auto num_nodes = static_cast<uint32_t>(forward.nodes.size());
+		reverse.nodes.resize(num_nodes);
+		for (uint32_t u = 0; u != num_nodes; ++u)
+		{
+			const Node& node = forward.nodes[u];
+			switch (node.type)
+			{
+			case NODE_SPLIT:
+				for (const auto& v : node.out)
+				{
+					reverse.nodes[v].out.emplace_back(u);
+				}
+				break;
+
+			case NODE_BYTES:
+			case NODE_ASSERT:
+				{
+					const uint32_t r = addNode(reverse, node.type);
+					reverse.nodes[r].assertion = node.assertion;
+					reverse.nodes[r].set = node.set;
+					reverse.nodes[r].out = { u };
+					reverse.nodes[node.out.at(0)].out.emplace_back(r);
+				}
+				break;
+
+			case NODE_MATCH:
+				break;
+			}
+		}
+		const uint32_t match_node = addNode(reverse, NODE_MATCH);
+		reverse.nodes[forward.start].out.emplace_back(match_node);
+		reverse.start = 0; // the forward match node
+	}
+
+	void RegexDfa::buildClasses() SOUP_EXCAL
+	{
+		// Bytes that are treated the same by every set share a class, so the transition tables can be smaller.
+		BigBitset<0x100 / 8> newline{};
+		newline.enable('\n');
+		BigBitset<0x100 / 8> word{};
+		for (uint16_t i = 0; i != 0x100; ++i)
+		{
+			word.set(i, string::isWordChar(static_cast<char>(i)));
+		}
+
+		memset(classes, 0, sizeof(classes));
+		num_classes = 1;
+		std::vector<uint16_t> remap{};
+		auto refine = [&](const BigBitset<0x100 / 8>& set)
+		{
+			remap.assign(num_classes * 2, 0xFFFF);
+			uint16_t next = 0;
+			for (uint16_t i = 0; i != 0x100; ++i)
+			{
+				auto& r = remap[classes[i] * 2 + set.get(i)];
+				if (r == 0xFFFF)
+				{
+					r = next++;
+				}
+				classes[i] = static_cast<uint8_t>(r);
+			}
+			num_classes = next;
+		};
+		refine(newline);
+		refine(word);
+		for (const auto& set : sets)
+		{
+			refine(set);
+		}
+
+		num_symbols = num_classes + 2;
+		symbol_info.resize(num_symbols);
+		symbol_byte.resize(num_symbols);
+		for (uint16_t i = 0; i != 0x100; ++i)
+		{
+			const char c = static_cast<char>(i);
+			symbol_info[classes[i]] = getContext(&c, nullptr);
+			symbol_byte[classes[i]] = i;
+		}
+		symbol_info[num_classes] = CTX_EOT;
+		symbol_byte[num_classes] = -1;
+		symbol_info[num_classes + 1] = (CTX_NL | CTX_FINAL_NL);
+		symbol_byte[num_classes + 1] = '\n';
+	}
+
+	uint32_t RegexDfa::addNode(Program& prog, NodeType type) SOUP_EXCAL
+	{
+		const auto id = static_cast<uint32_t>(prog.nodes.size());
+		prog.nodes.emplace_back().type = type;
+		return id;
+	}
+
+	bool RegexDfa::checkAssertion(uint8_t assertion, uint8_t before, uint8_t after) noexcept
+	{
+		switch (assertion)
+		{
+		case RegexConstraint::DFA_ASSERT_BEGIN:
+			return before & CTX_EOT;
+
+		case RegexConstraint::DFA_ASSERT_LINE_BEGIN:
+			return before & (CTX_EOT | CTX_NL);
+
+		case RegexConstraint::DFA_ASSERT_END:
+			return after & CTX_EOT;
+
+		case RegexConstraint::DFA_ASSERT_END_OR_FINAL_NEWLINE:
+			return after & (CTX_EOT | CTX_FINAL_NL);
+
+		case RegexConstraint::DFA_ASSERT_LINE_END:
+			return after & (CTX_EOT | CTX_NL);
+
+		case RegexConstraint::DFA_ASSERT_WORD_BOUNDARY:
+			return ((before | after) & CTX_EOT) || ((before ^ after) & CTX_WORD);
+
+		case RegexConstraint::DFA_ASSERT_NOT_WORD_BOUNDARY:
+			return !((before | after) & CTX_EOT) && !((before ^ after) & CTX_WORD);
+
+		case ASSERT_NOT_END:
+			return !(after & CTX_EOT);
+		}
+		return false;
+	}
+
+	uint8_t RegexDfa::getContext(const char* it, const char* end) const noexcept
+	{
+		uint8_t ctx = 0;
+		if (*it == '\n')
+		{
+			ctx |= CTX_NL;
+			if (it + 1 == end)
+			{
+				ctx |= CTX_FINAL_NL;
+			}
+		}
+		if (string::isWordChar(*it))
+		{
+			ctx |= CTX_WORD;
+		}
+		return ctx;
+	}
+
+	void RegexDfa::flush(StateCache& sc) const SOUP_EXCAL
+	{
+		sc.table.clear();
+		sc.states.clear();
+		sc.map.clear();
+		std::fill(std::begin(sc.starts), std::end(sc.starts), UNKNOWN);
+
+		// State 0 is the dead state, which is never looked up by key.
+		sc.states.emplace_back(&sc.map.emplace(std::string(), DEAD).first->first);
+		sc.table.resize(num_symbols, DEAD);
+	}
+
+	uint32_t RegexDfa::addState(StateCache& sc, std::string&& key, bool& flushed) const SOUP_EXCAL
+	{
+		if (auto e = sc.map.find(key); e != sc.map.end())
+		{
+			return e->second;
+		}
+		SOUP_IF_UNLIKELY ((sc.states.size() + 1) * num_symbols * sizeof(uint32_t) > CACHE_SIZE)
+		{
+			// Start over rather than use an unbounded amount of memory. The current transition still gets its state.
+			flush(sc);
+			flushed = true;
+		}
+		const auto id = static_cast<uint32_t>(sc.states.size());
+		sc.states.emplace_back(&sc.map.emplace(std::move(key), id).first->first);
+		sc.table.resize(sc.table.size() + num_symbols, UNKNOWN);
+		return id;
+	}
+
+	uint32_t RegexDfa::getStart(StateCache& sc, uint32_t node, uint8_t ctx, uint8_t slot) const SOUP_EXCAL
+	{
+		if (sc.states.empty())
+		{
+			flush(sc);
+		}
+		if (sc.starts[slot] == UNKNOWN)
+		{
+			std::string key(1, static_cast<char>(ctx));
+			key.append(reinterpret_cast<const char*>(&node), sizeof(node));
+			bool flushed = false;
+			const uint32_t state = addState(sc, std::move(key), flushed);
+			sc.starts[slot] = state;
+			return state;
+		}
+		return sc.starts[slot];
+	}
+
+	uint32_t RegexDfa::step(const Program& prog, StateCache& sc, uint32_t state, uint16_t sym) const SOUP_EXCAL
+	{
+		const bool is_reverse = (&prog == &reverse);
+		const std::string& key = *sc.states[state];
+		const uint8_t ctx = static_cast<uint8_t>(key[0]);
+		const uint8_t ahead = symbol_info[sym];
+		const uint8_t before = (is_reverse ? ahead : ctx);
+		const uint8_t after = (is_reverse ? ctx : ahead);
+		const int16_t byte = symbol_byte[sym];
+
+		// The forward direction never needs to know if the byte behind it was the final newline.
+		std::string next(1, static_cast<char>(ahead & context_mask & (is_reverse ? 0xFF : ~CTX_FINAL_NL)));
+
+		sc.marks.resize(prog.nodes.size(), 0);
+		sc.added.resize(prog.nodes.size(), 0);
+		SOUP_IF_UNLIKELY (++sc.generation == 0)
+		{
+			std::fill(sc.marks.begin(), sc.marks.end(), 0);
+			std::fill(sc.added.begin(), sc.added.end(), 0);
+			sc.generation = 1;
+		}
+		const uint32_t gen = sc.generation;
+
+		// Follow the epsilon transitions of each thread in order of priority. Threads that can consume the byte go into the next state.
+		bool matched = false;
+		sc.matched.clear();
+		for (size_t i = 1; i != key.size(); i += sizeof(uint32_t))
+		{
+			uint32_t seed;
+			memcpy(&seed, &key[i], sizeof(seed));
+			if (seed == MATCHES_FOLLOW)
+			{
+				break;
+			}
+			sc.stack.emplace_back(seed);
+			while (!sc.stack.empty())
+			{
+				const uint32_t n = sc.stack.back();
+				sc.stack.pop_back();
+				if (sc.marks[n] == gen)
+				{
+					continue;
+				}
+				sc.marks[n] = gen;
+
+				const Node& node = prog.nodes[n];
+				switch (node.type)
+				{
+				case NODE_SPLIT:
+					for (auto it = node.out.rbegin(); it != node.out.rend(); ++it)
+					{
+						sc.stack.emplace_back(*it);
+					}
+					break;
+
+				case NODE_ASSERT:
+					if (checkAssertion(node.assertion, before, after))
+					{
+						sc.stack.emplace_back(node.out[0]);
+					}
+					break;
+
+				case NODE_BYTES:
+					if (byte != -1
+						&& sets[node.set].get(byte)
+						&& sc.added[node.out[0]] != gen
+						)
+					{
+						sc.added[node.out[0]] = gen;
+						next.append(reinterpret_cast<const char*>(&node.out[0]), sizeof(uint32_t));
+					}
+					break;
+
+				case NODE_MATCH:
+					matched = true;
+					if (num_patterns != 1)
+					{
+						// Every pattern is interesting, so we just take note of which one this was.
+						sc.matched.emplace_back(node.set);
+					}
+					else if (!is_reverse)
+					{
+						// Every thread we haven't gotten to has a lower priority than this match.
+						sc.stack.clear();
+						goto _done;
+					}
+					break;
+				}
+			}
+		}
+	_done:
+
+		if (!sc.matched.empty())
+		{
+			// The next state is the one to know which patterns matched, so it's a different state for different patterns.
+			std::sort(sc.matched.begin(), sc.matched.end());
+			const uint32_t sep = MATCHES_FOLLOW;
+			next.append(reinterpret_cast<const char*>(&sep), sizeof(sep));
+			next.append(reinterpret_cast<const char*>(sc.matched.data()), sc.matched.size() * sizeof(uint32_t));
+		}
+
+		uint32_t res = DEAD;
+		bool flushed = false;
+		if (next.size() != 1)
+		{
+			res = addState(sc, std::move(next), flushed);
+		}
+		if (matched)
+		{
+			res |= MATCH_FLAG;
+		}
+		if (!flushed)
+		{
+			sc.table[state * num_symbols + sym] = res;
+		}
+		return res;
+	}
+
+	bool RegexDfa::runForward(Cache& c, const char* it, const char* begin, const char* end, bool unanchored, bool earliest, const char*& match_end) const SOUP_EXCAL
+	{
+		StateCache& sc = c.forward;
+		uint8_t ctx = CTX_EOT;
+		if (it != begin)
+		{
+			ctx = getContext(it - 1, nullptr);
+		}
+		ctx &= context_mask;
+		uint32_t state = getStart(sc, unanchored ? unanchored_start : forward.start, ctx, (unanchored << 4) | ctx);
+
+		bool found = false;
+		const char* last = end;
+		if (final_newline && it != end && *(end - 1) == '\n')
+		{
+			--last;
+		}
+		for (; it != last; ++it)
+		{
+			uint32_t t = sc.table[state * num_symbols + classes[static_cast<uint8_t>(*it)]];
+			SOUP_IF_UNLIKELY (t == UNKNOWN)
+			{
+				t = step(forward, sc, state, classes[static_cast<uint8_t>(*it)]);
+			}
+			if (t & MATCH_FLAG)
+			{
+				found = true;
+				match_end = it;
+				if (earliest)
+				{
+					return true;
+				}
+			}
+			state = (t & ~MATCH_FLAG);
+			if (state == DEAD)
+			{
+				return found;
+			}
+		}
+		if (it != end)
+		{
+			// Final newline, which '$' may match in front of.
+			uint32_t t = sc.table[state * num_symbols + num_classes + 1];
+			if (t == UNKNOWN)
+			{
+				t = step(forward, sc, state, num_classes + 1);
+			}
+			if (t & MATCH_FLAG)
+			{
+				found = true;
+				match_end = it;
+				if (earliest)
+				{
+					return true;
+				}
+			}
+			state = (t & ~MATCH_FLAG);
+			if (state == DEAD)
+			{
+				return found;
+			}
+			++it;
+		}
+		uint32_t t = sc.table[state * num_symbols + num_classes];
+		if (t == UNKNOWN)
+		{
+			t = step(forward, sc, state, num_classes);
+		}
+		if (t & MATCH_FLAG)
+		{
+			found = true;
+			match_end = end;
+		}
+		return found;
+	}
+
+	void RegexDfa::runAll(Cache& c, const char* begin, const char* end, std::vector<bool>& matched) const SOUP_EXCAL
+	{
+		StateCache& sc = c.forward;
+		uint32_t state = getStart(sc, unanchored_start, CTX_EOT & context_mask, 0x10 | (CTX_EOT & context_mask));
+
+		size_t remaining = num_patterns;
+		auto process = [&](uint16_t sym)
+		{
+			uint32_t t = sc.table[state * num_symbols + sym];
+			SOUP_IF_UNLIKELY (t == UNKNOWN)
+			{
+				t = step(forward, sc, state, sym);
+			}
+			state = (t & ~MATCH_FLAG);
+			if (num_patterns == 1)
+			{
+				if (t & MATCH_FLAG)
+				{
+					matched[0] = true;
+					remaining = 0;
+				}
+			}
+			else if (t & MATCH_FLAG)
+			{
+				const std::string& key = *sc.states[state];
+				size_t i = 1;
+				for (uint32_t seed = 0; seed != MATCHES_FOLLOW; i += sizeof(uint32_t))
+				{
+					memcpy(&seed, &key[i], sizeof(seed));
+				}
+				for (; i != key.size(); i += sizeof(uint32_t))
+				{
+					uint32_t pattern;
+					memcpy(&pattern, &key[i], sizeof(pattern));
+					if (!matched[pattern])
+					{
+						matched[pattern] = true;
+						--remaining;
+					}
+				}
+			}
+			return remaining != 0;
+		};
+
+		const char* last = end;
+		if (final_newline && begin != end && *(end - 1) == '\n')
+		{
+			--last;
+		}
+		for (const char* it = begin; it != last; ++it)
+		{
+			if (!process(classes[static_cast<uint8_t>(*it)]))
+			{
+				return;
+			}
+		}
+		if (last != end
+			&& !process(num_classes + 1)
+			)
+		{
+			return;
+		}
+		process(num_classes);
+	}
+
+	bool RegexDfa::runReverse(Cache& c, const char* it, const char* begin, const char* end, const char*& match_begin) const SOUP_EXCAL
+	{
+		StateCache& sc = c.reverse;
+		uint8_t ctx = CTX_EOT;
+		if (it != end)
+		{
+			ctx = getContext(it, end);
+		}
+		ctx &= context_mask;
+		uint32_t state = getStart(sc, reverse.start, ctx, ctx);
+
+		bool found = false;
+		if (final_newline && it == end && it != begin && *(it - 1) == '\n')
+		{
+			uint32_t t = sc.table[state * num_symbols + num_classes + 1];
+			if (t == UNKNOWN)
+			{
+				t = step(reverse, sc, state, num_classes + 1);
+			}
+			if (t & MATCH_FLAG)
+			{
+				found = true;
+				match_begin = it;
+			}
+			state = (t & ~MATCH_FLAG);
+			if (state == DEAD)
+			{
+				return found;
+			}
+			--it;
+		}
+		for (; it != begin; --it)
+		{
+			uint32_t t = sc.table[state * num_symbols + classes[static_cast<uint8_t>(*(it - 1))]];
+			SOUP_IF_UNLIKELY (t == UNKNOWN)
+			{
+				t = step(reverse, sc, state, classes[static_cast<uint8_t>(*(it - 1))]);
+			}
+			if (t & MATCH_FLAG)
+			{
+				found = true;
+				match_begin = it;
+			}
+			state = (t & ~MATCH_FLAG);
+			if (state == DEAD)
+			{
+				return found;
+			}
+		}
+		uint32_t t = sc.table[state * num_symbols + num_classes];
+		if (t == UNKNOWN)
+		{
+			t = step(reverse, sc, state, num_classes);
+		}
+		if (t & MATCH_FLAG)
+		{
+			found = true;
+			match_begin = begin;
+		}
+		return found;
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fwd.hpp"
+
+#include "BigBitset.hpp"
+#include "Mutex.hpp"
+#include "UniquePtr.hpp"
+
+NAMESPACE_SOUP
+{
+	// A lazily-built DFA for regexes that don't need backtracking, i.e. ones without backreferences or lookaround.
+	// States are only created as the input requires them and are cached, so matching is linear in the length of the input.
+	// Alternatives are prioritised like the backtracking matcher does, so the same match is found.
+	class RegexDfa
+	{
+	protected:
+		static constexpr uint32_t UNKNOWN = -1;
+		static constexpr uint32_t DEAD = 0;
+		static constexpr uint32_t MATCH_FLAG = 0x80000000; // The position before the transition is the end of a match.
+		static constexpr size_t MAX_NODES = 0x10000;
+		static constexpr size_t CACHE_SIZE = 0x40000; // per direction, in bytes of transition table
+		static constexpr uint8_t ASSERT_NOT_END = 0xFF; // used by the unanchored start, as searches don't try to match at the end
+		static constexpr uint32_t MATCHES_FOLLOW = -1; // separates the node indices in a state's key from the patterns that matched on the way to it
+
+		// What we know about the byte on one side of a position.
+		enum Context : uint8_t
+		{
+			CTX_EOT = (1 << 0), // There is no byte, i.e. this is the beginning/end of the input.
+			CTX_NL = (1 << 1),
+			CTX_WORD = (1 << 2),
+			CTX_FINAL_NL = (1 << 3), // '\n' that is the last byte of the input.
+		};
+
+		enum NodeType : uint8_t
+		{
+			NODE_SPLIT, // Epsilon transitions, in order of priority.
+			NODE_BYTES,
+			NODE_ASSERT,
+			NODE_MATCH,
+		};
+
+		struct Node
+		{
+			NodeType type = NODE_SPLIT;
+			uint8_t assertion = 0;
+			uint32_t set = 0; // index into 'sets', or the index of the pattern for NODE_MATCH
+			std::vector<uint32_t> out{};
+		};
+
+		struct Program
+		{
+			std::vector<Node> nodes;
+			uint32_t start;
+		};
+
+		struct StateCache
+		{
+			std::vector<uint32_t> table{}; // 'num_symbols' transitions per state
+			std::vector<const std::string*> states{};
+			std::unordered_map<std::string, uint32_t> map{}; // key is context byte followed by the ordered node indices
+			uint32_t starts[0x20];
+			std::vector<uint32_t> stack{};
+			std::vector<uint32_t> marks{};
+			std::vector<uint32_t> added{};
+			std::vector<uint32_t> matched{};
+			uint32_t generation = 0;
+		};
+
+		struct Cache
+		{
+			StateCache forward;
+			StateCache reverse;
+		};
+
+		Program forward;
+		Program reverse; // for finding the beginning of a match given its end
+		uint32_t unanchored_start;
+		std::vector<BigBitset<0x100 / 8>> sets{};
+		uint8_t classes[0x100];
+		uint16_t num_classes;
+		uint16_t num_symbols; // byte classes, followed by end-of-text and final newline
+		std::vector<uint8_t> symbol_info{};
+		std::vector<int16_t> symbol_byte{}; // a byte in the class, or -1 for end-of-text
+		uint32_t num_patterns = 1;
+		uint8_t context_mask = 0;
+		bool final_newline = false;
+		bool captures = false;
+		mutable Mutex mtx;
+		mutable Cache cache;
+
+	public:
+		RegexDfa() = default;
+
+		// Returns nullptr if the regex can't be matched without backtracking.
+		[[nodiscard]] static UniquePtr<RegexDfa> compile(const RegexGroup& group) SOUP_EXCAL;
+
+		// Combines multiple patterns into one automaton that can only be used with searchAll.
+		// Returns nullptr if any of the regexes can't be matched without backtracking.
+		[[nodiscard]] static UniquePtr<RegexDfa> compile(const std::vector<const RegexGroup*>& groups) SOUP_EXCAL;
+
+		// If true, a match only tells us about the extent of group 0.
+		[[nodiscard]] bool hasCaptures() const noexcept
+		{
+			return captures;
+		}
+
+		// Checks if there is any match beginning at 'it'.
+		[[nodiscard]] bool matches(const char* it, const char* begin, const char* end) const noexcept;
+
+		// Finds the end of the match beginning at 'it'.
+		[[nodiscard]] bool match(const char* it, const char* begin, const char* end, const char*& match_end) const noexcept;
+
+		// Finds the first match beginning before 'end'.
+		[[nodiscard]] bool search(const char* begin, const char* end, const char*& match_begin, const char*& match_end) const noexcept;
+
+		// Finds out which of the patterns have a match beginning before 'end', in a single pass over the input.
+		void searchAll(const char* begin, const char* end, std::vector<bool>& matched) const noexcept;
+
+	protected:
+		[[nodiscard]] bool build(const std::vector<const RegexGroup*>& groups) SOUP_EXCAL;
+		void buildReverse() SOUP_EXCAL;
+		void buildClasses() SOUP_EXCAL;
+		[[nodiscard]] uint32_t addNode(Program& prog, NodeType type) SOUP_EXCAL;
+
+		[[nodiscard]] static bool checkAssertion(uint8_t assertion, uint8_t before, uint8_t after) noexcept;
+
+		[[nodiscard]] uint8_t getContext(const char* it, const char* end) const noexcept;
+		void flush(StateCache& sc) const SOUP_EXCAL;
+		[[nodiscard]] uint32_t addState(StateCache& sc, std::string&& key, bool& flushed) const SOUP_EXCAL;
+		[[nodiscard]] uint32_t getStart(StateCache& sc, uint32_t node, uint8_t ctx, uint8_t slot) const SOUP_EXCAL;
+		[[nodiscard]] uint32_t step(const Program& prog, StateCache& sc, uint32_t state, uint16_t sym) const SOUP_EXCAL;
+
+		[[nodiscard]] bool runForward(Cache& c, const char* it, const char* begin, const char* end, bool unanchored, bool earliest, const char*& match_end) const SOUP_EXCAL;
+		[[nodiscard]] bool runReverse(Cache& c, const char* it, const char* begin, const char* end, const char*& match_begin) const SOUP_EXCAL;
+		void runAll(Cache& c, const char* begin, const char* end, std::vector<bool>& matched) const SOUP_EXCAL;
+	};
+}
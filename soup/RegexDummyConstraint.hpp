@@ -22,5 +22,10 @@ NAMESPACE_SOUP
 		{
 			return true;
 		}
+
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return DFA_EPSILON;
+		}
 	};
 }
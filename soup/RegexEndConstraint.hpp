@@ -32,6 +32,15 @@ NAMESPACE_SOUP
 			return false;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			if constexpr (multi_line)
+			{
+				return DFA_ASSERT_LINE_END;
+			}
+			return end_only ? DFA_ASSERT_END : DFA_ASSERT_END_OR_FINAL_NEWLINE;
+		}
+
 		[[nodiscard]] std::string toString() const noexcept final
 		{
 			if constexpr (escape_sequence)
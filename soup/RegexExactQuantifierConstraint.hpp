@@ -17,6 +17,11 @@ NAMESPACE_SOUP
 			return true;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return DFA_EPSILON;
+		}
+
 		[[nodiscard]] RegexConstraint* getEntrypoint() noexcept final
 		{
 			return constraints.at(0)->getEntrypoint();
@@ -32,6 +32,11 @@ NAMESPACE_SOUP
 			return true;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return DFA_EPSILON;
+		}
+
 		[[nodiscard]] const RegexGroup* getGroupCaturedWithin() const noexcept final
 		{
 			return &data;
@@ -23,6 +23,11 @@ NAMESPACE_SOUP
 			return true;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return DFA_EPSILON;
+		}
+
 		[[nodiscard]] size_t getCursorAdvancement() const final
 		{
 			return constraints.at(0)->getCursorAdvancement() * constraints.size();
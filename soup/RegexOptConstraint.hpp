@@ -21,6 +21,11 @@ NAMESPACE_SOUP
 			return true;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return DFA_EPSILON;
+		}
+
 		[[nodiscard]] std::string toString() const noexcept final
 		{
 			std::string str = constraint->toString();
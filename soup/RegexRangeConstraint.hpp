@@ -298,6 +298,20 @@ NAMESPACE_SOUP
 			return true;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return DFA_BYTES;
+		}
+
+		void getDfaBytes(std::vector<BigBitset<0x100 / 8>>& seq) const SOUP_EXCAL final
+		{
+			auto& set = seq.emplace_back();
+			for (uint16_t i = 0; i != 0x100; ++i)
+			{
+				set.set(i, mask.get(i) != inverted);
+			}
+		}
+
 		static void appendPresentably(std::string& str, char c) noexcept
 		{
 			switch (c)
@@ -22,6 +22,11 @@ NAMESPACE_SOUP
 			return true;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return DFA_EPSILON;
+		}
+
 		[[nodiscard]] virtual RegexConstraint* getEntrypoint() noexcept final
 		{
 			return constraint->getEntrypoint();
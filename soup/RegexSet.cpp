@@ -0,0 +1,293 @@
+#include "RegexSet.hpp"
+
+#include <algorithm> // sort
+#include <cstring> // memcmp
+#include <string_view>
+
+#if SOUP_X86 && SOUP_BITS == 64
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#endif
+
+#include "bitutil.hpp"
+#include "CpuInfo.hpp"
+
+NAMESPACE_SOUP
+{
+	RegexSet::RegexSet(const std::vector<std::string>& patterns, uint16_t flags)
+	{
+		// A Regex must not be moved after construction since its constraints point to its group.
+		regexes.reserve(patterns.size());
+
+		std::vector<const RegexGroup*> groups{};
+		for (size_t i = 0; i != patterns.size(); ++i)
+		{
+			const Regex& r = regexes.emplace_back(patterns[i], flags);
+			if (r.dfa)
+			{
+				dfa_patterns.emplace_back(i);
+				groups.emplace_back(&r.group);
+			}
+			else
+			{
+				other_patterns.emplace_back(i);
+			}
+
+			uint32_t literal = NO_LITERAL;
+			if (std::string str = getRequiredLiteral(r.group); !str.empty())
+			{
+				literal = static_cast<uint32_t>(std::find(literals.begin(), literals.end(), str) - literals.begin());
+				if (literal == literals.size())
+				{
+					literals.emplace_back(std::move(str));
+				}
+			}
+			required_literal.emplace_back(literal);
+		}
+
+		if (!groups.empty())
+		{
+			dfa = RegexDfa::compile(groups);
+			if (!dfa)
+			{
+				// Too big to combine, but each of them still has its own DFA.
+				other_patterns.insert(other_patterns.end(), dfa_patterns.begin(), dfa_patterns.end());
+				std::sort(other_patterns.begin(), other_patterns.end());
+				dfa_patterns.clear();
+			}
+		}
+
+		buildFingerprints();
+	}
+
+	std::vector<size_t> RegexSet::matches(const std::string& str) const SOUP_EXCAL
+	{
+		return matches(str.data(), &str.data()[str.size()]);
+	}
+
+	std::vector<size_t> RegexSet::matches(const char* it, const char* end) const SOUP_EXCAL
+	{
+		std::vector<bool> found{};
+		findLiterals(it, end, found);
+		auto is_candidate = [&](size_t i)
+		{
+			return required_literal[i] == NO_LITERAL || found[required_literal[i]];
+		};
+
+		std::vector<size_t> res{};
+		if (std::any_of(dfa_patterns.begin(), dfa_patterns.end(), is_candidate))
+		{
+			std::vector<bool> matched{};
+			dfa->searchAll(it, end, matched);
+			for (size_t i = 0; i != dfa_patterns.size(); ++i)
+			{
+				if (matched[i])
+				{
+					res.emplace_back(dfa_patterns[i]);
+				}
+			}
+		}
+		for (const auto& i : other_patterns)
+		{
+			if (is_candidate(i)
+				&& regexes[i].search(it, end).isSuccess()
+				)
+			{
+				res.emplace_back(i);
+			}
+		}
+		std::sort(res.begin(), res.end());
+		return res;
+	}
+
+	std::vector<std::pair<size_t, RegexMatchResult>> RegexSet::search(const std::string& str) const SOUP_EXCAL
+	{
+		return search(str.data(), &str.data()[str.size()]);
+	}
+
+	std::vector<std::pair<size_t, RegexMatchResult>> RegexSet::search(const char* it, const char* end) const SOUP_EXCAL
+	{
+		std::vector<std::pair<size_t, RegexMatchResult>> res{};
+		for (const auto& i : matches(it, end))
+		{
+			res.emplace_back(i, regexes[i].search(it, end));
+		}
+		return res;
+	}
+
+	std::string RegexSet::getRequiredLiteral(const RegexGroup& group) SOUP_EXCAL
+	{
+		// With only one alternative, every top-level constraint has to match, so the longest run of single bytes has to be in the input.
+		std::string best{};
+		if (group.alternatives.size() == 1)
+		{
+			std::string run{};
+			auto end_run = [&]
+			{
+				if (run.size() > best.size())
+				{
+					best = std::move(run);
+				}
+				run.clear();
+			};
+
+			std::vector<BigBitset<0x100 / 8>> seq{};
+			for (const auto& c : group.alternatives[0].constraints)
+			{
+				const auto kind = c->getDfaKind();
+				if (kind == RegexConstraint::DFA_BYTES
+					&& !c->rollback_transition
+					)
+				{
+					seq.clear();
+					c->getDfaBytes(seq);
+					for (const auto& set : seq)
+					{
+						int byte = -1;
+						for (uint16_t i = 0; i != 0x100; ++i)
+						{
+							if (set.get(i))
+							{
+								byte = (byte == -1 ? i : -2);
+							}
+						}
+						if (byte < 0)
+						{
+							end_run();
+						}
+						else
+						{
+							run.push_back(static_cast<char>(byte));
+						}
+					}
+				}
+				else if (kind < RegexConstraint::DFA_ASSERT_BEGIN) // assertions don't consume anything, so they don't interrupt a run
+				{
+					end_run();
+				}
+			}
+			end_run();
+		}
+		return best;
+	}
+
+	void RegexSet::buildFingerprints() SOUP_EXCAL
+	{
+		if (literals.empty())
+		{
+			return;
+		}
+		fingerprint_len = 3;
+		for (const auto& literal : literals)
+		{
+			if (literal.size() < fingerprint_len)
+			{
+				fingerprint_len = static_cast<uint8_t>(literal.size());
+			}
+		}
+		for (uint32_t i = 0; i != literals.size(); ++i)
+		{
+			const uint8_t bit = (1 << (i % 8));
+			buckets[i % 8].emplace_back(i);
+			for (uint8_t j = 0; j != fingerprint_len; ++j)
+			{
+				const auto c = static_cast<uint8_t>(literals[i][j]);
+				fingerprint_lo[j][c & 0xF] |= bit;
+				fingerprint_hi[j][c >> 4] |= bit;
+			}
+		}
+	}
+
+	void RegexSet::findLiterals(const char* it, const char* end, std::vector<bool>& found) const SOUP_EXCAL
+	{
+		found.assign(literals.size(), false);
+		size_t remaining = literals.size();
+		if (remaining == 0)
+		{
+			return;
+		}
+#if SOUP_X86 && SOUP_BITS == 64
+		if (CpuInfo::get().supportsSSSE3())
+		{
+			it = findLiteralsSsse3(it, end, found, remaining);
+			if (remaining == 0)
+			{
+				return;
+			}
+		}
+#endif
+		const std::string_view view(it, end - it);
+		for (uint32_t i = 0; i != literals.size(); ++i)
+		{
+			if (!found[i]
+				&& view.find(literals[i]) != std::string_view::npos
+				)
+			{
+				found[i] = true;
+			}
+		}
+	}
+
+#if SOUP_X86 && SOUP_BITS == 64
+#if defined(__GNUC__) || defined(__clang__)
+	__attribute__((target("ssse3")))
+#endif
+	const char* RegexSet::findLiteralsSsse3(const char* it, const char* end, std::vector<bool>& found, size_t& remaining) const noexcept
+	{
+		const __m128i nibble = _mm_set1_epi8(0x0F);
+		__m128i lo[3];
+		__m128i hi[3];
+		for (uint8_t i = 0; i != fingerprint_len; ++i)
+		{
+			lo[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fingerprint_lo[i]));
+			hi[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fingerprint_hi[i]));
+		}
+
+		// Each iteration checks 16 possible starting positions.
+		for (; end - it >= 16 + fingerprint_len - 1; it += 16)
+		{
+			__m128i candidates = _mm_set1_epi8(-1);
+			for (uint8_t i = 0; i != fingerprint_len; ++i)
+			{
+				const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + i));
+				const __m128i l = _mm_shuffle_epi8(lo[i], _mm_and_si128(data, nibble));
+				const __m128i h = _mm_shuffle_epi8(hi[i], _mm_and_si128(_mm_srli_epi16(data, 4), nibble));
+				candidates = _mm_and_si128(candidates, _mm_and_si128(l, h));
+			}
+			uint32_t mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(candidates, _mm_setzero_si128())) & 0xFFFF;
+			if (mask == 0)
+			{
+				continue;
+			}
+
+			alignas(16) uint8_t bits[16];
+			_mm_store_si128(reinterpret_cast<__m128i*>(bits), candidates);
+			do
+			{
+				const auto j = bitutil::getLeastSignificantSetBit(mask);
+				for (uint8_t b = bits[j]; b != 0; b &= (b - 1))
+				{
+					for (const auto& i : buckets[bitutil::getLeastSignificantSetBit(static_cast<uint16_t>(b))])
+					{
+						if (!found[i]
+							&& literals[i].size() <= static_cast<size_t>(end - (it + j))
+							&& memcmp(it + j, literals[i].data(), literals[i].size()) == 0
+							)
+						{
+							found[i] = true;
+							if (--remaining == 0)
+							{
+								return end;
+							}
+						}
+					}
+				}
+				bitutil::unsetLeastSignificantSetBit(mask);
+			} while (mask);
+		}
+
+		// The remaining starting positions are left to the caller, so literals that started before 'it' must have been found by now.
+		return it;
+	}
+#endif
+}
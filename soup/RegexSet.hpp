@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <utility> // pair
+#include <vector>
+
+#include "base.hpp"
+#include "Regex.hpp"
+
+NAMESPACE_SOUP
+{
+	// Matches many regexes against the same input in a single pass.
+	// Patterns that contain a literal string are only considered if that literal occurs in the input, which is checked for all literals at once.
+	class RegexSet
+	{
+	protected:
+		static constexpr uint32_t NO_LITERAL = -1;
+
+		std::vector<Regex> regexes; // The prefilters are built for these, so they must not change after construction.
+		UniquePtr<RegexDfa> dfa; // combines the patterns in 'dfa_patterns'
+		std::vector<size_t> dfa_patterns{};
+		std::vector<size_t> other_patterns{}; // patterns that need backtracking
+		std::vector<std::string> literals{};
+		std::vector<uint32_t> required_literal{}; // for each pattern, an index into 'literals' or NO_LITERAL
+
+		// Teddy-style fingerprints over the first bytes of each literal: Each literal is put into one of 8 buckets, and a byte can only be
+		// the beginning of a literal from a bucket if the masks for its low and high nibbles (and those of the bytes after it) have the bucket's bit set.
+		uint8_t fingerprint_len = 0;
+		uint8_t fingerprint_lo[3][16]{};
+		uint8_t fingerprint_hi[3][16]{};
+		std::vector<uint32_t> buckets[8];
+
+	public:
+		RegexSet(const std::vector<std::string>& patterns, uint16_t flags = 0);
+
+		[[nodiscard]] size_t size() const noexcept
+		{
+			return regexes.size();
+		}
+
+		[[nodiscard]] const std::vector<Regex>& getRegexes() const noexcept
+		{
+			return regexes;
+		}
+
+		// Returns the indices of the patterns that have a match in the string, in ascending order.
+		[[nodiscard]] std::vector<size_t> matches(const std::string& str) const SOUP_EXCAL;
+		[[nodiscard]] std::vector<size_t> matches(const char* it, const char* end) const SOUP_EXCAL;
+
+		// Like 'matches', but also provides the first match of each pattern.
+		[[nodiscard]] std::vector<std::pair<size_t, RegexMatchResult>> search(const std::string& str) const SOUP_EXCAL;
+		[[nodiscard]] std::vector<std::pair<size_t, RegexMatchResult>> search(const char* it, const char* end) const SOUP_EXCAL;
+
+	protected:
+		[[nodiscard]] static std::string getRequiredLiteral(const RegexGroup& group) SOUP_EXCAL;
+		void buildFingerprints() SOUP_EXCAL;
+
+		// Sets 'found' for each literal that occurs in the input.
+		void findLiterals(const char* it, const char* end, std::vector<bool>& found) const SOUP_EXCAL;
+#if SOUP_X86 && SOUP_BITS == 64
+		[[nodiscard]] const char* findLiteralsSsse3(const char* it, const char* end, std::vector<bool>& found, size_t& remaining) const noexcept;
+#endif
+	};
+}
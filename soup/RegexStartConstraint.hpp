@@ -25,6 +25,11 @@ NAMESPACE_SOUP
 			return false;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return multi_line ? DFA_ASSERT_LINE_BEGIN : DFA_ASSERT_BEGIN;
+		}
+
 		[[nodiscard]] std::string toString() const noexcept final
 		{
 			return escape_sequence ? "\\A" : "^";
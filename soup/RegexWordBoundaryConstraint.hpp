@@ -28,6 +28,11 @@ NAMESPACE_SOUP
 			}
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return inverted ? DFA_ASSERT_NOT_WORD_BOUNDARY : DFA_ASSERT_WORD_BOUNDARY;
+		}
+
 		[[nodiscard]] std::string toString() const noexcept final
 		{
 			return inverted ? "\\B" : "\\b";
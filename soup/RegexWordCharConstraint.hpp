@@ -15,6 +15,20 @@ NAMESPACE_SOUP
 			return string::isWordChar(*m.it++) ^ inverted;
 		}
 
+		[[nodiscard]] DfaKind getDfaKind() const noexcept final
+		{
+			return DFA_BYTES;
+		}
+
+		void getDfaBytes(std::vector<BigBitset<0x100 / 8>>& seq) const SOUP_EXCAL final
+		{
+			auto& set = seq.emplace_back();
+			for (uint16_t i = 0; i != 0x100; ++i)
+			{
+				set.set(i, string::isWordChar(static_cast<char>(i)) ^ inverted);
+			}
+		}
+
 		[[nodiscard]] std::string toString() const noexcept final
 		{
 			return inverted ? "\\W" : "\\w";
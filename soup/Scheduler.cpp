@@ -3,6 +3,11 @@
 #if !SOUP_WINDOWS
 #include <netinet/tcp.h> // TCP_NODELAY
 #endif
+#if SOUP_LINUX
+#include <cerrno> // EEXIST
+#include <sys/epoll.h>
+#include <unistd.h> // close
+#endif
 
 #include "log.hpp"
 #include "os.hpp"
@@ -21,10 +26,44 @@
 
 NAMESPACE_SOUP
 {
+#if SOUP_LINUX
+	// Sockets that are closed while parked don't get any more events, so the parked sockets are checked this often.
+	static constexpr time_t EPOLL_SWEEP_INTERVAL = 50;
+#endif
+
+	Scheduler::~Scheduler()
+	{
+#if SOUP_LINUX
+		if (epoll_fd != -1)
+		{
+			::close(epoll_fd);
+		}
+#endif
+	}
+
+	void Scheduler::setUseEpoll() noexcept
+	{
+#if SOUP_LINUX
+		if (epoll_fd == -1)
+		{
+			epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+		}
+#endif
+	}
+
+	bool Scheduler::isUsingEpoll() const noexcept
+	{
+#if SOUP_LINUX
+		return epoll_fd != -1;
+#else
+		return false;
+#endif
+	}
+
 	void Scheduler::addWorker(SharedPtr<Worker>&& w)
 	{
 		SOUP_ASSERT(w); // SharedPtr must hold a pointer
-		pending_workers.emplace_front(std::move(w));
+		pending_workers.push(std::move(w));
 	}
 
 #if !SOUP_WASM
@@ -99,6 +138,27 @@ NAMESPACE_SOUP
 		return workers.size() != passive_workers || !pending_workers.empty();
 	}
 
+	void Scheduler::clearWorkers() noexcept
+	{
+#if SOUP_LINUX
+		if (epoll_fd != -1)
+		{
+			for (const auto& w : workers)
+			{
+				if (w->type == WORKER_TYPE_SOCKET)
+				{
+					static_cast<Socket*>(w.get())->epoll.parked = false;
+					static_cast<Socket*>(w.get())->epoll.dirty = false;
+					epollForget(*static_cast<Socket*>(w.get()));
+				}
+			}
+			epoll_parked = 0;
+			epoll_dirty.clear();
+		}
+#endif
+		workers.clear();
+	}
+
 	void Scheduler::tick()
 	{
 		const auto prev_scheduler = this_thread_running_scheduler;
@@ -107,12 +167,7 @@ NAMESPACE_SOUP
 		std::vector<pollfd> pollfds{};
 		uint8_t workload_flags; // dummy for the out-param
 		tick(pollfds, workload_flags);
-#if !SOUP_WASM
-		if (poll(pollfds, 0) > 0)
-		{
-			processPollResults(pollfds);
-		}
-#endif
+		pollAndProcess(pollfds, 0);
 
 		this_thread_running_scheduler = prev_scheduler;
 	}
@@ -121,23 +176,34 @@ NAMESPACE_SOUP
 	{
 		// Schedule in pending workers
 		{
-			auto num_pending_workers = pending_workers.size();
+			const auto num_pending_workers = pending_workers.size();
 			SOUP_IF_UNLIKELY (num_pending_workers != 0)
 			{
 				workers.reserve(workers.size() + num_pending_workers);
-				do
+				pending_workers.popAll([&](SharedPtr<Worker>&& worker)
 				{
-					auto worker = pending_workers.pop_back();
-					workers.emplace_back(std::move(*worker));
-				} while (--num_pending_workers);
+					workers.emplace_back(std::move(worker));
+				});
 			}
 		}
 
 		// Process workers
+		auto i = workers.begin();
+#if SOUP_LINUX
+		if (epoll_fd != -1)
+		{
+			// Parked sockets are only looked at if epoll reported them.
+			epollUnparkDirty();
+			i += epoll_parked;
+		}
+		else
+#endif
+		{
 #if !SOUP_WASM
-		pollfds.reserve(workers.size());
+			pollfds.reserve(workers.size());
 #endif
-		for (auto i = workers.begin(); i != workers.end(); )
+		}
+		while (i != workers.end())
 		{
 			if ((*i)->type == WORKER_TYPE_SOCKET)
 			{
@@ -154,10 +220,26 @@ NAMESPACE_SOUP
 				{
 					on_work_done(*i->get(), *this);
 				}
+#if SOUP_LINUX
+				if ((*i)->type == WORKER_TYPE_SOCKET)
+				{
+					epollForget(*static_cast<Socket*>(i->get()));
+				}
+#endif
 				i = workers.erase(i);
 				continue;
 			}
 			tickWorker(pollfds, workload_flags, **i);
+#if SOUP_LINUX
+			if ((*i)->type == WORKER_TYPE_SOCKET
+				&& static_cast<Socket*>(i->get())->epoll.parked
+				)
+			{
+				static_cast<Socket*>(i->get())->epoll.index = epoll_parked;
+				std::swap(*i, workers[epoll_parked]);
+				++epoll_parked;
+			}
+#endif
 			++i;
 		}
 	}
@@ -167,6 +249,29 @@ NAMESPACE_SOUP
 #if !SOUP_WASM
 		if (w.holdup_type == Worker::SOCKET)
 		{
+			if (static_cast<Socket&>(w).transport_hasBufferedData())
+			{
+				// The data this socket is waiting for has already been read from the kernel, so polling would not report it.
+#if SOUP_LINUX
+				if (epoll_fd == -1)
+#endif
+				{
+					pollfds.emplace_back(pollfd{
+						(Socket::fd_t)-1,
+						0
+					});
+				}
+				workload_flags |= NOT_JUST_SOCKETS;
+				fireHoldupCallback(w);
+				return;
+			}
+#if SOUP_LINUX
+			if (epoll_fd != -1)
+			{
+				epollPark(static_cast<Socket&>(w));
+				return;
+			}
+#endif
 			pollfds.emplace_back(pollfd{
 				static_cast<Socket&>(w).fd,
 				POLLIN
@@ -176,10 +281,15 @@ NAMESPACE_SOUP
 #endif
 		{
 #if !SOUP_WASM
-			pollfds.emplace_back(pollfd{
-				(Socket::fd_t)-1,
-				0
-			});
+#if SOUP_LINUX
+			if (epoll_fd == -1)
+#endif
+			{
+				pollfds.emplace_back(pollfd{
+					(Socket::fd_t)-1,
+					0
+				});
+			}
 #endif
 
 			int dispo = Worker::NEUTRAL;
@@ -216,12 +326,7 @@ NAMESPACE_SOUP
 
 	void Scheduler::yieldBusyspin(std::vector<pollfd>& pollfds, uint8_t workload_flags)
 	{
-#if !SOUP_WASM
-		if (poll(pollfds, 0) > 0)
-		{
-			processPollResults(pollfds);
-		}
-#endif
+		pollAndProcess(pollfds, 0);
 		if (!(workload_flags & HAS_HIGH_FREQUENCY_TASKS))
 		{
 			os::sleep(1);
@@ -241,6 +346,19 @@ NAMESPACE_SOUP
 			timeout = -1;
 		}
 #endif
+		pollAndProcess(pollfds, timeout);
+#endif
+	}
+
+	void Scheduler::pollAndProcess(std::vector<pollfd>& pollfds, int timeout)
+	{
+#if SOUP_LINUX
+		if (epoll_fd != -1)
+		{
+			return epollAndProcess(timeout);
+		}
+#endif
+#if !SOUP_WASM
 		if (poll(pollfds, timeout) > 0)
 		{
 			processPollResults(pollfds);
@@ -281,6 +399,162 @@ NAMESPACE_SOUP
 	}
 #endif
 
+#if SOUP_LINUX
+	// Sockets are registered with the epoll instance by fd and only armed while parked. Since epoll is level-triggered, a parked socket going from one recv
+	// to the next stays parked and does not need any epoll_ctl calls.
+	void Scheduler::epollPark(Socket& s) noexcept
+	{
+		if (s.fd == -1)
+		{
+			return;
+		}
+		epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.u64 = 0;
+		ev.data.fd = s.fd;
+		if (s.epoll.fd == s.fd
+			&& static_cast<size_t>(s.fd) < epoll_sockets.size()
+			&& epoll_sockets[s.fd] == &s
+			)
+		{
+			if (::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, s.fd, &ev) != 0)
+			{
+				return;
+			}
+		}
+		else
+		{
+			// The fd may still be registered if it was moved here from another Socket.
+			if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, s.fd, &ev) != 0
+				&& (errno != EEXIST || ::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, s.fd, &ev) != 0)
+				)
+			{
+				return;
+			}
+			if (static_cast<size_t>(s.fd) >= epoll_sockets.size())
+			{
+				epoll_sockets.resize(s.fd + 1, nullptr);
+			}
+			epoll_sockets[s.fd] = &s;
+			s.epoll.fd = s.fd;
+		}
+		s.epoll.parked = true;
+	}
+
+	void Scheduler::epollUnpark(Socket& s) noexcept
+	{
+		const auto last = --epoll_parked;
+		if (s.epoll.index != last)
+		{
+			std::swap(workers[s.epoll.index], workers[last]);
+			static_cast<Socket*>(workers[s.epoll.index].get())->epoll.index = s.epoll.index;
+		}
+		s.epoll.parked = false;
+		if (s.fd != -1
+			&& s.fd == s.epoll.fd
+			)
+		{
+			epoll_event ev;
+			ev.events = 0;
+			ev.data.u64 = 0;
+			ev.data.fd = s.fd;
+			::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, s.fd, &ev);
+		}
+	}
+
+	void Scheduler::epollMarkDirty(Socket& s) SOUP_EXCAL
+	{
+		if (!s.epoll.dirty)
+		{
+			s.epoll.dirty = true;
+			epoll_dirty.emplace_back(&s);
+		}
+	}
+
+	void Scheduler::epollUnparkDirty() noexcept
+	{
+		for (const auto& s : epoll_dirty)
+		{
+			s->epoll.dirty = false;
+			if (s->epoll.parked
+				&& (s->fd == -1 || s->holdup_type != Worker::SOCKET || s->transport_hasBufferedData())
+				)
+			{
+				epollUnpark(*s);
+			}
+		}
+		epoll_dirty.clear();
+
+		if (time::millis() >= epoll_next_sweep)
+		{
+			epoll_next_sweep = time::millis() + EPOLL_SWEEP_INTERVAL;
+			for (size_t i = epoll_parked; i-- != 0; )
+			{
+				Socket& s = *static_cast<Socket*>(workers[i].get());
+				if (s.fd == -1 || s.holdup_type != Worker::SOCKET || s.transport_hasBufferedData())
+				{
+					epollUnpark(s);
+				}
+			}
+		}
+	}
+
+	void Scheduler::epollForget(Socket& s) noexcept
+	{
+		if (s.epoll.fd != -1)
+		{
+			if (static_cast<size_t>(s.epoll.fd) < epoll_sockets.size()
+				&& epoll_sockets[s.epoll.fd] == &s
+				)
+			{
+				epoll_sockets[s.epoll.fd] = nullptr;
+				if (s.fd == s.epoll.fd)
+				{
+					// The worker is about to be removed, but the socket may outlive it, so we can't rely on the fd being closed.
+					::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s.fd, nullptr);
+				}
+			}
+			s.epoll.fd = -1;
+		}
+	}
+
+	void Scheduler::epollAndProcess(int timeout)
+	{
+		epoll_event events[256];
+		const int num_events = ::epoll_wait(epoll_fd, events, sizeof(events) / sizeof(events[0]), timeout);
+		for (int i = 0; i < num_events; ++i)
+		{
+			const int fd = events[i].data.fd;
+			Socket* const s = (static_cast<size_t>(fd) < epoll_sockets.size() ? epoll_sockets[fd] : nullptr);
+			SOUP_IF_UNLIKELY (s == nullptr || s->fd != fd || !s->epoll.parked)
+			{
+				// The socket this fd was registered for has since been closed or moved away from.
+				::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+				if (s != nullptr)
+				{
+					epoll_sockets[fd] = nullptr;
+					s->epoll.fd = -1;
+					if (s->epoll.parked)
+					{
+						epollMarkDirty(*s);
+					}
+				}
+				continue;
+			}
+			epollMarkDirty(*s);
+			if (events[i].events & ~EPOLLIN)
+			{
+				s->remote_closed = true;
+				processClosedSocket(*s);
+			}
+			else
+			{
+				fireHoldupCallback(*s);
+			}
+		}
+	}
+#endif
+
 	void Scheduler::fireHoldupCallback(Worker& w)
 	{
 #if defined(_DEBUG) || !SOUP_EXCEPTIONS
@@ -382,22 +656,22 @@ NAMESPACE_SOUP
 			}
 		}
 
-		// Iterating over the AtomicDeque is fine here because this function should only be called on the scheduler thread, which is the same one that would pop.
-		for (auto node = pending_workers.head.load(); node != nullptr; node = node->next.load())
+		// Iterating over the pending workers is fine here because this function should only be called on the scheduler thread, which is the same one that would pop.
+		SharedPtr<Socket> res;
+		pending_workers.forEach([&](const SharedPtr<Worker>& w)
 		{
-			const SharedPtr<Socket>& w = node->data;
-			if (w->type == WORKER_TYPE_SOCKET
+			if (!res
+				&& w->type == WORKER_TYPE_SOCKET
 				&& static_cast<Socket*>(w.get())->custom_data.isStructInMap(ReuseTag)
 				&& static_cast<Socket*>(w.get())->custom_data.getStructFromMapConst(ReuseTag).host == host
 				&& static_cast<Socket*>(w.get())->custom_data.getStructFromMapConst(ReuseTag).port == port
 				&& static_cast<Socket*>(w.get())->custom_data.getStructFromMapConst(ReuseTag).tls == tls
 				)
 			{
-				return w;
+				res = w;
 			}
-		}
-
-		return {};
+		});
+		return res;
 	}
 
 	void Scheduler::closeReusableSockets() SOUP_EXCAL
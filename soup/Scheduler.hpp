@@ -12,7 +12,7 @@
 #include <poll.h>
 #endif
 
-#include "AtomicDeque.hpp"
+#include "SegmentedMpmcQueue.hpp"
 #include "SharedPtr.hpp"
 #include "Worker.hpp"
 
@@ -26,8 +26,8 @@ NAMESPACE_SOUP
 		inline static thread_local Scheduler* this_thread_running_scheduler = nullptr;
 
 	public:
-		std::vector<SharedPtr<Worker>> workers{};
-		AtomicDeque<SharedPtr<Worker>> pending_workers{};
+		std::vector<SharedPtr<Worker>> workers{}; // If epoll is used, the order is managed by the scheduler.
+		SegmentedMpmcQueue<SharedPtr<Worker>> pending_workers{};
 		size_t passive_workers = 0;
 		uint8_t default_workload_flags = 0;
 #if !SOUP_WASM
@@ -37,6 +37,15 @@ NAMESPACE_SOUP
 #if SOUP_WINDOWS
 		bool add_worker_can_wait_forever_for_all_i_care = false;
 #endif
+#if SOUP_LINUX
+		int epoll_fd = -1;
+		size_t epoll_parked = 0; // workers[0, epoll_parked) are sockets waiting for epoll to report them as ready
+		std::vector<Socket*> epoll_sockets{}; // by fd
+		std::vector<Socket*> epoll_dirty{};
+		time_t epoll_next_sweep = 0;
+	protected:
+		bool listen_reuse_port = false; // Used by Server. Part of Scheduler because the C API requires both to have the same size.
+#endif
 
 	public:
 		using on_work_done_t = void(*)(Worker&, Scheduler&);
@@ -51,7 +60,7 @@ NAMESPACE_SOUP
 		on_exception_t on_exception = &on_exception_log;
 #endif
 
-		virtual ~Scheduler() = default;
+		virtual ~Scheduler();
 
 		virtual void addWorker(SharedPtr<Worker>&& w);
 
@@ -102,6 +111,12 @@ NAMESPACE_SOUP
 			default_workload_flags |= HAS_HIGH_FREQUENCY_TASKS;
 		}
 
+		// On Linux, sockets will be waited on via epoll instead of poll, so a wakeup only costs as much as the number of sockets that are actually ready.
+		// Recommended for schedulers that hold many mostly-idle sockets. This is a no-op on other platforms, and if epoll is not available.
+		// Should be called before any sockets are added.
+		void setUseEpoll() noexcept;
+		[[nodiscard]] bool isUsingEpoll() const noexcept;
+
 		void run();
 		void runFor(unsigned int ms);
 		[[nodiscard]] bool shouldKeepRunning() const noexcept;
@@ -117,10 +132,20 @@ NAMESPACE_SOUP
 		void tickWorker(std::vector<pollfd>& pollfds, uint8_t& workload_flags, Worker& w);
 		void yieldBusyspin(std::vector<pollfd>& pollfds, uint8_t workload_flags);
 		void yieldKernel(std::vector<pollfd>& pollfds);
+		void pollAndProcess(std::vector<pollfd>& pollfds, int timeout);
 #if !SOUP_WASM
 		int poll(std::vector<pollfd>& pollfds, int timeout);
 		void processPollResults(const std::vector<pollfd>& pollfds);
 #endif
+#if SOUP_LINUX
+		void epollPark(Socket& s) noexcept;
+		void epollUnpark(Socket& s) noexcept;
+		void epollMarkDirty(Socket& s) SOUP_EXCAL;
+		void epollUnparkDirty() noexcept;
+		void epollForget(Socket& s) noexcept;
+		void epollAndProcess(int timeout);
+#endif
+		void clearWorkers() noexcept;
 		void fireHoldupCallback(Worker& w);
 #if !SOUP_WASM
 		void processClosedSocket(Socket& s);
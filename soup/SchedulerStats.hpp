@@ -2,15 +2,18 @@
 
 #include "Task.hpp"
 
+#include <atomic>
+
 #include "ObfusString.hpp"
 #include "Scheduler.hpp"
 
 NAMESPACE_SOUP
 {
+	// The numbers are sampled whenever the scheduler ticks, and may be read from other threads.
 	struct SchedulerStats : public Task
 	{
-		size_t num_workers;
-		size_t num_sockets;
+		std::atomic_size_t num_workers = 0; // including this task
+		std::atomic_size_t num_sockets = 0;
 
 		SchedulerStats()
 		{
@@ -18,8 +21,13 @@ NAMESPACE_SOUP
 
 		void onTick() final
 		{
-			num_workers = Scheduler::get()->getNumWorkers();
-			num_sockets = Scheduler::get()->getNumSockets();
+			num_workers.store(Scheduler::get()->getNumWorkers(), std::memory_order_relaxed);
+			num_sockets.store(Scheduler::get()->getNumSockets(), std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] int getSchedulingDisposition() const noexcept final
+		{
+			return LOW_FREQUENCY;
 		}
 
 		std::string toString() const SOUP_EXCAL final
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "MpmcQueue.hpp"
+
+NAMESPACE_SOUP
+{
+	// An unbounded lock-free queue for any number of producers and consumers, made up of MpmcQueue segments.
+	// When the last segment is full, it is closed and a new one is appended. Drained segments are unlinked and freed once no thread is inside the queue.
+	template <typename T, size_t SEGMENT_CAPACITY = 64>
+	class SegmentedMpmcQueue
+	{
+	protected:
+		struct Segment : public MpmcQueue<T>
+		{
+			std::atomic<Segment*> next = nullptr;
+			Segment* next_retired = nullptr;
+
+			Segment() SOUP_EXCAL
+				: MpmcQueue<T>(SEGMENT_CAPACITY)
+			{
+			}
+		};
+
+		// Counts the threads that are inside the queue, so retired segments are only freed when nobody could still be looking at them.
+		struct Guard
+		{
+			const SegmentedMpmcQueue& q;
+
+			Guard(const SegmentedMpmcQueue& q) noexcept
+				: q(q)
+			{
+				++q.active;
+			}
+
+			~Guard() noexcept
+			{
+				if (--q.active == 0
+					&& q.retired.load(std::memory_order_relaxed) != nullptr
+					)
+				{
+					q.reclaim();
+				}
+			}
+		};
+
+		std::atomic<Segment*> head;
+		char pad0[64];
+		std::atomic<Segment*> tail;
+		char pad1[64];
+		mutable std::atomic_size_t active{ 0 };
+		mutable std::atomic<Segment*> retired{ nullptr };
+
+	public:
+		SegmentedMpmcQueue() SOUP_EXCAL
+		{
+			Segment* const seg = new Segment();
+			head = seg;
+			tail = seg;
+		}
+
+		SegmentedMpmcQueue(const SegmentedMpmcQueue&) = delete;
+		SegmentedMpmcQueue& operator=(const SegmentedMpmcQueue&) = delete;
+
+		~SegmentedMpmcQueue() noexcept
+		{
+			for (Segment* seg = head.load(); seg != nullptr; )
+			{
+				Segment* const next = seg->next.load();
+				delete seg;
+				seg = next;
+			}
+			freeRetired(retired.load());
+		}
+
+		void push(T&& value) SOUP_EXCAL
+		{
+			Guard g(*this);
+			while (true)
+			{
+				Segment* seg = tail.load();
+				if (seg->tryPush(std::move(value)))
+				{
+					return;
+				}
+
+				// Closing the segment makes sure nothing is pushed to it after consumers moved on.
+				seg->close();
+				Segment* next = seg->next.load();
+				if (next == nullptr)
+				{
+					Segment* const fresh = new Segment();
+					(void)fresh->tryPush(std::move(value));
+					if (seg->next.compare_exchange_strong(next, fresh))
+					{
+						tail.compare_exchange_strong(seg, fresh);
+						return;
+					}
+					(void)fresh->tryPop(value);
+					delete fresh;
+				}
+				tail.compare_exchange_strong(seg, next);
+			}
+		}
+
+		// Returns false if the queue is empty.
+		[[nodiscard]] bool pop(T& out) SOUP_EXCAL
+		{
+			Guard g(*this);
+			return popImpl(out);
+		}
+
+		// Pops values until the queue is empty, which is cheaper than calling pop for each of them.
+		template <typename F>
+		void popAll(F&& f) SOUP_EXCAL
+		{
+			Guard g(*this);
+			T value;
+			while (popImpl(value))
+			{
+				f(std::move(value));
+			}
+		}
+
+		// Only a snapshot if other threads are using the queue.
+		[[nodiscard]] size_t size() const noexcept
+		{
+			Guard g(*this);
+			size_t res = 0;
+			for (Segment* seg = head.load(); seg != nullptr; seg = seg->next.load())
+			{
+				res += seg->size();
+			}
+			return res;
+		}
+
+		// Only a snapshot if other threads are using the queue.
+		[[nodiscard]] bool empty() const noexcept
+		{
+			Guard g(*this);
+			for (Segment* seg = head.load(); seg != nullptr; seg = seg->next.load())
+			{
+				if (!seg->empty())
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Calls the function for each value in the queue. This must only be done by the only thread that pops from this queue.
+		template <typename F>
+		void forEach(F&& f) const
+		{
+			Guard g(*this);
+			for (Segment* seg = head.load(); seg != nullptr; seg = seg->next.load())
+			{
+				seg->forEach(f);
+			}
+		}
+
+	protected:
+		[[nodiscard]] bool popImpl(T& out) SOUP_EXCAL
+		{
+			while (true)
+			{
+				Segment* seg = head.load();
+				if (seg->tryPop(out))
+				{
+					return true;
+				}
+				Segment* const next = seg->next.load();
+				if (next == nullptr
+					|| !seg->isDrained() // a producer is still writing to this segment, so its value is yet to be pushed
+					)
+				{
+					return false;
+				}
+				if (head.compare_exchange_strong(seg, next))
+				{
+					Segment* expected = seg;
+					tail.compare_exchange_strong(expected, next);
+					retire(seg);
+				}
+			}
+		}
+
+		void retire(Segment* seg) noexcept
+		{
+			Segment* next = retired.load();
+			do
+			{
+				seg->next_retired = next;
+			} while (!retired.compare_exchange_weak(next, seg));
+		}
+
+		void reclaim() const noexcept
+		{
+			// Segments are retired after being unlinked, so if nobody is inside the queue after we took them, nobody can be using them anymore.
+			Segment* const list = retired.exchange(nullptr);
+			if (list == nullptr)
+			{
+				return;
+			}
+			if (active.load() == 0)
+			{
+				freeRetired(list);
+				return;
+			}
+			Segment* last = list;
+			while (last->next_retired)
+			{
+				last = last->next_retired;
+			}
+			Segment* next = retired.load();
+			do
+			{
+				last->next_retired = next;
+			} while (!retired.compare_exchange_weak(next, list));
+		}
+
+		static void freeRetired(Segment* seg) noexcept
+		{
+			while (seg)
+			{
+				Segment* const next = seg->next_retired;
+				delete seg;
+				seg = next;
+			}
+		}
+	};
+}
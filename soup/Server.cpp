@@ -78,7 +78,7 @@ NAMESPACE_SOUP
 				{
 					service->on_connection_established(*s, *service, *server);
 				}
-				s->transport_recv([](Socket& s, std::string&& data, Capture&& _cap)
+				s->transport_recv(3, [](Socket& s, std::string&& data, Capture&& _cap)
 				{
 					s.transport_unrecv(data);
 					CaptureServerPortOptCrypto& cap = *_cap.get<CaptureServerPortOptCrypto*>();
@@ -103,6 +103,7 @@ NAMESPACE_SOUP
 	bool Server::bind(uint16_t port, ServerService* service) SOUP_EXCAL
 	{
 		Socket sock6{};
+		prepareListener(sock6, AF_INET6, SOCK_STREAM);
 		if (!sock6.bind6(port))
 		{
 			return false;
@@ -132,6 +133,7 @@ NAMESPACE_SOUP
 		if (!ip.isV4())
 #endif
 		{
+			prepareListener(sock, AF_INET6, SOCK_STREAM);
 			SOUP_RETHROW_FALSE(sock.bind6(SOCK_STREAM, port, ip));
 			setDataAvailableHandler6(sock);
 		}
@@ -150,6 +152,7 @@ NAMESPACE_SOUP
 	bool Server::bindCrypto(uint16_t port, ServerService* service, SharedPtr<CertStore> certstore, tls_server_on_client_hello_t on_client_hello) SOUP_EXCAL
 	{
 		Socket sock6{};
+		prepareListener(sock6, AF_INET6, SOCK_STREAM);
 		if (!sock6.bind6(port))
 		{
 			return false;
@@ -175,6 +178,7 @@ NAMESPACE_SOUP
 	bool Server::bindOptCrypto(uint16_t port, ServerService* service, SharedPtr<CertStore> certstore, tls_server_on_client_hello_t on_client_hello) SOUP_EXCAL
 	{
 		Socket sock6{};
+		prepareListener(sock6, AF_INET6, SOCK_STREAM);
 		if (!sock6.bind6(port))
 		{
 			return false;
@@ -200,6 +204,7 @@ NAMESPACE_SOUP
 	bool Server::bindUdp(uint16_t port, udp_callback_t callback) SOUP_EXCAL
 	{
 		Socket sock6{};
+		prepareListener(sock6, AF_INET6, SOCK_DGRAM);
 		if (!sock6.udpBind6(port))
 		{
 			return false;
@@ -235,6 +240,7 @@ NAMESPACE_SOUP
 	bool Server::bindUdp(uint16_t port, ServerServiceUdp* service) SOUP_EXCAL
 	{
 		Socket sock6{};
+		prepareListener(sock6, AF_INET6, SOCK_DGRAM);
 		if (!sock6.udpBind6(port))
 		{
 			return false;
@@ -267,6 +273,22 @@ NAMESPACE_SOUP
 		return true;
 	}
 
+	void Server::prepareListener(Socket& sock, int af, int type) noexcept
+	{
+#if SOUP_LINUX
+		if (listen_reuse_port
+			&& sock.init(af, type)
+			)
+		{
+			sock.setOpt<int>(SOL_SOCKET, SO_REUSEPORT, 1);
+		}
+#else
+		SOUP_UNUSED(sock);
+		SOUP_UNUSED(af);
+		SOUP_UNUSED(type);
+#endif
+	}
+
 	void Server::setDataAvailableHandler6(Socket& s) noexcept
 	{
 		s.holdup_type = Worker::SOCKET;
@@ -13,6 +13,15 @@ NAMESPACE_SOUP
 	public:
 		using udp_callback_t = void(*)(Socket&, SocketAddr&&, std::string&&) SOUP_EXCAL;
 
+		// Listeners will be created with SO_REUSEPORT so multiple servers can bind the same port, and the kernel distributes incoming connections between them.
+		// Only effective on Linux, other platforms don't load-balance between such listeners.
+		void setReusePort() noexcept
+		{
+#if SOUP_LINUX
+			listen_reuse_port = true;
+#endif
+		}
+
 		bool bind(uint16_t port, ServerService* service) SOUP_EXCAL;
 		bool bind(const IpAddr& ip, uint16_t port, ServerService* service) SOUP_EXCAL;
 		bool bindCrypto(uint16_t port, ServerService* service, SharedPtr<CertStore> certstore, tls_server_on_client_hello_t on_client_hello = nullptr) SOUP_EXCAL;
@@ -22,6 +31,8 @@ NAMESPACE_SOUP
 		bool bindUdp(uint16_t port, ServerServiceUdp* service) SOUP_EXCAL;
 		bool bindUdp(const IpAddr& addr, uint16_t port, ServerServiceUdp* service) SOUP_EXCAL;
 	protected:
+		void prepareListener(Socket& sock, int af, int type) noexcept;
+
 		static void setDataAvailableHandler6(Socket& s) noexcept;
 		static void setDataAvailableHandlerCrypto6(Socket& s) noexcept;
 		static void setDataAvailableHandlerOptCrypto6(Socket& s) noexcept;
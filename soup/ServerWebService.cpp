@@ -2,9 +2,13 @@
 
 #if !SOUP_WASM
 
+#include <algorithm> // min
+#include <string_view>
+
 #include "HttpRequest.hpp"
 #include "MimeType.hpp"
 #include "Socket.hpp"
+#include "string.hpp"
 #include "StringWriter.hpp"
 #include "WebSocket.hpp"
 #include "WebSocketFrameType.hpp"
@@ -15,6 +19,7 @@ NAMESPACE_SOUP
 	struct WebServerClientData
 	{
 		bool keep_alive = false;
+		std::string partial_request{}; // The start of a request whose end hasn't been received yet.
 	};
 
 	ServerWebService::ServerWebService(handle_request_t handle_request)
@@ -129,8 +134,10 @@ NAMESPACE_SOUP
 		cont.append("\r\nServer: Soup\r\nConnection: ");
 		cont.append(s.custom_data.getStructFromMap(WebServerClientData).keep_alive ? "keep-alive" : "close");
 		cont.append("\r\n");
-		cont.append(headers_and_body);
-		s.send(std::move(cont));
+		s.sendv({
+			{ cont.data(), cont.size() },
+			{ headers_and_body.data(), headers_and_body.size() },
+		});
 	}
 	
 	void ServerWebService::wsSendText(Socket& s, const std::string& data)
@@ -185,90 +192,213 @@ NAMESPACE_SOUP
 				}
 			}
 		}
-		w.data.append(payload);
-		s.send(w.data);
+		s.sendv({
+			{ w.data.data(), w.data.size() },
+			{ payload.data(), payload.size() },
+		});
 	}
 
 	void ServerWebService::httpRecv(Socket& s)
 	{
-		s.recv([](Socket& s, std::string&& data, Capture&& cap)
+		if (s.isEncrypted())
 		{
-			HttpRequest req{};
-			auto method_end = data.find(' ');
-			if (method_end == std::string::npos)
+			s.recv([](Socket& s, std::string&& data, Capture&& cap)
 			{
-			_bad_request:
-				s.send("HTTP/1.0 400\r\n\r\n");
-				s.close();
-				return;
+				ServerWebService& srv = *cap.get<ServerWebService*>();
+				size_t consumed;
+				if (srv.httpProcess(s, data.data(), data.size(), consumed))
+				{
+					srv.httpRecv(s);
+				}
+			}, this);
+		}
+		else
+		{
+			// Plain HTTP is parsed straight from the receive buffer. Anything after the handled requests, e.g. a pipelined one, stays buffered.
+			s.transport_recvView([](Socket& s, const char* data, size_t size, Capture&& cap) -> size_t
+			{
+				if (size == 0)
+				{
+					return 0;
+				}
+				ServerWebService& srv = *cap.get<ServerWebService*>();
+				size_t consumed;
+				if (srv.httpProcess(s, data, size, consumed))
+				{
+					// The receive buffer only gets back what we didn't consume once we return, so we must not read from the socket until then.
+					s.disallowRecursion();
+					srv.httpRecv(s);
+				}
+				return consumed;
+			}, this);
+		}
+	}
+
+	bool ServerWebService::httpProcess(Socket& s, const char* data, size_t size, size_t& consumed)
+	{
+		consumed = 0;
+
+		// The start of an incomplete request was kept from last time, so the data continues it.
+		if (auto& partial_request = s.custom_data.getStructFromMap(WebServerClientData).partial_request; !partial_request.empty())
+		{
+			std::string buf = std::move(partial_request);
+			const size_t prev_size = buf.size();
+			buf.append(data, size);
+			const size_t request_size = httpHandleRequest(s, buf.data(), buf.size());
+			if (request_size == 0)
+			{
+				s.custom_data.getStructFromMap(WebServerClientData).partial_request = std::move(buf);
+				consumed = size;
+				return true;
 			}
-			req.method = data.substr(0, method_end);
-			method_end += 1;
-			auto path_end = data.find(' ', method_end);
-			if (path_end == std::string::npos)
+			consumed = request_size - prev_size;
+			if (!httpShouldContinue(s))
 			{
-				goto _bad_request;
+				return false;
 			}
-			req.path = data.substr(method_end, path_end - method_end);
-			path_end += 1;
-			auto message_start = data.find("\r\n", path_end);
-			if (message_start == std::string::npos)
+		}
+
+		while (consumed != size)
+		{
+			const size_t request_size = httpHandleRequest(s, data + consumed, size - consumed);
+			if (request_size == 0)
 			{
-				goto _bad_request;
+				s.custom_data.getStructFromMap(WebServerClientData).partial_request.assign(data + consumed, size - consumed);
+				consumed = size;
+				return true;
 			}
-			message_start += 2;
-			req.loadMessage(data.substr(message_start));
+			consumed += request_size;
+			if (!httpShouldContinue(s))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
 
-			ServerWebService& srv = *cap.get<ServerWebService*>();
+	bool ServerWebService::httpShouldContinue(Socket& s)
+	{
+		return s.hasConnection()
+			&& s.custom_data.isStructInMap(WebServerClientData) // removed when upgrading to WebSocket
+			&& s.custom_data.getStructFromMap(WebServerClientData).keep_alive
+			;
+	}
 
-			if (auto upgrade_value = req.findHeader("Upgrade"))
+	size_t ServerWebService::httpHandleRequest(Socket& s, const char* data, size_t size)
+	{
+		// The request ends after its headers and as much body as its Content-Length says.
+		const std::string_view view(data, size);
+		size_t request_size = view.find("\r\n\r\n");
+		if (request_size == std::string_view::npos)
+		{
+			if (size > max_headers_size)
 			{
-				if (*upgrade_value == "websocket")
+				httpBadRequest(s);
+				return size;
+			}
+			return 0; // wait for the rest of the headers
+		}
+		if (request_size > max_headers_size)
+		{
+			httpBadRequest(s);
+			return size;
+		}
+		request_size += 4;
+
+		HttpRequest req{};
+		auto method_end = view.find(' ');
+		if (method_end >= request_size)
+		{
+			httpBadRequest(s);
+			return size;
+		}
+		req.method = std::string(data, method_end);
+		method_end += 1;
+		auto path_end = view.find(' ', method_end);
+		if (path_end >= request_size)
+		{
+			httpBadRequest(s);
+			return size;
+		}
+		req.path = std::string(data + method_end, path_end - method_end);
+		path_end += 1;
+		auto message_start = view.find("\r\n", path_end);
+		if (message_start >= request_size)
+		{
+			httpBadRequest(s);
+			return size;
+		}
+		message_start += 2;
+		req.loadMessage(std::string(data + message_start, request_size - message_start));
+		if (auto content_length = req.findHeader("Content-Length"))
+		{
+			const auto body_size = string::toIntOpt<size_t>(*content_length, string::TI_FULL);
+			if (!body_size.has_value()
+				|| *body_size > max_body_size
+				)
+			{
+				httpBadRequest(s);
+				return size;
+			}
+			if (*body_size > size - request_size)
+			{
+				return 0; // wait for the rest of the body
+			}
+			req.body.append(data + request_size, *body_size);
+			request_size += *body_size;
+		}
+
+		if (auto upgrade_value = req.findHeader("Upgrade"))
+		{
+			if (*upgrade_value == "websocket")
+			{
+				if (auto key_value = req.findHeader("Sec-WebSocket-Key"))
 				{
-					if (auto key_value = req.findHeader("Sec-WebSocket-Key"))
+					if (should_accept_websocket_connection
+						&& should_accept_websocket_connection(s, req, *this)
+						)
 					{
-						if (srv.should_accept_websocket_connection
-							&& srv.should_accept_websocket_connection(s, req, srv)
-							)
-						{
-							// Firefox throws a SkillIssueException if we say HTTP/1.0
-							std::string cont = "HTTP/1.1 101\r\nConnection: Upgrade\r\nUpgrade: websocket\r\nServer: Soup\r\nSec-WebSocket-Accept: ";
-							cont.append(WebSocket::hashKey(*key_value));
-							cont.append("\r\n\r\n");
-							s.send(cont);
-
-							s.custom_data.removeStructFromMap(WebServerClientData);
+						// Firefox throws a SkillIssueException if we say HTTP/1.0
+						std::string cont = "HTTP/1.1 101\r\nConnection: Upgrade\r\nUpgrade: websocket\r\nServer: Soup\r\nSec-WebSocket-Accept: ";
+						cont.append(WebSocket::hashKey(*key_value));
+						cont.append("\r\n\r\n");
+						s.send(cont);
 
-							if (srv.on_websocket_connection_established)
-							{
-								srv.on_websocket_connection_established(s, req, srv);
-							}
+						s.custom_data.removeStructFromMap(WebServerClientData);
 
-							srv.wsRecv(s);
+						if (on_websocket_connection_established)
+						{
+							on_websocket_connection_established(s, req, *this);
 						}
+
+						// Frames may only be received once the receive buffer got back what comes after this request.
+						s.disallowRecursion();
+						wsRecv(s);
 					}
 				}
-				return;
 			}
+			return request_size;
+		}
 
-			if (srv.handle_request)
+		if (handle_request)
+		{
+			if (auto connection_entry = req.header_fields.find("Connection"); connection_entry != req.header_fields.end())
 			{
-				if (auto connection_entry = req.header_fields.find("Connection"); connection_entry != req.header_fields.end())
+				if (connection_entry->second == "keep-alive")
 				{
-					if (connection_entry->second == "keep-alive")
-					{
-						s.custom_data.getStructFromMap(WebServerClientData).keep_alive = true;
-					}
+					s.custom_data.getStructFromMap(WebServerClientData).keep_alive = true;
 				}
+			}
 
-				srv.handle_request(s, std::move(req), srv);
+			handle_request(s, std::move(req), *this);
+		}
+		return request_size;
+	}
 
-				if (s.custom_data.getStructFromMap(WebServerClientData).keep_alive)
-				{
-					srv.httpRecv(s);
-				}
-			}
-		}, this);
+	void ServerWebService::httpBadRequest(Socket& s)
+	{
+		s.send("HTTP/1.0 400\r\n\r\n");
+		s.close();
 	}
 
 	void ServerWebService::wsRecv(Socket& s)
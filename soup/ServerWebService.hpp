@@ -22,6 +22,10 @@ NAMESPACE_SOUP
 		on_websocket_connection_established_t on_websocket_connection_established = nullptr;
 		on_websocket_message_t on_websocket_message = nullptr;
 
+		// Requests exceeding these limits are answered with status 400, so a client can't make us buffer without bounds.
+		size_t max_headers_size = 0x4000;
+		size_t max_body_size = 0x1000000;
+
 		ServerWebService(handle_request_t handle_request = nullptr);
 
 		// HTTP
@@ -51,6 +55,10 @@ NAMESPACE_SOUP
 
 	protected:
 		void httpRecv(Socket& s);
+		bool httpProcess(Socket& s, const char* data, size_t size, size_t& consumed); // returns true if we should keep receiving
+		[[nodiscard]] static bool httpShouldContinue(Socket& s);
+		size_t httpHandleRequest(Socket& s, const char* data, size_t size); // returns how many bytes belong to the request, or 0 if it's incomplete
+		static void httpBadRequest(Socket& s);
 		void wsRecv(Socket& s);
 	};
 }
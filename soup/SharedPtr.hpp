@@ -5,6 +5,7 @@
 
 #include "Exception.hpp"
 #include "memory.hpp" // construct_at
+#include "memPoolAllocator.hpp"
 #include "type_traits.hpp"
 
 #ifndef SOUP_DEBUG_SHAREDPTR
@@ -18,6 +19,12 @@
 
 NAMESPACE_SOUP
 {
+	template <typename T, typename = void>
+	struct has_class_operator_new : std::false_type {};
+
+	template <typename T>
+	struct has_class_operator_new<T, std::void_t<decltype(T::operator new(sizeof(T)))>> : std::true_type {};
+
 	template <typename T>
 	class SharedPtr
 	{
@@ -26,7 +33,7 @@ NAMESPACE_SOUP
 		inline static std::unordered_set<T*> managed_instances{};
 #endif
 
-		struct Data
+		struct Data : public memPooled
 		{
 			T* inst;
 			std::atomic_uint refcount;
@@ -76,9 +83,8 @@ NAMESPACE_SOUP
 					if (was_created_with_make_shared)
 					{
 						const auto inst = this->inst;
-						std::destroy_at<>(inst);
 						std::destroy_at<>(this);
-						::operator delete(reinterpret_cast<void*>(inst));
+						deleteMadeShared(inst);
 					}
 					else
 					{
@@ -231,6 +237,7 @@ NAMESPACE_SOUP
 			return data->refcount.load();
 		}
 
+		// If the instance was created by make_shared, it has to be freed with deleteMadeShared instead of 'delete'.
 		[[nodiscard]] T* release()
 		{
 			Data* const data = this->data;
@@ -241,42 +248,87 @@ NAMESPACE_SOUP
 				SOUP_THROW(Exception("Attempt to release SharedPtr with more than 1 reference"));
 			}
 			T* const inst = data->inst;
-			const auto was_created_with_make_shared = data->was_created_with_make_shared;
-			std::destroy_at<>(data);
-			if (was_created_with_make_shared)
+			if (data->was_created_with_make_shared)
 			{
 				// data will continue to be allocated behind the instance, but once the instance is free'd, data is also free'd.
+				std::destroy_at<>(data);
 			}
 			else
 			{
-				::operator delete(reinterpret_cast<void*>(data));
+				delete data;
 			}
 			return inst;
 		}
+
+		// Frees an instance the way make_shared allocated it. The control block is in the same allocation, behind the instance.
+		// 'delete' would pass sizeof(T) to a sized operator delete, which doesn't match the size that was allocated.
+		static void deleteMadeShared(T* inst) noexcept
+		{
+			if constexpr (has_class_operator_new<T>::value && alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			{
+				delete inst; // make_shared used 'new' for these.
+			}
+			else
+			{
+				std::destroy_at<>(inst);
+				if constexpr (has_class_operator_new<T>::value)
+				{
+					T::operator delete(inst);
+				}
+				else
+				{
+					::operator delete(reinterpret_cast<void*>(inst));
+				}
+			}
+		}
 	};
 
 	template <typename T, typename...Args, SOUP_RESTRICT(!std::is_array_v<T>)>
 	[[nodiscard]] SharedPtr<T> make_shared(Args&&...args)
 	{
-		struct Combined
+		if constexpr (has_class_operator_new<T>::value && alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
 		{
-			alignas(T) char t[sizeof(T)];
-			typename SharedPtr<T>::Data data;
-		};
-
-		void* const b = ::operator new(sizeof(Combined));
-		typename SharedPtr<T>::Data* data;
-		SOUP_TRY
-		{
-			auto inst = soup::construct_at<>(reinterpret_cast<T*>(b), std::forward<Args>(args)...);
-			data = soup::construct_at<>(reinterpret_cast<typename SharedPtr<T>::Data*>(reinterpret_cast<uintptr_t>(b) + offsetof(Combined, data)), inst);
+			// 'new' might pick a different overload for over-aligned types, so we leave it to decide.
+			return SharedPtr<T>(new T(std::forward<Args>(args)...));
 		}
-		SOUP_CATCH_ANY
+		else
 		{
-			::operator delete(b);
-			std::rethrow_exception(std::current_exception());
+			struct Combined
+			{
+				alignas(T) char t[sizeof(T)];
+				typename SharedPtr<T>::Data data;
+			};
+
+			// The instance has to be allocated the way its class wants it to be, so it can still be deleted after being released.
+			void* b;
+			if constexpr (has_class_operator_new<T>::value)
+			{
+				b = T::operator new(sizeof(Combined));
+			}
+			else
+			{
+				b = ::operator new(sizeof(Combined));
+			}
+			typename SharedPtr<T>::Data* data;
+			SOUP_TRY
+			{
+				auto inst = soup::construct_at<>(reinterpret_cast<T*>(b), std::forward<Args>(args)...);
+				data = soup::construct_at<>(reinterpret_cast<typename SharedPtr<T>::Data*>(reinterpret_cast<uintptr_t>(b) + offsetof(Combined, data)), inst);
+			}
+			SOUP_CATCH_ANY
+			{
+				if constexpr (has_class_operator_new<T>::value)
+				{
+					T::operator delete(b);
+				}
+				else
+				{
+					::operator delete(b);
+				}
+				std::rethrow_exception(std::current_exception());
+			}
+			data->was_created_with_make_shared = true;
+			return SharedPtr<T>(data);
 		}
-		data->was_created_with_make_shared = true;
-		return SharedPtr<T>(data);
 	}
 }
@@ -2,11 +2,14 @@
 
 #if !SOUP_WASM
 
+#include <algorithm> // min
+
 #if SOUP_POSIX
 #include <fcntl.h>
 #include <unistd.h> // close
 #include <poll.h>
 #include <sys/resource.h>
+#include <sys/uio.h> // iovec
 
 #include "signal.hpp"
 #endif
@@ -35,9 +38,11 @@
 #include "TlsEncryptedPreMasterSecret.hpp"
 #include "TlsExtensionType.hpp"
 #include "TlsHandshake.hpp"
+#include "TlsNewSessionTicket.hpp"
 #include "TlsRecord.hpp"
 #include "TlsServerHello.hpp"
 #include "TlsServerKeyExchange.hpp"
+#include "TlsSessionCache.hpp"
 #include "TlsSignatureScheme.hpp"
 #include "TrustStore.hpp"
 
@@ -426,6 +431,10 @@ NAMESPACE_SOUP
 			TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384, // api64.ipify.org
 			TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
 		});
+		vector_emplace_back_randomised(hello.cipher_suites, {
+			TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+			TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+		});
 		hello.cipher_suites.emplace(
 			hello.cipher_suites.begin() + rand(0, hello.cipher_suites.size() - 1),
 			tls_randGreaseyCiphersuite()
@@ -484,6 +493,35 @@ NAMESPACE_SOUP
 			hello.extensions.add(TlsExtensionType::supported_versions, "\x02\x03\x03");
 		}
 
+		if (auto session_cache = netConfig::get().tls_session_cache;
+			session_cache && !handshaker->server_name.empty()
+			)
+		{
+			handshaker->session_cache = session_cache;
+			handshaker->session_cache_key = handshaker->server_name;
+			handshaker->session_cache_key.push_back(':');
+			handshaker->session_cache_key.append(std::to_string(peer.getPort()));
+			const auto certchain_validator = netConfig::get().certchain_validator;
+			if (session_cache->find(handshaker->session_cache_key, handshaker->session)
+				&& handshaker->session.certchain_validator == certchain_validator
+				)
+			{
+				if (handshaker->session.session_id.empty())
+				{
+					// The server will echo this session ID if it accepts the ticket.
+					handshaker->session.session_id = rand.binstr(32);
+				}
+				hello.session_id = handshaker->session.session_id;
+			}
+			else
+			{
+				handshaker->session = {};
+				handshaker->session.server_name = handshaker->server_name;
+				handshaker->session.certchain_validator = certchain_validator;
+			}
+			hello.extensions.add(TlsExtensionType::session_ticket, std::string(handshaker->session.ticket));
+		}
+
 		if (tls_sendHandshake(handshaker, TlsHandshake::client_hello, hello.toBinaryString()))
 		{
 			tls_recvHandshake(std::move(handshaker), [](Socket& s, UniquePtr<SocketTlsHandshaker>&& handshaker, TlsHandshakeType_t handshake_type, std::string&& data) SOUP_EXCAL
@@ -502,6 +540,42 @@ NAMESPACE_SOUP
 				handshaker->cipher_suite = shello.cipher_suite;
 				handshaker->server_random = shello.random.toBinaryString();
 				handshaker->extended_master_secret = shello.extensions.contains(TlsExtensionType::extended_master_secret);
+				handshaker->expecting_session_ticket = shello.extensions.contains(TlsExtensionType::session_ticket);
+
+				if (handshaker->session_cache)
+				{
+					if (!handshaker->session.master_secret.empty()
+						&& !shello.session_id.empty()
+						&& shello.session_id == handshaker->session.session_id
+						)
+					{
+						// Server accepted our session, so we go straight to ChangeCipherSpec + Finished.
+						if (handshaker->cipher_suite != handshaker->session.cipher_suite
+							|| handshaker->extended_master_secret != handshaker->session.extended_master_secret
+							)
+						{
+							s.tls_close(TlsAlertDescription::illegal_parameter);
+							return;
+						}
+						++handshaker->session_cache->hits;
+						handshaker->resumed = true;
+						handshaker->master_secret = handshaker->session.master_secret;
+						handshaker->getKeys(
+							handshaker->pending_send_encrypter.mac_key,
+							handshaker->pending_recv_encrypter.mac_key,
+							handshaker->pending_send_encrypter.cipher_key,
+							handshaker->pending_recv_encrypter.cipher_key,
+							handshaker->pending_send_encrypter.implicit_iv,
+							handshaker->pending_recv_encrypter.implicit_iv
+						);
+						s.enableCryptoClientRecvServerFinished(std::move(handshaker));
+						return;
+					}
+					++handshaker->session_cache->misses;
+					handshaker->session.session_id = std::move(shello.session_id);
+					handshaker->session.ticket.clear();
+					handshaker->session.created = 0;
+				}
 
 				s.tls_recvHandshake(std::move(handshaker), [](Socket& s, UniquePtr<SocketTlsHandshaker>&& handshaker, TlsHandshakeType_t handshake_type, std::string&& data) SOUP_EXCAL
 				{
@@ -581,6 +655,8 @@ NAMESPACE_SOUP
 						case TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256:
 						case TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384:
 						case TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384:
+						case TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256:
+						case TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256:
 							s.tls_recvHandshake(std::move(handshaker), [](Socket& s, UniquePtr<SocketTlsHandshaker>&& handshaker, TlsHandshakeType_t handshake_type, std::string&& data) SOUP_EXCAL
 							{
 								if (handshake_type != TlsHandshake::server_key_exchange)
@@ -871,34 +947,92 @@ NAMESPACE_SOUP
 					tls_sendRecordEncrypted(TlsContentType::application_data, handshaker->initial_application_data);
 				}
 
-				tls_recvRecord(TlsContentType::change_cipher_spec, [](Socket& s, std::string&& data, Capture&& cap) SOUP_EXCAL
+				enableCryptoClientRecvServerFinished(std::move(handshaker));
+			}
+		}
+	}
+
+	void Socket::enableCryptoClientRecvServerFinished(UniquePtr<SocketTlsHandshaker>&& handshaker) SOUP_EXCAL
+	{
+		if (handshaker->expecting_session_ticket)
+		{
+			handshaker->expecting_session_ticket = false;
+			tls_recvHandshake(std::move(handshaker), [](Socket& s, UniquePtr<SocketTlsHandshaker>&& handshaker, TlsHandshakeType_t handshake_type, std::string&& data) SOUP_EXCAL
+			{
+				if (handshake_type != TlsHandshake::new_session_ticket)
 				{
-					UniquePtr<SocketTlsHandshaker> handshaker = std::move(cap.get<UniquePtr<SocketTlsHandshaker>>());
+					s.tls_close(TlsAlertDescription::unexpected_message);
+					return;
+				}
+				TlsNewSessionTicket nst;
+				if (!nst.fromBinary(data))
+				{
+					s.tls_close(TlsAlertDescription::decode_error);
+					return;
+				}
+				if (!nst.ticket.empty())
+				{
+					handshaker->session.ticket = std::move(nst.ticket);
+					handshaker->session.created = 0; // Ticket is new, so the session needs to be stored again.
+				}
+				s.enableCryptoClientRecvServerFinished(std::move(handshaker));
+			});
+			return;
+		}
 
-					s.tls_encrypter_recv = std::move(handshaker->pending_recv_encrypter);
+		tls_recvRecord(TlsContentType::change_cipher_spec, [](Socket& s, std::string&& data, Capture&& cap) SOUP_EXCAL
+		{
+			UniquePtr<SocketTlsHandshaker> handshaker = std::move(cap.get<UniquePtr<SocketTlsHandshaker>>());
 
-					handshaker->expected_finished_verify_data = handshaker->getServerFinishVerifyData();
+			s.tls_encrypter_recv = std::move(handshaker->pending_recv_encrypter);
 
-					s.tls_recvHandshake(std::move(handshaker), [](Socket& s, UniquePtr<SocketTlsHandshaker>&& handshaker, TlsHandshakeType_t handshake_type, std::string&& data) SOUP_EXCAL
+			handshaker->expected_finished_verify_data = handshaker->getServerFinishVerifyData();
+
+			s.tls_recvHandshake(std::move(handshaker), [](Socket& s, UniquePtr<SocketTlsHandshaker>&& handshaker, TlsHandshakeType_t handshake_type, std::string&& data) SOUP_EXCAL
+			{
+				if (handshake_type != TlsHandshake::finished)
+				{
+					s.tls_close(TlsAlertDescription::unexpected_message);
+					return;
+				}
+				if (data != handshaker->expected_finished_verify_data)
+				{
+					s.tls_close(TlsAlertDescription::decrypt_error);
+					return;
+				}
+				if (handshaker->resumed)
+				{
+					if (!s.tls_sendRecord(TlsContentType::change_cipher_spec, "\1"))
 					{
-						if (handshake_type != TlsHandshake::finished)
-						{
-							s.tls_close(TlsAlertDescription::unexpected_message);
-							return;
-						}
-						if (data != handshaker->expected_finished_verify_data)
-						{
-							s.tls_close(TlsAlertDescription::decrypt_error);
-							return;
-						}
-						handshaker->callback(s, std::move(handshaker->callback_capture));
-					});
-				}, std::move(handshaker));
-			}
-		}
+						return;
+					}
+					s.tls_encrypter_send = std::move(handshaker->pending_send_encrypter);
+					if (!s.tls_sendHandshake(handshaker, TlsHandshake::finished, handshaker->getClientFinishVerifyData()))
+					{
+						return;
+					}
+					if (!handshaker->initial_application_data.empty())
+					{
+						s.tls_sendRecordEncrypted(TlsContentType::application_data, handshaker->initial_application_data);
+					}
+				}
+				if (handshaker->session_cache
+					&& handshaker->session.created == 0
+					&& (!handshaker->session.session_id.empty() || !handshaker->session.ticket.empty())
+					)
+				{
+					handshaker->session.cipher_suite = handshaker->cipher_suite;
+					handshaker->session.extended_master_secret = handshaker->extended_master_secret;
+					handshaker->session.master_secret = handshaker->getMasterSecret();
+					handshaker->session.created = time::unixSeconds();
+					handshaker->session_cache->add(handshaker->session_cache_key, handshaker->session);
+				}
+				handshaker->callback(s, std::move(handshaker->callback_capture));
+			});
+		}, std::move(handshaker));
 	}
 
-	[[nodiscard]] static bool tls_serverSupportsCipherSuite(uint16_t cs) noexcept
+	[[nodiscard]] static bool tls_serverSupportsCipherSuite(uint16_t cs, bool client_supports_x25519) noexcept
 	{
 		switch (cs)
 		{
@@ -907,6 +1041,23 @@ NAMESPACE_SOUP
 		case TLS_RSA_WITH_AES_128_CBC_SHA256:
 		case TLS_RSA_WITH_AES_256_CBC_SHA256:
 			return true;
+
+		case TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+		case TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384:
+		case TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256:
+			return client_supports_x25519;
+		}
+		return false;
+	}
+
+	[[nodiscard]] static bool tls_isEcdheCipherSuite(uint16_t cs) noexcept
+	{
+		switch (cs)
+		{
+		case TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+		case TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384:
+		case TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256:
+			return true;
 		}
 		return false;
 	}
@@ -942,16 +1093,10 @@ NAMESPACE_SOUP
 					s.tls_close(TlsAlertDescription::decode_error);
 					return;
 				}
-				for (const auto& cs : hello.cipher_suites)
-				{
-					if (tls_serverSupportsCipherSuite(cs))
-					{
-						handshaker->cipher_suite = cs;
-						break;
-					}
-				}
-
+				bool client_supports_x25519 = false;
+				bool client_supports_tickets = false;
 				std::string server_name{};
+				std::string ticket{};
 				for (const auto& ext : hello.extensions.extensions)
 				{
 					if (ext.id == TlsExtensionType::server_name)
@@ -966,6 +1111,38 @@ NAMESPACE_SOUP
 					{
 						handshaker->extended_master_secret = true;
 					}
+					else if (ext.id == TlsExtensionType::session_ticket)
+					{
+						client_supports_tickets = true;
+						ticket = ext.data;
+					}
+					else if (ext.id == TlsExtensionType::elliptic_curves)
+					{
+						TlsClientHelloExtEllipticCurves ext_elliptic_curves;
+						if (ext_elliptic_curves.fromBinary(ext.data))
+						{
+							for (const auto& curve : ext_elliptic_curves.named_curves)
+							{
+								if (curve == NamedCurves::x25519)
+								{
+									client_supports_x25519 = true;
+									break;
+								}
+							}
+						}
+					}
+				}
+				for (const auto& cs : hello.cipher_suites)
+				{
+					if (tls_serverSupportsCipherSuite(cs, client_supports_x25519))
+					{
+						handshaker->cipher_suite = cs;
+						if (tls_isEcdheCipherSuite(cs))
+						{
+							handshaker->ecdhe_curve = NamedCurves::x25519;
+						}
+						break;
+					}
 				}
 				rsa_data = handshaker->certstore->findEntryForDomain(server_name);
 				if (!rsa_data)
@@ -976,6 +1153,37 @@ NAMESPACE_SOUP
 
 				handshaker->client_random = hello.random.toBinaryString();
 
+				if (handshaker->certstore->session_cache.capacity != 0)
+				{
+					handshaker->session_cache = &handshaker->certstore->session_cache;
+					if ((!ticket.empty() && handshaker->session_cache->decryptTicket(ticket, handshaker->session))
+						|| (!hello.session_id.empty() && handshaker->session_cache->find(hello.session_id, handshaker->session))
+						)
+					{
+						// Only resume if the client still offers the same parameters and asks for the same server name.
+						handshaker->resumed = (handshaker->session.extended_master_secret == handshaker->extended_master_secret
+							&& handshaker->session.server_name == server_name
+							&& tls_serverSupportsCipherSuite(handshaker->session.cipher_suite, client_supports_x25519)
+							&& std::find(hello.cipher_suites.begin(), hello.cipher_suites.end(), handshaker->session.cipher_suite) != hello.cipher_suites.end()
+							);
+					}
+					if (handshaker->resumed)
+					{
+						++handshaker->session_cache->hits;
+						handshaker->cipher_suite = handshaker->session.cipher_suite;
+						handshaker->master_secret = handshaker->session.master_secret;
+						handshaker->session_id = hello.session_id; // For tickets, this is how the client knows we accepted it.
+					}
+					else
+					{
+						++handshaker->session_cache->misses;
+						handshaker->session = {};
+						handshaker->session.server_name = server_name;
+						handshaker->session_id = rand.binstr(32);
+						handshaker->issue_session_ticket = client_supports_tickets;
+					}
+				}
+
 				if (handshaker->on_client_hello)
 				{
 					handshaker->on_client_hello(s, std::move(hello));
@@ -987,6 +1195,7 @@ NAMESPACE_SOUP
 				shello.random.time = static_cast<uint32_t>(time::unixSeconds());
 				rand.fill(shello.random.random);
 				handshaker->server_random = shello.random.toBinaryString();
+				shello.session_id = handshaker->session_id;
 				shello.cipher_suite = handshaker->cipher_suite;
 				shello.compression_method = 0;
 
@@ -994,6 +1203,10 @@ NAMESPACE_SOUP
 				{
 					shello.extensions.add(TlsExtensionType::extended_master_secret, {});
 				}
+				if (handshaker->issue_session_ticket)
+				{
+					shello.extensions.add(TlsExtensionType::session_ticket, {});
+				}
 
 				if (!s.tls_sendHandshake(handshaker, TlsHandshake::server_hello, shello.toBinaryString()))
 				{
@@ -1001,6 +1214,34 @@ NAMESPACE_SOUP
 				}
 			}
 
+			if (handshaker->resumed)
+			{
+				// Abbreviated handshake: We send ChangeCipherSpec + Finished right away and then expect the same from the client.
+				if (!s.tls_sendRecord(TlsContentType::change_cipher_spec, "\1"))
+				{
+					return;
+				}
+				handshaker->getKeys(
+					handshaker->pending_recv_encrypter.mac_key,
+					s.tls_encrypter_send.mac_key,
+					handshaker->pending_recv_encrypter.cipher_key,
+					s.tls_encrypter_send.cipher_key,
+					handshaker->pending_recv_encrypter.implicit_iv,
+					s.tls_encrypter_send.implicit_iv
+				);
+				if (!s.tls_sendHandshake(handshaker, TlsHandshake::finished, handshaker->getServerFinishVerifyData()))
+				{
+					return;
+				}
+				s.tls_recvRecord(TlsContentType::change_cipher_spec, [](Socket& s, std::string&& data, Capture&& cap)
+				{
+					UniquePtr<SocketTlsHandshaker> handshaker = std::move(cap.get<UniquePtr<SocketTlsHandshaker>>());
+					s.tls_encrypter_recv = std::move(handshaker->pending_recv_encrypter);
+					s.enableCryptoServerRecvFinished(std::move(handshaker));
+				}, std::move(handshaker));
+				return;
+			}
+
 			{
 				TlsCertificate tcert;
 				tcert.asn1_certs.reserve(rsa_data->chain.certs.size());
@@ -1014,21 +1255,70 @@ NAMESPACE_SOUP
 				}
 			}
 
-			if (!s.tls_sendHandshake(handshaker, TlsHandshake::server_hello_done, {}))
+			handshaker->private_key = &rsa_data->private_key;
+
+			if (handshaker->ecdhe_curve == 0)
 			{
+				if (s.tls_sendHandshake(handshaker, TlsHandshake::server_hello_done, {}))
+				{
+					s.enableCryptoServerRecvClientKeyExchange(std::move(handshaker));
+				}
 				return;
 			}
 
-			handshaker->private_key = &rsa_data->private_key;
+			uint8_t my_priv[Curve25519::KEY_SIZE];
+			Curve25519::generatePrivate(my_priv);
+			handshaker->ecdhe_private_key = std::string((const char*)my_priv, sizeof(my_priv));
 
-			s.tls_recvHandshake(std::move(handshaker), [](Socket& s, UniquePtr<SocketTlsHandshaker>&& handshaker, TlsHandshakeType_t handshake_type, std::string&& data)
+			// Signing takes a while with a big RSA key, so do it off the main thread.
+			handshaker->promise.fulfilOffThread([](Capture&& cap)
 			{
-				if (handshake_type != TlsHandshake::client_key_exchange)
+				auto* handshaker = cap.get<SocketTlsHandshaker*>();
+
+				uint8_t my_pub[Curve25519::KEY_SIZE];
+				Curve25519::derivePublic(my_pub, (const uint8_t*)handshaker->ecdhe_private_key.data());
+
+				TlsServerKeyExchange ske;
+				ske.params.curve_type = 3; // named_curve
+				ske.params.named_curve = NamedCurves::x25519;
+				ske.params.point = std::string((const char*)my_pub, sizeof(my_pub));
+				ske.signature_scheme = TlsSignatureScheme::rsa_pkcs1_sha256;
+				ske.signature = handshaker->private_key->sign<soup::sha256>(
+					handshaker->client_random + handshaker->server_random + ske.params.toBinaryString()
+				).toBinary(handshaker->private_key->n.getNumBytes());
+				handshaker->server_key_exchange = ske.toBinaryString();
+			}, handshaker.get());
+
+			auto* p = &handshaker->promise;
+			s.awaitPromiseCompletion(p, [](Worker& w, Capture&& cap)
+			{
+				w.holdup_type = Worker::NONE;
+
+				auto& s = static_cast<Socket&>(w);
+				UniquePtr<SocketTlsHandshaker> handshaker = std::move(cap.get<UniquePtr<SocketTlsHandshaker>>());
+
+				if (s.tls_sendHandshake(handshaker, TlsHandshake::server_key_exchange, handshaker->server_key_exchange)
+					&& s.tls_sendHandshake(handshaker, TlsHandshake::server_hello_done, {})
+					)
 				{
-					s.tls_close(TlsAlertDescription::unexpected_message);
-					return;
+					s.enableCryptoServerRecvClientKeyExchange(std::move(handshaker));
 				}
+			}, std::move(handshaker));
+		});
+	}
 
+	void Socket::enableCryptoServerRecvClientKeyExchange(UniquePtr<SocketTlsHandshaker>&& handshaker)
+	{
+		tls_recvHandshake(std::move(handshaker), [](Socket& s, UniquePtr<SocketTlsHandshaker>&& handshaker, TlsHandshakeType_t handshake_type, std::string&& data)
+		{
+			if (handshake_type != TlsHandshake::client_key_exchange)
+			{
+				s.tls_close(TlsAlertDescription::unexpected_message);
+				return;
+			}
+
+			if (handshaker->ecdhe_curve == 0)
+			{
 				if (data.size() <= 2)
 				{
 					s.tls_close(TlsAlertDescription::decode_error);
@@ -1044,57 +1334,107 @@ NAMESPACE_SOUP
 					handshaker.get(),
 					Bigint::fromBinary(data)
 				});
+			}
+			else // x25519; the promise is already fulfilled from signing the server key exchange.
+			{
+				if (data.size() != 1 + Curve25519::KEY_SIZE
+					|| data.at(0) != Curve25519::KEY_SIZE
+					)
+				{
+					s.tls_close(TlsAlertDescription::decode_error);
+					return;
+				}
 
-				s.tls_recvRecord(TlsContentType::change_cipher_spec, [](Socket& s, std::string&& data, Capture&& cap)
+				uint8_t my_priv[Curve25519::KEY_SIZE];
+				memcpy(my_priv, handshaker->ecdhe_private_key.data(), sizeof(my_priv));
+
+				uint8_t their_pub[Curve25519::KEY_SIZE];
+				memcpy(their_pub, &data.at(1), sizeof(their_pub));
+
+				uint8_t shared_secret[Curve25519::SHARED_SIZE];
+				Curve25519::x25519(shared_secret, my_priv, their_pub);
+				handshaker->pre_master_secret = std::string((const char*)shared_secret, sizeof(shared_secret));
+			}
+
+			s.tls_recvRecord(TlsContentType::change_cipher_spec, [](Socket& s, std::string&& data, Capture&& cap)
+			{
+				UniquePtr<SocketTlsHandshaker> handshaker = std::move(cap.get<UniquePtr<SocketTlsHandshaker>>());
+
+				auto* p = &handshaker->promise;
+				s.awaitPromiseCompletion(p, [](Worker& w, Capture&& cap)
 				{
-					if (!s.tls_sendRecord(TlsContentType::change_cipher_spec, "\1"))
-					{
-						return;
-					}
+					w.holdup_type = Worker::NONE;
 
+					auto& s = static_cast<Socket&>(w);
 					UniquePtr<SocketTlsHandshaker> handshaker = std::move(cap.get<UniquePtr<SocketTlsHandshaker>>());
 
-					auto* p = &handshaker->promise;
-					s.awaitPromiseCompletion(p, [](Worker& w, Capture&& cap)
-					{
-						w.holdup_type = Worker::NONE;
+					handshaker->getKeys(
+						s.tls_encrypter_recv.mac_key,
+						handshaker->pending_send_encrypter.mac_key,
+						s.tls_encrypter_recv.cipher_key,
+						handshaker->pending_send_encrypter.cipher_key,
+						s.tls_encrypter_recv.implicit_iv,
+						handshaker->pending_send_encrypter.implicit_iv
+					);
 
-						auto& s = static_cast<Socket&>(w);
-						UniquePtr<SocketTlsHandshaker> handshaker = std::move(cap.get<UniquePtr<SocketTlsHandshaker>>());
+					s.enableCryptoServerRecvFinished(std::move(handshaker));
+				}, std::move(handshaker));
+			}, std::move(handshaker));
+		});
+	}
 
-						handshaker->getKeys(
-							s.tls_encrypter_recv.mac_key,
-							s.tls_encrypter_send.mac_key,
-							s.tls_encrypter_recv.cipher_key,
-							s.tls_encrypter_send.cipher_key,
-							s.tls_encrypter_recv.implicit_iv,
-							s.tls_encrypter_send.implicit_iv
-						);
+	void Socket::enableCryptoServerRecvFinished(UniquePtr<SocketTlsHandshaker>&& handshaker)
+	{
+		handshaker->expected_finished_verify_data = handshaker->getClientFinishVerifyData();
+
+		tls_recvHandshake(std::move(handshaker), [](Socket& s, UniquePtr<SocketTlsHandshaker>&& handshaker, TlsHandshakeType_t handshake_type, std::string&& data)
+		{
+			if (handshake_type != TlsHandshake::finished)
+			{
+				s.tls_close(TlsAlertDescription::unexpected_message);
+				return;
+			}
 
-						handshaker->expected_finished_verify_data = handshaker->getClientFinishVerifyData();
+			if (data != handshaker->expected_finished_verify_data)
+			{
+				s.tls_close(TlsAlertDescription::decrypt_error);
+				return;
+			}
 
-						s.tls_recvHandshake(std::move(handshaker), [](Socket& s, UniquePtr<SocketTlsHandshaker>&& handshaker, TlsHandshakeType_t handshake_type, std::string&& data)
+			if (!handshaker->resumed)
+			{
+				if (handshaker->session_cache)
+				{
+					handshaker->session.cipher_suite = handshaker->cipher_suite;
+					handshaker->session.extended_master_secret = handshaker->extended_master_secret;
+					handshaker->session.master_secret = handshaker->getMasterSecret();
+					handshaker->session.created = time::unixSeconds();
+					handshaker->session_cache->add(handshaker->session_id, handshaker->session);
+
+					if (handshaker->issue_session_ticket)
+					{
+						TlsNewSessionTicket nst;
+						nst.ticket_lifetime_hint = static_cast<uint32_t>(handshaker->session_cache->lifetime);
+						nst.ticket = handshaker->session_cache->encryptTicket(handshaker->session);
+						if (!s.tls_sendHandshake(handshaker, TlsHandshake::new_session_ticket, nst.toBinaryString()))
 						{
-							if (handshake_type != TlsHandshake::finished)
-							{
-								s.tls_close(TlsAlertDescription::unexpected_message);
-								return;
-							}
+							return;
+						}
+					}
+				}
 
-							if (data != handshaker->expected_finished_verify_data)
-							{
-								s.tls_close(TlsAlertDescription::decrypt_error);
-								return;
-							}
+				if (!s.tls_sendRecord(TlsContentType::change_cipher_spec, "\1"))
+				{
+					return;
+				}
+				s.tls_encrypter_send = std::move(handshaker->pending_send_encrypter);
+				if (!s.tls_sendHandshake(handshaker, TlsHandshake::finished, handshaker->getServerFinishVerifyData()))
+				{
+					return;
+				}
+			}
 
-							if (s.tls_sendHandshake(handshaker, TlsHandshake::finished, handshaker->getServerFinishVerifyData()))
-							{
-								handshaker->callback(s, std::move(handshaker->callback_capture));
-							}
-						});
-					}, std::move(handshaker));
-				}, std::move(handshaker));
-			});
+			handshaker->callback(s, std::move(handshaker->callback_capture));
 		});
 	}
 
@@ -1107,11 +1447,64 @@ NAMESPACE_SOUP
 	{
 		if (tls_encrypter_send.isActive())
 		{
-			return tls_sendRecordEncrypted(TlsContentType::application_data, data, size);
+			const IoVec buf{ data, size };
+			return sendv(&buf, 1);
 		}
 		return transport_send(data, static_cast<int>(size));
 	}
 
+	bool Socket::sendv(const IoVec* bufs, size_t count) SOUP_EXCAL
+	{
+		if (!tls_encrypter_send.isActive())
+		{
+			return transport_sendv(bufs, count);
+		}
+
+		// The plaintext of a TLS record can be at most 2^14 bytes, so the buffers are gathered into records of up to that size.
+		// Buffers are only copied if they need to share a record with other buffers.
+		constexpr size_t max_record_size = 0x4000;
+		Buffer gathered{};
+		for (size_t i = 0; i != count; ++i)
+		{
+			auto data = reinterpret_cast<const uint8_t*>(bufs[i].data);
+			auto size = bufs[i].size;
+			while (size != 0)
+			{
+				size_t chunk;
+				if (gathered.empty()
+					&& (size >= max_record_size || i + 1 == count)
+					)
+				{
+					chunk = std::min(size, max_record_size);
+					if (!tls_sendRecordEncrypted(TlsContentType::application_data, data, chunk))
+					{
+						return false;
+					}
+				}
+				else
+				{
+					chunk = std::min(size, max_record_size - gathered.size());
+					gathered.append(data, chunk);
+					if (gathered.size() == max_record_size)
+					{
+						if (!tls_sendRecordEncrypted(TlsContentType::application_data, gathered.data(), gathered.size()))
+						{
+							return false;
+						}
+						gathered.clear();
+					}
+				}
+				data += chunk;
+				size -= chunk;
+			}
+		}
+		if (!gathered.empty())
+		{
+			return tls_sendRecordEncrypted(TlsContentType::application_data, gathered.data(), gathered.size());
+		}
+		return true;
+	}
+
 	bool Socket::initUdpBroadcast4()
 	{
 		return init(AF_INET, SOCK_DGRAM)
@@ -1299,8 +1692,11 @@ NAMESPACE_SOUP
 		BufferRefWriter bw(header);
 		record.write(bw);
 
-		body.prepend(header.data(), header.size());
-		return transport_send(body);
+		const IoVec bufs[] = {
+			{ header.data(), header.size() },
+			{ body.data(), body.size() },
+		};
+		return transport_sendv(bufs, 2);
 	}
 
 	struct CaptureSocketTlsRecvHandshake
@@ -1529,38 +1925,7 @@ NAMESPACE_SOUP
 					}
 					else
 					{
-						constexpr auto record_iv_length = 8;
-
-						if (data.size() < (record_iv_length + cipher_bytes))
-						{
-							s.tls_close(TlsAlertDescription::bad_record_mac);
-							return;
-						}
-
-						auto tag = data.substr(data.length() - cipher_bytes);
-
-						if (tag.size() != cipher_bytes)
-						{
-							s.tls_close(TlsAlertDescription::bad_record_mac);
-							return;
-						}
-
-						data.erase(data.length() - cipher_bytes);
-
-						auto iv = s.tls_encrypter_recv.implicit_iv;
-						auto nonce_explicit = data.substr(0, record_iv_length);
-						iv.insert(iv.end(), nonce_explicit.begin(), nonce_explicit.end());
-						data.erase(0, record_iv_length);
-
-						auto ad = s.tls_encrypter_recv.calculateMacBytes(cap.content_type, data.size());
-
-						if (aes::gcmDecrypt(
-							(uint8_t*)data.data(), data.size(),
-							(const uint8_t*)ad.data(), ad.size(),
-							s.tls_encrypter_recv.cipher_key.data(), s.tls_encrypter_recv.cipher_key.size(),
-							iv.data(), iv.size(),
-							(const uint8_t*)tag.data()
-						) != true)
+						if (!s.tls_encrypter_recv.decryptAead(cap.content_type, data))
 						{
 							s.tls_close(TlsAlertDescription::bad_record_mac);
 							return;
@@ -1588,7 +1953,8 @@ NAMESPACE_SOUP
 			}
 
 			{
-				std::string bin(1, '\2'); // fatal
+				// close_notify is sent as a warning because a fatal alert would invalidate the session for resumption.
+				std::string bin(1, desc == TlsAlertDescription::close_notify ? '\1' : '\2'); // warning : fatal
 				bin.push_back((char)desc); static_assert(sizeof(TlsAlertDescription_t) == sizeof(char));
 				tls_sendRecord(TlsContentType::alert, bin);
 			}
@@ -1614,6 +1980,10 @@ NAMESPACE_SOUP
 
 	bool Socket::transport_hasData() const
 	{
+		if (!recv_buf.empty())
+		{
+			return true;
+		}
 		char buf;
 		return ::recv(fd, &buf, 1, MSG_PEEK) == 1;
 	}
@@ -1633,20 +2003,70 @@ NAMESPACE_SOUP
 		return ::send(fd, (const char*)data, size, 0) == size;
 	}
 
-	std::string Socket::transport_recvCommon(int max_bytes) SOUP_EXCAL
+	bool Socket::transport_sendv(const IoVec* bufs, size_t count) const noexcept
+	{
+		constexpr size_t max_batch = 16;
+#if SOUP_WINDOWS
+		WSABUF vec[max_batch];
+#else
+		iovec vec[max_batch];
+#endif
+		while (count != 0)
+		{
+			const size_t batch = std::min(count, max_batch);
+			size_t total = 0;
+			for (size_t i = 0; i != batch; ++i)
+			{
+#if SOUP_WINDOWS
+				vec[i].buf = (CHAR*)bufs[i].data;
+				vec[i].len = static_cast<ULONG>(bufs[i].size);
+#else
+				vec[i].iov_base = const_cast<void*>(bufs[i].data);
+				vec[i].iov_len = bufs[i].size;
+#endif
+				total += bufs[i].size;
+			}
+#if SOUP_WINDOWS
+			DWORD sent;
+			if (::WSASend(fd, vec, static_cast<DWORD>(batch), &sent, 0, nullptr, nullptr) != 0
+				|| sent != total
+				)
+			{
+				return false;
+			}
+#else
+			msghdr msg{};
+			msg.msg_iov = vec;
+			msg.msg_iovlen = batch;
+			if (::sendmsg(fd, &msg, 0) != static_cast<ssize_t>(total))
+			{
+				return false;
+			}
+#endif
+			bufs += batch;
+			count -= batch;
+		}
+		return true;
+	}
+
+	bool Socket::transport_fill() SOUP_EXCAL
 	{
-		if (!unrecv_buf.empty())
+		// Reading as much as the kernel has for us means that e.g. a TLS record header and its body usually only cost one syscall.
+		size_t avail;
+		char* const dst = recv_buf.prepareWrite(avail);
+		if (avail == 0)
 		{
-			std::string ret = unrecv_buf.substr(0, max_bytes);
-			unrecv_buf.erase(0, max_bytes);
-			return ret;
+			return true;
 		}
-		std::string buf(max_bytes, '\0');
-		auto res = ::recv(fd, buf.data(), max_bytes, 0);
+		auto res = ::recv(fd, dst, static_cast<int>(avail), 0);
 		if (res > 0)
 		{
-			buf.resize(res);
-			return buf;
+			recv_buf.commitWrite(static_cast<size_t>(res));
+			return true;
+		}
+		if (recv_buf.empty())
+		{
+			recv_buf.release(); // Don't hold on to a block while waiting for data.
 		}
 #if SOUP_POSIX
 		/*else*/ if (res == 0
@@ -1662,7 +2082,20 @@ NAMESPACE_SOUP
 			close();
 		}
 #endif
-		return {};
+		return false;
+	}
+
+	void Socket::transport_recvCommon(std::string& out, size_t max_bytes) SOUP_EXCAL
+	{
+		if (recv_buf.empty()
+			&& !transport_fill()
+			)
+		{
+			return;
+		}
+		const size_t bytes = std::min(max_bytes, recv_buf.size());
+		out.append(recv_buf.data(), bytes);
+		recv_buf.consume(bytes);
 	}
 
 	void Socket::transport_recv(transport_recv_callback_t callback, Capture&& cap)
@@ -1682,7 +2115,9 @@ NAMESPACE_SOUP
 		if (canRecurse())
 		{
 			// In the case of remote_closed, recv callback would only be called if there's still data available or the user set callback_recv_on_close.
-			if (auto buf = transport_recvCommon(max_bytes); !buf.empty() || remote_closed)
+			std::string buf;
+			transport_recvCommon(buf, max_bytes);
+			if (!buf.empty() || remote_closed)
 			{
 				callback(*this, std::move(buf), std::move(cap));
 				return;
@@ -1711,10 +2146,15 @@ NAMESPACE_SOUP
 	{
 		if (canRecurse())
 		{
-			auto remainder = static_cast<int>(bytes - pre.size());
-			if (auto buf = transport_recvCommon(remainder); !buf.empty())
+			pre.reserve(bytes);
+			const bool had_buffered_data = !recv_buf.empty();
+			transport_recvCommon(pre, bytes - pre.size());
+			if (had_buffered_data
+				&& static_cast<int>(pre.size()) != bytes
+				)
 			{
-				pre.append(buf);
+				// What was buffered wasn't enough, but the kernel might have more for us.
+				transport_recvCommon(pre, bytes - pre.size());
 			}
 			if (static_cast<int>(pre.size()) == bytes)
 			{
@@ -1735,9 +2175,50 @@ NAMESPACE_SOUP
 		}, CaptureSocketTransportRecvExact(bytes, callback, std::move(cap), std::move(pre)));
 	}
 
-	void Socket::transport_unrecv(const std::string& data) SOUP_EXCAL
+	struct CaptureSocketTransportRecvView
+	{
+		Socket::transport_recv_view_callback_t callback;
+		Capture cap;
+	};
+
+	void Socket::transport_recvView(transport_recv_view_callback_t callback, Capture&& cap)
+	{
+		if (canRecurse())
+		{
+			if (!recv_buf.empty()
+				|| transport_fill()
+				|| remote_closed
+				)
+			{
+				// Taking the buffer out of the socket means the view stays valid even if the callback sets up the next receive.
+				SocketRecvBuffer buf = std::move(recv_buf);
+				buf.consume(callback(*this, buf.data(), buf.size(), std::move(cap)));
+				if (!buf.empty())
+				{
+					if (recv_buf.empty())
+					{
+						recv_buf = std::move(buf);
+					}
+					else
+					{
+						recv_buf.prepend(buf.data(), buf.size());
+					}
+				}
+				return;
+			}
+		}
+		holdup_type = SOCKET;
+		holdup_callback.set([](Worker& w, Capture&& _cap) // 'excal' as long as callback is
+		{
+			w.holdup_type = Worker::NONE;
+			auto& cap = _cap.get<CaptureSocketTransportRecvView>();
+			static_cast<Socket&>(w).transport_recvView(cap.callback, std::move(cap.cap));
+		}, CaptureSocketTransportRecvView{ callback, std::move(cap) });
+	}
+
+	void Socket::transport_unrecv(const void* data, size_t size) SOUP_EXCAL
 	{
-		unrecv_buf.insert(0, data);
+		recv_buf.prepend(reinterpret_cast<const char*>(data), size);
 	}
 
 	void Socket::transport_close() noexcept
@@ -5,6 +5,8 @@
 #include "fwd.hpp"
 #include "type.hpp"
 
+#include <initializer_list>
+
 #include "Worker.hpp"
 
 #if SOUP_WINDOWS
@@ -16,6 +18,7 @@
 
 #include "PrimitiveRaii.hpp"
 #include "SocketAddr.hpp"
+#include "SocketRecvBuffer.hpp"
 #include "SocketTlsEncrypter.hpp"
 #include "StructMap.hpp"
 #include "UniquePtr.hpp"
@@ -42,8 +45,22 @@ NAMESPACE_SOUP
 		bool remote_closed = false;
 		bool dispatched_connection_lost = false;
 		bool callback_recv_on_close = false;
+#if SOUP_LINUX
+		// Managed by the Scheduler if it uses epoll. A moved-to Socket starts out unregistered, since the Scheduler still knows the old one by its address.
+		struct EpollState
+		{
+			fd_t fd = -1; // the fd this socket was registered with
+			bool parked = false; // waiting for epoll to report the socket as ready, so Scheduler::tick skips it
+			bool dirty = false; // needs to be looked at by the next tick
+			size_t index = 0; // position in Scheduler::workers while parked
+
+			EpollState() noexcept = default;
+			EpollState(EpollState&&) noexcept {}
+			EpollState& operator =(EpollState&&) noexcept { return *this; }
+		} epoll{};
+#endif
 
-		std::string unrecv_buf{};
+		SocketRecvBuffer recv_buf{};
 
 		SocketTlsEncrypter tls_encrypter_send;
 		SocketTlsEncrypter tls_encrypter_recv;
@@ -116,10 +133,15 @@ NAMESPACE_SOUP
 	protected:
 		void enableCryptoClientRecvServerHelloDone(UniquePtr<SocketTlsHandshaker>&& handshaker) SOUP_EXCAL;
 		void enableCryptoClientProcessServerHelloDone(UniquePtr<SocketTlsHandshaker>&& handshaker) SOUP_EXCAL;
+		void enableCryptoClientRecvServerFinished(UniquePtr<SocketTlsHandshaker>&& handshaker) SOUP_EXCAL;
 
 	public:
 		void enableCryptoServer(SharedPtr<CertStore> certstore, void(*callback)(Socket&, Capture&&), Capture&& cap = {}, tls_server_on_client_hello_t on_client_hello = nullptr);
+	protected:
+		void enableCryptoServerRecvClientKeyExchange(UniquePtr<SocketTlsHandshaker>&& handshaker);
+		void enableCryptoServerRecvFinished(UniquePtr<SocketTlsHandshaker>&& handshaker);
 
+	public:
 		// Application Layer
 
 		[[nodiscard]] bool isEncrypted() const noexcept;
@@ -127,6 +149,16 @@ NAMESPACE_SOUP
 		bool send(const std::string& data) SOUP_EXCAL { return send(data.data(), data.size()); }
 		bool send(const void* data, size_t size) SOUP_EXCAL;
 
+		struct IoVec
+		{
+			const void* data;
+			size_t size;
+		};
+
+		// Sends multiple buffers as if they were one, without having to concatenate them first.
+		bool sendv(std::initializer_list<IoVec> bufs) SOUP_EXCAL { return sendv(bufs.begin(), bufs.size()); }
+		bool sendv(const IoVec* bufs, size_t count) SOUP_EXCAL;
+
 		bool initUdpBroadcast4();
 
 		bool setSourcePort4(uint16_t port);
@@ -184,19 +216,28 @@ NAMESPACE_SOUP
 		bool transport_send(const Buffer& buf) const noexcept;
 		bool transport_send(const std::string& data) const noexcept;
 		bool transport_send(const void* data, int size) const noexcept;
+		bool transport_sendv(const IoVec* bufs, size_t count) const noexcept; // Maps onto sendmsg/WSASend.
 
 		using transport_recv_callback_t = void(*)(Socket&, std::string&&, Capture&&);
+		using transport_recv_view_callback_t = size_t(*)(Socket&, const char* data, size_t size, Capture&&); // returns how many bytes were consumed
 
 		[[nodiscard]] bool transport_hasData() const;
+		[[nodiscard]] bool transport_hasBufferedData() const noexcept { return !recv_buf.empty(); }
 
 	protected:
-		[[nodiscard]] std::string transport_recvCommon(int max_bytes) SOUP_EXCAL;
+		bool transport_fill() SOUP_EXCAL;
+		void transport_recvCommon(std::string& out, size_t max_bytes) SOUP_EXCAL;
 	public:
 		void transport_recv(transport_recv_callback_t callback, Capture&& cap = {}); // 'excal' as long as callback is
 		void transport_recv(int max_bytes, transport_recv_callback_t callback, Capture&& cap = {}); // 'excal' as long as callback is
 		void transport_recvExact(int bytes, transport_recv_callback_t callback, Capture&& cap = {}, std::string&& pre = {}); // 'excal' as long as callback is
+		// Hands the callback everything that is currently buffered, without copying it. The data is only valid until the callback returns.
+		// Whatever the callback doesn't consume stays buffered for the next receive. 'size' is 0 if the remote closed the connection.
+		// That data is only put back once the callback returns, so to receive again from within it, call disallowRecursion first to have it happen on the next tick.
+		void transport_recvView(transport_recv_view_callback_t callback, Capture&& cap = {}); // 'excal' as long as callback is
 
-		void transport_unrecv(const std::string& data) SOUP_EXCAL;
+		void transport_unrecv(const std::string& data) SOUP_EXCAL { return transport_unrecv(data.data(), data.size()); }
+		void transport_unrecv(const void* data, size_t size) SOUP_EXCAL;
 
 		void transport_close() noexcept;
 
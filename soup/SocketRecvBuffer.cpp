@@ -0,0 +1,161 @@
+#include "SocketRecvBuffer.hpp"
+
+#include <cstring> // memcpy, memmove
+
+#include "alloc.hpp"
+
+NAMESPACE_SOUP
+{
+	// Free blocks are kept in an intrusive list, with the first bytes of each block pointing to the next one.
+	// This is trivially destructible so that buffers which are destroyed late during thread exit can still safely return their block.
+	struct SocketRecvBufferPool
+	{
+		static constexpr size_t MAX_CACHED = 32;
+
+		char* head;
+		size_t count;
+
+		[[nodiscard]] char* acquire() SOUP_EXCAL
+		{
+			if (head)
+			{
+				char* block = head;
+				head = *reinterpret_cast<char**>(block);
+				--count;
+				return block;
+			}
+			return reinterpret_cast<char*>(soup::malloc(SocketRecvBuffer::BLOCK_SIZE));
+		}
+
+		void recycle(char* block) noexcept
+		{
+			if (count >= MAX_CACHED)
+			{
+				soup::free(block);
+				return;
+			}
+			*reinterpret_cast<char**>(block) = head;
+			head = block;
+			++count;
+		}
+
+		void clear() noexcept
+		{
+			while (head)
+			{
+				char* next = *reinterpret_cast<char**>(head);
+				soup::free(head);
+				head = next;
+			}
+			count = MAX_CACHED; // Anything recycled after this point is freed immediately.
+		}
+	};
+	static thread_local SocketRecvBufferPool pool{};
+
+	struct SocketRecvBufferPoolCleanup
+	{
+		~SocketRecvBufferPoolCleanup() noexcept
+		{
+			pool.clear();
+		}
+	};
+	static thread_local SocketRecvBufferPoolCleanup pool_cleanup;
+
+	[[nodiscard]] static char* acquireBlock(size_t size) SOUP_EXCAL
+	{
+		if (size > SocketRecvBuffer::BLOCK_SIZE)
+		{
+			return reinterpret_cast<char*>(soup::malloc(size));
+		}
+		(void)&pool_cleanup; // Makes sure the pool is cleaned up when this thread exits.
+		return pool.acquire();
+	}
+
+	void SocketRecvBuffer::consume(size_t bytes) noexcept
+	{
+		SOUP_DEBUG_ASSERT(bytes <= size());
+		head += bytes;
+		if (head == tail)
+		{
+			release();
+		}
+	}
+
+	char* SocketRecvBuffer::prepareWrite(size_t& avail) SOUP_EXCAL
+	{
+		if (!block)
+		{
+			block = acquireBlock(BLOCK_SIZE);
+			capacity = BLOCK_SIZE;
+			head = 0;
+			tail = 0;
+		}
+		else if (head == tail)
+		{
+			head = 0;
+			tail = 0;
+		}
+		else if (tail == capacity && head != 0)
+		{
+			memmove(block, block + head, size());
+			tail -= head;
+			head = 0;
+		}
+		avail = capacity - tail;
+		return block + tail;
+	}
+
+	void SocketRecvBuffer::prepend(const char* data, size_t size) SOUP_EXCAL
+	{
+		if (size == 0)
+		{
+			return;
+		}
+		if (head >= size)
+		{
+			head -= size;
+			memcpy(block + head, data, size);
+			return;
+		}
+		const size_t buffered = this->size();
+		const size_t required = size + buffered;
+		if (required <= capacity)
+		{
+			// Fits into the current block after moving the buffered data back.
+			memmove(block + size, block + head, buffered);
+		}
+		else
+		{
+			char* const new_block = acquireBlock(required);
+			if (buffered != 0)
+			{
+				memcpy(new_block + size, block + head, buffered);
+			}
+			release();
+			block = new_block;
+			capacity = (required <= BLOCK_SIZE ? BLOCK_SIZE : required);
+		}
+		memcpy(block, data, size);
+		head = 0;
+		tail = required;
+	}
+
+	void SocketRecvBuffer::release() noexcept
+	{
+		if (block)
+		{
+			if (capacity == BLOCK_SIZE)
+			{
+				pool.recycle(block);
+			}
+			else
+			{
+				soup::free(block);
+			}
+			block = nullptr;
+			capacity = 0;
+		}
+		head = 0;
+		tail = 0;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef> // size_t
+
+#include "base.hpp"
+
+NAMESPACE_SOUP
+{
+	// Holds bytes that were read from a socket but not consumed yet.
+	// Storage is borrowed from a thread-local pool while there is data in it, so idle sockets don't pin any memory.
+	// Instead of wrapping around, unconsumed data is moved to the front when the tail is reached, so readers always get a contiguous view.
+	class SocketRecvBuffer
+	{
+	public:
+		static constexpr size_t BLOCK_SIZE = 0x4000;
+
+	protected:
+		char* block = nullptr;
+		size_t capacity = 0; // BLOCK_SIZE for pooled blocks, larger if data was put back that doesn't fit into one.
+		size_t head = 0;
+		size_t tail = 0;
+
+	public:
+		SocketRecvBuffer() noexcept = default;
+
+		SocketRecvBuffer(const SocketRecvBuffer&) = delete;
+
+		SocketRecvBuffer(SocketRecvBuffer&& b) noexcept
+			: block(b.block), capacity(b.capacity), head(b.head), tail(b.tail)
+		{
+			b.block = nullptr;
+			b.capacity = 0;
+			b.head = 0;
+			b.tail = 0;
+		}
+
+		~SocketRecvBuffer() noexcept
+		{
+			release();
+		}
+
+		void operator =(const SocketRecvBuffer&) = delete;
+
+		SocketRecvBuffer& operator =(SocketRecvBuffer&& b) noexcept
+		{
+			release();
+			block = b.block;
+			capacity = b.capacity;
+			head = b.head;
+			tail = b.tail;
+			b.block = nullptr;
+			b.capacity = 0;
+			b.head = 0;
+			b.tail = 0;
+			return *this;
+		}
+
+		[[nodiscard]] bool empty() const noexcept
+		{
+			return head == tail;
+		}
+
+		[[nodiscard]] size_t size() const noexcept
+		{
+			return tail - head;
+		}
+
+		[[nodiscard]] const char* data() const noexcept
+		{
+			return block + head;
+		}
+
+		// Marks the first 'bytes' of data() as consumed. Once everything is consumed, the storage goes back to the pool.
+		void consume(size_t bytes) noexcept;
+
+		// Returns the space that the next read from the socket should go into. 'avail' may be 0 if the buffer is full.
+		[[nodiscard]] char* prepareWrite(size_t& avail) SOUP_EXCAL;
+		void commitWrite(size_t bytes) noexcept
+		{
+			tail += bytes;
+		}
+
+		// Puts data back in front of what is buffered.
+		void prepend(const char* data, size_t size) SOUP_EXCAL;
+
+		void release() noexcept;
+	};
+}
@@ -1,6 +1,7 @@
 #include "SocketTlsEncrypter.hpp"
 
 #include "aes.hpp"
+#include "chacha20poly1305.hpp"
 #include "rand.hpp"
 #include "sha1.hpp"
 #include "sha256.hpp"
@@ -71,38 +72,131 @@ NAMESPACE_SOUP
 			buf.prepend(iv.data(), iv.size());
 			return buf;
 		}
+		else if (isChaCha20Poly1305())
+		{
+			uint8_t nonce[12];
+			getAeadNonce(nonce, nullptr);
+
+			auto ad = calculateMacBytes(content_type, size);
+
+			Buffer buf(size + cipher_bytes);
+			buf.append(data, size);
+
+			uint8_t tag[cipher_bytes];
+			chacha20poly1305::encrypt(
+				buf.data(), buf.size(),
+				(const uint8_t*)ad.data(), ad.size(),
+				cipher_key.data(),
+				nonce,
+				tag
+			);
+
+			buf.append(tag, cipher_bytes);
+			return buf;
+		}
 		else // AES-GCM
 		{
 			constexpr auto record_iv_length = 8;
 
-			auto nonce_explicit = rand.vec_u8(record_iv_length);
-			auto iv = implicit_iv;
-			iv.insert(iv.end(), nonce_explicit.begin(), nonce_explicit.end());
+			// RFC 5288 allows the explicit part of the nonce to be the sequence number, which is guaranteed to be unique per key.
+			uint8_t nonce_explicit[record_iv_length];
+			for (int i = 0; i != record_iv_length; ++i)
+			{
+				nonce_explicit[i] = static_cast<uint8_t>(seq_num >> ((record_iv_length - 1 - i) * 8));
+			}
+			uint8_t nonce[12];
+			getAeadNonce(nonce, nonce_explicit);
 
 			auto ad = calculateMacBytes(content_type, size);
 
-			Buffer buf(size + cipher_bytes + nonce_explicit.size());
+			Buffer buf(record_iv_length + size + cipher_bytes);
+			buf.append(nonce_explicit, record_iv_length);
 			buf.append(data, size);
 
 			uint8_t tag[cipher_bytes];
-			aes::gcmEncrypt(
-				buf.data(), buf.size(),
+			getGcm().encrypt(
+				buf.data() + record_iv_length, size,
 				(const uint8_t*)ad.data(), ad.size(),
-				cipher_key.data(), cipher_key.size(),
-				iv.data(), iv.size(),
+				nonce, sizeof(nonce),
 				tag
 			);
 
 			buf.append(tag, cipher_bytes);
-			buf.prepend(nonce_explicit.data(), nonce_explicit.size());
 			return buf;
 		}
 	}
 
+	bool SocketTlsEncrypter::decryptAead(TlsContentType_t content_type, std::string& data) SOUP_EXCAL
+	{
+		constexpr auto cipher_bytes = 16;
+		const size_t record_iv_length = (isChaCha20Poly1305() ? 0 : 8);
+
+		if (data.size() < (record_iv_length + cipher_bytes))
+		{
+			return false;
+		}
+		const size_t len = data.size() - (record_iv_length + cipher_bytes);
+
+		uint8_t nonce[12];
+		getAeadNonce(nonce, (const uint8_t*)data.data());
+
+		auto ad = calculateMacBytes(content_type, len);
+
+		uint8_t* const content = (uint8_t*)data.data() + record_iv_length;
+		const uint8_t* const tag = content + len;
+		if (isChaCha20Poly1305())
+		{
+			if (!chacha20poly1305::decrypt(content, len, (const uint8_t*)ad.data(), ad.size(), cipher_key.data(), nonce, tag))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			if (!getGcm().decrypt(content, len, (const uint8_t*)ad.data(), ad.size(), nonce, sizeof(nonce), tag))
+			{
+				return false;
+			}
+		}
+
+		data.erase(data.size() - cipher_bytes);
+		data.erase(0, record_iv_length);
+		return true;
+	}
+
+	void SocketTlsEncrypter::getAeadNonce(uint8_t nonce[12], const uint8_t* explicit_nonce) const noexcept
+	{
+		if (isChaCha20Poly1305())
+		{
+			// RFC 7905: The padded sequence number is XORed with the write IV.
+			memcpy(nonce, implicit_iv.data(), 12);
+			for (int i = 0; i != 8; ++i)
+			{
+				nonce[4 + i] ^= static_cast<uint8_t>(seq_num >> ((7 - i) * 8));
+			}
+		}
+		else
+		{
+			// RFC 5288: The salt from the key block followed by the explicit nonce from the record.
+			memcpy(nonce, implicit_iv.data(), 4);
+			memcpy(nonce + 4, explicit_nonce, 8);
+		}
+	}
+
+	aes::GcmContext& SocketTlsEncrypter::getGcm() SOUP_EXCAL
+	{
+		if (!gcm)
+		{
+			gcm = soup::make_unique<aes::GcmContext>(cipher_key.data(), cipher_key.size());
+		}
+		return *gcm;
+	}
+
 	void SocketTlsEncrypter::reset() noexcept
 	{
 		seq_num = 0;
 		cipher_key.clear();
 		mac_key.clear();
+		gcm.reset();
 	}
 }
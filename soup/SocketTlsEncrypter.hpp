@@ -6,7 +6,9 @@
 #include "base.hpp"
 #include "type.hpp"
 
+#include "aes.hpp"
 #include "Buffer.hpp"
+#include "UniquePtr.hpp"
 
 NAMESPACE_SOUP
 {
@@ -16,6 +18,7 @@ NAMESPACE_SOUP
 		std::vector<uint8_t> cipher_key;
 		std::string mac_key;
 		std::vector<uint8_t> implicit_iv;
+		UniquePtr<aes::GcmContext> gcm; // Created on first use so the key schedule and GHASH tables are only computed once per connection.
 
 		[[nodiscard]] bool isActive() const noexcept
 		{
@@ -27,12 +30,23 @@ NAMESPACE_SOUP
 			return !implicit_iv.empty();
 		}
 
+		[[nodiscard]] bool isChaCha20Poly1305() const noexcept
+		{
+			return implicit_iv.size() == 12;
+		}
+
 		[[nodiscard]] size_t getMacLength() const noexcept;
 		[[nodiscard]] std::string calculateMacBytes(TlsContentType_t content_type, size_t content_length) SOUP_EXCAL;
 		[[nodiscard]] std::string calculateMac(TlsContentType_t content_type, const std::string& content) SOUP_EXCAL { return calculateMac(content_type, content.data(), content.size()); }
 		[[nodiscard]] std::string calculateMac(TlsContentType_t content_type, const void* data, size_t size) SOUP_EXCAL;
 
 		[[nodiscard]] Buffer encrypt(TlsContentType_t content_type, const void* data, size_t size) SOUP_EXCAL;
+		[[nodiscard]] bool decryptAead(TlsContentType_t content_type, std::string& data) SOUP_EXCAL; // Decrypts and authenticates in-place. Returns false on a bad record MAC.
+
+	protected:
+		void getAeadNonce(uint8_t nonce[12], const uint8_t* explicit_nonce) const noexcept;
+		[[nodiscard]] aes::GcmContext& getGcm() SOUP_EXCAL;
+	public:
 
 		void reset() noexcept;
 	};
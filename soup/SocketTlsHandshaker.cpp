@@ -75,9 +75,15 @@ NAMESPACE_SOUP
 			mac_key_length = 0;
 			fixed_iv_length = 4;
 			break;
+
+		case TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256:
+		case TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256:
+			mac_key_length = 0;
+			fixed_iv_length = 12;
+			break;
 		}
 
-		size_t enc_key_length = 16; // AES128 = 16, AES256 = 32
+		size_t enc_key_length = 16; // AES128 = 16, AES256 = 32, ChaCha20 = 32
 		switch (cipher_suite)
 		{
 		case TLS_RSA_WITH_AES_256_CBC_SHA:
@@ -86,6 +92,8 @@ NAMESPACE_SOUP
 		case TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384:
 		case TLS_ECDHE_ECDSA_WITH_AES_256_CBC_SHA:
 		case TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384:
+		case TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256:
+		case TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256:
 			enc_key_length = 32;
 			break;
 		}
@@ -11,6 +11,7 @@
 #include "SharedPtr.hpp"
 #include "SocketTlsEncrypter.hpp"
 #include "TlsCipherSuite.hpp"
+#include "TlsSessionCache.hpp"
 #include "X509Certchain.hpp"
 #include "X509Certificate.hpp"
 
@@ -23,7 +24,7 @@ NAMESPACE_SOUP
 		Capture callback_capture;
 
 		TlsCipherSuite_t cipher_suite = TLS_RSA_WITH_AES_128_CBC_SHA;
-		uint16_t ecdhe_curve = 0; // client
+		uint16_t ecdhe_curve = 0;
 		Promise<> promise{};
 		bool extended_master_secret = false;
 		std::string layer_bytes{};
@@ -32,18 +33,28 @@ NAMESPACE_SOUP
 		std::string pre_master_secret{};
 		std::string master_secret{};
 		std::string expected_finished_verify_data{};
+		SocketTlsEncrypter pending_recv_encrypter;
+		SocketTlsEncrypter pending_send_encrypter;
+		bool resumed = false;
+		TlsSessionCache* session_cache = nullptr;
+		TlsSession session{};
 
 		// client
 		X509Certchain certchain{};
 		std::string server_name{};
+		std::string session_cache_key{}; // server_name:port
 		std::string ecdhe_public_key{};
 		std::string initial_application_data{};
-		SocketTlsEncrypter pending_recv_encrypter;
+		bool expecting_session_ticket = false;
 
 		// server
 		SharedPtr<CertStore> certstore;
 		void(*on_client_hello)(Socket&, TlsClientHello&&);
 		const RsaPrivateKey* private_key{};
+		std::string ecdhe_private_key{};
+		std::string server_key_exchange{};
+		std::string session_id{};
+		bool issue_session_ticket = false;
 
 		explicit SocketTlsHandshaker(void(*callback)(Socket&, Capture&&), Capture&& callback_capture) noexcept;
 
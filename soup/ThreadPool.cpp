@@ -0,0 +1,314 @@
+#include "ThreadPool.hpp"
+#if !SOUP_WASM && (!SOUP_WINDOWS || !SOUP_CROSS_COMPILE)
+
+#include <algorithm> // min
+#include <thread> // hardware_concurrency, yield
+#include <utility> // exchange
+
+NAMESPACE_SOUP
+{
+	static thread_local ThreadPool* this_thread_pool = nullptr;
+	static thread_local size_t this_thread_queue_index;
+
+	struct ThreadPoolThreadInfo
+	{
+		ThreadPool* pool;
+		size_t i;
+	};
+
+	struct ThreadPoolRange
+	{
+		ThreadPool* pool;
+		void(*callback)(unsigned int, unsigned int, unsigned int, const Capture&);
+		const Capture& cap;
+		unsigned int size;
+		unsigned int grain;
+		std::atomic_uint remaining_chunks;
+		ThreadPool::FirstException exception;
+
+		ThreadPoolRange(ThreadPool* pool, void(*callback)(unsigned int, unsigned int, unsigned int, const Capture&), const Capture& cap, unsigned int size, unsigned int grain, unsigned int num_chunks)
+			: pool(pool), callback(callback), cap(cap), size(size), grain(grain), remaining_chunks(num_chunks)
+		{
+		}
+	};
+
+	ThreadPool::ThreadPool(unsigned int num_threads) SOUP_EXCAL
+	{
+		queues.reserve(num_threads + 1);
+		for (unsigned int i = 0; i != num_threads + 1; ++i)
+		{
+			queues.emplace_back(soup::make_unique<Queue>());
+		}
+		threads.reserve(num_threads);
+		for (unsigned int i = 0; i != num_threads; ++i)
+		{
+			threads.emplace_back(soup::make_unique<Thread>([](Capture&& cap)
+			{
+				auto& info = cap.get<ThreadPoolThreadInfo>();
+				info.pool->threadFunc(info.i);
+			}, ThreadPoolThreadInfo{ this, i }));
+		}
+	}
+
+	ThreadPool::~ThreadPool() noexcept
+	{
+		{
+			std::lock_guard lock(sleep_mtx);
+			stopping = true;
+		}
+		sleep_cv.notify_all();
+		Thread::awaitCompletion(threads);
+	}
+
+	ThreadPool& ThreadPool::getDefault() SOUP_EXCAL
+	{
+		static ThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+		return pool;
+	}
+
+	unsigned int ThreadPool::getGrain(unsigned int size, unsigned int grain) const noexcept
+	{
+		if (grain == 0)
+		{
+			// Aim for a few chunks per thread so stealing can even out uneven items.
+			grain = size / ((getNumThreads() + 1) * 4);
+			if (grain == 0)
+			{
+				grain = 1;
+			}
+		}
+		return grain;
+	}
+
+	void ThreadPool::parallelFor(unsigned int size, void(*callback)(unsigned int, const Capture&), const Capture& cap, unsigned int grain)
+	{
+		struct ForContext
+		{
+			void(*callback)(unsigned int, const Capture&);
+			const Capture& cap;
+		};
+		ForContext ctx{ callback, cap };
+		parallelForChunks(size, getGrain(size, grain), [](unsigned int, unsigned int begin, unsigned int end, const Capture& cap)
+		{
+			auto& ctx = *cap.get<ForContext*>();
+			for (unsigned int i = begin; i != end; ++i)
+			{
+				ctx.callback(i, ctx.cap);
+			}
+		}, &ctx);
+	}
+
+	void ThreadPool::parallelForChunks(unsigned int size, unsigned int grain, void(*callback)(unsigned int, unsigned int, unsigned int, const Capture&), const Capture& cap)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+		SOUP_ASSERT(grain != 0);
+		const unsigned int num_chunks = getNumChunks(size, grain);
+		ThreadPoolRange range(this, callback, cap, size, grain, num_chunks);
+		Job root{ &execRange, &range, 0, num_chunks, nullptr, {} };
+		execRange(root);
+		while (range.remaining_chunks.load(std::memory_order_acquire) != 0)
+		{
+			if (!runOne())
+			{
+				std::this_thread::yield();
+			}
+		}
+		range.exception.rethrow();
+	}
+
+	void ThreadPool::execRange(Job& job)
+	{
+		auto& range = *reinterpret_cast<ThreadPoolRange*>(job.ctx);
+		auto begin = job.begin;
+		auto end = job.end;
+
+		// Split off the upper half until we're left with a single chunk. Thieves take from the front of the queue, so they'll get the biggest halves.
+		SOUP_TRY
+		{
+			while (end - begin > 1)
+			{
+				const auto mid = begin + ((end - begin) / 2);
+				range.pool->push(Job{ &execRange, &range, mid, end, nullptr, {} });
+				end = mid;
+			}
+		}
+		SOUP_CATCH_ANY
+		{
+			// The rest could not be handed off, so it's done here.
+		}
+
+		for (; begin != end; ++begin)
+		{
+			execChunk(range, begin);
+		}
+	}
+
+	void ThreadPool::execChunk(ThreadPoolRange& range, unsigned int chunk) noexcept
+	{
+		const auto chunk_begin = chunk * range.grain;
+		const auto chunk_end = chunk_begin + std::min(range.grain, range.size - chunk_begin);
+		SOUP_TRY
+		{
+			range.callback(chunk, chunk_begin, chunk_end, range.cap);
+		}
+		SOUP_CATCH_ANY
+		{
+			range.exception.capture();
+		}
+		// The waiting thread only leaves once every chunk is accounted for, also when one of them threw.
+		range.remaining_chunks.fetch_sub(1, std::memory_order_release);
+	}
+
+	void ThreadPool::FirstException::capture() noexcept
+	{
+		std::lock_guard lock(mtx);
+		if (!ptr)
+		{
+			ptr = std::current_exception();
+		}
+	}
+
+	void ThreadPool::FirstException::rethrow()
+	{
+		if (ptr)
+		{
+			std::rethrow_exception(std::exchange(ptr, nullptr));
+		}
+	}
+
+	void ThreadPool::TaskGroup::run(void(*f)(Capture&&), Capture&& cap) SOUP_EXCAL
+	{
+		++pending;
+		pool.push(Job{ [](Job& job)
+		{
+			auto& group = *reinterpret_cast<TaskGroup*>(job.ctx);
+			SOUP_TRY
+			{
+				job.f(std::move(job.cap));
+			}
+			SOUP_CATCH_ANY
+			{
+				group.exception.capture();
+			}
+			--group.pending;
+		}, this, 0, 0, f, std::move(cap) });
+	}
+
+	void ThreadPool::TaskGroup::wait()
+	{
+		await();
+		exception.rethrow();
+	}
+
+	void ThreadPool::TaskGroup::await() noexcept
+	{
+		while (pending.load(std::memory_order_acquire) != 0)
+		{
+			if (!pool.runOne())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void ThreadPool::push(Job&& job) SOUP_EXCAL
+	{
+		{
+			auto& q = *queues[getOwnQueueIndex()];
+			std::lock_guard lock(q.mtx);
+			q.jobs.emplace_back(std::move(job));
+		}
+		num_queued.fetch_add(1);
+		// A worker counts itself as sleeping before it checks num_queued, so either it sees this job or we see it.
+		if (num_sleeping.load() != 0)
+		{
+			// It might not be waiting yet, but it holds sleep_mtx until it does.
+			{
+				std::lock_guard lock(sleep_mtx);
+			}
+			sleep_cv.notify_one();
+		}
+	}
+
+	bool ThreadPool::runOne() noexcept
+	{
+		const auto own = getOwnQueueIndex();
+		Job job;
+		bool found = false;
+		{
+			// Own queue is used like a stack for cache locality.
+			auto& q = *queues[own];
+			std::lock_guard lock(q.mtx);
+			if (!q.jobs.empty())
+			{
+				job = std::move(q.jobs.back());
+				q.jobs.pop_back();
+				found = true;
+			}
+		}
+		for (size_t i = 1; !found && i != queues.size(); ++i)
+		{
+			auto& q = *queues[(own + i) % queues.size()];
+			std::lock_guard lock(q.mtx);
+			if (!q.jobs.empty())
+			{
+				job = std::move(q.jobs.front());
+				q.jobs.pop_front();
+				found = true;
+			}
+		}
+		if (!found)
+		{
+			return false;
+		}
+		num_queued.fetch_sub(1);
+
+		// Jobs pushed by this job should go into this thread's queue, even if this is an external thread helping out a different pool.
+		const auto prev_pool = this_thread_pool;
+		const auto prev_queue_index = this_thread_queue_index;
+		this_thread_pool = this;
+		this_thread_queue_index = own;
+		job.exec(job);
+		this_thread_pool = prev_pool;
+		this_thread_queue_index = prev_queue_index;
+		return true;
+	}
+
+	size_t ThreadPool::getOwnQueueIndex() const noexcept
+	{
+		if (this_thread_pool == this)
+		{
+			return this_thread_queue_index;
+		}
+		return queues.size() - 1;
+	}
+
+	void ThreadPool::threadFunc(size_t i) noexcept
+	{
+		this_thread_pool = this;
+		this_thread_queue_index = i;
+		while (true)
+		{
+			if (runOne())
+			{
+				continue;
+			}
+			std::unique_lock lock(sleep_mtx);
+			if (stopping)
+			{
+				break;
+			}
+			++num_sleeping;
+			if (num_queued.load() == 0)
+			{
+				sleep_cv.wait(lock);
+			}
+			--num_sleeping;
+		}
+	}
+}
+
+#endif
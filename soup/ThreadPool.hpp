@@ -0,0 +1,160 @@
+#pragma once
+
+#include "base.hpp"
+#if !SOUP_WASM && (!SOUP_WINDOWS || !SOUP_CROSS_COMPILE)
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+#include "Capture.hpp"
+#include "Thread.hpp"
+#include "UniquePtr.hpp"
+
+NAMESPACE_SOUP
+{
+	struct ThreadPoolRange;
+
+	// A persistent pool of threads with per-thread job queues. Idle threads steal work from the others.
+	// Threads that wait for a parallelFor or TaskGroup to complete help execute jobs in the meantime, so nesting is fine.
+	class ThreadPool
+	{
+	public:
+		struct Job
+		{
+			void(*exec)(Job&);
+			void* ctx;
+			unsigned int begin;
+			unsigned int end;
+			void(*f)(Capture&&);
+			Capture cap;
+		};
+
+		struct Queue
+		{
+			std::mutex mtx;
+			std::deque<Job> jobs;
+		};
+
+		// Keeps the first exception thrown by a job, so it can be rethrown on the thread that waits for the work.
+		struct FirstException
+		{
+			std::mutex mtx;
+			std::exception_ptr ptr;
+
+			void capture() noexcept;
+			void rethrow();
+		};
+
+		class TaskGroup
+		{
+		protected:
+			ThreadPool& pool;
+			std::atomic_size_t pending = 0;
+			FirstException exception;
+
+		public:
+			TaskGroup(ThreadPool& pool = ThreadPool::getDefault()) noexcept
+				: pool(pool)
+			{
+			}
+
+			// If a task threw and wait was not called, the exception is discarded.
+			~TaskGroup() noexcept
+			{
+				await();
+			}
+
+			void run(void(*f)(Capture&&), Capture&& cap = {}) SOUP_EXCAL;
+
+			// Waits for all tasks to complete, then rethrows the first exception a task threw, if any.
+			void wait();
+
+		protected:
+			void await() noexcept;
+		};
+
+	protected:
+		std::vector<UniquePtr<Queue>> queues{}; // one per thread, plus one shared by all external threads at the end
+		std::vector<UniquePtr<Thread>> threads{};
+		std::atomic_size_t num_queued = 0;
+		std::mutex sleep_mtx;
+		std::condition_variable sleep_cv;
+		std::atomic_size_t num_sleeping = 0;
+		bool stopping = false;
+
+	public:
+		// The calling thread always participates in the work, so a pool with 0 threads is valid and will simply run everything on the caller.
+		explicit ThreadPool(unsigned int num_threads) SOUP_EXCAL;
+		~ThreadPool() noexcept;
+
+		// The default pool has one thread less than the hardware has, since the calling thread also contributes.
+		[[nodiscard]] static ThreadPool& getDefault() SOUP_EXCAL;
+
+		[[nodiscard]] unsigned int getNumThreads() const noexcept { return static_cast<unsigned int>(threads.size()); }
+
+		// Determines the number of indices per chunk to use if grain is 0.
+		[[nodiscard]] unsigned int getGrain(unsigned int size, unsigned int grain = 0) const noexcept;
+
+		// ceil(size / grain), without overflowing for sizes close to UINT_MAX.
+		[[nodiscard]] static unsigned int getNumChunks(unsigned int size, unsigned int grain) noexcept
+		{
+			return (size / grain) + ((size % grain) != 0);
+		}
+
+		// If the callback throws, the rest of that chunk is skipped, but the other chunks still run, and the first exception is rethrown once they are done.
+		void parallelFor(unsigned int size, void(*callback)(unsigned int i, const Capture&), const Capture& cap = {}, unsigned int grain = 0);
+
+		// Calls back for every chunk of `grain` indices. Chunk indices are in the range [0, ceil(size / grain)). Exceptions are handled like in parallelFor.
+		void parallelForChunks(unsigned int size, unsigned int grain, void(*callback)(unsigned int chunk, unsigned int begin, unsigned int end, const Capture&), const Capture& cap = {});
+
+		// Every chunk is reduced in index order, then the chunk results are combined in chunk order, so the result is deterministic for a given grain.
+		template <typename T>
+		[[nodiscard]] T parallelReduce(unsigned int size, T identity, T(*map)(unsigned int i, const Capture&), T(*reduce)(T, T), const Capture& cap = {}, unsigned int grain = 0)
+		{
+			struct ReduceContext
+			{
+				const T& identity;
+				T(*map)(unsigned int, const Capture&);
+				T(*reduce)(T, T);
+				const Capture& cap;
+				std::vector<T> partials;
+			};
+
+			grain = getGrain(size, grain);
+			ReduceContext ctx{ identity, map, reduce, cap, std::vector<T>(getNumChunks(size, grain), identity) };
+			parallelForChunks(size, grain, [](unsigned int chunk, unsigned int begin, unsigned int end, const Capture& cap)
+			{
+				auto& ctx = *cap.get<ReduceContext*>();
+				T accum = ctx.identity;
+				for (unsigned int i = begin; i != end; ++i)
+				{
+					accum = ctx.reduce(std::move(accum), ctx.map(i, ctx.cap));
+				}
+				ctx.partials[chunk] = std::move(accum);
+			}, &ctx);
+
+			T res = std::move(identity);
+			for (auto& partial : ctx.partials)
+			{
+				res = reduce(std::move(res), std::move(partial));
+			}
+			return res;
+		}
+
+	protected:
+		void push(Job&& job) SOUP_EXCAL;
+		[[nodiscard]] bool runOne() noexcept;
+		[[nodiscard]] size_t getOwnQueueIndex() const noexcept;
+
+		static void execRange(Job& job);
+		static void execChunk(ThreadPoolRange& range, unsigned int chunk) noexcept;
+
+		void threadFunc(size_t i) noexcept;
+	};
+}
+
+#endif
@@ -25,6 +25,9 @@ NAMESPACE_SOUP
 		TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256 = 0xC02B,
 		TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384 = 0xC02C,
 
+		TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256 = 0xCCA8,
+		TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256 = 0xCCA9,
+
 		TLS_GREASE_0 = 0x0A0A,
 		TLS_GREASE_1 = 0x1A1A,
 		TLS_GREASE_2 = 0x2A2A,
@@ -13,6 +13,7 @@ NAMESPACE_SOUP
 		ec_point_formats = 11,
 		signature_algorithms = 13,
 		extended_master_secret = 23,
+		session_ticket = 35,
 		supported_versions = 43,
 	);
 
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Packet.hpp"
+
+NAMESPACE_SOUP
+{
+	// RFC 5077
+	SOUP_PACKET(TlsNewSessionTicket)
+	{
+		u32 ticket_lifetime_hint; // in seconds
+		std::string ticket;
+
+		SOUP_PACKET_IO(s)
+		{
+			return s.u32be(ticket_lifetime_hint)
+				&& s.template str_lp<u16be_t>(ticket)
+				;
+		}
+	};
+}
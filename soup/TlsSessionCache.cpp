@@ -0,0 +1,192 @@
+#include "TlsSessionCache.hpp"
+
+#if !SOUP_WASM
+
+#include <cstring> // memcmp
+
+#include "aes.hpp"
+#include "rand.hpp"
+#include "time.hpp"
+
+NAMESPACE_SOUP
+{
+	// Ticket format: key_name (16) + iv (12) + encrypted state + tag (16), with key_name as additional data.
+	// State format: cipher_suite (2) + extended_master_secret (1) + created (8) + master_secret (48) + server_name length (2) + server_name
+	static constexpr size_t TICKET_KEY_NAME_SIZE = 16;
+	static constexpr size_t TICKET_IV_SIZE = 12;
+	static constexpr size_t TICKET_TAG_SIZE = 16;
+	static constexpr size_t TICKET_STATE_FIXED_SIZE = 2 + 1 + 8 + 48 + 2;
+
+	TlsSessionCache::TlsSessionCache(size_t capacity, time_t lifetime) SOUP_EXCAL
+		: capacity(capacity), lifetime(lifetime)
+	{
+		rand.fill(ticket_key_name);
+		rand.fill(ticket_key);
+	}
+
+	void TlsSessionCache::add(const std::string& key, const TlsSession& session) SOUP_EXCAL
+	{
+		std::lock_guard lock(mtx);
+		if (auto it = index.find(key); it != index.end())
+		{
+			it->second->second = session;
+			entries.splice(entries.begin(), entries, it->second);
+			return;
+		}
+		if (capacity == 0)
+		{
+			return;
+		}
+		if (entries.size() == capacity)
+		{
+			index.erase(entries.back().first);
+			entries.pop_back();
+		}
+		entries.emplace_front(key, session);
+		index.emplace(key, entries.begin());
+	}
+
+	bool TlsSessionCache::find(const std::string& key, TlsSession& out) SOUP_EXCAL
+	{
+		std::lock_guard lock(mtx);
+		if (auto it = index.find(key); it != index.end())
+		{
+			if (isExpired(it->second->second))
+			{
+				entries.erase(it->second);
+				index.erase(it);
+				return false;
+			}
+			entries.splice(entries.begin(), entries, it->second);
+			out = it->second->second;
+			return true;
+		}
+		return false;
+	}
+
+	void TlsSessionCache::remove(const std::string& key) SOUP_EXCAL
+	{
+		std::lock_guard lock(mtx);
+		if (auto it = index.find(key); it != index.end())
+		{
+			entries.erase(it->second);
+			index.erase(it);
+		}
+	}
+
+	void TlsSessionCache::clear() noexcept
+	{
+		std::lock_guard lock(mtx);
+		entries.clear();
+		index.clear();
+	}
+
+	size_t TlsSessionCache::size() noexcept
+	{
+		std::lock_guard lock(mtx);
+		return entries.size();
+	}
+
+	std::string TlsSessionCache::encryptTicket(const TlsSession& session) const SOUP_EXCAL
+	{
+		SOUP_DEBUG_ASSERT(session.master_secret.size() == 48);
+		SOUP_DEBUG_ASSERT(session.server_name.size() <= 0xffff);
+
+		const size_t state_size = TICKET_STATE_FIXED_SIZE + session.server_name.size();
+		std::string ticket((const char*)ticket_key_name, TICKET_KEY_NAME_SIZE);
+		ticket.reserve(TICKET_KEY_NAME_SIZE + TICKET_IV_SIZE + state_size + TICKET_TAG_SIZE);
+
+		uint8_t iv[TICKET_IV_SIZE];
+		rand.fill(iv);
+		ticket.append((const char*)iv, sizeof(iv));
+
+		const size_t state_offset = ticket.size();
+		ticket.push_back(static_cast<char>(session.cipher_suite >> 8));
+		ticket.push_back(static_cast<char>(session.cipher_suite & 0xff));
+		ticket.push_back(session.extended_master_secret ? 1 : 0);
+		for (int i = 7; i >= 0; --i)
+		{
+			ticket.push_back(static_cast<char>(static_cast<uint64_t>(session.created) >> (i * 8)));
+		}
+		ticket.append(session.master_secret);
+		ticket.push_back(static_cast<char>(session.server_name.size() >> 8));
+		ticket.push_back(static_cast<char>(session.server_name.size() & 0xff));
+		ticket.append(session.server_name);
+
+		uint8_t tag[TICKET_TAG_SIZE];
+		aes::gcmEncrypt(
+			(uint8_t*)ticket.data() + state_offset, state_size,
+			ticket_key_name, sizeof(ticket_key_name),
+			ticket_key, sizeof(ticket_key),
+			iv, sizeof(iv),
+			tag
+		);
+		ticket.append((const char*)tag, sizeof(tag));
+		return ticket;
+	}
+
+	bool TlsSessionCache::decryptTicket(const std::string& ticket, TlsSession& out) const SOUP_EXCAL
+	{
+		if (ticket.size() < TICKET_KEY_NAME_SIZE + TICKET_IV_SIZE + TICKET_STATE_FIXED_SIZE + TICKET_TAG_SIZE
+			|| memcmp(ticket.data(), ticket_key_name, TICKET_KEY_NAME_SIZE) != 0
+			)
+		{
+			return false;
+		}
+
+		const size_t state_size = ticket.size() - (TICKET_KEY_NAME_SIZE + TICKET_IV_SIZE + TICKET_TAG_SIZE);
+		std::string buf = ticket.substr(TICKET_KEY_NAME_SIZE + TICKET_IV_SIZE, state_size);
+		if (!aes::gcmDecrypt(
+			(uint8_t*)buf.data(), state_size,
+			ticket_key_name, sizeof(ticket_key_name),
+			ticket_key, sizeof(ticket_key),
+			(const uint8_t*)ticket.data() + TICKET_KEY_NAME_SIZE, TICKET_IV_SIZE,
+			(const uint8_t*)ticket.data() + TICKET_KEY_NAME_SIZE + TICKET_IV_SIZE + state_size
+		))
+		{
+			return false;
+		}
+		const uint8_t* const state = (const uint8_t*)buf.data();
+		const size_t server_name_len = (static_cast<size_t>(state[59]) << 8) | state[60];
+		if (TICKET_STATE_FIXED_SIZE + server_name_len != state_size)
+		{
+			return false;
+		}
+
+		TlsSession session;
+		session.cipher_suite = (static_cast<uint16_t>(state[0]) << 8) | state[1];
+		session.extended_master_secret = (state[2] != 0);
+		uint64_t created = 0;
+		for (int i = 0; i != 8; ++i)
+		{
+			created = (created << 8) | state[3 + i];
+		}
+		session.created = static_cast<time_t>(created);
+		session.master_secret = std::string((const char*)state + 11, 48);
+		session.server_name = std::string((const char*)state + TICKET_STATE_FIXED_SIZE, server_name_len);
+		if (isExpired(session))
+		{
+			return false;
+		}
+		out = std::move(session);
+		return true;
+	}
+
+	double TlsSessionCache::getHitRate() const noexcept
+	{
+		const size_t h = hits.load();
+		const size_t total = h + misses.load();
+		if (total == 0)
+		{
+			return 0.0;
+		}
+		return static_cast<double>(h) / static_cast<double>(total);
+	}
+
+	bool TlsSessionCache::isExpired(const TlsSession& session) const noexcept
+	{
+		return time::unixSeconds() - session.created > lifetime;
+	}
+}
+
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "base.hpp"
+#if !SOUP_WASM
+
+#include <atomic>
+#include <ctime> // time_t
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "type.hpp"
+
+NAMESPACE_SOUP
+{
+	struct TlsSession
+	{
+		TlsCipherSuite_t cipher_suite = 0;
+		bool extended_master_secret = false;
+		std::string master_secret{};
+		time_t created = 0;
+		std::string server_name{}; // As per RFC 6066, section 3, a session is only resumed for the server name it was established with.
+
+		// client
+		std::string session_id{};
+		std::string ticket{};
+		certchain_validator_t certchain_validator = nullptr; // Sessions are only resumed if the same validator is still in use.
+	};
+
+	// A bounded, thread-safe cache of TLS 1.2 sessions so reconnecting peers can use an abbreviated handshake.
+	// Clients key sessions by server name and port, servers key them by session ID.
+	// Servers can also issue session tickets as per RFC 5077, in which case the session state is encrypted and stored by the client instead.
+	class TlsSessionCache
+	{
+	public:
+		size_t capacity;
+		time_t lifetime; // in seconds
+
+		// Counted by the handshake: A hit is a resumed session, a miss is a full handshake.
+		std::atomic_size_t hits{ 0 };
+		std::atomic_size_t misses{ 0 };
+
+	protected:
+		std::mutex mtx;
+		std::list<std::pair<std::string, TlsSession>> entries{}; // Most recently used at the front.
+		std::unordered_map<std::string, std::list<std::pair<std::string, TlsSession>>::iterator> index{};
+		uint8_t ticket_key_name[16];
+		uint8_t ticket_key[32];
+
+	public:
+		explicit TlsSessionCache(size_t capacity = 1000, time_t lifetime = 2 * 60 * 60) SOUP_EXCAL;
+
+		void add(const std::string& key, const TlsSession& session) SOUP_EXCAL;
+		[[nodiscard]] bool find(const std::string& key, TlsSession& out) SOUP_EXCAL;
+		void remove(const std::string& key) SOUP_EXCAL;
+		void clear() noexcept;
+		[[nodiscard]] size_t size() noexcept;
+
+		[[nodiscard]] std::string encryptTicket(const TlsSession& session) const SOUP_EXCAL;
+		[[nodiscard]] bool decryptTicket(const std::string& ticket, TlsSession& out) const SOUP_EXCAL;
+
+		[[nodiscard]] double getHitRate() const noexcept;
+	protected:
+		[[nodiscard]] bool isExpired(const TlsSession& session) const noexcept;
+	};
+}
+#endif
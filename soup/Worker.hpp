@@ -8,6 +8,7 @@
 
 #include "Callback.hpp"
 #include "Capture.hpp"
+#include "memPoolAllocator.hpp"
 
 NAMESPACE_SOUP
 {
@@ -19,7 +20,7 @@ NAMESPACE_SOUP
 		WORKER_TYPE_USER,
 	};
 
-	struct Worker
+	struct Worker : public memPooled
 	{
 		enum HoldupType : uint8_t
 		{
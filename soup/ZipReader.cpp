@@ -1,7 +1,10 @@
 #include "ZipReader.hpp"
 
+#include "crc32.hpp"
 #include "deflate.hpp"
 #include "Exception.hpp"
+#include "InflateReader.hpp"
+#include "MemoryRefReader.hpp"
 #include "Reader.hpp"
 #include "ZipCentralDirectoryFile.hpp"
 #include "ZipEndOfCentralDirectory.hpp"
@@ -9,6 +12,70 @@
 
 NAMESPACE_SOUP
 {
+	// Confines reads to the data of a stored file, and checks its CRC32 once it has been read from start to end.
+	class ZipStoredReader final : public Reader
+	{
+	public:
+		Reader& is;
+		size_t start;
+		size_t size;
+		size_t offset = 0;
+		uint32_t expected_crc32;
+		uint32_t checksum = crc32::INITIAL;
+		size_t checksum_pos = 0; // end of the data that has been included in the checksum
+
+		ZipStoredReader(Reader& is, size_t size, uint32_t expected_crc32)
+			: Reader(), is(is), start(is.getPosition()), size(size), expected_crc32(expected_crc32)
+		{
+		}
+
+		~ZipStoredReader() final = default;
+
+		bool hasMore() noexcept final
+		{
+			return offset != size;
+		}
+
+		bool raw(void* data, size_t len) noexcept final
+		{
+			SOUP_IF_UNLIKELY ((offset + len) > size)
+			{
+				return false;
+			}
+			is.seek(start + offset);
+			SOUP_IF_UNLIKELY (!is.raw(data, len))
+			{
+				return false;
+			}
+			if (offset == checksum_pos)
+			{
+				checksum = crc32::hash(reinterpret_cast<const uint8_t*>(data), len, checksum);
+				checksum_pos += len;
+				SOUP_IF_UNLIKELY (checksum_pos == size && checksum != expected_crc32)
+				{
+					return false;
+				}
+			}
+			offset += len;
+			return true;
+		}
+
+		[[nodiscard]] size_t getPosition() noexcept final
+		{
+			return offset;
+		}
+
+		void seek(size_t pos) noexcept final
+		{
+			offset = (pos > size ? size : pos);
+		}
+
+		void seekEnd() noexcept final
+		{
+			offset = size;
+		}
+	};
+
 	size_t ZipReader::seekCentralDirectory() const
 	{
 		std::vector<ZipIndexedFile> ret{};
@@ -161,4 +228,100 @@ NAMESPACE_SOUP
 
 		return ret;
 	}
+
+	UniquePtr<Reader> ZipReader::getFileReader(const ZipIndexedFile& file) const
+	{
+		is.seek(file.offset);
+		std::string bytes;
+		is.str(4, bytes);
+		ZipLocalFileHeader lfh;
+		if (bytes != "\x50\x4b\x03\x04"
+			|| !lfh.read(is)
+			)
+		{
+			SOUP_THROW(Exception("Invalid local file header"));
+		}
+		// Sizes in the local file header may be zero if they were written in a data descriptor, so we use those from the central directory.
+		if (file.compression_method == 0)
+		{
+			return soup::make_unique<ZipStoredReader>(is, file.compressed_size, file.uncompressed_data_crc32);
+		}
+		if (file.compression_method == 8)
+		{
+			auto r = soup::make_unique<InflateReader>(is, deflate::RAW, file.compressed_size);
+			r->setExpectedCrc32(file.uncompressed_data_crc32);
+			return r;
+		}
+		SOUP_THROW(Exception("Unsupported compression method"));
+	}
+
+#if !SOUP_WASM && (!SOUP_WINDOWS || !SOUP_CROSS_COMPILE)
+	std::vector<unsigned int> ZipReader::extractFiles(const void* archive, size_t archive_size, const std::vector<ZipIndexedFile>& files, void(*callback)(unsigned int i, std::string&& contents, const Capture&), const Capture& cap, ThreadPool& pool)
+	{
+		struct Context
+		{
+			const void* archive;
+			size_t archive_size;
+			const std::vector<ZipIndexedFile>& files;
+			void(*callback)(unsigned int, std::string&&, const Capture&);
+			const Capture& cap;
+			std::vector<uint8_t> failed;
+		};
+		Context ctx{ archive, archive_size, files, callback, cap, std::vector<uint8_t>(files.size(), 0) };
+
+		pool.parallelFor(static_cast<unsigned int>(files.size()), [](unsigned int i, const Capture& cap)
+		{
+			auto& ctx = *cap.get<Context*>();
+			const ZipIndexedFile& file = ctx.files[i];
+
+			MemoryRefReader r(ctx.archive, ctx.archive_size);
+			r.seek(file.offset);
+			std::string bytes;
+			ZipLocalFileHeader lfh;
+			if (!r.str(4, bytes)
+				|| bytes != "\x50\x4b\x03\x04"
+				|| !lfh.read(r)
+				|| r.getPosition() + file.compressed_size > ctx.archive_size
+				)
+			{
+				ctx.failed[i] = 1;
+				return;
+			}
+			const char* data = reinterpret_cast<const char*>(ctx.archive) + r.getPosition();
+
+			std::string contents;
+			if (file.compression_method == 0)
+			{
+				contents = std::string(data, file.compressed_size);
+			}
+			else if (file.compression_method == 8)
+			{
+				contents = deflate::decompress(data, file.compressed_size, file.uncompressed_size).decompressed;
+			}
+			else
+			{
+				ctx.failed[i] = 1;
+				return;
+			}
+			if (contents.size() != file.uncompressed_size
+				|| crc32::hash(contents) != file.uncompressed_data_crc32
+				)
+			{
+				ctx.failed[i] = 1;
+				return;
+			}
+			ctx.callback(i, std::move(contents), ctx.cap);
+		}, &ctx, 1);
+
+		std::vector<unsigned int> failed{};
+		for (unsigned int i = 0; i != files.size(); ++i)
+		{
+			if (ctx.failed[i])
+			{
+				failed.emplace_back(i);
+			}
+		}
+		return failed;
+	}
+#endif
 }
@@ -4,6 +4,8 @@
 
 #include <vector>
 
+#include "ThreadPool.hpp"
+#include "UniquePtr.hpp"
 #include "ZipIndexedFile.hpp"
 
 NAMESPACE_SOUP
@@ -23,5 +25,16 @@ NAMESPACE_SOUP
 
 		[[nodiscard]] std::string getFileContents(const ZipIndexedFile& file) const;
 		[[nodiscard]] std::string getFileContents(uint32_t offset, uint32_t compressed_size = 0) const;
+
+		// Returns a Reader that decompresses the file as it is being read, so it doesn't need to fit into memory.
+		// The returned Reader uses the ZipReader's Reader, so only one of them can be in use at a time.
+		[[nodiscard]] UniquePtr<Reader> getFileReader(const ZipIndexedFile& file) const;
+
+#if !SOUP_WASM && (!SOUP_WINDOWS || !SOUP_CROSS_COMPILE)
+		// Extracts files from an archive in memory, e.g. from filesystem::createFileMapping, decompressing them and checking their CRCs on the pool.
+		// The callback is invoked from multiple threads with the index into files and the contents, in no particular order.
+		// Returns the indices of the files that could not be extracted or failed the CRC check.
+		[[nodiscard]] static std::vector<unsigned int> extractFiles(const void* archive, size_t archive_size, const std::vector<ZipIndexedFile>& files, void(*callback)(unsigned int i, std::string&& contents, const Capture&), const Capture& cap = {}, ThreadPool& pool = ThreadPool::getDefault());
+#endif
 	};
 }
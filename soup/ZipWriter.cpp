@@ -1,6 +1,9 @@
 #include "ZipWriter.hpp"
 
+#include <algorithm> // min
+
 #include "crc32.hpp"
+#include "deflate.hpp"
 #include "Writer.hpp"
 #include "ZipCentralDirectoryFile.hpp"
 #include "ZipEndOfCentralDirectory.hpp"
@@ -9,12 +12,17 @@
 NAMESPACE_SOUP
 {
 	ZipIndexedFile ZipWriter::addFile(std::string name, const std::string& contents_uncompressed, uint16_t compression_method, const std::string& contents_compressed) const
+	{
+		return addFile(std::move(name), crc32::hash(contents_uncompressed), static_cast<uint32_t>(contents_uncompressed.size()), compression_method, contents_compressed);
+	}
+
+	ZipIndexedFile ZipWriter::addFile(std::string name, uint32_t uncompressed_data_crc32, uint32_t uncompressed_size, uint16_t compression_method, const std::string& contents_compressed) const
 	{
 		ZipIndexedFile zif;
 		zif.compression_method = compression_method;
-		zif.uncompressed_data_crc32 = crc32::hash(contents_uncompressed);
+		zif.uncompressed_data_crc32 = uncompressed_data_crc32;
 		zif.compressed_size = static_cast<uint32_t>(contents_compressed.size());
-		zif.uncompressed_size = static_cast<uint32_t>(contents_uncompressed.size());
+		zif.uncompressed_size = uncompressed_size;
 		zif.offset = static_cast<uint32_t>(os.getPosition());
 		zif.name = std::move(name);
 
@@ -57,6 +65,66 @@ NAMESPACE_SOUP
 		return addFile(std::move(name), contents_uncompressed, 8, anti_compressed);
 	}
 
+	ZipIndexedFile ZipWriter::addFileCompressed(std::string name, const std::string& contents, int level) const
+	{
+		return addFile(std::move(name), contents, 8, deflate::compress(contents, level, deflate::RAW));
+	}
+
+#if !SOUP_WASM && (!SOUP_WINDOWS || !SOUP_CROSS_COMPILE)
+	std::vector<ZipIndexedFile> ZipWriter::addFilesCompressed(const std::vector<std::pair<std::string, std::string>>& files, int level, ThreadPool& pool) const
+	{
+		struct CompressedFile
+		{
+			uint32_t crc;
+			uint16_t compression_method;
+			std::string data;
+		};
+
+		struct Context
+		{
+			const std::vector<std::pair<std::string, std::string>>& files;
+			int level;
+			size_t batch_begin;
+			std::vector<CompressedFile> results;
+		};
+
+		std::vector<ZipIndexedFile> ret{};
+		ret.reserve(files.size());
+
+		// Working in batches bounds how much compressed data is held in memory at once.
+		const size_t batch_size = (pool.getNumThreads() + 1) * 8;
+		Context ctx{ files, level, 0, std::vector<CompressedFile>(batch_size) };
+		for (; ctx.batch_begin < files.size(); ctx.batch_begin += batch_size)
+		{
+			const size_t n = std::min(batch_size, files.size() - ctx.batch_begin);
+			pool.parallelFor(static_cast<unsigned int>(n), [](unsigned int i, const Capture& cap)
+			{
+				auto& ctx = *cap.get<Context*>();
+				const std::string& contents = ctx.files[ctx.batch_begin + i].second;
+				CompressedFile& res = ctx.results[i];
+				res.crc = crc32::hash(contents);
+				res.data = deflate::compress(contents, ctx.level, deflate::RAW);
+				res.compression_method = 8;
+				if (res.data.size() >= contents.size())
+				{
+					res.data.clear();
+					res.compression_method = 0;
+				}
+			}, &ctx, 1);
+
+			for (size_t i = 0; i != n; ++i)
+			{
+				const auto& file = files[ctx.batch_begin + i];
+				CompressedFile& res = ctx.results[i];
+				ret.emplace_back(addFile(file.first, res.crc, static_cast<uint32_t>(file.second.size()), res.compression_method, res.compression_method == 0 ? file.second : res.data));
+				res.data.clear();
+			}
+		}
+
+		return ret;
+	}
+#endif
+
 	void ZipWriter::finalise(const std::vector<ZipIndexedFile>& files) const
 	{
 		ZipEndOfCentralDirectory eocd{};
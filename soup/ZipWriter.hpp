@@ -1,8 +1,10 @@
 #pragma once
 
+#include <utility> // pair
 #include <vector>
 
 #include "fwd.hpp"
+#include "ThreadPool.hpp"
 #include "ZipIndexedFile.hpp"
 
 NAMESPACE_SOUP
@@ -19,9 +21,16 @@ NAMESPACE_SOUP
 
 	protected:
 		ZipIndexedFile addFile(std::string name, const std::string& contents_uncompressed, uint16_t compression_method, const std::string& contents_compressed) const;
+		ZipIndexedFile addFile(std::string name, uint32_t uncompressed_data_crc32, uint32_t uncompressed_size, uint16_t compression_method, const std::string& contents_compressed) const;
 	public:
 		ZipIndexedFile addFileUncompressed(std::string name, const std::string& contents) const;
 		ZipIndexedFile addFileAnticompressed(std::string name, const std::string& contents_uncompressed) const;
+		ZipIndexedFile addFileCompressed(std::string name, const std::string& contents, int level = 6) const;
+#if !SOUP_WASM && (!SOUP_WINDOWS || !SOUP_CROSS_COMPILE)
+		// Takes pairs of name and contents. The files are compressed on the pool, but written in the given order, so the archive is deterministic.
+		// Files that don't get smaller are stored uncompressed.
+		std::vector<ZipIndexedFile> addFilesCompressed(const std::vector<std::pair<std::string, std::string>>& files, int level = 6, ThreadPool& pool = ThreadPool::getDefault()) const;
+#endif
 
 		void finalise(const std::vector<ZipIndexedFile>& files) const;
 	};
@@ -438,57 +438,14 @@ NAMESPACE_SOUP
 
 	void aes::gcmEncrypt(uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t* key, size_t key_len, const uint8_t* iv, size_t iv_len, uint8_t tag[16]) noexcept
 	{
-		const auto Nr = getNrFromKeyLen(key_len);
-		alignas(16) uint8_t roundKeys[240];
-		aes::expandKey(roundKeys, key, key_len);
-
-		uint8_t h[16];
-		calcH(h, roundKeys, Nr);
-
-		uint8_t j0[16];
-		calcJ0(j0, h, iv, iv_len);
-
-		// encrypt
-		{
-			uint8_t icb[16];
-			memcpy(icb, j0, 16);
-			inc32(icb);
-
-			gctr(data, data_len, roundKeys, Nr, icb);
-		}
-
-		calcGcmTag(tag, data, data_len, aadata, aadata_len, roundKeys, Nr, h, j0);
+		GcmContext ctx(key, key_len);
+		ctx.encrypt(data, data_len, aadata, aadata_len, iv, iv_len, tag);
 	}
 
 	bool aes::gcmDecrypt(uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t* key, size_t key_len, const uint8_t* iv, size_t iv_len, const uint8_t tag[16]) noexcept
 	{
-		const auto Nr = getNrFromKeyLen(key_len);
-		alignas(16) uint8_t roundKeys[240];
-		aes::expandKey(roundKeys, key, key_len);
-
-		uint8_t h[16];
-		calcH(h, roundKeys, Nr);
-
-		uint8_t j0[16];
-		calcJ0(j0, h, iv, iv_len);
-
-		uint8_t ctag[16];
-		calcGcmTag(ctag, data, data_len, aadata, aadata_len, roundKeys, Nr, h, j0);
-		if (memcmp(ctag, tag, 16) != 0)
-		{
-			return false;
-		}
-
-		// decrypt
-		{
-			uint8_t icb[16];
-			memcpy(icb, j0, 16);
-			inc32(icb);
-
-			gctr(data, data_len, roundKeys, Nr, icb);
-		}
-
-		return true;
+		GcmContext ctx(key, key_len);
+		return ctx.decrypt(data, data_len, aadata, aadata_len, iv, iv_len, tag);
 	}
 
 	void aes::encryptBlock(const uint8_t in[16], uint8_t out[16], const uint8_t roundKeys[240], const int Nr) noexcept
@@ -1039,4 +996,350 @@ NAMESPACE_SOUP
 		memcpy(tmp, res, 16);
 		mulBlocks(res, tmp, h);
 	}
+
+	// Portable GHASH multiplication using a 4-bit table, as described in the GCM specification (section 4.1, "Shoup's method").
+
+	static const uint64_t gcm_last4[16] = {
+		0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+		0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+	};
+
+	[[nodiscard]] static uint64_t gcm_read_u64(const uint8_t* p) noexcept
+	{
+		uint64_t v;
+		memcpy(&v, p, 8);
+		if constexpr (ENDIAN_NATIVE != ENDIAN_BIG)
+		{
+			v = Endianness::invert(v);
+		}
+		return v;
+	}
+
+	static void gcm_write_u64(uint8_t* p, uint64_t v) noexcept
+	{
+		if constexpr (ENDIAN_NATIVE != ENDIAN_BIG)
+		{
+			v = Endianness::invert(v);
+		}
+		memcpy(p, &v, 8);
+	}
+
+	static void gcm_init_table(uint64_t table[2][16], const uint8_t h[16]) noexcept
+	{
+		uint64_t* const hh = table[0];
+		uint64_t* const hl = table[1];
+
+		uint64_t vh = gcm_read_u64(&h[0]);
+		uint64_t vl = gcm_read_u64(&h[8]);
+
+		hh[0] = 0;
+		hl[0] = 0;
+		hh[8] = vh;
+		hl[8] = vl;
+		for (int i = 4; i > 0; i >>= 1)
+		{
+			const uint64_t t = (vl & 1) * 0xe1000000;
+			vl = (vh << 63) | (vl >> 1);
+			vh = (vh >> 1) ^ (t << 32);
+			hh[i] = vh;
+			hl[i] = vl;
+		}
+		for (int i = 2; i <= 8; i *= 2)
+		{
+			for (int j = 1; j < i; ++j)
+			{
+				hh[i + j] = hh[i] ^ hh[j];
+				hl[i + j] = hl[i] ^ hl[j];
+			}
+		}
+	}
+
+	static void gcm_mul_table(uint8_t x[16], const uint64_t table[2][16]) noexcept
+	{
+		const uint64_t* const hh = table[0];
+		const uint64_t* const hl = table[1];
+
+		uint8_t lo = x[15] & 0xf;
+		uint64_t zh = hh[lo];
+		uint64_t zl = hl[lo];
+		for (int i = 15; i >= 0; --i)
+		{
+			lo = x[i] & 0xf;
+			const uint8_t hi = (x[i] >> 4) & 0xf;
+
+			uint8_t rem;
+			if (i != 15)
+			{
+				rem = zl & 0xf;
+				zl = (zh << 60) | (zl >> 4);
+				zh = (zh >> 4) ^ (gcm_last4[rem] << 48);
+				zh ^= hh[lo];
+				zl ^= hl[lo];
+			}
+
+			rem = zl & 0xf;
+			zl = (zh << 60) | (zl >> 4);
+			zh = (zh >> 4) ^ (gcm_last4[rem] << 48);
+			zh ^= hh[hi];
+			zl ^= hl[hi];
+		}
+		gcm_write_u64(&x[0], zh);
+		gcm_write_u64(&x[8], zl);
+	}
+
+	aes::GcmContext::GcmContext(const uint8_t* key, size_t key_len, bool allow_acceleration) noexcept
+		: Nr(getNrFromKeyLen(key_len))
+	{
+		expandKey(roundKeys, key, key_len);
+
+		uint8_t h[16];
+		calcH(h, roundKeys, Nr);
+
+#if AES_USE_INTRIN && SOUP_X86
+		accelerated = (allow_acceleration && IS_AES_INTRIN_AVAILBLE && CpuInfo::get().supportsPCLMULQDQ() && CpuInfo::get().supportsSSSE3());
+		if (accelerated)
+		{
+			intrin::aes_gcm_init_h_powers(h_powers, h);
+		}
+		else
+#else
+		SOUP_UNUSED(allow_acceleration);
+		accelerated = false;
+#endif
+		{
+			gcm_init_table(h_table, h);
+		}
+	}
+
+	void aes::GcmContext::setIv(const uint8_t* iv, size_t iv_len) noexcept
+	{
+		if (iv_len == 12)
+		{
+			memcpy(j0, iv, 12);
+			j0[12] = 0;
+			j0[13] = 0;
+			j0[14] = 0;
+			j0[15] = 1;
+		}
+		else
+		{
+			memset(ghash, 0, 16);
+			ghashBlocks(iv, iv_len / 16);
+			if (iv_len % 16)
+			{
+				uint8_t block[16]{};
+				memcpy(block, &iv[iv_len - (iv_len % 16)], iv_len % 16);
+				ghashBlocks(block, 1);
+			}
+			uint8_t block[16]{};
+			gcm_write_u64(&block[8], static_cast<uint64_t>(iv_len) * 8);
+			ghashBlocks(block, 1);
+			memcpy(j0, ghash, 16);
+		}
+
+		memcpy(cb, j0, 16);
+		inc32(cb);
+		memset(ghash, 0, 16);
+		partial_len = 0;
+		in_data = false;
+		aad_len = 0;
+		data_len = 0;
+	}
+
+	void aes::GcmContext::aad(const uint8_t* data, size_t size) noexcept
+	{
+		SOUP_DEBUG_ASSERT(!in_data);
+		aad_len += size;
+
+		if (partial_len != 0)
+		{
+			while (size != 0 && partial_len != 16)
+			{
+				partial_block[partial_len++] = *data++;
+				--size;
+			}
+			if (partial_len != 16)
+			{
+				return;
+			}
+			ghashBlocks(partial_block, 1);
+			partial_len = 0;
+		}
+
+		ghashBlocks(data, size / 16);
+		data += size - (size % 16);
+		size %= 16;
+
+		memcpy(partial_block, data, size);
+		partial_len = static_cast<uint8_t>(size);
+	}
+
+	void aes::GcmContext::flushAad() noexcept
+	{
+		if (partial_len != 0)
+		{
+			memset(&partial_block[partial_len], 0, 16 - partial_len);
+			ghashBlocks(partial_block, 1);
+			partial_len = 0;
+		}
+		in_data = true;
+	}
+
+	void aes::GcmContext::encryptUpdate(uint8_t* data, size_t size) noexcept
+	{
+		update(data, size, true);
+	}
+
+	void aes::GcmContext::decryptUpdate(uint8_t* data, size_t size) noexcept
+	{
+		update(data, size, false);
+	}
+
+	void aes::GcmContext::update(uint8_t* data, size_t size, bool encrypt) noexcept
+	{
+		if (!in_data)
+		{
+			flushAad();
+		}
+		data_len += size;
+
+		// Finish the block that a previous call left incomplete
+		if (partial_len != 0)
+		{
+			while (size != 0 && partial_len != 16)
+			{
+				const uint8_t in = *data;
+				*data = in ^ partial_ks[partial_len];
+				partial_block[partial_len++] = (encrypt ? *data : in);
+				++data;
+				--size;
+			}
+			if (partial_len != 16)
+			{
+				return;
+			}
+			ghashBlocks(partial_block, 1);
+			partial_len = 0;
+		}
+
+		// Whole blocks
+		const size_t blocks = size / 16;
+#if AES_USE_INTRIN && SOUP_X86
+		if (accelerated)
+		{
+			intrin::aes_gcm_crypt(data, blocks, roundKeys, Nr, cb, ghash, h_powers, encrypt);
+		}
+		else
+#endif
+		{
+			uint8_t ks[16];
+			for (size_t i = 0; i != blocks; ++i)
+			{
+				encryptBlock(cb, ks, roundKeys, Nr);
+				inc32(cb);
+				if (!encrypt)
+				{
+					ghashBlocks(&data[i * 16], 1);
+				}
+				xorBlocks(&data[i * 16], ks);
+				if (encrypt)
+				{
+					ghashBlocks(&data[i * 16], 1);
+				}
+			}
+		}
+		data += blocks * 16;
+		size %= 16;
+
+		// Start a new incomplete block with whatever is left
+		if (size != 0)
+		{
+			encryptBlock(cb, partial_ks, roundKeys, Nr);
+			inc32(cb);
+			for (; partial_len != size; ++partial_len)
+			{
+				const uint8_t in = data[partial_len];
+				data[partial_len] = in ^ partial_ks[partial_len];
+				partial_block[partial_len] = (encrypt ? data[partial_len] : in);
+			}
+		}
+	}
+
+	void aes::GcmContext::finish(uint8_t tag[16]) noexcept
+	{
+		if (!in_data)
+		{
+			flushAad();
+		}
+		else if (partial_len != 0)
+		{
+			memset(&partial_block[partial_len], 0, 16 - partial_len);
+			ghashBlocks(partial_block, 1);
+			partial_len = 0;
+		}
+
+		uint8_t block[16];
+		gcm_write_u64(&block[0], aad_len * 8);
+		gcm_write_u64(&block[8], data_len * 8);
+		ghashBlocks(block, 1);
+
+		encryptBlock(j0, tag, roundKeys, Nr);
+		xorBlocks(tag, ghash);
+	}
+
+	bool aes::GcmContext::verify(const uint8_t tag[16]) noexcept
+	{
+		uint8_t ctag[16];
+		finish(ctag);
+		uint8_t diff = 0;
+		for (int i = 0; i != 16; ++i)
+		{
+			diff |= (ctag[i] ^ tag[i]);
+		}
+		return diff == 0;
+	}
+
+	void aes::GcmContext::encrypt(uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t* iv, size_t iv_len, uint8_t tag[16]) noexcept
+	{
+		setIv(iv, iv_len);
+		aad(aadata, aadata_len);
+		encryptUpdate(data, data_len);
+		finish(tag);
+	}
+
+	bool aes::GcmContext::decrypt(uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t* iv, size_t iv_len, const uint8_t tag[16]) noexcept
+	{
+		setIv(iv, iv_len);
+		aad(aadata, aadata_len);
+		decryptUpdate(data, data_len);
+		if (!verify(tag))
+		{
+			// Decrypting and hashing in one pass is faster for the common case, so we undo the decryption if the tag turns out to be wrong.
+			ctr(data, data_len);
+			return false;
+		}
+		return true;
+	}
+
+	void aes::GcmContext::ghashBlocks(const uint8_t* data, size_t blocks) noexcept
+	{
+#if AES_USE_INTRIN && SOUP_X86
+		if (accelerated)
+		{
+			return intrin::aes_gcm_ghash(ghash, data, blocks, h_powers);
+		}
+#endif
+		for (; blocks != 0; --blocks, data += 16)
+		{
+			xorBlocks(ghash, data);
+			gcm_mul_table(ghash, h_table);
+		}
+	}
+
+	void aes::GcmContext::ctr(uint8_t* data, size_t size) noexcept
+	{
+		memcpy(cb, j0, 16);
+		inc32(cb);
+		gctr(data, size, roundKeys, Nr, cb);
+	}
 }
@@ -88,5 +88,45 @@ NAMESPACE_SOUP
 
 			void transform() noexcept;
 		};
+
+		// Keyed AES-GCM state so that many messages can be processed without re-expanding the key or recomputing GHASH tables.
+		// Usage: setIv, then any number of aad calls, then any number of encryptUpdate or decryptUpdate calls, then finish or verify.
+		// On x86 with AES-NI and PCLMULQDQ, CTR and GHASH are processed 8 blocks at a time using carry-less multiplication.
+		struct GcmContext
+		{
+			alignas(16) uint8_t roundKeys[240];
+			int Nr;
+			bool accelerated;
+			alignas(16) uint8_t h_powers[8][16]; // H^1 to H^8, byte-reflected. Only used if accelerated.
+			uint64_t h_table[2][16]; // 4-bit multiplication table for H. Only used if not accelerated.
+
+			alignas(16) uint8_t j0[16];
+			alignas(16) uint8_t cb[16];
+			alignas(16) uint8_t ghash[16];
+			uint8_t partial_ks[16];
+			uint8_t partial_block[16];
+			uint8_t partial_len;
+			bool in_data;
+			uint64_t aad_len;
+			uint64_t data_len;
+
+			GcmContext(const uint8_t* key, size_t key_len, bool allow_acceleration = true) noexcept; // Disallowing acceleration is mostly useful for testing the portable code.
+
+			void setIv(const uint8_t* iv, size_t iv_len) noexcept;
+			void aad(const uint8_t* data, size_t size) noexcept;
+			void encryptUpdate(uint8_t* data, size_t size) noexcept;
+			void decryptUpdate(uint8_t* data, size_t size) noexcept;
+			void finish(uint8_t tag[16]) noexcept;
+			[[nodiscard]] bool verify(const uint8_t tag[16]) noexcept; // Constant-time.
+
+			void encrypt(uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t* iv, size_t iv_len, uint8_t tag[16]) noexcept;
+			[[nodiscard]] bool decrypt(uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t* iv, size_t iv_len, const uint8_t tag[16]) noexcept; // If the tag does not match, data is left unmodified.
+
+		protected:
+			void update(uint8_t* data, size_t size, bool encrypt) noexcept;
+			void flushAad() noexcept;
+			void ghashBlocks(const uint8_t* data, size_t blocks) noexcept;
+			void ctr(uint8_t* data, size_t size) noexcept;
+		};
 	};
 }
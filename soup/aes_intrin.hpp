@@ -5,6 +5,7 @@
 #include <cstdint>
 
 #if SOUP_X86
+	#include <tmmintrin.h>
 	#include <wmmintrin.h>
 #elif SOUP_ARM
 	#include <arm_neon.h>
@@ -13,6 +14,7 @@
 // x86:
 // - https://gist.github.com/acapola/d5b940da024080dfaf5f
 // - https://www.intel.com/content/dam/doc/white-paper/advanced-encryption-standard-new-instructions-set-paper.pdf
+// - https://www.intel.com/content/dam/develop/external/us/en/documents/clmul-wp-rev-2-02-2014-04-20.pdf
 // ARM:
 // - https://blog.michaelbrase.com/2018/06/04/optimizing-x86-aes-intrinsics-on-armv8-a/
 
@@ -328,6 +330,181 @@ NAMESPACE_SOUP
 			data = _mm_aesdeclast_si128(data, reinterpret_cast<const __m128i*>(roundKeys)[0]);
 			*reinterpret_cast<__m128i*>(out) = data;
 		}
+	#if defined(__GNUC__) || defined(__clang__)
+		__attribute__((target("ssse3")))
+	#endif
+		[[nodiscard]] static __m128i gcm_reflect(__m128i x) noexcept
+		{
+			return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+		}
+
+		// Accumulates the unreduced 256-bit product of a and b into lo, mid, and hi.
+	#if defined(__GNUC__) || defined(__clang__)
+		__attribute__((target("pclmul")))
+	#endif
+		static void gcm_clmul_acc(__m128i a, __m128i b, __m128i& lo, __m128i& mid, __m128i& hi) noexcept
+		{
+			lo = _mm_xor_si128(lo, _mm_clmulepi64_si128(a, b, 0x00));
+			mid = _mm_xor_si128(mid, _mm_clmulepi64_si128(a, b, 0x10));
+			mid = _mm_xor_si128(mid, _mm_clmulepi64_si128(a, b, 0x01));
+			hi = _mm_xor_si128(hi, _mm_clmulepi64_si128(a, b, 0x11));
+		}
+
+		// Reduces a 256-bit product of byte-reflected operands modulo the GCM polynomial. This is the second half of "gfmul" from the CLMUL white paper.
+		[[nodiscard]] static __m128i gcm_reduce(__m128i lo, __m128i mid, __m128i hi) noexcept
+		{
+			lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+			hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+			// Shift the 256-bit value left by 1 to account for the reflected bit order
+			__m128i t7 = _mm_srli_epi32(lo, 31);
+			__m128i t8 = _mm_srli_epi32(hi, 31);
+			lo = _mm_slli_epi32(lo, 1);
+			hi = _mm_slli_epi32(hi, 1);
+			__m128i t9 = _mm_srli_si128(t7, 12);
+			t8 = _mm_slli_si128(t8, 4);
+			t7 = _mm_slli_si128(t7, 4);
+			lo = _mm_or_si128(lo, t7);
+			hi = _mm_or_si128(hi, t8);
+			hi = _mm_or_si128(hi, t9);
+
+			t7 = _mm_slli_epi32(lo, 31);
+			t8 = _mm_slli_epi32(lo, 30);
+			t9 = _mm_slli_epi32(lo, 25);
+			t7 = _mm_xor_si128(t7, t8);
+			t7 = _mm_xor_si128(t7, t9);
+			t8 = _mm_srli_si128(t7, 4);
+			t7 = _mm_slli_si128(t7, 12);
+			lo = _mm_xor_si128(lo, t7);
+
+			__m128i t2 = _mm_srli_epi32(lo, 1);
+			__m128i t4 = _mm_srli_epi32(lo, 2);
+			__m128i t5 = _mm_srli_epi32(lo, 7);
+			t2 = _mm_xor_si128(t2, t4);
+			t2 = _mm_xor_si128(t2, t5);
+			t2 = _mm_xor_si128(t2, t8);
+			lo = _mm_xor_si128(lo, t2);
+			return _mm_xor_si128(hi, lo);
+		}
+
+	#if defined(__GNUC__) || defined(__clang__)
+		__attribute__((target("pclmul,ssse3")))
+	#endif
+		[[nodiscard]] static __m128i gcm_mul(__m128i a, __m128i b) noexcept
+		{
+			__m128i lo = _mm_setzero_si128();
+			__m128i mid = _mm_setzero_si128();
+			__m128i hi = _mm_setzero_si128();
+			gcm_clmul_acc(a, b, lo, mid, hi);
+			return gcm_reduce(lo, mid, hi);
+		}
+
+	#if defined(__GNUC__) || defined(__clang__)
+		__attribute__((target("pclmul,ssse3")))
+	#endif
+		void aes_gcm_init_h_powers(uint8_t h_powers[8][16], const uint8_t h[16]) noexcept
+		{
+			const __m128i h1 = gcm_reflect(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)));
+			__m128i hn = h1;
+			_mm_store_si128(reinterpret_cast<__m128i*>(h_powers[0]), hn);
+			for (int i = 1; i != 8; ++i)
+			{
+				hn = gcm_mul(hn, h1);
+				_mm_store_si128(reinterpret_cast<__m128i*>(h_powers[i]), hn);
+			}
+		}
+
+	#if defined(__GNUC__) || defined(__clang__)
+		__attribute__((target("pclmul,ssse3")))
+	#endif
+		void aes_gcm_ghash(uint8_t ghash[16], const uint8_t* data, size_t blocks, const uint8_t h_powers[8][16]) noexcept
+		{
+			const __m128i* hp = reinterpret_cast<const __m128i*>(h_powers);
+			__m128i x = gcm_reflect(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ghash)));
+			for (; blocks >= 8; blocks -= 8, data += 8 * 16)
+			{
+				__m128i lo = _mm_setzero_si128();
+				__m128i mid = _mm_setzero_si128();
+				__m128i hi = _mm_setzero_si128();
+				gcm_clmul_acc(_mm_xor_si128(x, gcm_reflect(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)))), _mm_load_si128(&hp[7]), lo, mid, hi);
+				for (int i = 1; i != 8; ++i)
+				{
+					gcm_clmul_acc(gcm_reflect(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16))), _mm_load_si128(&hp[7 - i]), lo, mid, hi);
+				}
+				x = gcm_reduce(lo, mid, hi);
+			}
+			for (; blocks != 0; --blocks, data += 16)
+			{
+				x = gcm_mul(_mm_xor_si128(x, gcm_reflect(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)))), _mm_load_si128(&hp[0]));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(ghash), gcm_reflect(x));
+		}
+
+		// Encrypts or decrypts whole blocks in CTR mode while updating GHASH over the ciphertext. 8 blocks are kept in flight so that the AES and CLMUL pipelines stay busy.
+	#if defined(__GNUC__) || defined(__clang__)
+		__attribute__((target("aes,pclmul,ssse3")))
+	#endif
+		void aes_gcm_crypt(uint8_t* data, size_t blocks, const uint8_t* roundKeys, const int Nr, uint8_t cb[16], uint8_t ghash[16], const uint8_t h_powers[8][16], const bool encrypt) noexcept
+		{
+			const __m128i* rk = reinterpret_cast<const __m128i*>(roundKeys);
+			const __m128i* hp = reinterpret_cast<const __m128i*>(h_powers);
+			__m128i x = gcm_reflect(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ghash)));
+			__m128i ctr = gcm_reflect(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cb))); // The 32-bit counter is now the lowest lane, so inc32 is an _mm_add_epi32.
+			const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+
+			for (; blocks >= 8; blocks -= 8, data += 8 * 16)
+			{
+				__m128i b[8];
+				for (int i = 0; i != 8; ++i)
+				{
+					b[i] = _mm_xor_si128(gcm_reflect(ctr), _mm_load_si128(&rk[0]));
+					ctr = _mm_add_epi32(ctr, one);
+				}
+				for (int r = 1; r != Nr; ++r)
+				{
+					const __m128i k = _mm_load_si128(&rk[r]);
+					for (int i = 0; i != 8; ++i)
+					{
+						b[i] = _mm_aesenc_si128(b[i], k);
+					}
+				}
+				const __m128i klast = _mm_load_si128(&rk[Nr]);
+
+				__m128i lo = _mm_setzero_si128();
+				__m128i mid = _mm_setzero_si128();
+				__m128i hi = _mm_setzero_si128();
+				for (int i = 0; i != 8; ++i)
+				{
+					const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16));
+					const __m128i out = _mm_xor_si128(_mm_aesenclast_si128(b[i], klast), in);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(data + i * 16), out);
+					__m128i c = gcm_reflect(encrypt ? out : in);
+					if (i == 0)
+					{
+						c = _mm_xor_si128(c, x);
+					}
+					gcm_clmul_acc(c, _mm_load_si128(&hp[7 - i]), lo, mid, hi);
+				}
+				x = gcm_reduce(lo, mid, hi);
+			}
+
+			for (; blocks != 0; --blocks, data += 16)
+			{
+				__m128i b = _mm_xor_si128(gcm_reflect(ctr), _mm_load_si128(&rk[0]));
+				ctr = _mm_add_epi32(ctr, one);
+				for (int r = 1; r != Nr; ++r)
+				{
+					b = _mm_aesenc_si128(b, _mm_load_si128(&rk[r]));
+				}
+				const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+				const __m128i out = _mm_xor_si128(_mm_aesenclast_si128(b, _mm_load_si128(&rk[Nr])), in);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(data), out);
+				x = gcm_mul(_mm_xor_si128(x, gcm_reflect(encrypt ? out : in)), _mm_load_si128(&hp[0]));
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(ghash), gcm_reflect(x));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(cb), gcm_reflect(ctr));
+		}
 #elif SOUP_ARM
 	#if defined(__GNUC__) || defined(__clang__)
 		__attribute__((target("aes")))
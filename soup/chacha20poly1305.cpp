@@ -0,0 +1,295 @@
+#include "chacha20poly1305.hpp"
+
+#include <cstring> // memcpy
+
+NAMESPACE_SOUP
+{
+	[[nodiscard]] static uint32_t chacha_read_u32(const uint8_t* p) noexcept
+	{
+		return static_cast<uint32_t>(p[0])
+			| (static_cast<uint32_t>(p[1]) << 8)
+			| (static_cast<uint32_t>(p[2]) << 16)
+			| (static_cast<uint32_t>(p[3]) << 24)
+			;
+	}
+
+	[[nodiscard]] static SOUP_FORCEINLINE uint32_t chacha_rotl(uint32_t v, int c) noexcept
+	{
+		return (v << c) | (v >> (32 - c));
+	}
+
+	static void chacha_write_u32(uint8_t* p, uint32_t v) noexcept
+	{
+		p[0] = static_cast<uint8_t>(v);
+		p[1] = static_cast<uint8_t>(v >> 8);
+		p[2] = static_cast<uint8_t>(v >> 16);
+		p[3] = static_cast<uint8_t>(v >> 24);
+	}
+
+	static void chacha_write_u64(uint8_t* p, uint64_t v) noexcept
+	{
+		chacha_write_u32(p, static_cast<uint32_t>(v));
+		chacha_write_u32(p + 4, static_cast<uint32_t>(v >> 32));
+	}
+
+#define CHACHA_QUARTERROUND(a, b, c, d) \
+	a += b; d ^= a; d = chacha_rotl(d, 16); \
+	c += d; b ^= c; b = chacha_rotl(b, 12); \
+	a += b; d ^= a; d = chacha_rotl(d, 8); \
+	c += d; b ^= c; b = chacha_rotl(b, 7);
+
+	void chacha20poly1305::encrypt(uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t key[32], const uint8_t nonce[12], uint8_t tag[16]) noexcept
+	{
+		chacha20(data, data_len, key, nonce, 1);
+		calcTag(tag, data, data_len, aadata, aadata_len, key, nonce);
+	}
+
+	bool chacha20poly1305::decrypt(uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t key[32], const uint8_t nonce[12], const uint8_t tag[16]) noexcept
+	{
+		uint8_t ctag[16];
+		calcTag(ctag, data, data_len, aadata, aadata_len, key, nonce);
+		uint8_t diff = 0;
+		for (int i = 0; i != 16; ++i)
+		{
+			diff |= (ctag[i] ^ tag[i]);
+		}
+		if (diff != 0)
+		{
+			return false;
+		}
+		chacha20(data, data_len, key, nonce, 1);
+		return true;
+	}
+
+	void chacha20poly1305::chacha20(uint8_t* data, size_t data_len, const uint8_t key[32], const uint8_t nonce[12], uint32_t counter) noexcept
+	{
+		uint8_t ks[64];
+		for (; data_len >= 64; data_len -= 64, data += 64)
+		{
+			chacha20Block(ks, key, nonce, counter++);
+			for (int i = 0; i != 64; ++i)
+			{
+				data[i] ^= ks[i];
+			}
+		}
+		if (data_len != 0)
+		{
+			chacha20Block(ks, key, nonce, counter);
+			for (size_t i = 0; i != data_len; ++i)
+			{
+				data[i] ^= ks[i];
+			}
+		}
+	}
+
+	void chacha20poly1305::chacha20Block(uint8_t out[64], const uint8_t key[32], const uint8_t nonce[12], uint32_t counter) noexcept
+	{
+		uint32_t in[16];
+		in[0] = 0x61707865;
+		in[1] = 0x3320646e;
+		in[2] = 0x79622d32;
+		in[3] = 0x6b206574;
+		for (int i = 0; i != 8; ++i)
+		{
+			in[4 + i] = chacha_read_u32(&key[i * 4]);
+		}
+		in[12] = counter;
+		in[13] = chacha_read_u32(&nonce[0]);
+		in[14] = chacha_read_u32(&nonce[4]);
+		in[15] = chacha_read_u32(&nonce[8]);
+
+		uint32_t x[16];
+		memcpy(x, in, sizeof(x));
+		for (int i = 0; i != 10; ++i)
+		{
+			CHACHA_QUARTERROUND(x[0], x[4], x[8], x[12]);
+			CHACHA_QUARTERROUND(x[1], x[5], x[9], x[13]);
+			CHACHA_QUARTERROUND(x[2], x[6], x[10], x[14]);
+			CHACHA_QUARTERROUND(x[3], x[7], x[11], x[15]);
+			CHACHA_QUARTERROUND(x[0], x[5], x[10], x[15]);
+			CHACHA_QUARTERROUND(x[1], x[6], x[11], x[12]);
+			CHACHA_QUARTERROUND(x[2], x[7], x[8], x[13]);
+			CHACHA_QUARTERROUND(x[3], x[4], x[9], x[14]);
+		}
+		for (int i = 0; i != 16; ++i)
+		{
+			chacha_write_u32(&out[i * 4], x[i] + in[i]);
+		}
+	}
+
+	chacha20poly1305::Poly1305::Poly1305(const uint8_t key[32]) noexcept
+	{
+		// r &= 0xffffffc0ffffffc0ffffffc0fffffff
+		r[0] = (chacha_read_u32(&key[0])) & 0x3ffffff;
+		r[1] = (chacha_read_u32(&key[3]) >> 2) & 0x3ffff03;
+		r[2] = (chacha_read_u32(&key[6]) >> 4) & 0x3ffc0ff;
+		r[3] = (chacha_read_u32(&key[9]) >> 6) & 0x3f03fff;
+		r[4] = (chacha_read_u32(&key[12]) >> 8) & 0x00fffff;
+
+		h[0] = 0;
+		h[1] = 0;
+		h[2] = 0;
+		h[3] = 0;
+		h[4] = 0;
+
+		pad[0] = chacha_read_u32(&key[16]);
+		pad[1] = chacha_read_u32(&key[20]);
+		pad[2] = chacha_read_u32(&key[24]);
+		pad[3] = chacha_read_u32(&key[28]);
+	}
+
+	void chacha20poly1305::Poly1305::append(const uint8_t* data, size_t size) noexcept
+	{
+		if (buffer_counter != 0)
+		{
+			while (size != 0 && buffer_counter != 16)
+			{
+				buffer[buffer_counter++] = *data++;
+				--size;
+			}
+			if (buffer_counter != 16)
+			{
+				return;
+			}
+			blocks(buffer, 1, 1 << 24);
+			buffer_counter = 0;
+		}
+
+		blocks(data, size / 16, 1 << 24);
+		data += size - (size % 16);
+		size %= 16;
+
+		memcpy(buffer, data, size);
+		buffer_counter = static_cast<uint8_t>(size);
+	}
+
+	void chacha20poly1305::Poly1305::appendPadding() noexcept
+	{
+		if (buffer_counter != 0)
+		{
+			memset(&buffer[buffer_counter], 0, 16 - buffer_counter);
+			blocks(buffer, 1, 1 << 24);
+			buffer_counter = 0;
+		}
+	}
+
+	void chacha20poly1305::Poly1305::finish(uint8_t tag[16]) noexcept
+	{
+		if (buffer_counter != 0)
+		{
+			buffer[buffer_counter] = 1;
+			memset(&buffer[buffer_counter + 1], 0, 16 - (buffer_counter + 1));
+			blocks(buffer, 1, 0);
+			buffer_counter = 0;
+		}
+
+		uint32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+
+		// Fully carry h
+		uint32_t c;
+		c = h1 >> 26; h1 &= 0x3ffffff;
+		h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+		h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+		h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+		h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+		h1 += c;
+
+		// Compute h + -p
+		uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+		uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+		uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+		uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+		uint32_t g4 = h4 + c - (1 << 26);
+
+		// Select h if h < p, or h + -p if h >= p
+		uint32_t mask = (g4 >> 31) - 1;
+		g0 &= mask;
+		g1 &= mask;
+		g2 &= mask;
+		g3 &= mask;
+		g4 &= mask;
+		mask = ~mask;
+		h0 = (h0 & mask) | g0;
+		h1 = (h1 & mask) | g1;
+		h2 = (h2 & mask) | g2;
+		h3 = (h3 & mask) | g3;
+		h4 = (h4 & mask) | g4;
+
+		// h = h % (2^128)
+		h0 = ((h0) | (h1 << 26));
+		h1 = ((h1 >> 6) | (h2 << 20));
+		h2 = ((h2 >> 12) | (h3 << 14));
+		h3 = ((h3 >> 18) | (h4 << 8));
+
+		// tag = (h + pad) % (2^128)
+		uint64_t f;
+		f = static_cast<uint64_t>(h0) + pad[0]; h0 = static_cast<uint32_t>(f);
+		f = static_cast<uint64_t>(h1) + pad[1] + (f >> 32); h1 = static_cast<uint32_t>(f);
+		f = static_cast<uint64_t>(h2) + pad[2] + (f >> 32); h2 = static_cast<uint32_t>(f);
+		f = static_cast<uint64_t>(h3) + pad[3] + (f >> 32); h3 = static_cast<uint32_t>(f);
+
+		chacha_write_u32(&tag[0], h0);
+		chacha_write_u32(&tag[4], h1);
+		chacha_write_u32(&tag[8], h2);
+		chacha_write_u32(&tag[12], h3);
+	}
+
+	void chacha20poly1305::Poly1305::blocks(const uint8_t* data, size_t blocks, uint32_t hibit) noexcept
+	{
+		const uint32_t r0 = r[0], r1 = r[1], r2 = r[2], r3 = r[3], r4 = r[4];
+		const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+		uint32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+
+		for (; blocks != 0; --blocks, data += 16)
+		{
+			// h += m[i]
+			h0 += (chacha_read_u32(&data[0])) & 0x3ffffff;
+			h1 += (chacha_read_u32(&data[3]) >> 2) & 0x3ffffff;
+			h2 += (chacha_read_u32(&data[6]) >> 4) & 0x3ffffff;
+			h3 += (chacha_read_u32(&data[9]) >> 6) & 0x3ffffff;
+			h4 += (chacha_read_u32(&data[12]) >> 8) | hibit;
+
+			// h *= r
+			const uint64_t d0 = (static_cast<uint64_t>(h0) * r0) + (static_cast<uint64_t>(h1) * s4) + (static_cast<uint64_t>(h2) * s3) + (static_cast<uint64_t>(h3) * s2) + (static_cast<uint64_t>(h4) * s1);
+			uint64_t d1 = (static_cast<uint64_t>(h0) * r1) + (static_cast<uint64_t>(h1) * r0) + (static_cast<uint64_t>(h2) * s4) + (static_cast<uint64_t>(h3) * s3) + (static_cast<uint64_t>(h4) * s2);
+			uint64_t d2 = (static_cast<uint64_t>(h0) * r2) + (static_cast<uint64_t>(h1) * r1) + (static_cast<uint64_t>(h2) * r0) + (static_cast<uint64_t>(h3) * s4) + (static_cast<uint64_t>(h4) * s3);
+			uint64_t d3 = (static_cast<uint64_t>(h0) * r3) + (static_cast<uint64_t>(h1) * r2) + (static_cast<uint64_t>(h2) * r1) + (static_cast<uint64_t>(h3) * r0) + (static_cast<uint64_t>(h4) * s4);
+			uint64_t d4 = (static_cast<uint64_t>(h0) * r4) + (static_cast<uint64_t>(h1) * r3) + (static_cast<uint64_t>(h2) * r2) + (static_cast<uint64_t>(h3) * r1) + (static_cast<uint64_t>(h4) * r0);
+
+			// (partial) h %= p
+			uint32_t c;
+			c = static_cast<uint32_t>(d0 >> 26); h0 = static_cast<uint32_t>(d0) & 0x3ffffff;
+			d1 += c; c = static_cast<uint32_t>(d1 >> 26); h1 = static_cast<uint32_t>(d1) & 0x3ffffff;
+			d2 += c; c = static_cast<uint32_t>(d2 >> 26); h2 = static_cast<uint32_t>(d2) & 0x3ffffff;
+			d3 += c; c = static_cast<uint32_t>(d3 >> 26); h3 = static_cast<uint32_t>(d3) & 0x3ffffff;
+			d4 += c; c = static_cast<uint32_t>(d4 >> 26); h4 = static_cast<uint32_t>(d4) & 0x3ffffff;
+			h0 += c * 5; c = (h0 >> 26); h0 &= 0x3ffffff;
+			h1 += c;
+		}
+
+		h[0] = h0;
+		h[1] = h1;
+		h[2] = h2;
+		h[3] = h3;
+		h[4] = h4;
+	}
+
+	void chacha20poly1305::calcTag(uint8_t tag[16], const uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t key[32], const uint8_t nonce[12]) noexcept
+	{
+		uint8_t otk[64];
+		chacha20Block(otk, key, nonce, 0);
+
+		Poly1305 mac(otk);
+		mac.append(aadata, aadata_len);
+		mac.appendPadding();
+		mac.append(data, data_len);
+		mac.appendPadding();
+
+		uint8_t lengths[16];
+		chacha_write_u64(&lengths[0], aadata_len);
+		chacha_write_u64(&lengths[8], data_len);
+		mac.append(lengths, sizeof(lengths));
+
+		mac.finish(tag);
+	}
+}
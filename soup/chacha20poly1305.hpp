@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "base.hpp"
+
+NAMESPACE_SOUP
+{
+	// ChaCha20-Poly1305 AEAD as per RFC 8439.
+	struct chacha20poly1305
+	{
+		static constexpr auto KEY_SIZE = 32;
+		static constexpr auto NONCE_SIZE = 12;
+		static constexpr auto TAG_SIZE = 16;
+
+		static void encrypt(uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t key[32], const uint8_t nonce[12], uint8_t tag[16]) noexcept;
+		[[nodiscard]] static bool decrypt(uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t key[32], const uint8_t nonce[12], const uint8_t tag[16]) noexcept; // If the tag does not match, data is left unmodified.
+
+		static void chacha20(uint8_t* data, size_t data_len, const uint8_t key[32], const uint8_t nonce[12], uint32_t counter) noexcept;
+		static void chacha20Block(uint8_t out[64], const uint8_t key[32], const uint8_t nonce[12], uint32_t counter) noexcept;
+
+		// Original source: https://github.com/floodyberry/poly1305-donna (32-bit variant)
+		// Original licence: MIT or public domain.
+		struct Poly1305
+		{
+			uint32_t r[5];
+			uint32_t h[5];
+			uint32_t pad[4];
+			uint8_t buffer[16];
+			uint8_t buffer_counter = 0;
+
+			Poly1305(const uint8_t key[32]) noexcept;
+
+			void append(const uint8_t* data, size_t size) noexcept;
+			void appendPadding() noexcept; // Pads with zeroes to a multiple of 16 bytes.
+			void finish(uint8_t tag[16]) noexcept;
+
+		protected:
+			void blocks(const uint8_t* data, size_t blocks, uint32_t hibit) noexcept;
+		};
+
+		static void calcTag(uint8_t tag[16], const uint8_t* data, size_t data_len, const uint8_t* aadata, size_t aadata_len, const uint8_t key[32], const uint8_t nonce[12]) noexcept;
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include "base.hpp"
@@ -9,6 +10,13 @@ NAMESPACE_SOUP
 {
 	struct deflate
 	{
+		enum Format : uint8_t
+		{
+			RAW = 0,
+			ZLIB,
+			GZIP,
+		};
+
 		struct DecompressResult
 		{
 			std::string decompressed{};
@@ -22,5 +30,8 @@ NAMESPACE_SOUP
 		static DecompressResult decompress(const std::string& compressed_data, size_t max_decompressed_size);
 		static DecompressResult decompress(const void* compressed_data, size_t compressed_data_size);
 		static DecompressResult decompress(const void* compressed_data, size_t compressed_data_size, size_t max_decompressed_size);
+
+		// level is 0 (no compression) to 9 (best compression). For streaming, use DeflateWriter.
+		[[nodiscard]] static std::string compress(const std::string& data, int level = 6, Format format = ZLIB);
 	};
 }
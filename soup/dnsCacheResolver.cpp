@@ -1,6 +1,10 @@
 #include "dnsCacheResolver.hpp"
 
+#include <algorithm> // push_heap, pop_heap, make_heap, remove_if, transform
+#include <iterator> // back_inserter
+
 #include "ObfusString.hpp"
+#include "string.hpp"
 #include "time.hpp"
 
 #define LOGGING false
@@ -12,46 +16,86 @@
 
 NAMESPACE_SOUP
 {
-	Optional<std::vector<UniquePtr<dnsRecord>>> dnsCacheResolver::lookup(dnsType qtype, const std::string& name) const
+	// For the expiry heap to have the entry that expires first at the front.
+	[[nodiscard]] static bool expiresLater(const std::pair<time_t, std::string>& a, const std::pair<time_t, std::string>& b) noexcept
 	{
-		auto res = findInCache(qtype, name);
-		if (res.empty())
+		return a.first > b.first;
+	}
+
+	Optional<std::vector<SharedPtr<dnsRecord>>> dnsCacheResolver::lookup(dnsType qtype, const std::string& name) const
+	{
+		auto key = makeKey(qtype, name);
+		if (auto cached = findInCache(key))
 		{
-			if (underlying->lookup(qtype, name).consume(res))
-			{
-				addToCache(res);
-			}
+			return cached->records;
+		}
+		auto res = underlying->lookup(qtype, name);
+		if (res)
+		{
+			addToCache(std::move(key), *res);
 		}
 		return res;
 	}
 
-	struct dnsLookupAndCacheTask : public dnsLookupTask
+	struct dnsCoalescedLookupTask : public dnsLookupTask
 	{
 		const dnsCacheResolver& resolver;
-		UniquePtr<dnsLookupTask> underlying;
+		std::string key;
+		SharedPtr<dnsCacheResolver::InFlightLookup> lookup;
 
-		dnsLookupAndCacheTask(const dnsCacheResolver& resolver, UniquePtr<dnsLookupTask>&& underlying)
-			: resolver(resolver), underlying(std::move(underlying))
+		dnsCoalescedLookupTask(const dnsCacheResolver& resolver, std::string&& key, SharedPtr<dnsCacheResolver::InFlightLookup>&& lookup)
+			: resolver(resolver), key(std::move(key)), lookup(std::move(lookup))
 		{
 		}
 
 		void onTick() final
 		{
-			if (underlying->tickUntilDone())
+			if (!lookup->done)
 			{
-				result = std::move(underlying->result);
-				if (result)
+				// If another task is already ticking the lookup, we'll check back later.
+				std::unique_lock lock(lookup->mtx, std::try_to_lock);
+				if (!lock.owns_lock()
+					|| (!lookup->done && !tickLookup())
+					)
 				{
-					resolver.addToCache(*result);
+					return;
 				}
-				setWorkDone();
 			}
+			if (!lookup->failed)
+			{
+				result = (lookup->result ? lookup->result->records : std::vector<SharedPtr<dnsRecord>>{});
+			}
+			setWorkDone();
+		}
+
+		// Only called with the lookup's mutex held.
+		[[nodiscard]] bool tickLookup()
+		{
+			if (!lookup->task->tickUntilDone())
+			{
+				return false;
+			}
+			if (lookup->task->result)
+			{
+				lookup->result = resolver.addToCache(std::string(key), *lookup->task->result);
+			}
+			else
+			{
+				lookup->failed = true;
+			}
+			{
+				// Only now that the result is in the cache, new lookup tasks can go without this lookup.
+				std::lock_guard lock(resolver.mtx);
+				resolver.in_flight.erase(key);
+			}
+			lookup->done = true;
+			return true;
 		}
 
 		std::string toString() const SOUP_EXCAL final
 		{
-			std::string str = ObfusString("dnsLookupAndCacheTask: [");
-			str.append(underlying->toString());
+			std::string str = ObfusString("dnsCoalescedLookupTask: [");
+			str.append(lookup->task->toString());
 			str.push_back(']');
 			return str;
 		}
@@ -59,59 +103,162 @@ NAMESPACE_SOUP
 
 	UniquePtr<dnsLookupTask> dnsCacheResolver::makeLookupTask(dnsType qtype, const std::string& name) const
 	{
-		if (auto res = findInCache(qtype, name); !res.empty())
+		auto key = makeKey(qtype, name);
+		if (auto cached = findInCache(key))
 		{
-			return dnsCachedResultTask::make(std::move(res));
+			return dnsCachedResultTask::make(std::vector<SharedPtr<dnsRecord>>(cached->records));
 		}
-		return soup::make_unique<dnsLookupAndCacheTask>(*this, underlying->makeLookupTask(qtype, name));
+		SharedPtr<InFlightLookup> lookup;
+		{
+			std::lock_guard lock(mtx);
+			if (auto it = in_flight.find(key); it != in_flight.end())
+			{
+				lookup = it->second;
+			}
+		}
+		if (!lookup)
+		{
+			auto fresh = soup::make_shared<InFlightLookup>();
+			fresh->task = underlying->makeLookupTask(qtype, name);
+
+			// If another lookup task was made in the meantime, we go with theirs.
+			std::lock_guard lock(mtx);
+			lookup = in_flight.emplace(key, std::move(fresh)).first->second;
+		}
+		return soup::make_unique<dnsCoalescedLookupTask>(*this, std::move(key), std::move(lookup));
+	}
+
+	SharedPtr<dnsCacheResolver::CachedResult> dnsCacheResolver::findInCache(dnsType qtype, const std::string& name) const SOUP_EXCAL
+	{
+		return findInCache(makeKey(qtype, name));
+	}
+
+	SharedPtr<dnsCacheResolver::CachedResult> dnsCacheResolver::addToCache(dnsType qtype, const std::string& name, const std::vector<SharedPtr<dnsRecord>>& records) const SOUP_EXCAL
+	{
+		return addToCache(makeKey(qtype, name), records);
 	}
 
-	std::vector<UniquePtr<dnsRecord>> dnsCacheResolver::findInCache(dnsType qtype, const std::string& name) const
+	size_t dnsCacheResolver::size() const noexcept
 	{
-		std::vector<UniquePtr<dnsRecord>> res;
-		for (auto i = cache.begin(); i != cache.end(); )
+		std::lock_guard lock(mtx);
+		return entries.size();
+	}
+
+	void dnsCacheResolver::clear() noexcept
+	{
+		std::lock_guard lock(mtx);
+		entries.clear();
+		index.clear();
+		expiry_heap.clear();
+	}
+
+	std::string dnsCacheResolver::makeKey(dnsType qtype, const std::string& name) SOUP_EXCAL
+	{
+		std::string key;
+		key.reserve(2 + name.size());
+		key.push_back(static_cast<char>(qtype >> 8));
+		key.push_back(static_cast<char>(qtype));
+		// Names are case-insensitive as per RFC 4343.
+		std::transform(name.begin(), name.end(), std::back_inserter(key), &string::lower_char<char>);
+		return key;
+	}
+
+	SharedPtr<dnsCacheResolver::CachedResult> dnsCacheResolver::findInCache(const std::string& key) const SOUP_EXCAL
+	{
+		std::lock_guard lock(mtx);
+		removeExpired(time::unixSeconds());
+		if (auto it = index.find(key); it != index.end())
 		{
-			if (i->getExpiry() < time::unixSeconds())
-			{
-				i = cache.erase(i);				
 #if LOGGING
-				logWriteLine(format("[DNS Cache] {}@{} expired", dnsTypeToString(i->record->type), i->record->name));
+			logWriteLine(format("[DNS Cache] {} hit", key.substr(2)));
 #endif
-				continue;
-			}
-			if (i->record->type == qtype
-				&& i->record->name == name
-				)
+			++hits;
+			entries.splice(entries.begin(), entries, it->second);
+			return it->second->result;
+		}
+#if LOGGING
+		logWriteLine(format("[DNS Cache] {} miss", key.substr(2)));
+#endif
+		++misses;
+		return {};
+	}
+
+	SharedPtr<dnsCacheResolver::CachedResult> dnsCacheResolver::addToCache(std::string&& key, const std::vector<SharedPtr<dnsRecord>>& records) const SOUP_EXCAL
+	{
+		if (records.empty())
+		{
+			return {};
+		}
+
+		uint32_t ttl = records.at(0)->ttl;
+		for (const auto& record : records)
+		{
+			if (record->ttl < ttl)
 			{
-				res.emplace_back(i->record->copy());
+				ttl = record->ttl;
 			}
-			++i;
+		}
+		auto result = soup::make_shared<CachedResult>();
+		result->records = records;
+		const time_t expires_at = time::unixSeconds() + ttl;
+
+		std::lock_guard lock(mtx);
+		if (capacity == 0)
+		{
+			return result;
 		}
 #if LOGGING
-		if (res.empty())
+		logWriteLine(format("[DNS Cache] {} added", key.substr(2)));
+#endif
+		if (auto it = index.find(key); it != index.end())
 		{
-			logWriteLine(format("[DNS Cache] {}@{} miss", dnsTypeToString(qtype), name));
+			it->second->result = result;
+			it->second->expires_at = expires_at;
+			entries.splice(entries.begin(), entries, it->second);
 		}
 		else
 		{
-			logWriteLine(format("[DNS Cache] {}@{} hit", dnsTypeToString(qtype), name));
+			if (entries.size() >= capacity)
+			{
+				index.erase(entries.back().key);
+				entries.pop_back();
+			}
+			entries.emplace_front(Entry{ key, result, expires_at });
+			index.emplace(key, entries.begin());
 		}
-#endif
-		return res;
+		expiry_heap.emplace_back(expires_at, std::move(key));
+		std::push_heap(expiry_heap.begin(), expiry_heap.end(), &expiresLater);
+
+		// Entries that were evicted or replaced still have their place in the heap, so it is rebuilt if those make up the majority.
+		if (expiry_heap.size() > entries.size() * 2 + 64)
+		{
+			expiry_heap.erase(std::remove_if(expiry_heap.begin(), expiry_heap.end(), [this](const std::pair<time_t, std::string>& e)
+			{
+				auto it = index.find(e.second);
+				return it == index.end() || it->second->expires_at != e.first;
+			}), expiry_heap.end());
+			std::make_heap(expiry_heap.begin(), expiry_heap.end(), &expiresLater);
+		}
+		return result;
 	}
 
-	void dnsCacheResolver::addToCache(const std::vector<UniquePtr<dnsRecord>>& records) const
+	void dnsCacheResolver::removeExpired(time_t now) const SOUP_EXCAL
 	{
-		if (!records.empty())
+		while (!expiry_heap.empty()
+			&& expiry_heap.front().first <= now
+			)
 		{
-			const auto t = time::unixSeconds();
-			for (const auto& record : records)
+			std::pop_heap(expiry_heap.begin(), expiry_heap.end(), &expiresLater);
+			const auto& e = expiry_heap.back();
+			if (auto it = index.find(e.second); it != index.end() && it->second->expires_at == e.first)
 			{
 #if LOGGING
-				logWriteLine(format("[DNS Cache] {}@{} added", dnsTypeToString(record->type), record->name));
+				logWriteLine(format("[DNS Cache] {} expired", e.second.substr(2)));
 #endif
-				cache.emplace_back(CachedRecord{ record->copy(), t });
+				entries.erase(it->second);
+				index.erase(it);
 			}
+			expiry_heap.pop_back();
 		}
 	}
 }
@@ -2,37 +2,80 @@
 
 #include "dnsResolver.hpp"
 
+#include <atomic>
+#include <ctime> // time_t
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "SharedPtr.hpp"
 #include "UniquePtr.hpp"
 
 NAMESPACE_SOUP
 {
+	// Caches the results of queries until the lowest TTL among their records runs out, evicting the least recently used ones once 'capacity' is reached.
+	// Concurrent lookup tasks for the same query share one lookup on the underlying resolver.
 	struct dnsCacheResolver : public dnsResolver
 	{
-		struct CachedRecord
+		// Shared by every lookup that hits it, as are its records, so neither must be modified.
+		struct CachedResult
 		{
-			UniquePtr<dnsRecord> record;
-			time_t obtained_at;
+			std::vector<SharedPtr<dnsRecord>> records;
+		};
 
-			[[nodiscard]] time_t getExpiry() const noexcept
-			{
-				return obtained_at + record->ttl;
-			}
+		// A lookup on the underlying resolver that lookup tasks are waiting for. Whichever of them gets to it first ticks it.
+		struct InFlightLookup
+		{
+			std::mutex mtx;
+			UniquePtr<dnsLookupTask> task;
+			std::atomic_bool done = false;
+			SharedPtr<CachedResult> result; // null if the lookup failed or had no records
+			bool failed = false;
+		};
+
+		struct Entry
+		{
+			std::string key;
+			SharedPtr<CachedResult> result;
+			time_t expires_at;
 		};
 
 		UniquePtr<dnsResolver> underlying;
-		mutable std::vector<CachedRecord> cache;
+		size_t capacity = 1000;
 
+		mutable std::atomic_size_t hits{ 0 };
+		mutable std::atomic_size_t misses{ 0 };
+
+	protected:
+		mutable std::mutex mtx;
+		mutable std::list<Entry> entries{}; // Most recently used at the front.
+		mutable std::unordered_map<std::string, std::list<Entry>::iterator> index{};
+		mutable std::vector<std::pair<time_t, std::string>> expiry_heap{}; // Entries are removed lazily, so it may contain some that no longer exist.
+		mutable std::unordered_map<std::string, SharedPtr<InFlightLookup>> in_flight{};
+
+	public:
 		dnsCacheResolver(UniquePtr<dnsResolver>&& underlying)
 			: underlying(std::move(underlying))
 		{
 		}
 
-		[[nodiscard]] Optional<std::vector<UniquePtr<dnsRecord>>> lookup(dnsType qtype, const std::string& name) const final;
+		[[nodiscard]] Optional<std::vector<SharedPtr<dnsRecord>>> lookup(dnsType qtype, const std::string& name) const final;
 		[[nodiscard]] UniquePtr<dnsLookupTask> makeLookupTask(dnsType qtype, const std::string& name) const final;
 
-		[[nodiscard]] std::vector<UniquePtr<dnsRecord>> findInCache(dnsType qtype, const std::string& name) const;
-		void addToCache(const std::vector<UniquePtr<dnsRecord>>& records) const;
+		[[nodiscard]] SharedPtr<CachedResult> findInCache(dnsType qtype, const std::string& name) const SOUP_EXCAL;
+		SharedPtr<CachedResult> addToCache(dnsType qtype, const std::string& name, const std::vector<SharedPtr<dnsRecord>>& records) const SOUP_EXCAL;
+
+		[[nodiscard]] size_t size() const noexcept;
+		void clear() noexcept;
+
+	protected:
+		[[nodiscard]] static std::string makeKey(dnsType qtype, const std::string& name) SOUP_EXCAL;
+		[[nodiscard]] SharedPtr<CachedResult> findInCache(const std::string& key) const SOUP_EXCAL;
+		SharedPtr<CachedResult> addToCache(std::string&& key, const std::vector<SharedPtr<dnsRecord>>& records) const SOUP_EXCAL;
+		void removeExpired(time_t now) const SOUP_EXCAL;
+
+		friend struct dnsCoalescedLookupTask;
 	};
 }
@@ -7,12 +7,12 @@
 
 NAMESPACE_SOUP
 {
-	Optional<std::vector<UniquePtr<dnsRecord>>> dnsHttpResolver::lookup(dnsType qtype, const std::string& name) const
+	Optional<std::vector<SharedPtr<dnsRecord>>> dnsHttpResolver::lookup(dnsType qtype, const std::string& name) const
 	{
 #if SOUP_WASM
 		SOUP_ASSERT(false, "Blocking lookup is not supported under WASM");
 #else
-		std::vector<UniquePtr<dnsRecord>> res;
+		std::vector<SharedPtr<dnsRecord>> res;
 		if (checkBuiltinResult(res, qtype, name))
 		{
 			return res;
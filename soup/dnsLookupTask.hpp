@@ -6,15 +6,16 @@
 
 #include "dns_records.hpp"
 #include "Optional.hpp"
+#include "SharedPtr.hpp"
 #include "UniquePtr.hpp"
 
 NAMESPACE_SOUP
 {
-	using dnsLookupTask = PromiseTask<Optional<std::vector<UniquePtr<dnsRecord>>>>;
+	using dnsLookupTask = PromiseTask<Optional<std::vector<SharedPtr<dnsRecord>>>>;
 
 	struct dnsCachedResultTask : public dnsLookupTask
 	{
-		static UniquePtr<dnsCachedResultTask> make(std::vector<UniquePtr<dnsRecord>>&& res) SOUP_EXCAL
+		static UniquePtr<dnsCachedResultTask> make(std::vector<SharedPtr<dnsRecord>>&& res) SOUP_EXCAL
 		{
 			auto task = soup::make_unique<dnsCachedResultTask>();
 			task->result = std::move(res);
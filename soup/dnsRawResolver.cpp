@@ -8,17 +8,17 @@
 
 NAMESPACE_SOUP
 {
-	bool dnsRawResolver::checkBuiltinResult(std::vector<UniquePtr<dnsRecord>>& res, dnsType qtype, const std::string& name) SOUP_EXCAL
+	bool dnsRawResolver::checkBuiltinResult(std::vector<SharedPtr<dnsRecord>>& res, dnsType qtype, const std::string& name) SOUP_EXCAL
 	{
 		if (name == "localhost")
 		{
 			if (qtype == DNS_A)
 			{
-				res.emplace_back(soup::make_unique<dnsARecord>(name, -1, SOUP_IPV4_NWE(127, 0, 0, 1)));
+				res.emplace_back(soup::make_shared<dnsARecord>(name, -1, SOUP_IPV4_NWE(127, 0, 0, 1)));
 			}
 			else if (qtype == DNS_AAAA)
 			{
-				res.emplace_back(soup::make_unique<dnsAaaaRecord>(name, -1, IpAddr(0, 0, 0, 0, 0, 0, 0, 1)));
+				res.emplace_back(soup::make_shared<dnsAaaaRecord>(name, -1, IpAddr(0, 0, 0, 0, 0, 0, 0, 1)));
 			}
 			return true;
 		}
@@ -27,7 +27,7 @@ NAMESPACE_SOUP
 
 	UniquePtr<dnsLookupTask> dnsRawResolver::checkBuiltinResultTask(dnsType qtype, const std::string& name) SOUP_EXCAL
 	{
-		std::vector<UniquePtr<dnsRecord>> res;
+		std::vector<SharedPtr<dnsRecord>> res;
 		if (checkBuiltinResult(res, qtype, name))
 		{
 			return dnsCachedResultTask::make(std::move(res));
@@ -53,7 +53,7 @@ NAMESPACE_SOUP
 		return sw.data;
 	}
 
-	std::vector<UniquePtr<dnsRecord>> dnsRawResolver::parseResponse(const std::string& data) SOUP_EXCAL
+	std::vector<SharedPtr<dnsRecord>> dnsRawResolver::parseResponse(const std::string& data) SOUP_EXCAL
 	{
 		MemoryRefReader sr(data);
 
@@ -66,7 +66,7 @@ NAMESPACE_SOUP
 			dq.read(sr);
 		}
 
-		std::vector<UniquePtr<dnsRecord>> res{};
+		std::vector<SharedPtr<dnsRecord>> res{};
 		for (uint16_t i = 0; i != dh.ancount; ++i)
 		{
 			dnsResource dr;
@@ -81,11 +81,11 @@ NAMESPACE_SOUP
 
 			if (dr.rtype == DNS_A)
 			{
-				res.emplace_back(soup::make_unique<dnsARecord>(std::move(name), dr.ttl, *reinterpret_cast<uint32_t*>(dr.rdata.data())));
+				res.emplace_back(soup::make_shared<dnsARecord>(std::move(name), dr.ttl, *reinterpret_cast<uint32_t*>(dr.rdata.data())));
 			}
 			else if (dr.rtype == DNS_AAAA)
 			{
-				res.emplace_back(soup::make_unique<dnsAaaaRecord>(std::move(name), dr.ttl, reinterpret_cast<uint8_t*>(dr.rdata.data())));
+				res.emplace_back(soup::make_shared<dnsAaaaRecord>(std::move(name), dr.ttl, reinterpret_cast<uint8_t*>(dr.rdata.data())));
 			}
 			else if (dr.rtype == DNS_CNAME)
 			{
@@ -94,7 +94,7 @@ NAMESPACE_SOUP
 				dnsName cname;
 				cname.read(rdata_sr);
 
-				res.emplace_back(soup::make_unique<dnsCnameRecord>(std::move(name), dr.ttl, string::join(cname.resolve(data), '.')));
+				res.emplace_back(soup::make_shared<dnsCnameRecord>(std::move(name), dr.ttl, string::join(cname.resolve(data), '.')));
 			}
 			else if (dr.rtype == DNS_PTR)
 			{
@@ -103,7 +103,7 @@ NAMESPACE_SOUP
 				dnsName cname;
 				cname.read(rdata_sr);
 
-				res.emplace_back(soup::make_unique<dnsPtrRecord>(std::move(name), dr.ttl, string::join(cname.resolve(data), '.')));
+				res.emplace_back(soup::make_shared<dnsPtrRecord>(std::move(name), dr.ttl, string::join(cname.resolve(data), '.')));
 			}
 			else if (dr.rtype == DNS_TXT)
 			{
@@ -114,7 +114,7 @@ NAMESPACE_SOUP
 					data.append(dr.rdata.substr(i, chunk_size));
 					i += chunk_size;
 				}
-				res.emplace_back(soup::make_unique<dnsTxtRecord>(std::move(name), dr.ttl, std::move(data)));
+				res.emplace_back(soup::make_shared<dnsTxtRecord>(std::move(name), dr.ttl, std::move(data)));
 			}
 			else if (dr.rtype == DNS_MX)
 			{
@@ -125,7 +125,7 @@ NAMESPACE_SOUP
 				rdata_sr.u16be(priority);
 				target.read(rdata_sr);
 
-				res.emplace_back(soup::make_unique<dnsMxRecord>(std::move(name), dr.ttl, priority, string::join(target.resolve(data), '.')));
+				res.emplace_back(soup::make_shared<dnsMxRecord>(std::move(name), dr.ttl, priority, string::join(target.resolve(data), '.')));
 			}
 			else if (dr.rtype == DNS_SRV)
 			{
@@ -138,7 +138,7 @@ NAMESPACE_SOUP
 				rdata_sr.u16be(port);
 				target.read(rdata_sr);
 
-				res.emplace_back(soup::make_unique<dnsSrvRecord>(std::move(name), dr.ttl, priority, weight, string::join(target.resolve(data), '.'), port));
+				res.emplace_back(soup::make_shared<dnsSrvRecord>(std::move(name), dr.ttl, priority, weight, string::join(target.resolve(data), '.'), port));
 			}
 			else if (dr.rtype == DNS_NS)
 			{
@@ -147,7 +147,7 @@ NAMESPACE_SOUP
 				dnsName cname;
 				cname.read(rdata_sr);
 
-				res.emplace_back(soup::make_unique<dnsNsRecord>(std::move(name), dr.ttl, string::join(cname.resolve(data), '.')));
+				res.emplace_back(soup::make_shared<dnsNsRecord>(std::move(name), dr.ttl, string::join(cname.resolve(data), '.')));
 			}
 		}
 		return res;
@@ -65,7 +65,7 @@ NAMESPACE_SOUP
 		return simplifyIPv6LookupResults(lookup(DNS_AAAA, name));
 	}
 
-	Optional<std::vector<UniquePtr<dnsRecord>>> dnsResolver::lookup(dnsType qtype, const std::string& name) const
+	Optional<std::vector<SharedPtr<dnsRecord>>> dnsResolver::lookup(dnsType qtype, const std::string& name) const
 	{
 		auto task = makeLookupTask(qtype, name);
 		task->run();
@@ -77,7 +77,7 @@ NAMESPACE_SOUP
 		return soup::make_unique<dnsAsyncWatcherTask>(dns_async_sched.add<dnsAsyncExecTask>(*this, qtype, name));
 	}
 
-	std::vector<IpAddr> dnsResolver::simplifyIPv4LookupResults(const Optional<std::vector<UniquePtr<dnsRecord>>>& results)
+	std::vector<IpAddr> dnsResolver::simplifyIPv4LookupResults(const Optional<std::vector<SharedPtr<dnsRecord>>>& results)
 	{
 		std::vector<IpAddr> res{};
 		if (results.has_value())
@@ -93,7 +93,7 @@ NAMESPACE_SOUP
 		return res;
 	}
 
-	std::vector<IpAddr> dnsResolver::simplifyIPv6LookupResults(const Optional<std::vector<UniquePtr<dnsRecord>>>& results)
+	std::vector<IpAddr> dnsResolver::simplifyIPv6LookupResults(const Optional<std::vector<SharedPtr<dnsRecord>>>& results)
 	{
 		std::vector<IpAddr> res{};
 		if (results.has_value())
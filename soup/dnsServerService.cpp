@@ -5,11 +5,35 @@
 #include "dnsHeader.hpp"
 #include "dnsQuestion.hpp"
 #include "dnsResource.hpp"
+#include "dnsZone.hpp"
 #include "Socket.hpp"
 #include "string.hpp"
 
+#if SOUP_LINUX
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
 NAMESPACE_SOUP
 {
+#if SOUP_LINUX
+	// Datagrams that are already waiting are received and answered in batches, so there are only a few syscalls for many of them.
+	struct dnsServerService::Batch
+	{
+		static constexpr unsigned int SIZE = 32;
+		static constexpr unsigned int MAX_PER_WAKEUP = 8; // so other workers don't starve while queries keep coming in
+
+		mmsghdr in_msgs[SIZE];
+		iovec in_iovs[SIZE];
+		sockaddr_in6 addrs[SIZE];
+		char bufs[SIZE][0x1000];
+
+		mmsghdr out_msgs[SIZE];
+		iovec out_iovs[SIZE];
+		std::string responses[SIZE];
+	};
+#endif
+
 	dnsServerService::dnsServerService(on_query_t on_query)
 		: ServerServiceUdp([](Socket& s, SocketAddr&& addr, std::string&& data, ServerServiceUdp& srv)
 		{
@@ -18,7 +42,27 @@ NAMESPACE_SOUP
 	{
 	}
 
+	dnsServerService::~dnsServerService() = default;
+
 	void dnsServerService::handle(Socket& s, SocketAddr&& addr, std::string&& data)
+	{
+		std::string response;
+		if (zone
+			&& zone->answer(data.data(), data.size(), response)
+			)
+		{
+			s.udpServerSend(addr, response);
+		}
+		else
+		{
+			handleQuery(s, std::move(addr), std::move(data));
+		}
+#if SOUP_LINUX
+		handleBatches(s);
+#endif
+	}
+
+	void dnsServerService::handleQuery(Socket& s, SocketAddr&& addr, std::string&& data)
 	{
 		StringReader sr(std::move(data));
 
@@ -103,6 +147,83 @@ NAMESPACE_SOUP
 		}
 		s.udpServerSend(addr, sw.data);
 	}
+
+#if SOUP_LINUX
+	void dnsServerService::handleBatches(Socket& s)
+	{
+		if (!batch)
+		{
+			batch = soup::make_unique<Batch>();
+		}
+		for (unsigned int i = 0; i != Batch::MAX_PER_WAKEUP; ++i)
+		{
+			for (unsigned int j = 0; j != Batch::SIZE; ++j)
+			{
+				batch->in_iovs[j].iov_base = batch->bufs[j];
+				batch->in_iovs[j].iov_len = sizeof(batch->bufs[j]);
+				batch->in_msgs[j].msg_hdr = {};
+				batch->in_msgs[j].msg_hdr.msg_name = &batch->addrs[j];
+				batch->in_msgs[j].msg_hdr.msg_namelen = sizeof(batch->addrs[j]);
+				batch->in_msgs[j].msg_hdr.msg_iov = &batch->in_iovs[j];
+				batch->in_msgs[j].msg_hdr.msg_iovlen = 1;
+			}
+			const int num_in = ::recvmmsg(s.fd, batch->in_msgs, Batch::SIZE, MSG_DONTWAIT, nullptr);
+			if (num_in <= 0)
+			{
+				return;
+			}
+
+			unsigned int num_out = 0;
+			for (int j = 0; j != num_in; ++j)
+			{
+				const mmsghdr& in = batch->in_msgs[j];
+				if (zone
+					&& zone->answer(batch->bufs[j], in.msg_len, batch->responses[num_out])
+					)
+				{
+					batch->out_iovs[num_out].iov_base = batch->responses[num_out].data();
+					batch->out_iovs[num_out].iov_len = batch->responses[num_out].size();
+					batch->out_msgs[num_out].msg_hdr = {};
+					batch->out_msgs[num_out].msg_hdr.msg_name = in.msg_hdr.msg_name;
+					batch->out_msgs[num_out].msg_hdr.msg_namelen = in.msg_hdr.msg_namelen;
+					batch->out_msgs[num_out].msg_hdr.msg_iov = &batch->out_iovs[num_out];
+					batch->out_msgs[num_out].msg_hdr.msg_iovlen = 1;
+					++num_out;
+					continue;
+				}
+
+				SocketAddr sender;
+				if (in.msg_hdr.msg_namelen == sizeof(sockaddr_in6))
+				{
+					sender.ip = IpAddr(reinterpret_cast<uint8_t*>(&batch->addrs[j].sin6_addr));
+					sender.port = network_u16_t(batch->addrs[j].sin6_port);
+				}
+				else
+				{
+					auto sa = reinterpret_cast<sockaddr_in*>(&batch->addrs[j]);
+					sender.ip = network_u32_t(*reinterpret_cast<uint32_t*>(&sa->sin_addr));
+					sender.port = network_u16_t(sa->sin_port);
+				}
+				handleQuery(s, std::move(sender), std::string(batch->bufs[j], in.msg_len));
+			}
+
+			for (unsigned int sent = 0; sent != num_out; )
+			{
+				const int res = ::sendmmsg(s.fd, &batch->out_msgs[sent], num_out - sent, 0);
+				if (res <= 0)
+				{
+					break;
+				}
+				sent += res;
+			}
+
+			if (num_in != Batch::SIZE)
+			{
+				return;
+			}
+		}
+	}
+#endif
 }
 
 #endif
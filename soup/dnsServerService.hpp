@@ -10,6 +10,7 @@
 
 #include "dns_records.hpp"
 #include "SharedPtr.hpp"
+#include "UniquePtr.hpp"
 
 NAMESPACE_SOUP
 {
@@ -21,10 +22,25 @@ NAMESPACE_SOUP
 
 		on_query_t on_query;
 
+		// If set, queries it has an answer for are answered from it without calling on_query. It must outlive the service.
+		const dnsZone* zone = nullptr;
+
+	private:
+#if SOUP_LINUX
+		struct Batch;
+		UniquePtr<Batch> batch;
+#endif
+
+	public:
 		dnsServerService(on_query_t on_query);
+		~dnsServerService();
 
 	private:
 		void handle(Socket& s, SocketAddr&& addr, std::string&& data);
+		void handleQuery(Socket& s, SocketAddr&& addr, std::string&& data);
+#if SOUP_LINUX
+		void handleBatches(Socket& s);
+#endif
 	};
 }
 
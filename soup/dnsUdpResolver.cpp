@@ -35,10 +35,10 @@ NAMESPACE_SOUP
 		}
 	};
 
-	Optional<std::vector<UniquePtr<dnsRecord>>> dnsUdpResolver::lookup(dnsType qtype, const std::string& name) const
+	Optional<std::vector<SharedPtr<dnsRecord>>> dnsUdpResolver::lookup(dnsType qtype, const std::string& name) const
 	{
 		{
-			std::vector<UniquePtr<dnsRecord>> res;
+			std::vector<SharedPtr<dnsRecord>> res;
 			if (checkBuiltinResult(res, qtype, name))
 			{
 				return res;
@@ -15,7 +15,7 @@ NAMESPACE_SOUP
 		unsigned int timeout_ms = 200; // normally would set this to like 3000 but 1.1.1.1 responds in <50 ms and we really don't wanna wait eons
 		unsigned int num_retries = 1;
 
-		[[nodiscard]] Optional<std::vector<UniquePtr<dnsRecord>>> lookup(dnsType qtype, const std::string& name) const final;
+		[[nodiscard]] Optional<std::vector<SharedPtr<dnsRecord>>> lookup(dnsType qtype, const std::string& name) const final;
 	};
 }
 
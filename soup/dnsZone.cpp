@@ -0,0 +1,234 @@
+#include "dnsZone.hpp"
+
+#include <algorithm> // find
+#include <cstring> // memcpy, memcmp
+
+#include "dnsHeader.hpp"
+#include "dnsQuestion.hpp"
+#include "dnsResource.hpp"
+#include "string.hpp"
+#include "StringWriter.hpp"
+
+NAMESPACE_SOUP
+{
+	[[nodiscard]] static uint32_t hashKey(const char* data, size_t size) noexcept
+	{
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i != size; ++i)
+		{
+			hash ^= static_cast<uint8_t>(data[i]);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	void dnsZone::compile(const std::unordered_map<std::string, std::vector<SharedPtr<dnsRecord>>>& records) SOUP_EXCAL
+	{
+		slots.clear();
+		num_responses = 0;
+		size_t num_keys = 0;
+		for (const auto& e : records)
+		{
+			num_keys += e.second.size() + 1;
+		}
+		size_t num_slots = 16;
+		while (num_slots < num_keys * 2)
+		{
+			num_slots <<= 1;
+		}
+		slots.resize(num_slots);
+
+		for (const auto& e : records)
+		{
+			std::string wire_name;
+			if (!encodeName(wire_name, string::lower(std::string(e.first))))
+			{
+				continue;
+			}
+
+			std::vector<uint16_t> qtypes{ DNS_ALL };
+			for (const auto& rr : e.second)
+			{
+				if (std::find(qtypes.begin(), qtypes.end(), rr->type) == qtypes.end())
+				{
+					qtypes.emplace_back(rr->type);
+				}
+			}
+			for (uint16_t qtype : qtypes)
+			{
+				dnsHeader dh{};
+				dh.bitfield1 = (1 << 7) | (1 << 2); // QR, AA
+				dh.bitfield2 = 0; // RA = 0, Z = 0, RCODE = OK
+				dh.qdcount = 1;
+				dh.ancount = 0;
+				for (const auto& rr : e.second)
+				{
+					if (rr->type == qtype
+						|| qtype == DNS_ALL
+						)
+					{
+						++dh.ancount;
+					}
+				}
+				dh.nscount = 0;
+				dh.arcount = 0;
+
+				StringWriter sw;
+				dh.write(sw);
+				sw.data.append(wire_name);
+				sw.u16be(qtype);
+				uint16_t qclass = DNS_IN;
+				sw.u16be(qclass);
+				for (const auto& rr : e.second)
+				{
+					if (rr->type != qtype
+						&& qtype != DNS_ALL
+						)
+					{
+						continue;
+					}
+					dnsResource dr{};
+					dr.name.ptr = 12; // point to name in question
+					dr.rtype = rr->type;
+					dr.rclass = DNS_IN;
+					dr.ttl = rr->ttl;
+					dr.rdata = rr->toRdata();
+					dr.write(sw);
+				}
+
+				std::string key = wire_name;
+				key.push_back(static_cast<char>(qtype >> 8));
+				key.push_back(static_cast<char>(qtype));
+				insert(std::move(key), std::move(sw.data));
+			}
+		}
+	}
+
+	bool dnsZone::answer(const char* query, size_t size, std::string& out) const SOUP_EXCAL
+	{
+		if (size < 12 + 1 + 4
+			|| slots.empty()
+			)
+		{
+			return false;
+		}
+		const auto* const data = reinterpret_cast<const uint8_t*>(query);
+		if ((data[2] & 0b1'1111'000) != 0 // QR = 0, OPCODE = QUERY
+			|| data[4] != 0 || data[5] != 1 // QDCOUNT = 1
+			)
+		{
+			return false;
+		}
+
+		// The key is the name in lowercase followed by the qtype, as it was encoded for the slots.
+		char key[255 + 2];
+		size_t key_len = 0;
+		size_t i = 12;
+		while (true)
+		{
+			if (i >= size)
+			{
+				return false;
+			}
+			const uint8_t len = data[i];
+			if (len > 63 // compression pointers are not expected in the question
+				|| key_len + 1 + len > 255
+				|| i + 1 + len > size
+				)
+			{
+				return false;
+			}
+			key[key_len++] = static_cast<char>(len);
+			++i;
+			for (const auto end = i + len; i != end; ++i)
+			{
+				key[key_len++] = string::lower_char(query[i]);
+			}
+			if (len == 0)
+			{
+				break;
+			}
+		}
+		const size_t name_len = key_len;
+		if (i + 4 > size
+			|| data[i + 2] != 0 || data[i + 3] != DNS_IN
+			)
+		{
+			return false;
+		}
+		key[key_len++] = query[i];
+		key[key_len++] = query[i + 1];
+
+		const uint32_t hash = hashKey(key, key_len);
+		const size_t mask = slots.size() - 1;
+		for (size_t slot_i = hash & mask; ; slot_i = (slot_i + 1) & mask)
+		{
+			const Slot& slot = slots[slot_i];
+			if (slot.key.empty())
+			{
+				return false;
+			}
+			if (slot.hash == hash
+				&& slot.key.size() == key_len
+				&& memcmp(slot.key.data(), key, key_len) == 0
+				)
+			{
+				out.assign(slot.response);
+				break;
+			}
+		}
+
+		// Patch in the ID and RD bit, and echo the name as it was sent, since some resolvers randomise its case.
+		out[0] = query[0];
+		out[1] = query[1];
+		out[2] = static_cast<char>(out[2] | (data[2] & 1));
+		memcpy(out.data() + 12, query + 12, name_len);
+		return true;
+	}
+
+	bool dnsZone::encodeName(std::string& out, const std::string& name) SOUP_EXCAL
+	{
+		for (const auto& label : string::explode(name, '.'))
+		{
+			if (label.empty())
+			{
+				continue;
+			}
+			if (label.size() > 63)
+			{
+				return false;
+			}
+			out.push_back(static_cast<char>(label.size()));
+			out.append(label);
+		}
+		out.push_back('\0');
+		return out.size() <= 255;
+	}
+
+	void dnsZone::insert(std::string&& key, std::string&& response) SOUP_EXCAL
+	{
+		const uint32_t hash = hashKey(key.data(), key.size());
+		const size_t mask = slots.size() - 1;
+		for (size_t i = hash & mask; ; i = (i + 1) & mask)
+		{
+			Slot& slot = slots[i];
+			if (slot.key.empty())
+			{
+				slot.hash = hash;
+				slot.key = std::move(key);
+				slot.response = std::move(response);
+				++num_responses;
+				return;
+			}
+			if (slot.hash == hash
+				&& slot.key == key
+				)
+			{
+				// Names that only differ in case have been given separately, in which case the last one wins.
+				slot.response = std::move(response);
+				return;
+			}
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dns_records.hpp"
+#include "SharedPtr.hpp"
+
+NAMESPACE_SOUP
+{
+	// Authoritative answers that are encoded ahead of time, so answering a query is a hash lookup on its wire-format name and a copy.
+	class dnsZone
+	{
+	protected:
+		struct Slot
+		{
+			uint32_t hash;
+			std::string key; // lowercase wire-format name followed by qtype, empty if the slot is unused
+			std::string response; // with ID 0 and RD unset
+		};
+
+		std::vector<Slot> slots{}; // open addressing with linear probing, the size is a power of 2
+		size_t num_responses = 0;
+
+	public:
+		// Replaces the answers with ones for the given records, keyed by name. Each name can be queried for the types it has records of or DNS_ALL.
+		void compile(const std::unordered_map<std::string, std::vector<SharedPtr<dnsRecord>>>& records) SOUP_EXCAL;
+
+		// Writes the response to the query into 'out' and returns true, or returns false if the query is not for anything in this zone.
+		// 'out' can be reused between calls to avoid allocations.
+		[[nodiscard]] bool answer(const char* query, size_t size, std::string& out) const SOUP_EXCAL;
+
+		[[nodiscard]] size_t size() const noexcept
+		{
+			return num_responses;
+		}
+
+	protected:
+		[[nodiscard]] static bool encodeName(std::string& out, const std::string& name) SOUP_EXCAL;
+		void insert(std::string&& key, std::string&& response) SOUP_EXCAL;
+	};
+}
@@ -1,6 +1,9 @@
 #include "ecc.hpp"
 
+#include <algorithm> // max
+
 #include "Exception.hpp"
+#include "MontgomeryField.hpp"
 #include "ObfusString.hpp"
 #include "rand.hpp"
 
@@ -8,6 +11,569 @@ NAMESPACE_SOUP
 {
 	using namespace literals;
 
+	// Arithmetic modulo p, with elements kept in [0, p). Works for any p, but every operation allocates.
+	struct EccFieldBigint
+	{
+		using Element = Bigint;
+		using Affine = EccPoint;
+
+		const Bigint p;
+
+		explicit EccFieldBigint(const Bigint& p) SOUP_EXCAL
+			: p(p)
+		{
+		}
+
+		[[nodiscard]] static const EccPoint& fromPoint(const EccPoint& P) noexcept
+		{
+			return P;
+		}
+
+		[[nodiscard]] static EccPoint toPoint(EccPoint&& P) noexcept
+		{
+			return std::move(P);
+		}
+
+		[[nodiscard]] Bigint fromBigint(const Bigint& a) const SOUP_EXCAL
+		{
+			return a.mod(p);
+		}
+
+		[[nodiscard]] static Bigint one() SOUP_EXCAL
+		{
+			return Bigint((Bigint::chunk_t)1u);
+		}
+
+		[[nodiscard]] static bool isZero(const Bigint& a) noexcept
+		{
+			return a.isZero();
+		}
+
+		[[nodiscard]] Bigint add(const Bigint& a, const Bigint& b) const SOUP_EXCAL
+		{
+			Bigint res = a + b;
+			if (res >= p)
+			{
+				res.subUnsigned(p);
+			}
+			return res;
+		}
+
+		[[nodiscard]] Bigint sub(const Bigint& a, const Bigint& b) const SOUP_EXCAL
+		{
+			Bigint res = a + p;
+			res.subUnsigned(b);
+			if (res >= p)
+			{
+				res.subUnsigned(p);
+			}
+			return res;
+		}
+
+		[[nodiscard]] Bigint neg(const Bigint& a) const SOUP_EXCAL
+		{
+			return a.isZero() ? Bigint{} : p - a;
+		}
+
+		[[nodiscard]] Bigint mul(const Bigint& a, const Bigint& b) const SOUP_EXCAL
+		{
+			return (a * b).modUnsigned(p);
+		}
+
+		[[nodiscard]] Bigint sqr(const Bigint& a) const SOUP_EXCAL
+		{
+			return a.pow2().modUnsigned(p);
+		}
+
+		[[nodiscard]] Bigint inv(const Bigint& a) const
+		{
+			return a.modMulInv(p);
+		}
+	};
+
+	// Arithmetic modulo p on elements of a fixed number of 64-bit limbs, which is much faster for the curves that fit.
+	template <size_t LIMBS>
+	struct EccFieldMontgomery : public MontgomeryField<LIMBS>
+	{
+		using Element = typename MontgomeryField<LIMBS>::Element;
+
+		struct Affine
+		{
+			Element x;
+			Element y;
+
+			[[nodiscard]] bool isPointAtInfinity() const noexcept
+			{
+				return MontgomeryField<LIMBS>::isZero(x);
+			}
+		};
+
+		using MontgomeryField<LIMBS>::MontgomeryField;
+
+		[[nodiscard]] Affine fromPoint(const EccPoint& P) const SOUP_EXCAL
+		{
+			if (P.isPointAtInfinity())
+			{
+				return Affine{};
+			}
+			return Affine{ this->fromBigint(P.x), this->fromBigint(P.y) };
+		}
+
+		[[nodiscard]] EccPoint toPoint(const Affine& P) const SOUP_EXCAL
+		{
+			if (P.isPointAtInfinity())
+			{
+				return EccPoint{};
+			}
+			return EccPoint{ this->toBigint(P.x), this->toBigint(P.y) };
+		}
+	};
+
+	// A point in Jacobian coordinates represents the affine point (x / z^2, y / z^3), so adding and doubling doesn't need a modular inverse.
+	template <typename Element>
+	struct EccJacobianPoint
+	{
+		Element x;
+		Element y;
+		Element z; // zero for the point at infinity
+	};
+
+	// Formulas are from https://hyperelliptic.org/EFD/g1p/auto-shortw-jacobian.html
+	template <typename Field>
+	struct EccJacobianArithmetic
+	{
+		using Element = typename Field::Element;
+		using Affine = typename Field::Affine;
+		using Point = EccJacobianPoint<Element>;
+
+		const Field& f;
+		Element a;
+		bool a_is_zero;
+		bool a_is_minus_3;
+
+		EccJacobianArithmetic(const Field& f, const EccCurve& curve) SOUP_EXCAL
+			: f(f), a(f.fromBigint(curve.a)), a_is_zero(curve.a.mod(curve.p).isZero()), a_is_minus_3((curve.a + Bigint((Bigint::chunk_t)3u)).mod(curve.p).isZero())
+		{
+		}
+
+		[[nodiscard]] Point fromAffine(const Affine& P) const SOUP_EXCAL
+		{
+			return Point{ P.x, P.y, f.one() };
+		}
+
+		[[nodiscard]] Affine toAffine(const Point& P) const
+		{
+			if (Field::isZero(P.z))
+			{
+				return Affine{};
+			}
+			const Element z_inv = f.inv(P.z);
+			const Element z_inv2 = f.sqr(z_inv);
+			return Affine{ f.mul(P.x, z_inv2), f.mul(P.y, f.mul(z_inv2, z_inv)) };
+		}
+
+		// Converts all points with a single modular inverse (Montgomery's trick).
+		[[nodiscard]] std::vector<Affine> toAffine(const std::vector<Point>& points) const
+		{
+			// Points at infinity are skipped by treating their z as 1.
+			const auto z_or_one = [this](const Point& P)
+			{
+				return Field::isZero(P.z) ? f.one() : P.z;
+			};
+			std::vector<Element> prefix;
+			prefix.reserve(points.size());
+			prefix.emplace_back(z_or_one(points.at(0)));
+			for (size_t i = 1; i != points.size(); ++i)
+			{
+				prefix.emplace_back(f.mul(prefix.back(), z_or_one(points[i])));
+			}
+			Element inv = f.inv(prefix.back());
+			std::vector<Affine> res(points.size());
+			for (size_t i = points.size(); i-- != 0; )
+			{
+				const Element z_inv = (i == 0 ? inv : f.mul(inv, prefix[i - 1]));
+				if (i != 0)
+				{
+					inv = f.mul(inv, z_or_one(points[i]));
+				}
+				if (!Field::isZero(points[i].z))
+				{
+					const Element z_inv2 = f.sqr(z_inv);
+					res[i] = Affine{ f.mul(points[i].x, z_inv2), f.mul(points[i].y, f.mul(z_inv2, z_inv)) };
+				}
+			}
+			return res;
+		}
+
+		// dbl-2007-bl, with dbl-2001-b's shortcut when a = -3.
+		void dbl(Point& P) const SOUP_EXCAL
+		{
+			if (Field::isZero(P.z))
+			{
+				return;
+			}
+			if (Field::isZero(P.y))
+			{
+				P.z = Element{};
+				return;
+			}
+			const Element xx = f.sqr(P.x);
+			const Element yy = f.sqr(P.y);
+			const Element yyyy = f.sqr(yy);
+			const Element zz = f.sqr(P.z);
+			Element s = f.sub(f.sub(f.sqr(f.add(P.x, yy)), xx), yyyy);
+			s = f.add(s, s);
+			Element m;
+			if (a_is_minus_3)
+			{
+				m = f.mul(f.sub(P.x, zz), f.add(P.x, zz));
+				m = f.add(f.add(m, m), m);
+			}
+			else
+			{
+				m = f.add(f.add(xx, xx), xx);
+				if (!a_is_zero)
+				{
+					m = f.add(m, f.mul(a, f.sqr(zz)));
+				}
+			}
+			P.z = f.sub(f.sub(f.sqr(f.add(P.y, P.z)), yy), zz);
+			P.x = f.sub(f.sqr(m), f.add(s, s));
+			Element yyyy8 = f.add(yyyy, yyyy);
+			yyyy8 = f.add(yyyy8, yyyy8);
+			yyyy8 = f.add(yyyy8, yyyy8);
+			P.y = f.sub(f.mul(m, f.sub(s, P.x)), yyyy8);
+		}
+
+		// add-2007-bl
+		void add(Point& P, const Point& Q) const SOUP_EXCAL
+		{
+			if (Field::isZero(Q.z))
+			{
+				return;
+			}
+			if (Field::isZero(P.z))
+			{
+				P = Q;
+				return;
+			}
+			const Element z1z1 = f.sqr(P.z);
+			const Element z2z2 = f.sqr(Q.z);
+			const Element u1 = f.mul(P.x, z2z2);
+			const Element u2 = f.mul(Q.x, z1z1);
+			const Element s1 = f.mul(f.mul(P.y, Q.z), z2z2);
+			const Element s2 = f.mul(f.mul(Q.y, P.z), z1z1);
+			const Element h = f.sub(u2, u1);
+			Element r = f.sub(s2, s1);
+			if (Field::isZero(h))
+			{
+				if (Field::isZero(r))
+				{
+					dbl(P);
+				}
+				else
+				{
+					P.z = Element{};
+				}
+				return;
+			}
+			const Element i = f.sqr(f.add(h, h));
+			const Element j = f.mul(h, i);
+			r = f.add(r, r);
+			const Element v = f.mul(u1, i);
+			P.z = f.mul(f.sub(f.sub(f.sqr(f.add(P.z, Q.z)), z1z1), z2z2), h);
+			P.x = f.sub(f.sub(f.sqr(r), j), f.add(v, v));
+			const Element s1j = f.mul(s1, j);
+			P.y = f.sub(f.mul(r, f.sub(v, P.x)), f.add(s1j, s1j));
+		}
+
+		// madd-2007-bl, adding -Q instead if 'negate' is true.
+		void addAffine(Point& P, const Affine& Q, bool negate = false) const SOUP_EXCAL
+		{
+			if (Q.isPointAtInfinity())
+			{
+				return;
+			}
+			if (Field::isZero(P.z))
+			{
+				P = Point{ Q.x, negate ? f.neg(Q.y) : Q.y, f.one() };
+				return;
+			}
+			const Element z1z1 = f.sqr(P.z);
+			const Element u2 = f.mul(Q.x, z1z1);
+			Element s2 = f.mul(f.mul(Q.y, P.z), z1z1);
+			if (negate)
+			{
+				s2 = f.neg(s2);
+			}
+			const Element h = f.sub(u2, P.x);
+			Element r = f.sub(s2, P.y);
+			if (Field::isZero(h))
+			{
+				if (Field::isZero(r))
+				{
+					dbl(P);
+				}
+				else
+				{
+					P.z = Element{};
+				}
+				return;
+			}
+			const Element hh = f.sqr(h);
+			Element i = f.add(hh, hh);
+			i = f.add(i, i);
+			const Element j = f.mul(h, i);
+			r = f.add(r, r);
+			const Element v = f.mul(P.x, i);
+			P.z = f.sub(f.sub(f.sqr(f.add(P.z, h)), z1z1), hh);
+			P.x = f.sub(f.sub(f.sqr(r), j), f.add(v, v));
+			const Element y1j = f.mul(P.y, j);
+			P.y = f.sub(f.mul(r, f.sub(v, P.x)), f.add(y1j, y1j));
+		}
+
+		// P, 3P, 5P, ..., (2 * count - 1)P
+		[[nodiscard]] std::vector<Affine> oddMultiples(const Affine& P, size_t count) const
+		{
+			std::vector<Point> points{ fromAffine(P) };
+			points.reserve(count);
+			Point P2 = points.back();
+			dbl(P2);
+			while (points.size() != count)
+			{
+				Point next = points.back();
+				add(next, P2);
+				points.emplace_back(std::move(next));
+			}
+			return toAffine(points);
+		}
+	};
+
+	// Width-w non-adjacent form: every non-zero digit is odd and less than 2^(w-1) in magnitude, and is followed by at least w-1 zeroes.
+	[[nodiscard]] static std::vector<int8_t> toWnaf(const Bigint& k, unsigned int w) SOUP_EXCAL
+	{
+		const size_t len = k.getBitLength() + 1;
+		std::vector<int8_t> digits(len, 0);
+		unsigned int carry = 0;
+		for (size_t bit = 0; bit < len; )
+		{
+			if (k.getBit(bit) == carry)
+			{
+				++bit;
+				continue;
+			}
+			unsigned int word = carry;
+			for (unsigned int i = 0; i != w; ++i)
+			{
+				word += (k.getBit(bit + i) << i);
+			}
+			carry = (word >> (w - 1)) & 1;
+			digits[bit] = static_cast<int8_t>(static_cast<int>(word) - static_cast<int>(carry << w));
+			bit += w;
+		}
+		return digits;
+	}
+
+	template <typename Arithmetic>
+	static void addWnafDigit(const Arithmetic& arith, typename Arithmetic::Point& R, const std::vector<typename Arithmetic::Affine>& odd_multiples, int8_t digit) SOUP_EXCAL
+	{
+		if (digit > 0)
+		{
+			arith.addAffine(R, odd_multiples[(digit - 1) / 2]);
+		}
+		else if (digit < 0)
+		{
+			arith.addAffine(R, odd_multiples[(-digit - 1) / 2], true);
+		}
+	}
+
+	static constexpr unsigned int WNAF_WIDTH = 5;
+	static constexpr unsigned int WNAF_WIDTH_PRECOMPUTED = 8;
+	static constexpr unsigned int COMB_TEETH = 8;
+
+	[[nodiscard]] static bool isSamePoint(const EccPoint& P, const EccPoint& Q) noexcept
+	{
+		return &P == &Q
+			|| (P.x == Q.x && P.y == Q.y)
+			;
+	}
+
+#undef max
+
+	// Point multiplication using the arithmetic of the given field, with tables for G if precompute was called.
+	template <typename Field>
+	struct EccMultiplier : public EccCurve::Precomputed
+	{
+		using Affine = typename Field::Affine;
+		using Point = EccJacobianPoint<typename Field::Element>;
+
+		const Field f;
+		const EccJacobianArithmetic<Field> arith;
+		size_t comb_spacing = 0;
+		std::vector<Affine> comb{}; // comb[i - 1] is the sum of 2^(j * comb_spacing) * G for each bit j that is set in i
+		std::vector<Affine> odd_multiples{}; // G, 3G, 5G, ...
+
+		explicit EccMultiplier(const EccCurve& curve) SOUP_EXCAL
+			: f(curve.p), arith(f, curve)
+		{
+		}
+
+		EccMultiplier(const EccMultiplier&) = delete; // 'arith' refers to 'f'
+
+		void precompute(const EccCurve& curve) SOUP_EXCAL
+		{
+			comb_spacing = (curve.n.getBitLength() + COMB_TEETH - 1) / COMB_TEETH;
+			const Affine G = f.fromPoint(curve.G);
+
+			// The teeth are G, 2^comb_spacing * G, 2^(2 * comb_spacing) * G, ...
+			std::vector<Point> teeth{ arith.fromAffine(G) };
+			while (teeth.size() != COMB_TEETH)
+			{
+				auto tooth = teeth.back();
+				for (size_t i = 0; i != comb_spacing; ++i)
+				{
+					arith.dbl(tooth);
+				}
+				teeth.emplace_back(std::move(tooth));
+			}
+			std::vector<Point> points;
+			points.reserve((1 << COMB_TEETH) - 1);
+			for (unsigned int i = 1; i != (1 << COMB_TEETH); ++i)
+			{
+				// The entry for i is the one for i without its highest bit plus the tooth for that bit.
+				unsigned int high = 0;
+				while ((i >> (high + 1)) != 0)
+				{
+					++high;
+				}
+				auto entry = teeth[high];
+				if (const unsigned int rest = (i & ~(1u << high)); rest != 0)
+				{
+					arith.add(entry, points[rest - 1]);
+				}
+				points.emplace_back(std::move(entry));
+			}
+			comb = arith.toAffine(points);
+
+			odd_multiples = arith.oddMultiples(G, 1 << (WNAF_WIDTH_PRECOMPUTED - 2));
+		}
+
+		[[nodiscard]] EccPoint multiply(const EccCurve& curve, const EccPoint& G, const Bigint& d) const final
+		{
+			if (G.isPointAtInfinity())
+			{
+				return EccPoint{};
+			}
+
+			Point R{};
+			if (!comb.empty()
+				&& isSamePoint(G, curve.G)
+				)
+			{
+				// Comb method: the scalar is split into COMB_TEETH rows of comb_spacing bits, so each column selects one precomputed sum to add.
+				Bigint reduced;
+				const Bigint* k = &d;
+				if (d >= curve.n)
+				{
+					reduced = d.mod(curve.n);
+					k = &reduced;
+				}
+				for (size_t col = comb_spacing; col-- != 0; )
+				{
+					arith.dbl(R);
+					unsigned int index = 0;
+					for (unsigned int j = 0; j != COMB_TEETH; ++j)
+					{
+						index |= (k->getBit(j * comb_spacing + col) << j);
+					}
+					if (index != 0)
+					{
+						arith.addAffine(R, comb[index - 1]);
+					}
+				}
+			}
+			else
+			{
+				const auto g_odd_multiples = arith.oddMultiples(f.fromPoint(G), 1 << (WNAF_WIDTH - 2));
+				const auto digits = toWnaf(d, WNAF_WIDTH);
+				for (size_t i = digits.size(); i-- != 0; )
+				{
+					arith.dbl(R);
+					addWnafDigit(arith, R, g_odd_multiples, digits[i]);
+				}
+			}
+			return f.toPoint(arith.toAffine(R));
+		}
+
+		[[nodiscard]] EccPoint multiplyAndAdd(const EccCurve& curve, const EccPoint& G, const Bigint& u1, const EccPoint& Q, const Bigint& u2) const final
+		{
+			std::vector<Affine> g_odd_multiples;
+			const std::vector<Affine>* g_table = &g_odd_multiples;
+			std::vector<int8_t> g_digits;
+			if (!odd_multiples.empty()
+				&& isSamePoint(G, curve.G)
+				)
+			{
+				g_table = &odd_multiples;
+				g_digits = toWnaf(u1, WNAF_WIDTH_PRECOMPUTED);
+			}
+			else if (!G.isPointAtInfinity())
+			{
+				g_odd_multiples = arith.oddMultiples(f.fromPoint(G), 1 << (WNAF_WIDTH - 2));
+				g_digits = toWnaf(u1, WNAF_WIDTH);
+			}
+
+			std::vector<Affine> q_odd_multiples;
+			std::vector<int8_t> q_digits;
+			if (!Q.isPointAtInfinity())
+			{
+				q_odd_multiples = arith.oddMultiples(f.fromPoint(Q), 1 << (WNAF_WIDTH - 2));
+				q_digits = toWnaf(u2, WNAF_WIDTH);
+			}
+
+			// Shamir's trick: both products share the same doublings.
+			Point R{};
+			for (size_t i = std::max(g_digits.size(), q_digits.size()); i-- != 0; )
+			{
+				arith.dbl(R);
+				if (i < g_digits.size())
+				{
+					addWnafDigit(arith, R, *g_table, g_digits[i]);
+				}
+				if (i < q_digits.size())
+				{
+					addWnafDigit(arith, R, q_odd_multiples, q_digits[i]);
+				}
+			}
+			return f.toPoint(arith.toAffine(R));
+		}
+	};
+
+	// Calls 'f' with the precomputed multiplier if there is one, or otherwise sets up one without tables, using fixed-size limbs where p allows for it.
+	template <typename F>
+	[[nodiscard]] static EccPoint withMultiplier(const EccCurve& curve, F&& f)
+	{
+		if (curve.precomputed)
+		{
+			return f(*curve.precomputed);
+		}
+		if (curve.p.isOdd())
+		{
+			if (curve.p.getBitLength() <= 256)
+			{
+				const EccMultiplier<EccFieldMontgomery<4>> multiplier(curve);
+				return f(multiplier);
+			}
+			if (curve.p.getBitLength() <= 384)
+			{
+				const EccMultiplier<EccFieldMontgomery<6>> multiplier(curve);
+				return f(multiplier);
+			}
+		}
+		const EccMultiplier<EccFieldBigint> multiplier(curve);
+		return f(multiplier);
+	}
+
 	[[nodiscard]] static EccCurve construct_secp256k1()
 	{
 		// https://asecuritysite.com/encryption/secp256k1p
@@ -20,6 +586,7 @@ NAMESPACE_SOUP
 			"0x483ADA7726A3C4655DA4FBFC0E1108A8FD17B448A68554199C47D08FFB10D4B8"_b
 		};
 		curve.n = "0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141"_b;
+		curve.precompute();
 		return curve;
 	}
 
@@ -35,6 +602,7 @@ NAMESPACE_SOUP
 			"36134250956749795798585127919587881956611106672985015071877198253568414405109"_b
 		};
 		curve.n = "0xFFFFFFFF00000000FFFFFFFFFFFFFFFFBCE6FAADA7179E84F3B9CAC2FC632551"_b;
+		curve.precompute();
 		return curve;
 	}
 
@@ -50,6 +618,7 @@ NAMESPACE_SOUP
 			"0x3617DE4A96262C6F5D9E98BF9292DC29F8F41DBD289A147CE9DA3113B5F0B8C00A60B1CE1D7E819D7A431D7C90EA0E5F"_b
 		};
 		curve.n = "0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFC7634D81F4372DDF581A0DB248B0A77AECEC196ACCC52973"_b;
+		curve.precompute();
 		return curve;
 	}
 
@@ -71,6 +640,34 @@ NAMESPACE_SOUP
 		return s_secp384r1;
 	}
 
+	template <typename Field>
+	[[nodiscard]] static SharedPtr<EccCurve::Precomputed> precomputeWith(const EccCurve& curve) SOUP_EXCAL
+	{
+		auto multiplier = soup::make_shared<EccMultiplier<Field>>(curve);
+		multiplier->precompute(curve);
+		return multiplier;
+	}
+
+	void EccCurve::precompute() SOUP_EXCAL
+	{
+		if (p.isOdd()
+			&& p.getBitLength() <= 256
+			)
+		{
+			precomputed = precomputeWith<EccFieldMontgomery<4>>(*this);
+		}
+		else if (p.isOdd()
+			&& p.getBitLength() <= 384
+			)
+		{
+			precomputed = precomputeWith<EccFieldMontgomery<6>>(*this);
+		}
+		else
+		{
+			precomputed = precomputeWith<EccFieldBigint>(*this);
+		}
+	}
+
 	Bigint EccCurve::generatePrivate() const SOUP_EXCAL
 	{
 		Bigint d;
@@ -123,69 +720,18 @@ NAMESPACE_SOUP
 
 	EccPoint EccCurve::multiply(const EccPoint& G, const Bigint& d) const
 	{
-#if true
-		// Double-and-add
-		EccPoint R;
-		for (size_t i = d.getBitLength(); i-- != 0; )
+		return withMultiplier(*this, [&](const Precomputed& multiplier)
 		{
-			R = add(R, R);
-			if (d.getBitInbounds(i))
-			{
-				R = add(R, G);
-			}
-		}
-		return R;
-#else
-		// Montgomery ladder (constant-time)
-		EccPoint R0, R1 = G;
-		for (int i = d.getBitLength() - 1; i >= 0; i--)
-		{
-			if (d.getBit(i) == 0)
-			{
-				R1 = add(R0, R1);
-				R0 = add(R0, R0);
-			}
-			else
-			{
-				R0 = add(R0, R1);
-				R1 = add(R1, R1);
-			}
-		}
-		return R0;
-#endif
+			return multiplier.multiply(*this, G, d);
+		});
 	}
 
-#undef max
-
 	EccPoint EccCurve::multiplyAndAdd(const EccPoint& G, const Bigint& u1, const EccPoint& Q, const Bigint& u2) const
 	{
-		EccPoint R;
-
-		auto l1 = u1.getBitLength();
-		auto l2 = u2.getBitLength();
-
-		auto max_len = std::max(l1, l2);
-
-		EccPoint sum = add(G, Q);
-
-		const EccPoint* table[3];
-		table[0] = &G;
-		table[1] = &Q;
-		table[2] = &sum;
-
-		for (size_t i = max_len; i-- != 0; )
+		return withMultiplier(*this, [&](const Precomputed& multiplier)
 		{
-			R = add(R, R);
-
-			uint8_t index = u1.getBit(i);
-			index += (u2.getBit(i) * 2);
-			if (index != 0)
-			{
-				R = add(R, *table[index - 1]);
-			}
-		}
-
-		return R;
+			return multiplier.multiplyAndAdd(*this, G, u1, Q, u2);
+		});
 	}
 
 	std::string EccCurve::encodePointUncompressed(const EccPoint& P) const SOUP_EXCAL
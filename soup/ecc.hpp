@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Bigint.hpp"
+#include "SharedPtr.hpp"
 
 NAMESPACE_SOUP
 {
@@ -18,16 +19,29 @@ NAMESPACE_SOUP
 
 	struct EccCurve
 	{
+		// Field arithmetic set up for this curve, along with multiples of G that are computed once, so multiplications of G only need to add them up.
+		struct Precomputed
+		{
+			virtual ~Precomputed() = default;
+
+			[[nodiscard]] virtual EccPoint multiply(const EccCurve& curve, const EccPoint& G, const Bigint& d) const = 0;
+			[[nodiscard]] virtual EccPoint multiplyAndAdd(const EccCurve& curve, const EccPoint& G, const Bigint& u1, const EccPoint& Q, const Bigint& u2) const = 0;
+		};
+
 		Bigint a;
 		Bigint b;
 		Bigint p;
 		EccPoint G;
 		Bigint n;
+		SharedPtr<Precomputed> precomputed;
 
 		[[nodiscard]] static const EccCurve& secp256k1();
 		[[nodiscard]] static const EccCurve& secp256r1(); // aka. P-256
 		[[nodiscard]] static const EccCurve& secp384r1(); // aka. P-384
 
+		// Takes some time and memory, but makes multiplications of G much faster. The predefined curves have already done this.
+		void precompute() SOUP_EXCAL;
+
 		[[nodiscard]] Bigint generatePrivate() const SOUP_EXCAL;
 		[[nodiscard]] EccPoint derivePublic(const Bigint& d) const;
 
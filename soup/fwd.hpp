@@ -152,6 +152,9 @@ NAMESPACE_SOUP
 	class Socket;
 	struct SocketAddr;
 
+	// net.dns
+	class dnsZone;
+
 	// net.dns.resolver
 	struct dnsResolver;
 	struct dnsName;
@@ -160,6 +163,7 @@ NAMESPACE_SOUP
 	// net.tls
 	class SocketTlsHandshaker;
 	struct TlsClientHello;
+	class TlsSessionCache;
 
 	// net.web
 	class HttpRequest;
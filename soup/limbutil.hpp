@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+#include "base.hpp"
+
+#if defined(_MSC_VER) && !defined(__clang__) && SOUP_BITS == 64
+#include <intrin.h>
+#endif
+
+NAMESPACE_SOUP
+{
+	// Building blocks for arithmetic on numbers made up of 64-bit limbs.
+	struct limbutil
+	{
+		// Returns the low half of a * b + c + d, which can't overflow 128 bits, and stores the high half in 'hi'.
+		[[nodiscard]] static SOUP_FORCEINLINE uint64_t mulAdd(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t& hi) noexcept
+		{
+#if defined(__SIZEOF_INT128__)
+			const unsigned __int128 res = static_cast<unsigned __int128>(a) * b + c + d;
+			hi = static_cast<uint64_t>(res >> 64);
+			return static_cast<uint64_t>(res);
+#else
+			uint64_t lo = mul(a, b, hi);
+			lo += c;
+			hi += (lo < c);
+			lo += d;
+			hi += (lo < d);
+			return lo;
+#endif
+		}
+
+		// Returns the low half of a * b and stores the high half in 'hi'.
+		[[nodiscard]] static SOUP_FORCEINLINE uint64_t mul(uint64_t a, uint64_t b, uint64_t& hi) noexcept
+		{
+#if defined(__SIZEOF_INT128__)
+			const unsigned __int128 res = static_cast<unsigned __int128>(a) * b;
+			hi = static_cast<uint64_t>(res >> 64);
+			return static_cast<uint64_t>(res);
+#elif defined(_MSC_VER) && !defined(__clang__) && SOUP_BITS == 64 && SOUP_X86
+			return _umul128(a, b, &hi);
+#elif defined(_MSC_VER) && !defined(__clang__) && SOUP_BITS == 64
+			hi = __umulh(a, b);
+			return a * b;
+#else
+			const uint64_t a_lo = static_cast<uint32_t>(a), a_hi = (a >> 32);
+			const uint64_t b_lo = static_cast<uint32_t>(b), b_hi = (b >> 32);
+			const uint64_t lo_lo = a_lo * b_lo;
+			const uint64_t hi_lo = a_hi * b_lo;
+			const uint64_t lo_hi = a_lo * b_hi;
+			const uint64_t hi_hi = a_hi * b_hi;
+			const uint64_t cross = (lo_lo >> 32) + static_cast<uint32_t>(hi_lo) + lo_hi;
+			hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+			return (cross << 32) | static_cast<uint32_t>(lo_lo);
+#endif
+		}
+
+		// Returns a + b + carry and sets carry to 1 if that overflowed, 0 otherwise.
+		[[nodiscard]] static SOUP_FORCEINLINE uint64_t addCarry(uint64_t a, uint64_t b, uint64_t& carry) noexcept
+		{
+			const uint64_t sum = a + b;
+			const uint64_t res = sum + carry;
+			carry = (sum < a) | (res < sum);
+			return res;
+		}
+
+		// Returns a - b - borrow and sets borrow to 1 if that underflowed, 0 otherwise.
+		[[nodiscard]] static SOUP_FORCEINLINE uint64_t subBorrow(uint64_t a, uint64_t b, uint64_t& borrow) noexcept
+		{
+			const uint64_t diff = a - b;
+			const uint64_t res = diff - borrow;
+			borrow = (a < b) | (diff < borrow);
+			return res;
+		}
+	};
+}
@@ -0,0 +1,265 @@
+#include "memPoolAllocator.hpp"
+
+#include <atomic>
+#include <cstdint> // uintptr_t
+#include <cstdlib> // malloc, realloc, free
+#include <cstring> // memcpy
+
+NAMESPACE_SOUP
+{
+	memPoolAllocator g_pool_allocator = memPoolAllocator();
+
+	// Size classes are 16 bytes apart up to 256 bytes, then 64 bytes apart up to 512 bytes, then 128 bytes apart up to 1024 bytes.
+	static constexpr size_t NUM_CLASSES = 24;
+	static constexpr size_t CHUNK_SIZE = 0x8000;
+
+	[[nodiscard]] static constexpr size_t getClassIndex(size_t size) noexcept
+	{
+		if (size <= 256)
+		{
+			return size == 0 ? 0 : (size - 1) / 16;
+		}
+		if (size <= 512)
+		{
+			return 16 + (size - 257) / 64;
+		}
+		return 20 + (size - 513) / 128;
+	}
+
+	[[nodiscard]] static constexpr size_t getClassSize(size_t index) noexcept
+	{
+		if (index < 16)
+		{
+			return (index + 1) * 16;
+		}
+		if (index < 20)
+		{
+			return 256 + (index - 15) * 64;
+		}
+		return 512 + (index - 19) * 128;
+	}
+
+	static_assert(getClassSize(NUM_CLASSES - 1) == memPoolAllocator::MAX_SIZE);
+	static_assert(getClassIndex(memPoolAllocator::MAX_SIZE) == NUM_CLASSES - 1);
+
+	struct memPoolThreadCache;
+
+	// Precedes every block, so the size class and owner can be found when it is freed.
+	struct alignas(16) memPoolBlockHeader
+	{
+		memPoolThreadCache* owner; // nullptr if the block was allocated by malloc
+		uint32_t size; // usable size
+		uint32_t size_class;
+	};
+	static_assert(sizeof(memPoolBlockHeader) == 16);
+
+	// Free blocks are kept in intrusive lists, with the first bytes of each block pointing to the next one.
+	struct memPoolThreadCache
+	{
+		void* free_list[NUM_CLASSES]{};
+		std::atomic<void*> remote_free[NUM_CLASSES]{}; // blocks freed by other threads
+		char* bump[NUM_CLASSES]{}; // where the next block of each size class will be carved out of the current chunk
+		char* bump_end[NUM_CLASSES]{};
+		void* chunks = nullptr; // each chunk starts with a pointer to the previous one
+		memPoolThreadCache* next_orphan = nullptr;
+
+		[[nodiscard]] void* allocate(size_t size_class) SOUP_EXCAL
+		{
+			void* block = free_list[size_class];
+			SOUP_IF_UNLIKELY (block == nullptr)
+			{
+				if (remote_free[size_class].load(std::memory_order_relaxed) == nullptr)
+				{
+					return carve(size_class);
+				}
+				block = remote_free[size_class].exchange(nullptr, std::memory_order_acquire);
+			}
+			free_list[size_class] = *reinterpret_cast<void**>(block);
+			return block;
+		}
+
+		void deallocate(void* block, size_t size_class) noexcept
+		{
+			*reinterpret_cast<void**>(block) = free_list[size_class];
+			free_list[size_class] = block;
+		}
+
+		void deallocateRemote(void* block, size_t size_class) noexcept
+		{
+			void* head = remote_free[size_class].load(std::memory_order_relaxed);
+			do
+			{
+				*reinterpret_cast<void**>(block) = head;
+			} while (!remote_free[size_class].compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		[[nodiscard]] void* carve(size_t size_class) SOUP_EXCAL
+		{
+			const size_t size = getClassSize(size_class);
+			const size_t stride = sizeof(memPoolBlockHeader) + size;
+			SOUP_IF_UNLIKELY (static_cast<size_t>(bump_end[size_class] - bump[size_class]) < stride)
+			{
+				void* const chunk = ::malloc(CHUNK_SIZE);
+				SOUP_IF_UNLIKELY (chunk == nullptr)
+				{
+					SOUP_THROW(std::bad_alloc{});
+				}
+				*reinterpret_cast<void**>(chunk) = chunks;
+				chunks = chunk;
+				bump[size_class] = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(chunk) + sizeof(void*) + 15) & ~static_cast<uintptr_t>(15));
+				bump_end[size_class] = reinterpret_cast<char*>(chunk) + CHUNK_SIZE;
+			}
+			auto header = reinterpret_cast<memPoolBlockHeader*>(bump[size_class]);
+			bump[size_class] += stride;
+			header->owner = this;
+			header->size = static_cast<uint32_t>(size);
+			header->size_class = static_cast<uint32_t>(size_class);
+			return header + 1;
+		}
+	};
+
+	// Caches are never destroyed since blocks may still be handed back to them, so the caches of threads that exited are kept here.
+	static std::atomic<memPoolThreadCache*> orphaned_caches{ nullptr };
+
+	static thread_local memPoolThreadCache* this_thread_cache = nullptr;
+	static thread_local bool this_thread_exited = false;
+
+	static void pushOrphans(memPoolThreadCache* first, memPoolThreadCache* last) noexcept
+	{
+		memPoolThreadCache* head = orphaned_caches.load(std::memory_order_relaxed);
+		do
+		{
+			last->next_orphan = head;
+		} while (!orphaned_caches.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	struct memPoolThreadCacheReleaser
+	{
+		~memPoolThreadCacheReleaser() noexcept
+		{
+			// Blocks freed after this point are handed back like any other thread would, and allocations are passed on to malloc.
+			pushOrphans(this_thread_cache, this_thread_cache);
+			this_thread_cache = nullptr;
+			this_thread_exited = true;
+		}
+	};
+	static thread_local memPoolThreadCacheReleaser this_thread_cache_releaser;
+
+	[[nodiscard]] static memPoolThreadCache* acquireCache() SOUP_EXCAL
+	{
+		if (this_thread_exited)
+		{
+			return nullptr;
+		}
+
+		// Taking the whole list and putting back what we don't need avoids the ABA problem of popping a single node.
+		memPoolThreadCache* cache = orphaned_caches.exchange(nullptr, std::memory_order_acquire);
+		if (cache)
+		{
+			if (memPoolThreadCache* rest = cache->next_orphan)
+			{
+				memPoolThreadCache* last = rest;
+				while (last->next_orphan)
+				{
+					last = last->next_orphan;
+				}
+				pushOrphans(rest, last);
+			}
+			cache->next_orphan = nullptr;
+		}
+		else
+		{
+			cache = new memPoolThreadCache();
+		}
+		(void)&this_thread_cache_releaser; // Makes sure the cache is orphaned when this thread exits.
+		this_thread_cache = cache;
+		return cache;
+	}
+
+	void* memPoolAllocator::allocateBlock(size_t size) SOUP_EXCAL
+	{
+		SOUP_IF_LIKELY (size <= MAX_SIZE)
+		{
+			memPoolThreadCache* cache = this_thread_cache;
+			SOUP_IF_UNLIKELY (cache == nullptr)
+			{
+				cache = acquireCache();
+			}
+			SOUP_IF_LIKELY (cache != nullptr)
+			{
+				return cache->allocate(getClassIndex(size));
+			}
+		}
+		SOUP_IF_UNLIKELY (size > UINT32_MAX - sizeof(memPoolBlockHeader))
+		{
+			SOUP_THROW(std::bad_alloc{});
+		}
+		auto header = reinterpret_cast<memPoolBlockHeader*>(::malloc(sizeof(memPoolBlockHeader) + size));
+		SOUP_IF_UNLIKELY (header == nullptr)
+		{
+			SOUP_THROW(std::bad_alloc{});
+		}
+		header->owner = nullptr;
+		header->size = static_cast<uint32_t>(size);
+		return header + 1;
+	}
+
+	void* memPoolAllocator::reallocateBlock(void* addr, size_t new_size) SOUP_EXCAL
+	{
+		if (addr == nullptr)
+		{
+			return allocateBlock(new_size);
+		}
+		auto header = reinterpret_cast<memPoolBlockHeader*>(addr) - 1;
+		if (header->owner)
+		{
+			if (new_size <= header->size)
+			{
+				return addr;
+			}
+		}
+		else if (new_size > MAX_SIZE
+			&& new_size <= UINT32_MAX - sizeof(memPoolBlockHeader)
+			)
+		{
+			header = reinterpret_cast<memPoolBlockHeader*>(::realloc(header, sizeof(memPoolBlockHeader) + new_size));
+			SOUP_IF_UNLIKELY (header == nullptr)
+			{
+				SOUP_THROW(std::bad_alloc{});
+			}
+			header->size = static_cast<uint32_t>(new_size);
+			return header + 1;
+		}
+		void* const block = allocateBlock(new_size);
+		memcpy(block, addr, header->size < new_size ? header->size : new_size);
+		deallocateBlock(addr);
+		return block;
+	}
+
+	void memPoolAllocator::deallocateBlock(void* addr) noexcept
+	{
+		if (addr == nullptr)
+		{
+			return;
+		}
+		auto header = reinterpret_cast<memPoolBlockHeader*>(addr) - 1;
+		memPoolThreadCache* const owner = header->owner;
+		SOUP_IF_UNLIKELY (owner == nullptr)
+		{
+			::free(header);
+		}
+		else SOUP_IF_LIKELY (owner == this_thread_cache)
+		{
+			owner->deallocate(addr, header->size_class);
+		}
+		else
+		{
+			owner->deallocateRemote(addr, header->size_class);
+		}
+	}
+
+	size_t memPoolAllocator::getUsableSize(void* addr) noexcept
+	{
+		return (reinterpret_cast<memPoolBlockHeader*>(addr) - 1)->size;
+	}
+}
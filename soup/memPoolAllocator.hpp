@@ -0,0 +1,86 @@
+#pragma once
+
+#include "memAllocator.hpp"
+
+#include <new> // align_val_t
+
+// If enabled, SharedPtr control blocks, Capture payloads, AtomicDeque nodes and Workers are allocated via the pool allocator.
+#ifndef SOUP_USE_POOL_ALLOCATOR
+#define SOUP_USE_POOL_ALLOCATOR false
+#endif
+
+NAMESPACE_SOUP
+{
+	// Serves small allocations from size classes, with each thread having its own cache, so they usually don't need any synchronisation.
+	// A block freed by a thread other than the one that allocated it is handed back to the owning cache via a lock-free list,
+	// so objects can be freely passed between threads. Allocations bigger than MAX_SIZE are passed on to malloc.
+	// Memory is kept for reuse rather than being given back to the system, and the cache of a thread that exits is adopted by the next new thread.
+	class memPoolAllocator : public memAllocator
+	{
+	public:
+		static constexpr size_t MAX_SIZE = 1024;
+
+		constexpr memPoolAllocator() noexcept
+			: memAllocator(&allocateImpl, &reallocateImpl, &deallocateImpl)
+		{
+		}
+
+		[[nodiscard]] static void* allocateBlock(size_t size) SOUP_EXCAL;
+		[[nodiscard]] static void* reallocateBlock(void* addr, size_t new_size) SOUP_EXCAL;
+		static void deallocateBlock(void* addr) noexcept;
+
+		// Returns how many bytes can be used at the given address, which was returned by this allocator.
+		[[nodiscard]] static size_t getUsableSize(void* addr) noexcept;
+
+	protected:
+		static void* allocateImpl(memAllocator*, size_t size) /* SOUP_EXCAL */
+		{
+			return allocateBlock(size);
+		}
+
+		static void* reallocateImpl(memAllocator*, void* addr, size_t new_size) /* SOUP_EXCAL */
+		{
+			return reallocateBlock(addr, new_size);
+		}
+
+		static void deallocateImpl(memAllocator*, void* addr) noexcept
+		{
+			deallocateBlock(addr);
+		}
+	};
+
+	extern memPoolAllocator g_pool_allocator;
+
+	// Inheriting from this makes 'new' and 'delete' use the pool allocator.
+	struct memPoolAllocated
+	{
+		[[nodiscard]] static void* operator new(size_t size) SOUP_EXCAL
+		{
+			return memPoolAllocator::allocateBlock(size);
+		}
+
+		static void operator delete(void* addr) noexcept
+		{
+			memPoolAllocator::deallocateBlock(addr);
+		}
+
+		// The pool can't satisfy bigger alignments, so those go to the global allocator.
+
+		[[nodiscard]] static void* operator new(size_t size, std::align_val_t al)
+		{
+			return ::operator new(size, al);
+		}
+
+		static void operator delete(void* addr, std::align_val_t al) noexcept
+		{
+			::operator delete(addr, al);
+		}
+	};
+
+	// Inheriting from this makes 'new' and 'delete' use the pool allocator, if SOUP_USE_POOL_ALLOCATOR is enabled.
+#if SOUP_USE_POOL_ALLOCATOR
+	using memPooled = memPoolAllocated;
+#else
+	struct memPooled {};
+#endif
+}
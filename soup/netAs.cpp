@@ -12,11 +12,11 @@ NAMESPACE_SOUP
 		WasmScript ws;
 		SOUP_IF_LIKELY (ws.load(intel.extra_wasm))
 		{
-			if (auto code = ws.getExportedFuntion("is_hosting_asn"))
+			if (auto func_index = ws.getExportedFunctionIndex("is_hosting_asn"); func_index != -1)
 			{
 				WasmVm vm(ws);
 				vm.locals.emplace_back(this->number);
-				if (vm.run(*code)
+				if (vm.run(func_index)
 					&& vm.stack.top().i32
 					)
 				{
@@ -24,7 +24,7 @@ NAMESPACE_SOUP
 				}
 			}
 
-			if (auto code = ws.getExportedFuntion("is_hosting_slug"))
+			if (auto func_index = ws.getExportedFunctionIndex("is_hosting_slug"); func_index != -1)
 			{
 				std::string slug = this->handle;
 				slug.push_back(' ');
@@ -36,7 +36,7 @@ NAMESPACE_SOUP
 				{
 					WasmVm vm(ws);
 					vm.locals.emplace_back(scrap);
-					if (vm.run(*code)
+					if (vm.run(func_index)
 						&& vm.stack.top().i32
 						)
 					{
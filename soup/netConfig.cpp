@@ -6,10 +6,16 @@
 #include "dnsSmartResolver.hpp"
 #endif
 #include "Socket.hpp"
+#if !SOUP_WASM
+#include "TlsSessionCache.hpp"
+#endif
 
 NAMESPACE_SOUP
 {
 	static thread_local netConfig netConfig_inst;
+#if !SOUP_WASM
+	static TlsSessionCache default_tls_session_cache;
+#endif
 
 	netConfig& netConfig::get()
 	{
@@ -34,7 +40,7 @@ NAMESPACE_SOUP
 
 	netConfig::netConfig()
 #if !SOUP_WASM
-		: certchain_validator(&Socket::certchain_validator_default)
+		: certchain_validator(&Socket::certchain_validator_default), tls_session_cache(&default_tls_session_cache)
 #endif
 	{
 	}
@@ -18,6 +18,7 @@ NAMESPACE_SOUP
 		UniquePtr<dnsResolver> dns_resolver;
 #if !SOUP_WASM
 		certchain_validator_t certchain_validator;
+		TlsSessionCache* tls_session_cache; // Used by Socket::enableCryptoClient. Defaults to a cache shared by all threads, may be set to nullptr to disable session resumption.
 #endif
 
 		[[nodiscard]] dnsResolver& getDnsResolver() SOUP_EXCAL;
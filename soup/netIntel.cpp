@@ -115,10 +115,10 @@ NAMESPACE_SOUP
 		WasmScript ws;
 		SOUP_IF_LIKELY (ws.load(extra_wasm))
 		{
-			if (auto code = ws.getExportedFuntion("asn_name_overwrites"))
+			if (auto func_index = ws.getExportedFunctionIndex("asn_name_overwrites"); func_index != -1)
 			{
 				WasmVm vm(ws);
-				if (vm.run(*code))
+				if (vm.run(func_index))
 				{
 					while (!vm.stack.empty())
 					{
@@ -9,6 +9,7 @@ NAMESPACE_SOUP
 {
 	struct parallel
 	{
+		// Runs on ThreadPool::getDefault(). See ThreadPool for more fine-grained control.
 		static void iterateRange(unsigned int size, void(*callback)(unsigned int, const Capture&), const Capture& cap = {});
 	};
 }
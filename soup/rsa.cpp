@@ -105,16 +105,14 @@ NAMESPACE_SOUP
 	// KeyMontgomeryData
 
 	RsaKeyMontgomeryData::RsaKeyMontgomeryData(const Bigint& n)
-		: re(n.montgomeryREFromM()),
-		r(Bigint::montgomeryRFromRE(re)),
-		one_mont(r.modUnsignedNotpowerof2(n))
+		: ctx(n)
 	{
-		Bigint::modMulInv2Coprimes(n, r, n_mod_mul_inv, r_mod_mul_inv);
 	}
 
 	Bigint RsaKeyMontgomeryData::modPow(const Bigint& n, const Bigint& e, const Bigint& x) const SOUP_EXCAL
 	{
-		return x.modPowMontgomery(e, re, r, n, r_mod_mul_inv, n_mod_mul_inv, one_mont);
+		SOUP_DEBUG_ASSERT(n == ctx.modulus);
+		return ctx.modPow(x, e);
 	}
 
 	// PublicKey
@@ -135,7 +133,7 @@ NAMESPACE_SOUP
 
 	Bigint RsaPublicKey::modPow(const Bigint& x) const SOUP_EXCAL
 	{
-		return x.modPowBasic(e, n);
+		return x.modPowMontgomery(e, n);
 	}
 
 	// LonglivedPublicKey
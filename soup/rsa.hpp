@@ -4,6 +4,7 @@
 
 #include "Bigint.hpp"
 #include "JsonObject.hpp"
+#include "MontgomeryContext.hpp"
 
 NAMESPACE_SOUP
 {
@@ -112,11 +113,7 @@ NAMESPACE_SOUP
 
 	struct RsaKeyMontgomeryData
 	{
-		size_t re{};
-		Bigint r{};
-		Bigint n_mod_mul_inv{};
-		Bigint r_mod_mul_inv{};
-		Bigint one_mont{};
+		MontgomeryContext ctx{};
 
 		RsaKeyMontgomeryData() noexcept = default;
 		RsaKeyMontgomeryData(const Bigint& n);
@@ -125,9 +122,9 @@ NAMESPACE_SOUP
 	};
 
 	/*
-	* In the case of an 1024-bit rsa public key, using a long-lived instance takes ~134ms, but performs operations in ~2ms, compared to
-	* ~12ms using a short-lived instance. From these numbers, we can estimate that a long-lived instance is the right choice for rsa public
-	* keys that are (expected to be) used more than 13 times.
+	* In the case of an 1024-bit rsa public key, using a long-lived instance takes ~0.15ms, but performs operations in ~0.05ms, compared to
+	* ~0.2ms using a short-lived instance. From these numbers, we can estimate that a long-lived instance is the right choice for rsa public
+	* keys that are (expected to be) used more than once.
 	*/
 	struct RsaPublicKeyLonglived : public RsaPublicKeyBase<RsaPublicKeyLonglived>
 	{
@@ -130,7 +130,12 @@ NAMESPACE_SOUP
 
 		appendByte(0x80);
 
-		while (buffer_counter != 120)
+		// The message length is encoded as a 128-bit integer, of which we only track the lower 64 bits.
+		while (buffer_counter != 112)
+		{
+			appendByte(0);
+		}
+		for (int i = 0; i != 8; ++i)
 		{
 			appendByte(0);
 		}
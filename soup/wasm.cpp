@@ -1,5 +1,7 @@
 #include "wasm.hpp"
 
+#include <algorithm> // copy
+#include <cstddef> // offsetof
 #include <cstring> // memset
 
 #include "alloc.hpp"
@@ -7,6 +9,14 @@
 #include "MemoryRefReader.hpp"
 #include "Reader.hpp"
 
+#if SOUP_X86 && SOUP_BITS == 64
+#include "AllocRaiiVirtual.hpp"
+#include "AssemblyBuilder.hpp"
+#include "CpuInfo.hpp"
+#include "UniquePtr.hpp"
+#include "x64.hpp"
+#endif
+
 #define DEBUG_LOAD false
 #define DEBUG_VM false
 
@@ -15,12 +25,136 @@
 #include "string.hpp"
 #endif
 
+// Operations of translated functions. Memory and numeric operations correspond to a WASM opcode and take a fixed number of operands.
+#define FOR_EACH_WASM_OP(op, mem_op, num_op) \
+op(UNREACHABLE) \
+op(BR) \
+op(BR_IF) \
+op(BR_TABLE) \
+op(IF) \
+op(LOOP) \
+op(RETURN) \
+op(CALL) \
+op(CALL_IMPORT) \
+op(CALL_INDIRECT) \
+op(DROP) \
+op(SELECT) \
+op(LOCAL_GET) \
+op(LOCAL_SET) \
+op(LOCAL_TEE) \
+op(GLOBAL_GET) \
+op(GLOBAL_SET) \
+op(MEMORY_SIZE) \
+op(MEMORY_GROW) \
+op(CONST) \
+mem_op(I32_LOAD, 0x28, 1, 1) \
+mem_op(I64_LOAD, 0x29, 1, 1) \
+mem_op(F32_LOAD, 0x2a, 1, 1) \
+mem_op(F64_LOAD, 0x2b, 1, 1) \
+mem_op(I32_LOAD8_S, 0x2c, 1, 1) \
+mem_op(I32_LOAD8_U, 0x2d, 1, 1) \
+mem_op(I32_LOAD16_S, 0x2e, 1, 1) \
+mem_op(I32_LOAD16_U, 0x2f, 1, 1) \
+mem_op(I64_LOAD8_S, 0x30, 1, 1) \
+mem_op(I64_LOAD8_U, 0x31, 1, 1) \
+mem_op(I64_LOAD16_S, 0x32, 1, 1) \
+mem_op(I64_LOAD16_U, 0x33, 1, 1) \
+mem_op(I64_LOAD32_S, 0x34, 1, 1) \
+mem_op(I64_LOAD32_U, 0x35, 1, 1) \
+mem_op(I32_STORE, 0x36, 2, 0) \
+mem_op(I64_STORE, 0x37, 2, 0) \
+mem_op(F32_STORE, 0x38, 2, 0) \
+mem_op(F64_STORE, 0x39, 2, 0) \
+mem_op(I32_STORE8, 0x3a, 2, 0) \
+mem_op(I32_STORE16, 0x3b, 2, 0) \
+num_op(I32_EQZ, 0x45, 1) \
+num_op(I32_EQ, 0x46, 2) \
+num_op(I32_NE, 0x47, 2) \
+num_op(I32_LT_S, 0x48, 2) \
+num_op(I32_LT_U, 0x49, 2) \
+num_op(I32_GT_S, 0x4a, 2) \
+num_op(I32_GT_U, 0x4b, 2) \
+num_op(I32_LE_S, 0x4c, 2) \
+num_op(I32_LE_U, 0x4d, 2) \
+num_op(I32_GE_S, 0x4e, 2) \
+num_op(I32_GE_U, 0x4f, 2) \
+num_op(I64_EQZ, 0x50, 1) \
+num_op(I64_EQ, 0x51, 2) \
+num_op(I64_NE, 0x52, 2) \
+num_op(I64_LT_S, 0x53, 2) \
+num_op(I64_LT_U, 0x54, 2) \
+num_op(I64_GT_S, 0x55, 2) \
+num_op(I64_GT_U, 0x56, 2) \
+num_op(I64_LE_S, 0x57, 2) \
+num_op(I64_LE_U, 0x58, 2) \
+num_op(I64_GE_S, 0x59, 2) \
+num_op(I64_GE_U, 0x5a, 2) \
+num_op(F32_EQ, 0x5b, 2) \
+num_op(F32_NE, 0x5c, 2) \
+num_op(F32_LT, 0x5d, 2) \
+num_op(F32_GT, 0x5e, 2) \
+num_op(F32_LE, 0x5f, 2) \
+num_op(F32_GE, 0x60, 2) \
+num_op(F64_EQ, 0x61, 2) \
+num_op(F64_NE, 0x62, 2) \
+num_op(F64_LT, 0x63, 2) \
+num_op(F64_GT, 0x64, 2) \
+num_op(F64_LE, 0x65, 2) \
+num_op(F64_GE, 0x66, 2) \
+num_op(I32_POPCNT, 0x69, 1) \
+num_op(I32_ADD, 0x6a, 2) \
+num_op(I32_SUB, 0x6b, 2) \
+num_op(I32_MUL, 0x6c, 2) \
+num_op(I32_DIV_S, 0x6d, 2) \
+num_op(I32_DIV_U, 0x6e, 2) \
+num_op(I32_REM_S, 0x6f, 2) \
+num_op(I32_REM_U, 0x70, 2) \
+num_op(I32_AND, 0x71, 2) \
+num_op(I32_OR, 0x72, 2) \
+num_op(I32_XOR, 0x73, 2) \
+num_op(I32_SHL, 0x74, 2) \
+num_op(I32_SHR_S, 0x75, 2) \
+num_op(I32_SHR_U, 0x76, 2) \
+num_op(I64_ADD, 0x7c, 2) \
+num_op(I64_SUB, 0x7d, 2) \
+num_op(I64_MUL, 0x7e, 2) \
+num_op(I64_DIV_S, 0x7f, 2) \
+num_op(I64_DIV_U, 0x80, 2) \
+num_op(I64_REM_S, 0x81, 2) \
+num_op(I64_REM_U, 0x82, 2) \
+num_op(I64_AND, 0x83, 2) \
+num_op(I64_OR, 0x84, 2) \
+num_op(I64_XOR, 0x85, 2) \
+num_op(I64_SHL, 0x86, 2) \
+num_op(I64_SHR_S, 0x87, 2) \
+num_op(I64_SHR_U, 0x88, 2) \
+num_op(F32_ADD, 0x92, 2) \
+num_op(F32_SUB, 0x93, 2) \
+num_op(F32_MUL, 0x94, 2) \
+num_op(F32_DIV, 0x95, 2) \
+num_op(F64_ADD, 0xa0, 2) \
+num_op(F64_SUB, 0xa1, 2) \
+num_op(F64_MUL, 0xa2, 2) \
+num_op(F64_DIV, 0xa3, 2) \
+num_op(I32_WRAP_I64, 0xa7, 1) \
+num_op(I64_EXTEND_I32_S, 0xac, 1) \
+num_op(I64_EXTEND_I32_U, 0xad, 1)
+
+#define WASM_OP_ENUM(name) OP_##name,
+#define WASM_MEM_OP_ENUM(name, code, pops, pushes) OP_##name,
+#define WASM_NUM_OP_ENUM(name, code, pops) OP_##name,
+
 // Good resources:
 // - https://webassembly.github.io/wabt/demo/wat2wasm/
 // - https://github.com/sunfishcode/wasm-reference-manual/blob/master/WebAssembly.md
 
 NAMESPACE_SOUP
 {
+	enum WasmOp : uint16_t
+	{
+		FOR_EACH_WASM_OP(WASM_OP_ENUM, WASM_MEM_OP_ENUM, WASM_NUM_OP_ENUM)
+	};
+
 	// WasmScript
 
 	WasmScript::~WasmScript() noexcept
@@ -29,6 +163,12 @@ NAMESPACE_SOUP
 		{
 			soup::free(memory);
 		}
+#if SOUP_X86 && SOUP_BITS == 64
+		for (const auto& fn : compiled)
+		{
+			delete fn.native.load();
+		}
+#endif
 	}
 
 	bool WasmScript::load(const std::string& data)
@@ -125,8 +265,8 @@ NAMESPACE_SOUP
 						uint8_t kind; r.u8(kind);
 						if (kind == 0) // function
 						{
-							size_t type_index; r.oml(type_index);
-							function_imports.emplace_back(FunctionImport{ std::move(module_name), std::move(field_name), nullptr });
+							uint32_t type_index; r.oml(type_index);
+							function_imports.emplace_back(FunctionImport{ std::move(module_name), std::move(field_name), nullptr, type_index });
 						}
 					}
 				}
@@ -342,6 +482,17 @@ NAMESPACE_SOUP
 				r.oml(section_size);
 			}
 		}
+
+		compiled = std::vector<CompiledFunction>(code.size());
+		for (size_t i = 0; i != code.size() && i != functions.size(); ++i)
+		{
+			compiled[i].type_index = functions[i];
+			if (!translate(compiled[i], code[i]))
+			{
+				// We'll have to interpret the bytecode instead.
+				compiled[i].instructions.clear();
+			}
+		}
 		return true;
 	}
 
@@ -360,16 +511,26 @@ NAMESPACE_SOUP
 	}
 
 	const std::string* WasmScript::getExportedFuntion(const std::string& name) const noexcept
+	{
+		const size_t i = getExportedFunctionIndex(name);
+		if (i != -1)
+		{
+			return &code.at(i);
+		}
+		return nullptr;
+	}
+
+	size_t WasmScript::getExportedFunctionIndex(const std::string& name) const noexcept
 	{
 		if (auto e = export_map.find(name); e != export_map.end())
 		{
 			const size_t i = (e->second - function_imports.size());
 			if (i < code.size())
 			{
-				return &code.at(i);
+				return i;
 			}
 		}
-		return nullptr;
+		return -1;
 	}
 
 	size_t WasmScript::allocateMemory(size_t len) noexcept
@@ -400,6 +561,21 @@ NAMESPACE_SOUP
 			;
 	}
 
+	WasmValue WasmScript::growMemory(WasmValue delta) noexcept
+	{
+		size_t bytes = (memory64 ? static_cast<size_t>(static_cast<uint64_t>(delta.i64)) : static_cast<size_t>(static_cast<uint32_t>(delta.i32)));
+		bytes *= 0x10'000;
+		size_t res = -1;
+		if (auto nmem = (uint8_t*)::realloc(memory, memory_size + bytes))
+		{
+			memset(&nmem[memory_size], 0, bytes);
+			res = memory_size / 0x10'000;
+			memory = nmem;
+			memory_size += bytes;
+		}
+		return memory64 ? WasmValue(static_cast<uint64_t>(res)) : WasmValue(static_cast<uint32_t>(res));
+	}
+
 	void WasmScript::linkWasiPreview1() noexcept
 	{
 		// Resources:
@@ -500,130 +676,231 @@ NAMESPACE_SOUP
 		return static_cast<size_t>(ptr);
 	}
 
-	// WasmVm
-
-	bool WasmVm::run(const std::string& data) SOUP_EXCAL
+	bool WasmScript::translate(CompiledFunction& fn, const std::string& body) const SOUP_EXCAL
 	{
-		MemoryRefReader r(data);
-		return run(r);
-	}
+		MemoryRefReader r(body);
 
-	bool WasmVm::run(Reader& r) SOUP_EXCAL
-	{
-		size_t local_decl_count;
+		uint32_t local_decl_count;
 		r.oml(local_decl_count);
 		while (local_decl_count--)
 		{
-			size_t type_count;
+			uint32_t type_count;
 			r.oml(type_count);
 			uint8_t type;
 			r.u8(type);
-			SOUP_UNUSED(type);
-			// type 0x7f = i32
-			// type 0x7e = i64
-			while (type_count--)
+			SOUP_IF_UNLIKELY (type_count > 0x10'000 - fn.num_locals)
 			{
-				locals.emplace_back();
+				return false;
 			}
+			fn.num_locals += type_count;
+		}
+		SOUP_IF_UNLIKELY (fn.type_index >= types.size())
+		{
+			return false;
 		}
+		const FunctionType& type = types[fn.type_index];
+		const uint32_t num_locals = type.num_parameters + fn.num_locals;
 
-		std::stack<CtrlFlowEntry> ctrlflow{};
+		// Since we know the height of the stack at every instruction, branches can be resolved to "drop n values, keep m, jump to x".
+		struct Block
+		{
+			uint32_t height;
+			uint32_t branch_arity;
+			uint32_t end_arity;
+			uint32_t loop_start; // -1 if this is not a loop
+			uint32_t if_instruction; // -1 if this is not an 'if' or its 'else' has been seen
+			std::vector<uint32_t> fixups{}; // branches to the end of this block
+		};
+		std::vector<Block> blocks{};
+		blocks.emplace_back(Block{ 0, type.num_results, type.num_results, (uint32_t)-1, (uint32_t)-1 });
+
+		auto& out = fn.instructions;
+		uint32_t height = 0;
+		bool reachable = true;
+		uint32_t unreachable_depth = 0; // blocks opened in unreachable code
+
+		auto emit = [&](uint16_t op, uint32_t a = 0, WasmValue b = {}) -> uint32_t
+		{
+			out.emplace_back(Instruction{ op, 0, a, b });
+			return static_cast<uint32_t>(out.size() - 1);
+		};
+		auto pop = [&](uint32_t n)
+		{
+			if (height < blocks.back().height + n)
+			{
+				return false;
+			}
+			height -= n;
+			return true;
+		};
+		auto push = [&](uint32_t n)
+		{
+			height += n;
+			if (height > fn.max_stack)
+			{
+				fn.max_stack = height;
+			}
+		};
+		auto branch = [&](uint16_t op, uint32_t depth)
+		{
+			if (depth >= blocks.size())
+			{
+				return false;
+			}
+			Block& target = blocks[blocks.size() - 1 - depth];
+			if (height < target.height + target.branch_arity)
+			{
+				return false;
+			}
+			const uint32_t i = emit(op, height - target.height - target.branch_arity);
+			out[i].arity = static_cast<uint16_t>(target.branch_arity);
+			if (target.loop_start != -1)
+			{
+				out[i].b = target.loop_start;
+			}
+			else
+			{
+				target.fixups.emplace_back(i);
+			}
+			return true;
+		};
+		auto read_block_type = [&](uint32_t& arity)
+		{
+			uint8_t block_type;
+			r.u8(block_type);
+			if (block_type == 0x40) // void
+			{
+				arity = 0;
+				return true;
+			}
+			arity = 1;
+			return (block_type >= 0x7b && block_type <= 0x7f) || block_type == 0x70 || block_type == 0x6f; // single value, not a type index
+		};
 
 		uint8_t op;
 		while (r.u8(op))
 		{
+			if (!reachable)
+			{
+				// Code after an unconditional branch doesn't need to be translated, but we still need to find the end of the block.
+				if (op == 0x02 || op == 0x03 || op == 0x04) // block, loop, if
+				{
+					r.skip(1); // result type
+					++unreachable_depth;
+					continue;
+				}
+				if (op == 0x05 || op == 0x0b) // else, end
+				{
+					if (unreachable_depth != 0)
+					{
+						unreachable_depth -= (op == 0x0b);
+						continue;
+					}
+				}
+				else
+				{
+					SOUP_RETHROW_FALSE(skipImmediates(r, op));
+					continue;
+				}
+			}
+
 			switch (op)
 			{
 			default:
-#if DEBUG_VM
-				std::cout << "Unsupported opcode: " << string::hex(op) << "\n";
-#endif
 				return false;
 
 			case 0x00: // unreachable
-#if DEBUG_VM
-				std::cout << "unreachable\n";
-#endif
-				return false;
+				if (reachable)
+				{
+					emit(OP_UNREACHABLE);
+					reachable = false;
+				}
+				break;
 
 			case 0x01: // nop
 				break;
 
 			case 0x02: // block
+			case 0x03: // loop
 				{
-					uint8_t result_type; r.u8(result_type);
-					bool has_result = (result_type != /* void */ 0x40);
-					ctrlflow.emplace(CtrlFlowEntry{ (size_t)-1, stack.size() + has_result });
-#if DEBUG_VM
-					std::cout << "block at position " << r.getPosition() << " with stack size " << stack.size() << "\n";
-#endif
+					uint32_t arity;
+					SOUP_RETHROW_FALSE(read_block_type(arity));
+					blocks.emplace_back(Block{ height, op == 0x03 ? 0 : arity, arity, op == 0x03 ? static_cast<uint32_t>(out.size()) : (uint32_t)-1, (uint32_t)-1 });
+					if (op == 0x03)
+					{
+						emit(OP_LOOP);
+					}
 				}
 				break;
 
-			case 0x03: // loop
+			case 0x04: // if
 				{
-					uint8_t result_type; r.u8(result_type);
-					bool has_result = (result_type != /* void */ 0x40);
-					ctrlflow.emplace(CtrlFlowEntry{ r.getPosition(), stack.size() + has_result });
-#if DEBUG_VM
-					std::cout << "loop at position " << r.getPosition() << " with stack size " << stack.size() << "\n";
-#endif
+					uint32_t arity;
+					SOUP_RETHROW_FALSE(read_block_type(arity));
+					SOUP_RETHROW_FALSE(pop(1));
+					blocks.emplace_back(Block{ height, arity, arity, (uint32_t)-1, emit(OP_IF) });
 				}
 				break;
 
-			case 0x04: // if
+			case 0x05: // else
 				{
-					uint8_t result_type; r.u8(result_type);
-					bool has_result = (result_type != /* void */ 0x40);
-					auto value = stack.top(); stack.pop();
-					//std::cout << "if: condition is " << (value.i32 ? "true" : "false") << "\n";
-					if (value.i32)
+					Block& block = blocks.back();
+					SOUP_IF_UNLIKELY (block.if_instruction == -1)
 					{
-						ctrlflow.emplace(CtrlFlowEntry{ r.getPosition(), stack.size() + has_result });
+						return false;
 					}
-					else
+					if (reachable)
 					{
-						if (skipOverBranch(r))
+						SOUP_IF_UNLIKELY (height != block.height + block.end_arity)
 						{
-							// we're in the 'else' branch
-							ctrlflow.emplace(CtrlFlowEntry{ r.getPosition(), stack.size() + has_result });
-						}
-						else
-						{
-							// we're after the 'end'
-							SOUP_IF_UNLIKELY (has_result)
-							{
-#if DEBUG_VM
-								std::cout << "if: has result but no 'else' clause\n";
-#endif
-								return false;
-							}
+							return false;
 						}
+						block.fixups.emplace_back(emit(OP_BR));
 					}
+					out[block.if_instruction].b = static_cast<uint32_t>(out.size());
+					block.if_instruction = -1;
+					height = block.height;
+					reachable = true;
 				}
 				break;
 
-			case 0x05: // else
-				//std::cout << "else: skipping over this branch\n";
-				skipOverBranch(r);
-				[[fallthrough]];
 			case 0x0b: // end
-				if (ctrlflow.empty())
 				{
-					return true;
+					Block& block = blocks.back();
+					SOUP_IF_UNLIKELY (reachable && height != block.height + block.end_arity)
+					{
+						return false;
+					}
+					if (block.if_instruction != -1)
+					{
+						SOUP_IF_UNLIKELY (block.end_arity != 0) // 'if' with a result but without 'else'
+						{
+							return false;
+						}
+						out[block.if_instruction].b = static_cast<uint32_t>(out.size());
+					}
+					for (const auto& i : block.fixups)
+					{
+						out[i].b = static_cast<uint32_t>(out.size());
+					}
+					height = block.height;
+					push(block.end_arity);
+					reachable = true;
+					blocks.pop_back();
+					if (blocks.empty())
+					{
+						emit(OP_RETURN, type.num_results);
+						return !r.hasMore();
+					}
 				}
-				ctrlflow.pop();
-				//std::cout << "ctrlflow stack now has " << ctrlflow.size() << " entries\n";
 				break;
 
 			case 0x0c: // br
 				{
 					uint32_t depth;
 					r.oml(depth);
-					SOUP_IF_UNLIKELY (!doBranch(r, depth, ctrlflow))
-					{
-						return false;
-					}
+					SOUP_RETHROW_FALSE(branch(OP_BR, depth));
+					reachable = false;
 				}
 				break;
 
@@ -631,78 +908,63 @@ NAMESPACE_SOUP
 				{
 					uint32_t depth;
 					r.oml(depth);
-					auto value = stack.top(); stack.pop();
-					if (value.i32)
-					{
-						SOUP_IF_UNLIKELY (!doBranch(r, depth, ctrlflow))
-						{
-							return false;
-						}
-					}
+					SOUP_RETHROW_FALSE(pop(1));
+					SOUP_RETHROW_FALSE(branch(OP_BR_IF, depth));
 				}
 				break;
 
 			case 0x0e: // br_table
 				{
-					std::vector<uint32_t> table;
 					uint32_t num_branches;
 					r.oml(num_branches);
-					table.reserve(num_branches);
-					while (num_branches--)
+					SOUP_RETHROW_FALSE(pop(1));
+					emit(OP_BR_TABLE, num_branches);
+					// Followed by a branch for every index, and the default branch.
+					for (uint32_t i = 0; i != num_branches + 1; ++i)
 					{
 						uint32_t depth;
 						r.oml(depth);
-						table.emplace_back(depth);
-					}
-					uint32_t depth;
-					r.oml(depth);
-					auto index = static_cast<uint32_t>(stack.top().i32); stack.pop();
-					if (index < table.size())
-					{
-						depth = table.at(index);
-					}
-					SOUP_IF_UNLIKELY (!doBranch(r, depth, ctrlflow))
-					{
-						return false;
+						SOUP_RETHROW_FALSE(branch(OP_BR, depth));
 					}
+					reachable = false;
 				}
 				break;
 
 			case 0x0f: // return
-				return true;
+				SOUP_IF_UNLIKELY (height < type.num_results)
+				{
+					return false;
+				}
+				emit(OP_RETURN, type.num_results);
+				reachable = false;
+				break;
 
 			case 0x10: // call
 				{
 					uint32_t function_index;
 					r.oml(function_index);
-					if (function_index < script.function_imports.size())
+					uint32_t type_index;
+					if (function_index < function_imports.size())
 					{
-#if DEBUG_VM
-						std::cout << "Calling into " << script.function_imports.at(function_index).module_name << ":" << script.function_imports.at(function_index).function_name << "\n";
-#endif
-						SOUP_IF_UNLIKELY (script.function_imports.at(function_index).ptr == nullptr)
+						type_index = function_imports[function_index].type_index;
+						emit(OP_CALL_IMPORT, function_index);
+					}
+					else
+					{
+						function_index -= static_cast<uint32_t>(function_imports.size());
+						SOUP_IF_UNLIKELY (function_index >= functions.size() || function_index >= code.size())
 						{
-#if DEBUG_VM
-							std::cout << "call: function is not imported\n";
-#endif
 							return false;
 						}
-						script.function_imports.at(function_index).ptr(*this);
-						break;
-					}
-					function_index -= static_cast<uint32_t>(script.function_imports.size());
-					SOUP_IF_UNLIKELY (function_index >= script.functions.size() || function_index >= script.code.size())
-					{
-#if DEBUG_VM
-						std::cout << "call: function is out-of-bounds\n";
-#endif
-						return false;
+						type_index = functions[function_index];
+						emit(OP_CALL, function_index);
 					}
-					uint32_t type_index = script.functions.at(function_index);
-					SOUP_IF_UNLIKELY (!doCall(type_index, function_index))
+					SOUP_IF_UNLIKELY (type_index >= types.size())
 					{
 						return false;
 					}
+					SOUP_RETHROW_FALSE(pop(types[type_index].num_parameters));
+					push(types[type_index].num_results);
 				}
 				break;
 
@@ -710,346 +972,598 @@ NAMESPACE_SOUP
 				{
 					uint32_t type_index; r.oml(type_index);
 					uint32_t table_index; r.oml(table_index);
-					SOUP_IF_UNLIKELY (table_index != 0)
-					{
-#if DEBUG_VM
-						std::cout << "call: table is out-of-bounds\n";
-#endif
-						return false;
-					}
-					auto element_index = static_cast<uint32_t>(stack.top().i32); stack.pop();
-					SOUP_IF_UNLIKELY (element_index >= script.elements.size())
-					{
-#if DEBUG_VM
-						std::cout << "call: element is out-of-bounds\n";
-#endif
-						return false;
-					}
-					uint32_t function_index = script.elements.at(element_index);
-					SOUP_IF_UNLIKELY (function_index < script.function_imports.size())
-					{
-#if DEBUG_VM
-						std::cout << "indirect call to imported function\n";
-#endif
-						return false;
-					}
-					function_index -= static_cast<uint32_t>(script.function_imports.size());
-					SOUP_IF_UNLIKELY (type_index != script.functions.at(function_index))
+					SOUP_IF_UNLIKELY (table_index != 0 || type_index >= types.size())
 					{
-#if DEBUG_VM
-						std::cout << "call: function type mismatch\n";
-#endif
 						return false;
 					}
-					SOUP_RETHROW_FALSE(doCall(type_index, function_index));
+					SOUP_RETHROW_FALSE(pop(1));
+					SOUP_RETHROW_FALSE(pop(types[type_index].num_parameters));
+					push(types[type_index].num_results);
+					emit(OP_CALL_INDIRECT, type_index);
 				}
 				break;
 
 			case 0x1a: // drop
-				stack.pop();
+				SOUP_RETHROW_FALSE(pop(1));
+				emit(OP_DROP);
 				break;
 
 			case 0x1b: // select
-				{
-					auto cond = stack.top(); stack.pop();
-					auto fvalue = stack.top(); stack.pop();
-					auto tvalue = stack.top(); stack.pop();
-					stack.push(cond.i32 ? tvalue : fvalue);
-				}
+				SOUP_RETHROW_FALSE(pop(3));
+				push(1);
+				emit(OP_SELECT);
 				break;
 
 			case 0x20: // local.get
+			case 0x21: // local.set
+			case 0x22: // local.tee
 				{
-					size_t local_index;
+					uint32_t local_index;
 					r.oml(local_index);
-					SOUP_IF_UNLIKELY (local_index >= locals.size())
+					SOUP_IF_UNLIKELY (local_index >= num_locals)
 					{
-#if DEBUG_VM
-						std::cout << "local.get: index is out-of-bounds: " << local_index << "\n";
-#endif
 						return false;
 					}
-					stack.push(locals.at(local_index));
-				}
-				break;
-
-			case 0x21: // local.set
-				{
-					size_t local_index;
-					r.oml(local_index);
-					SOUP_IF_UNLIKELY (local_index >= locals.size())
+					if (op != 0x20)
 					{
-#if DEBUG_VM
-						std::cout << "local.set: index is out-of-bounds: " << local_index << "\n";
-#endif
-						return false;
+						SOUP_RETHROW_FALSE(pop(1));
 					}
-					locals.at(local_index) = stack.top(); stack.pop();
-				}
-				break;
-
-			case 0x22: // local.tee
-				{
-					size_t local_index;
-					r.oml(local_index);
-					SOUP_IF_UNLIKELY (local_index >= locals.size())
+					if (op != 0x21)
 					{
-#if DEBUG_VM
-						std::cout << "local.tee: index is out-of-bounds: " << local_index << "\n";
-#endif
-						return false;
+						push(1);
 					}
-					locals.at(local_index) = stack.top();
+					emit(op == 0x20 ? OP_LOCAL_GET : op == 0x21 ? OP_LOCAL_SET : OP_LOCAL_TEE, local_index);
 				}
 				break;
 
 			case 0x23: // global.get
+			case 0x24: // global.set
 				{
-					size_t global_index;
+					uint32_t global_index;
 					r.oml(global_index);
-					SOUP_IF_UNLIKELY (global_index >= script.globals.size())
+					SOUP_IF_UNLIKELY (global_index >= globals.size())
 					{
-#if DEBUG_VM
-						std::cout << "global.get: index is out-of-bounds: " << global_index << "\n";
-#endif
 						return false;
 					}
-					stack.push(script.globals.at(global_index));
+					if (op == 0x23)
+					{
+						push(1);
+					}
+					else
+					{
+						SOUP_RETHROW_FALSE(pop(1));
+					}
+					emit(op == 0x23 ? OP_GLOBAL_GET : OP_GLOBAL_SET, global_index);
 				}
 				break;
 
-			case 0x24: // global.set
+#define WASM_MEM_OP_TRANSLATE(name, code, pops, pushes) \
+			case code: \
+				{ \
+					r.skip(1); /* memflags */ \
+					const auto offset = readUPTR(r); \
+					SOUP_RETHROW_FALSE(pop(pops)); \
+					push(pushes); \
+					emit(OP_##name, 0, static_cast<uint64_t>(offset)); \
+				} \
+				break;
+#define WASM_NUM_OP_TRANSLATE(name, code, pops) \
+			case code: \
+				SOUP_RETHROW_FALSE(pop(pops)); \
+				push(1); \
+				emit(OP_##name); \
+				break;
+#define WASM_OP_IGNORE(name)
+				FOR_EACH_WASM_OP(WASM_OP_IGNORE, WASM_MEM_OP_TRANSLATE, WASM_NUM_OP_TRANSLATE)
+#undef WASM_MEM_OP_TRANSLATE
+#undef WASM_NUM_OP_TRANSLATE
+#undef WASM_OP_IGNORE
+
+			case 0x3f: // memory.size
+				r.skip(1); // reserved
+				push(1);
+				emit(OP_MEMORY_SIZE);
+				break;
+
+			case 0x40: // memory.grow
+				r.skip(1); // reserved
+				SOUP_RETHROW_FALSE(pop(1));
+				push(1);
+				emit(OP_MEMORY_GROW);
+				break;
+
+			case 0x41: // i32.const
 				{
-					size_t global_index;
-					r.oml(global_index);
-					SOUP_IF_UNLIKELY (global_index >= script.globals.size())
-					{
-#if DEBUG_VM
-						std::cout << "global.set: index is out-of-bounds: " << global_index << "\n";
-#endif
-						return false;
-					}
-					script.globals.at(global_index) = stack.top().i32; stack.pop();
+					int32_t value;
+					r.soml(value);
+					push(1);
+					emit(OP_CONST, 0, value);
 				}
 				break;
 
-			case 0x28: // i32.load
+			case 0x42: // i64.const
 				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<int32_t>(base, offset))
-					{
-						stack.emplace(*ptr);
-					}
-					else
-					{
-#if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
-#endif
-						return false;
-					}
+					int64_t value;
+					r.soml(value);
+					push(1);
+					emit(OP_CONST, 0, value);
 				}
 				break;
 
-			case 0x29: // i64.load
+			case 0x43: // f32.const
 				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<int64_t>(base, offset))
-					{
-						stack.emplace(*ptr);
-					}
-					else
-					{
+					float value;
+					r.f32(value);
+					push(1);
+					emit(OP_CONST, 0, value);
+				}
+				break;
+
+			case 0x44: // f64.const
+				{
+					double value;
+					r.f64(value);
+					push(1);
+					emit(OP_CONST, 0, value);
+				}
+				break;
+			}
+		}
+		return false;
+	}
+
+	bool WasmScript::skipImmediates(Reader& r, uint8_t op) const noexcept
+	{
+		switch (op)
+		{
+		default:
+			return false;
+
+		case 0x00: // unreachable
+		case 0x01: // nop
+		case 0x0f: // return
+		case 0x1a: // drop
+		case 0x1b: // select
+#define WASM_NUM_OP_CASE(name, code, pops) case code:
+#define WASM_OP_IGNORE(...)
+			FOR_EACH_WASM_OP(WASM_OP_IGNORE, WASM_OP_IGNORE, WASM_NUM_OP_CASE)
+#undef WASM_NUM_OP_CASE
+#undef WASM_OP_IGNORE
+			break;
+
+		case 0x0c: // br
+		case 0x0d: // br_if
+		case 0x10: // call
+		case 0x20: // local.get
+		case 0x21: // local.set
+		case 0x22: // local.tee
+		case 0x23: // global.get
+		case 0x24: // global.set
+			{
+				uint32_t imm;
+				r.oml(imm);
+			}
+			break;
+
+		case 0x0e: // br_table
+			{
+				uint32_t num_branches;
+				r.oml(num_branches);
+				for (uint32_t i = 0; i != num_branches + 1; ++i)
+				{
+					uint32_t depth;
+					r.oml(depth);
+				}
+			}
+			break;
+
+		case 0x11: // call_indirect
+			{
+				uint32_t type_index; r.oml(type_index);
+				uint32_t table_index; r.oml(table_index);
+			}
+			break;
+
+#define WASM_MEM_OP_CASE(name, code, pops, pushes) case code:
+#define WASM_OP_IGNORE(...)
+			FOR_EACH_WASM_OP(WASM_OP_IGNORE, WASM_MEM_OP_CASE, WASM_OP_IGNORE)
+#undef WASM_MEM_OP_CASE
+#undef WASM_OP_IGNORE
+			r.skip(1); // memflags
+			SOUP_UNUSED(readUPTR(r));
+			break;
+
+		case 0x3f: // memory.size
+		case 0x40: // memory.grow
+			r.skip(1);
+			break;
+
+		case 0x41: // i32.const
+			{
+				int32_t value;
+				r.soml(value);
+			}
+			break;
+
+		case 0x42: // i64.const
+			{
+				int64_t value;
+				r.soml(value);
+			}
+			break;
+
+		case 0x43: // f32.const
+			r.skip(4);
+			break;
+
+		case 0x44: // f64.const
+			r.skip(8);
+			break;
+		}
+		return true;
+	}
+
+	// WasmVm
+
+	bool WasmVm::run(size_t func_index) SOUP_EXCAL
+	{
+		SOUP_IF_UNLIKELY (func_index >= script.code.size())
+		{
+			return false;
+		}
+
+		// Function bodies from the script have been translated at load time, so they don't need to be decoded again.
+		auto& fn = script.compiled[func_index];
+		if (!fn.instructions.empty()
+			&& locals.size() == script.types.at(fn.type_index).num_parameters
+			)
+		{
+			locals.resize(locals.size() + fn.num_locals);
+			return execute(fn, -1, stack.size());
+		}
+
+		return run(script.code[func_index]);
+	}
+
+	bool WasmVm::run(const std::string& data) SOUP_EXCAL
+	{
+		MemoryRefReader r(data);
+		return run(r);
+	}
+
+	bool WasmVm::run(Reader& r) SOUP_EXCAL
+	{
+		size_t local_decl_count;
+		r.oml(local_decl_count);
+		while (local_decl_count--)
+		{
+			size_t type_count;
+			r.oml(type_count);
+			uint8_t type;
+			r.u8(type);
+			SOUP_UNUSED(type);
+			// type 0x7f = i32
+			// type 0x7e = i64
+			while (type_count--)
+			{
+				locals.emplace_back();
+			}
+		}
+
+		std::stack<CtrlFlowEntry> ctrlflow{};
+
+		uint8_t op;
+		while (r.u8(op))
+		{
+			switch (op)
+			{
+			default:
 #if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
+				std::cout << "Unsupported opcode: " << string::hex(op) << "\n";
 #endif
-						return false;
-					}
-				}
+				return false;
+
+			case 0x00: // unreachable
+#if DEBUG_VM
+				std::cout << "unreachable\n";
+#endif
+				return false;
+
+			case 0x01: // nop
 				break;
 
-			case 0x2a: // f32.load
+			case 0x02: // block
 				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<float>(base, offset))
-					{
-						stack.emplace(*ptr);
-					}
-					else
-					{
+					uint8_t result_type; r.u8(result_type);
+					bool has_result = (result_type != /* void */ 0x40);
+					ctrlflow.emplace(CtrlFlowEntry{ (size_t)-1, stack.size() + has_result });
 #if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
+					std::cout << "block at position " << r.getPosition() << " with stack size " << stack.size() << "\n";
 #endif
-						return false;
-					}
 				}
 				break;
 
-			case 0x2b: // f64.load
+			case 0x03: // loop
 				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<double>(base, offset))
-					{
-						stack.emplace(*ptr);
-					}
-					else
-					{
+					uint8_t result_type; r.u8(result_type);
+					bool has_result = (result_type != /* void */ 0x40);
+					ctrlflow.emplace(CtrlFlowEntry{ r.getPosition(), stack.size() + has_result });
 #if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
+					std::cout << "loop at position " << r.getPosition() << " with stack size " << stack.size() << "\n";
 #endif
-						return false;
-					}
 				}
 				break;
 
-			case 0x2c: // i32.load8_s
+			case 0x04: // if
 				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<int8_t>(base, offset))
+					uint8_t result_type; r.u8(result_type);
+					bool has_result = (result_type != /* void */ 0x40);
+					auto value = stack.top(); stack.pop();
+					//std::cout << "if: condition is " << (value.i32 ? "true" : "false") << "\n";
+					if (value.i32)
 					{
-						stack.emplace(static_cast<int32_t>(*ptr));
+						ctrlflow.emplace(CtrlFlowEntry{ r.getPosition(), stack.size() + has_result });
 					}
 					else
 					{
+						if (skipOverBranch(r))
+						{
+							// we're in the 'else' branch
+							ctrlflow.emplace(CtrlFlowEntry{ r.getPosition(), stack.size() + has_result });
+						}
+						else
+						{
+							// we're after the 'end'
+							SOUP_IF_UNLIKELY (has_result)
+							{
 #if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
+								std::cout << "if: has result but no 'else' clause\n";
 #endif
-						return false;
+								return false;
+							}
+						}
 					}
 				}
 				break;
 
-			case 0x2d: // i32.load8_u
-				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<uint8_t>(base, offset))
+			case 0x05: // else
+				//std::cout << "else: skipping over this branch\n";
+				skipOverBranch(r);
+				[[fallthrough]];
+			case 0x0b: // end
+				if (ctrlflow.empty())
+				{
+					return true;
+				}
+				ctrlflow.pop();
+				//std::cout << "ctrlflow stack now has " << ctrlflow.size() << " entries\n";
+				break;
+
+			case 0x0c: // br
+				{
+					uint32_t depth;
+					r.oml(depth);
+					SOUP_IF_UNLIKELY (!doBranch(r, depth, ctrlflow))
 					{
-						stack.emplace(static_cast<uint32_t>(*ptr));
+						return false;
 					}
-					else
+				}
+				break;
+
+			case 0x0d: // br_if
+				{
+					uint32_t depth;
+					r.oml(depth);
+					auto value = stack.top(); stack.pop();
+					if (value.i32)
+					{
+						SOUP_IF_UNLIKELY (!doBranch(r, depth, ctrlflow))
+						{
+							return false;
+						}
+					}
+				}
+				break;
+
+			case 0x0e: // br_table
+				{
+					std::vector<uint32_t> table;
+					uint32_t num_branches;
+					r.oml(num_branches);
+					table.reserve(num_branches);
+					while (num_branches--)
+					{
+						uint32_t depth;
+						r.oml(depth);
+						table.emplace_back(depth);
+					}
+					uint32_t depth;
+					r.oml(depth);
+					auto index = static_cast<uint32_t>(stack.top().i32); stack.pop();
+					if (index < table.size())
+					{
+						depth = table.at(index);
+					}
+					SOUP_IF_UNLIKELY (!doBranch(r, depth, ctrlflow))
 					{
-#if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
-#endif
 						return false;
 					}
 				}
 				break;
 
-			case 0x2e: // i32.load16_s
+			case 0x0f: // return
+				return true;
+
+			case 0x10: // call
 				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<int16_t>(base, offset))
+					uint32_t function_index;
+					r.oml(function_index);
+					if (function_index < script.function_imports.size())
 					{
-						stack.emplace(static_cast<uint32_t>(*ptr));
+#if DEBUG_VM
+						std::cout << "Calling into " << script.function_imports.at(function_index).module_name << ":" << script.function_imports.at(function_index).function_name << "\n";
+#endif
+						SOUP_IF_UNLIKELY (script.function_imports.at(function_index).ptr == nullptr)
+						{
+#if DEBUG_VM
+							std::cout << "call: function is not imported\n";
+#endif
+							return false;
+						}
+						script.function_imports.at(function_index).ptr(*this);
+						break;
 					}
-					else
+					function_index -= static_cast<uint32_t>(script.function_imports.size());
+					SOUP_IF_UNLIKELY (function_index >= script.functions.size() || function_index >= script.code.size())
 					{
 #if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
+						std::cout << "call: function is out-of-bounds\n";
 #endif
 						return false;
 					}
+					uint32_t type_index = script.functions.at(function_index);
+					SOUP_IF_UNLIKELY (!doCall(type_index, function_index))
+					{
+						return false;
+					}
 				}
 				break;
 
-			case 0x2f: // i32.load16_u
+			case 0x11: // call_indirect
 				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<uint16_t>(base, offset))
+					uint32_t type_index; r.oml(type_index);
+					uint32_t table_index; r.oml(table_index);
+					SOUP_IF_UNLIKELY (table_index != 0)
 					{
-						stack.emplace(static_cast<uint32_t>(*ptr));
+#if DEBUG_VM
+						std::cout << "call: table is out-of-bounds\n";
+#endif
+						return false;
 					}
-					else
+					auto element_index = static_cast<uint32_t>(stack.top().i32); stack.pop();
+					SOUP_IF_UNLIKELY (element_index >= script.elements.size())
 					{
 #if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
+						std::cout << "call: element is out-of-bounds\n";
+#endif
+						return false;
+					}
+					uint32_t function_index = script.elements.at(element_index);
+					SOUP_IF_UNLIKELY (function_index < script.function_imports.size())
+					{
+#if DEBUG_VM
+						std::cout << "indirect call to imported function\n";
 #endif
 						return false;
 					}
+					function_index -= static_cast<uint32_t>(script.function_imports.size());
+					SOUP_IF_UNLIKELY (type_index != script.functions.at(function_index))
+					{
+#if DEBUG_VM
+						std::cout << "call: function type mismatch\n";
+#endif
+						return false;
+					}
+					SOUP_RETHROW_FALSE(doCall(type_index, function_index));
 				}
 				break;
 
-			case 0x30: // i64.load8_s
+			case 0x1a: // drop
+				stack.pop();
+				break;
+
+			case 0x1b: // select
 				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<int8_t>(base, offset))
-					{
-						stack.emplace(static_cast<int64_t>(*ptr));
-					}
-					else
+					auto cond = stack.top(); stack.pop();
+					auto fvalue = stack.top(); stack.pop();
+					auto tvalue = stack.top(); stack.pop();
+					stack.push(cond.i32 ? tvalue : fvalue);
+				}
+				break;
+
+			case 0x20: // local.get
+				{
+					size_t local_index;
+					r.oml(local_index);
+					SOUP_IF_UNLIKELY (local_index >= locals.size())
 					{
 #if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
+						std::cout << "local.get: index is out-of-bounds: " << local_index << "\n";
 #endif
 						return false;
 					}
+					stack.push(locals.at(local_index));
 				}
 				break;
 
-			case 0x31: // i64.load8_u
+			case 0x21: // local.set
 				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<uint8_t>(base, offset))
+					size_t local_index;
+					r.oml(local_index);
+					SOUP_IF_UNLIKELY (local_index >= locals.size())
 					{
-						stack.emplace(static_cast<uint64_t>(*ptr));
+#if DEBUG_VM
+						std::cout << "local.set: index is out-of-bounds: " << local_index << "\n";
+#endif
+						return false;
 					}
-					else
+					locals.at(local_index) = stack.top(); stack.pop();
+				}
+				break;
+
+			case 0x22: // local.tee
+				{
+					size_t local_index;
+					r.oml(local_index);
+					SOUP_IF_UNLIKELY (local_index >= locals.size())
 					{
 #if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
+						std::cout << "local.tee: index is out-of-bounds: " << local_index << "\n";
 #endif
 						return false;
 					}
+					locals.at(local_index) = stack.top();
 				}
 				break;
 
-			case 0x32: // i64.load16_s
+			case 0x23: // global.get
 				{
-					auto base = stack.top(); stack.pop();
-					r.skip(1); // memflags
-					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<int16_t>(base, offset))
+					size_t global_index;
+					r.oml(global_index);
+					SOUP_IF_UNLIKELY (global_index >= script.globals.size())
 					{
-						stack.emplace(static_cast<int64_t>(*ptr));
+#if DEBUG_VM
+						std::cout << "global.get: index is out-of-bounds: " << global_index << "\n";
+#endif
+						return false;
 					}
-					else
+					stack.push(script.globals.at(global_index));
+				}
+				break;
+
+			case 0x24: // global.set
+				{
+					size_t global_index;
+					r.oml(global_index);
+					SOUP_IF_UNLIKELY (global_index >= script.globals.size())
 					{
 #if DEBUG_VM
-						std::cout << "memory access out of bounds\n";
+						std::cout << "global.set: index is out-of-bounds: " << global_index << "\n";
 #endif
 						return false;
 					}
+					script.globals.at(global_index) = stack.top().i32; stack.pop();
 				}
 				break;
 
-			case 0x33: // i64.load16_u
+			case 0x28: // i32.load
 				{
 					auto base = stack.top(); stack.pop();
 					r.skip(1); // memflags
 					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<uint16_t>(base, offset))
+					if (auto ptr = script.getMemory<int32_t>(base, offset))
 					{
-						stack.emplace(static_cast<uint64_t>(*ptr));
+						stack.emplace(*ptr);
 					}
 					else
 					{
@@ -1061,14 +1575,14 @@ NAMESPACE_SOUP
 				}
 				break;
 
-			case 0x34: // i64.load32_s
+			case 0x29: // i64.load
 				{
 					auto base = stack.top(); stack.pop();
 					r.skip(1); // memflags
 					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<int32_t>(base, offset))
+					if (auto ptr = script.getMemory<int64_t>(base, offset))
 					{
-						stack.emplace(static_cast<int64_t>(*ptr));
+						stack.emplace(*ptr);
 					}
 					else
 					{
@@ -1080,14 +1594,14 @@ NAMESPACE_SOUP
 				}
 				break;
 
-			case 0x35: // i64.load32_u
+			case 0x2a: // f32.load
 				{
 					auto base = stack.top(); stack.pop();
 					r.skip(1); // memflags
 					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<uint32_t>(base, offset))
+					if (auto ptr = script.getMemory<float>(base, offset))
 					{
-						stack.emplace(static_cast<uint64_t>(*ptr));
+						stack.emplace(*ptr);
 					}
 					else
 					{
@@ -1099,16 +1613,14 @@ NAMESPACE_SOUP
 				}
 				break;
 
-
-			case 0x36: // i32.store
+			case 0x2b: // f64.load
 				{
-					auto value = stack.top(); stack.pop();
 					auto base = stack.top(); stack.pop();
 					r.skip(1); // memflags
 					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<int32_t>(base, offset))
+					if (auto ptr = script.getMemory<double>(base, offset))
 					{
-						*ptr = value.i32;
+						stack.emplace(*ptr);
 					}
 					else
 					{
@@ -1120,15 +1632,14 @@ NAMESPACE_SOUP
 				}
 				break;
 
-			case 0x37: // i64.store
+			case 0x2c: // i32.load8_s
 				{
-					auto value = stack.top(); stack.pop();
 					auto base = stack.top(); stack.pop();
 					r.skip(1); // memflags
 					auto offset = script.readUPTR(r);
-					if (auto ptr = script.getMemory<int64_t>(base, offset))
+					if (auto ptr = script.getMemory<int8_t>(base, offset))
 					{
-						*ptr = value.i64;
+						stack.emplace(static_cast<int32_t>(*ptr));
 					}
 					else
 					{
@@ -1140,9 +1651,221 @@ NAMESPACE_SOUP
 				}
 				break;
 
-			case 0x38: // f32.store
+			case 0x2d: // i32.load8_u
 				{
-					auto value = stack.top(); stack.pop();
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<uint8_t>(base, offset))
+					{
+						stack.emplace(static_cast<uint32_t>(*ptr));
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+			case 0x2e: // i32.load16_s
+				{
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<int16_t>(base, offset))
+					{
+						stack.emplace(static_cast<uint32_t>(*ptr));
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+			case 0x2f: // i32.load16_u
+				{
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<uint16_t>(base, offset))
+					{
+						stack.emplace(static_cast<uint32_t>(*ptr));
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+			case 0x30: // i64.load8_s
+				{
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<int8_t>(base, offset))
+					{
+						stack.emplace(static_cast<int64_t>(*ptr));
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+			case 0x31: // i64.load8_u
+				{
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<uint8_t>(base, offset))
+					{
+						stack.emplace(static_cast<uint64_t>(*ptr));
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+			case 0x32: // i64.load16_s
+				{
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<int16_t>(base, offset))
+					{
+						stack.emplace(static_cast<int64_t>(*ptr));
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+			case 0x33: // i64.load16_u
+				{
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<uint16_t>(base, offset))
+					{
+						stack.emplace(static_cast<uint64_t>(*ptr));
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+			case 0x34: // i64.load32_s
+				{
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<int32_t>(base, offset))
+					{
+						stack.emplace(static_cast<int64_t>(*ptr));
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+			case 0x35: // i64.load32_u
+				{
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<uint32_t>(base, offset))
+					{
+						stack.emplace(static_cast<uint64_t>(*ptr));
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+
+			case 0x36: // i32.store
+				{
+					auto value = stack.top(); stack.pop();
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<int32_t>(base, offset))
+					{
+						*ptr = value.i32;
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+			case 0x37: // i64.store
+				{
+					auto value = stack.top(); stack.pop();
+					auto base = stack.top(); stack.pop();
+					r.skip(1); // memflags
+					auto offset = script.readUPTR(r);
+					if (auto ptr = script.getMemory<int64_t>(base, offset))
+					{
+						*ptr = value.i64;
+					}
+					else
+					{
+#if DEBUG_VM
+						std::cout << "memory access out of bounds\n";
+#endif
+						return false;
+					}
+				}
+				break;
+
+			case 0x38: // f32.store
+				{
+					auto value = stack.top(); stack.pop();
 					auto base = stack.top(); stack.pop();
 					r.skip(1); // memflags
 					auto offset = script.readUPTR(r);
@@ -1188,32 +1911,8 @@ NAMESPACE_SOUP
 				break;
 
 			case 0x40: // memory.grow
-				{
-					r.skip(1); // reserved
-					size_t delta;
-					if (script.memory64)
-					{
-						delta = static_cast<uint64_t>(stack.top().i64);
-					}
-					else
-					{
-						delta = static_cast<uint32_t>(stack.top().i32);
-					}
-					stack.pop();
-					delta *= 0x10'000;
-					auto nmem = (uint8_t*)::realloc(script.memory, script.memory_size + delta);
-					if (nmem == nullptr)
-					{
-						pushIPTR(-1);
-					}
-					else
-					{
-						memset(&nmem[script.memory_size], 0, delta);
-						pushIPTR(script.memory_size / 0x10'000);
-						script.memory = nmem;
-						script.memory_size += delta;
-					}
-				}
+				r.skip(1); // reserved
+				stack.top() = script.growMemory(stack.top());
 				break;
 
 			case 0x41: // i32.const
@@ -2183,4 +2882,1266 @@ NAMESPACE_SOUP
 			stack.push(static_cast<uint32_t>(ptr));
 		}
 	}
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define WASM_THREADED_DISPATCH true
+#else
+	#define WASM_THREADED_DISPATCH false
+#endif
+
+	bool WasmVm::execute(WasmScript::CompiledFunction& fn, size_t frame, size_t base) SOUP_EXCAL
+	{
+#if SOUP_X86 && SOUP_BITS == 64
+		if (fn.native.load(std::memory_order_acquire) == nullptr
+			&& fn.hotness.load(std::memory_order_relaxed) >= script.jit_threshold
+			&& script.jit_threshold != -1
+			&& !fn.native_unsupported.load(std::memory_order_relaxed)
+			)
+		{
+			script.compileNative(fn);
+		}
+		if (fn.native.load(std::memory_order_acquire) != nullptr)
+		{
+			return executeNative(fn, frame, base);
+		}
+#endif
+		fn.heatUp();
+
+		// The translator has worked out how high the stack can get, so after this, no instruction needs to check for space.
+		stack.reserve(fn.max_stack);
+
+		const WasmScript::Instruction* const code = fn.instructions.data();
+		const WasmScript::Instruction* pc = code;
+		WasmValue* sp;
+		WasmValue* local;
+
+		// Calls may reallocate the stack or change its size.
+#define WASM_SYNC stack.count = static_cast<size_t>(sp - stack.values.data());
+#define WASM_RELOAD sp = stack.values.data() + stack.count; local = (frame == -1 ? locals.data() : stack.values.data() + frame);
+		WASM_RELOAD;
+
+#if WASM_THREADED_DISPATCH
+#define WASM_OP_LABEL(name) &&L_##name,
+#define WASM_MEM_OP_LABEL(name, code, pops, pushes) &&L_##name,
+#define WASM_NUM_OP_LABEL(name, code, pops) &&L_##name,
+		static const void* const labels[] = {
+			FOR_EACH_WASM_OP(WASM_OP_LABEL, WASM_MEM_OP_LABEL, WASM_NUM_OP_LABEL)
+		};
+#undef WASM_OP_LABEL
+#undef WASM_MEM_OP_LABEL
+#undef WASM_NUM_OP_LABEL
+#define HANDLER(name) L_##name:
+#define NEXT goto *labels[pc->op]
+		NEXT;
+#else
+#define HANDLER(name) case OP_##name:
+#define NEXT goto _dispatch
+	_dispatch:
+		switch (pc->op)
+		{
+#endif
+		HANDLER(UNREACHABLE)
+		{
+#if DEBUG_VM
+			std::cout << "unreachable\n";
+#endif
+			return false;
+		}
+
+		HANDLER(BR)
+		{
+			if (pc->a != 0)
+			{
+				std::copy(sp - pc->arity, sp, sp - pc->arity - pc->a);
+				sp -= pc->a;
+			}
+			pc = code + pc->b.i32;
+			NEXT;
+		}
+
+		HANDLER(BR_IF)
+		{
+			if ((--sp)->i32)
+			{
+				if (pc->a != 0)
+				{
+					std::copy(sp - pc->arity, sp, sp - pc->arity - pc->a);
+					sp -= pc->a;
+				}
+				pc = code + pc->b.i32;
+			}
+			else
+			{
+				++pc;
+			}
+			NEXT;
+		}
+
+		HANDLER(BR_TABLE)
+		{
+			// The branches follow, with the default one last.
+			auto index = static_cast<uint32_t>((--sp)->i32);
+			if (index > pc->a)
+			{
+				index = pc->a;
+			}
+			pc += 1 + index;
+			NEXT;
+		}
+
+		HANDLER(IF)
+		{
+			pc = ((--sp)->i32 ? pc + 1 : code + pc->b.i32);
+			NEXT;
+		}
+
+		HANDLER(LOOP)
+		{
+			fn.heatUp();
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(RETURN)
+		{
+			memmove(stack.values.data() + base, sp - pc->a, pc->a * sizeof(WasmValue));
+			stack.count = base + pc->a;
+			return true;
+		}
+
+		HANDLER(CALL)
+		{
+			WASM_SYNC;
+			SOUP_RETHROW_FALSE(callFunction(pc->a));
+			WASM_RELOAD;
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(CALL_IMPORT)
+		{
+			WASM_SYNC;
+			SOUP_RETHROW_FALSE(callImport(pc->a));
+			WASM_RELOAD;
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(CALL_INDIRECT)
+		{
+			WASM_SYNC;
+			SOUP_RETHROW_FALSE(callIndirect(pc->a));
+			WASM_RELOAD;
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(DROP)
+		{
+			--sp;
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(SELECT)
+		{
+			sp -= 2;
+			if (!sp[1].i32)
+			{
+				sp[-1] = sp[0];
+			}
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(LOCAL_GET)
+		{
+			*sp++ = local[pc->a];
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(LOCAL_SET)
+		{
+			local[pc->a] = *--sp;
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(LOCAL_TEE)
+		{
+			local[pc->a] = sp[-1];
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(GLOBAL_GET)
+		{
+			*sp++ = script.globals[pc->a];
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(GLOBAL_SET)
+		{
+			script.globals[pc->a] = (--sp)->i32;
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(MEMORY_SIZE)
+		{
+			*sp++ = (script.memory64 ? WasmValue(static_cast<uint64_t>(script.memory_size / 0x10'000)) : WasmValue(static_cast<uint32_t>(script.memory_size / 0x10'000)));
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(MEMORY_GROW)
+		{
+			sp[-1] = script.growMemory(sp[-1]);
+			++pc;
+			NEXT;
+		}
+
+		HANDLER(CONST)
+		{
+			*sp++ = pc->b;
+			++pc;
+			NEXT;
+		}
+
+#define WASM_LOAD(name, T, R) \
+		HANDLER(name) \
+		{ \
+			auto ptr = script.getMemory<T>(sp[-1], static_cast<size_t>(pc->b.i64)); \
+			SOUP_IF_UNLIKELY (ptr == nullptr) \
+			{ \
+				return false; \
+			} \
+			sp[-1] = WasmValue(static_cast<R>(*ptr)); \
+			++pc; \
+			NEXT; \
+		}
+		WASM_LOAD(I32_LOAD, int32_t, int32_t)
+		WASM_LOAD(I64_LOAD, int64_t, int64_t)
+		WASM_LOAD(F32_LOAD, float, float)
+		WASM_LOAD(F64_LOAD, double, double)
+		WASM_LOAD(I32_LOAD8_S, int8_t, int32_t)
+		WASM_LOAD(I32_LOAD8_U, uint8_t, uint32_t)
+		WASM_LOAD(I32_LOAD16_S, int16_t, int32_t)
+		WASM_LOAD(I32_LOAD16_U, uint16_t, uint32_t)
+		WASM_LOAD(I64_LOAD8_S, int8_t, int64_t)
+		WASM_LOAD(I64_LOAD8_U, uint8_t, uint64_t)
+		WASM_LOAD(I64_LOAD16_S, int16_t, int64_t)
+		WASM_LOAD(I64_LOAD16_U, uint16_t, uint64_t)
+		WASM_LOAD(I64_LOAD32_S, int32_t, int64_t)
+		WASM_LOAD(I64_LOAD32_U, uint32_t, uint64_t)
+#undef WASM_LOAD
+
+#define WASM_STORE(name, T, field) \
+		HANDLER(name) \
+		{ \
+			sp -= 2; \
+			auto ptr = script.getMemory<T>(sp[0], static_cast<size_t>(pc->b.i64)); \
+			SOUP_IF_UNLIKELY (ptr == nullptr) \
+			{ \
+				return false; \
+			} \
+			*ptr = static_cast<T>(sp[1].field); \
+			++pc; \
+			NEXT; \
+		}
+		WASM_STORE(I32_STORE, int32_t, i32)
+		WASM_STORE(I64_STORE, int64_t, i64)
+		WASM_STORE(F32_STORE, float, f32)
+		WASM_STORE(F64_STORE, double, f64)
+		WASM_STORE(I32_STORE8, int8_t, i32)
+		WASM_STORE(I32_STORE16, int16_t, i32)
+#undef WASM_STORE
+
+#define WASM_UNARY(name, expr) \
+		HANDLER(name) \
+		{ \
+			const WasmValue a = sp[-1]; \
+			sp[-1] = WasmValue(expr); \
+			++pc; \
+			NEXT; \
+		}
+		WASM_UNARY(I32_EQZ, a.i32 == 0)
+		WASM_UNARY(I64_EQZ, a.i64 == 0)
+		WASM_UNARY(I32_POPCNT, static_cast<uint32_t>(bitutil::getNumSetBits(static_cast<uint32_t>(a.i32))))
+		WASM_UNARY(I32_WRAP_I64, static_cast<int32_t>(a.i64))
+		WASM_UNARY(I64_EXTEND_I32_S, static_cast<int64_t>(a.i32))
+		WASM_UNARY(I64_EXTEND_I32_U, static_cast<uint64_t>(static_cast<uint32_t>(a.i32)))
+#undef WASM_UNARY
+
+		// Integer arithmetic is done on unsigned types so overflow wraps around like it should.
+#define WASM_BINARY(name, T, field, expr) \
+		HANDLER(name) \
+		{ \
+			const auto a = static_cast<T>(sp[-2].field); \
+			const auto b = static_cast<T>(sp[-1].field); \
+			--sp; \
+			sp[-1] = WasmValue(expr); \
+			++pc; \
+			NEXT; \
+		}
+		WASM_BINARY(I32_EQ, int32_t, i32, a == b)
+		WASM_BINARY(I32_NE, int32_t, i32, a != b)
+		WASM_BINARY(I32_LT_S, int32_t, i32, a < b)
+		WASM_BINARY(I32_LT_U, uint32_t, i32, a < b)
+		WASM_BINARY(I32_GT_S, int32_t, i32, a > b)
+		WASM_BINARY(I32_GT_U, uint32_t, i32, a > b)
+		WASM_BINARY(I32_LE_S, int32_t, i32, a <= b)
+		WASM_BINARY(I32_LE_U, uint32_t, i32, a <= b)
+		WASM_BINARY(I32_GE_S, int32_t, i32, a >= b)
+		WASM_BINARY(I32_GE_U, uint32_t, i32, a >= b)
+		WASM_BINARY(I64_EQ, int64_t, i64, a == b)
+		WASM_BINARY(I64_NE, int64_t, i64, a != b)
+		WASM_BINARY(I64_LT_S, int64_t, i64, a < b)
+		WASM_BINARY(I64_LT_U, uint64_t, i64, a < b)
+		WASM_BINARY(I64_GT_S, int64_t, i64, a > b)
+		WASM_BINARY(I64_GT_U, uint64_t, i64, a > b)
+		WASM_BINARY(I64_LE_S, int64_t, i64, a <= b)
+		WASM_BINARY(I64_LE_U, uint64_t, i64, a <= b)
+		WASM_BINARY(I64_GE_S, int64_t, i64, a >= b)
+		WASM_BINARY(I64_GE_U, uint64_t, i64, a >= b)
+		WASM_BINARY(F32_EQ, float, f32, a == b)
+		WASM_BINARY(F32_NE, float, f32, a != b)
+		WASM_BINARY(F32_LT, float, f32, a < b)
+		WASM_BINARY(F32_GT, float, f32, a > b)
+		WASM_BINARY(F32_LE, float, f32, a <= b)
+		WASM_BINARY(F32_GE, float, f32, a >= b)
+		WASM_BINARY(F64_EQ, double, f64, a == b)
+		WASM_BINARY(F64_NE, double, f64, a != b)
+		WASM_BINARY(F64_LT, double, f64, a < b)
+		WASM_BINARY(F64_GT, double, f64, a > b)
+		WASM_BINARY(F64_LE, double, f64, a <= b)
+		WASM_BINARY(F64_GE, double, f64, a >= b)
+		WASM_BINARY(I32_ADD, uint32_t, i32, a + b)
+		WASM_BINARY(I32_SUB, uint32_t, i32, a - b)
+		WASM_BINARY(I32_MUL, uint32_t, i32, a * b)
+		WASM_BINARY(I32_AND, uint32_t, i32, a & b)
+		WASM_BINARY(I32_OR, uint32_t, i32, a | b)
+		WASM_BINARY(I32_XOR, uint32_t, i32, a ^ b)
+		WASM_BINARY(I32_SHL, uint32_t, i32, a << (b % 32))
+		WASM_BINARY(I32_SHR_S, int32_t, i32, a >> (static_cast<uint32_t>(b) % 32))
+		WASM_BINARY(I32_SHR_U, uint32_t, i32, a >> (b % 32))
+		WASM_BINARY(I64_ADD, uint64_t, i64, a + b)
+		WASM_BINARY(I64_SUB, uint64_t, i64, a - b)
+		WASM_BINARY(I64_MUL, uint64_t, i64, a * b)
+		WASM_BINARY(I64_AND, uint64_t, i64, a & b)
+		WASM_BINARY(I64_OR, uint64_t, i64, a | b)
+		WASM_BINARY(I64_XOR, uint64_t, i64, a ^ b)
+		WASM_BINARY(I64_SHL, uint64_t, i64, a << (b % 64))
+		WASM_BINARY(I64_SHR_S, int64_t, i64, a >> (static_cast<uint64_t>(b) % 64))
+		WASM_BINARY(I64_SHR_U, uint64_t, i64, a >> (b % 64))
+		WASM_BINARY(F32_ADD, float, f32, a + b)
+		WASM_BINARY(F32_SUB, float, f32, a - b)
+		WASM_BINARY(F32_MUL, float, f32, a * b)
+		WASM_BINARY(F32_DIV, float, f32, a / b)
+		WASM_BINARY(F64_ADD, double, f64, a + b)
+		WASM_BINARY(F64_SUB, double, f64, a - b)
+		WASM_BINARY(F64_MUL, double, f64, a * b)
+		WASM_BINARY(F64_DIV, double, f64, a / b)
+#undef WASM_BINARY
+
+		// Division traps if the result is undefined.
+#define WASM_DIVISION(name, T, field, trap, expr) \
+		HANDLER(name) \
+		{ \
+			const auto a = static_cast<T>(sp[-2].field); \
+			const auto b = static_cast<T>(sp[-1].field); \
+			SOUP_IF_UNLIKELY (trap) \
+			{ \
+				return false; \
+			} \
+			--sp; \
+			sp[-1] = WasmValue(expr); \
+			++pc; \
+			NEXT; \
+		}
+		WASM_DIVISION(I32_DIV_S, int32_t, i32, b == 0 || (a == INT32_MIN && b == -1), a / b)
+		WASM_DIVISION(I32_DIV_U, uint32_t, i32, b == 0, a / b)
+		WASM_DIVISION(I32_REM_S, int32_t, i32, b == 0, b == -1 ? 0 : a % b)
+		WASM_DIVISION(I32_REM_U, uint32_t, i32, b == 0, a % b)
+		WASM_DIVISION(I64_DIV_S, int64_t, i64, b == 0 || (a == INT64_MIN && b == -1), a / b)
+		WASM_DIVISION(I64_DIV_U, uint64_t, i64, b == 0, a / b)
+		WASM_DIVISION(I64_REM_S, int64_t, i64, b == 0, b == -1 ? 0 : a % b)
+		WASM_DIVISION(I64_REM_U, uint64_t, i64, b == 0, a % b)
+#undef WASM_DIVISION
+#if !WASM_THREADED_DISPATCH
+		}
+#endif
+#undef HANDLER
+#undef NEXT
+#undef WASM_SYNC
+#undef WASM_RELOAD
+		return false;
+	}
+
+	bool WasmVm::callFunction(uint32_t function_index) SOUP_EXCAL
+	{
+		auto& fn = script.compiled[function_index];
+		if (fn.instructions.empty())
+		{
+			return doCall(fn.type_index, function_index);
+		}
+		// The arguments are already on the stack, so they just need to be followed by the other locals.
+		const size_t frame = stack.count - script.types[fn.type_index].num_parameters;
+		stack.reserve(fn.num_locals);
+		std::fill_n(stack.values.begin() + stack.count, fn.num_locals, WasmValue());
+		stack.count += fn.num_locals;
+		return execute(fn, frame, frame);
+	}
+
+	bool WasmVm::callImport(uint32_t import_index) SOUP_EXCAL
+	{
+		const auto& fi = script.function_imports[import_index];
+		SOUP_IF_UNLIKELY (fi.ptr == nullptr || fi.type_index >= script.types.size())
+		{
+#if DEBUG_VM
+			std::cout << "call: function is not imported\n";
+#endif
+			return false;
+		}
+		const size_t expected_size = stack.count - script.types[fi.type_index].num_parameters + script.types[fi.type_index].num_results;
+		fi.ptr(*this);
+		SOUP_IF_UNLIKELY (stack.count != expected_size)
+		{
+#if DEBUG_VM
+			std::cout << "call: imported function did not respect its signature\n";
+#endif
+			return false;
+		}
+		return true;
+	}
+
+	bool WasmVm::callIndirect(uint32_t type_index) SOUP_EXCAL
+	{
+		const auto element_index = static_cast<uint32_t>(stack.top().i32); stack.pop();
+		SOUP_IF_UNLIKELY (element_index >= script.elements.size())
+		{
+#if DEBUG_VM
+			std::cout << "call: element is out-of-bounds\n";
+#endif
+			return false;
+		}
+		uint32_t function_index = script.elements[element_index];
+		SOUP_IF_UNLIKELY (function_index < script.function_imports.size())
+		{
+#if DEBUG_VM
+			std::cout << "indirect call to imported function\n";
+#endif
+			return false;
+		}
+		function_index -= static_cast<uint32_t>(script.function_imports.size());
+		SOUP_IF_UNLIKELY (function_index >= script.compiled.size() || script.compiled[function_index].type_index != type_index)
+		{
+#if DEBUG_VM
+			std::cout << "call: function type mismatch\n";
+#endif
+			return false;
+		}
+		return callFunction(function_index);
+	}
+
+#if SOUP_X86 && SOUP_BITS == 64
+	// Native code keeps these in registers and reloads them after calling into the VM, since that may move the stack or the memory.
+	struct WasmVm::NativeFrame
+	{
+		WasmValue* local;
+		WasmValue* operands; // height 0 of the operand stack
+		uint8_t* memory;
+		size_t memory_size;
+		WasmValue* results;
+		int32_t* globals;
+		WasmVm* vm;
+		size_t frame;
+		size_t operand_base;
+		size_t result_base;
+
+		void reload() noexcept
+		{
+			local = (frame == -1 ? vm->locals.data() : vm->stack.values.data() + frame);
+			operands = vm->stack.values.data() + operand_base;
+			memory = vm->script.memory;
+			memory_size = vm->script.memory_size;
+			results = vm->stack.values.data() + result_base;
+			globals = vm->script.globals.data();
+		}
+	};
+
+	bool WasmVm::executeNative(const WasmScript::CompiledFunction& fn, size_t frame, size_t base) SOUP_EXCAL
+	{
+		stack.reserve(fn.max_stack);
+		NativeFrame f;
+		f.vm = this;
+		f.frame = frame;
+		f.operand_base = stack.count;
+		f.result_base = base;
+		f.reload();
+		SOUP_RETHROW_FALSE(reinterpret_cast<bool(*)(NativeFrame*)>(fn.native.load(std::memory_order_acquire)->addr)(&f));
+		stack.count = base + script.types[fn.type_index].num_results;
+		return true;
+	}
+
+	template <bool(WasmVm::*f)(uint32_t)>
+	bool WasmVm::nativeCall(NativeFrame& frame, uint32_t height, uint32_t arg) noexcept
+	{
+		WasmVm& vm = *frame.vm;
+		vm.stack.count = frame.operand_base + height;
+		bool ret = false;
+		SOUP_TRY
+		{
+			ret = (vm.*f)(arg);
+		}
+		SOUP_CATCH_ANY
+		{
+			// Exceptions can't be thrown through native code, so this is treated like a trap.
+		}
+		frame.reload();
+		return ret;
+	}
+
+	bool WasmVm::nativeMemoryGrow(NativeFrame& frame, uint32_t height, uint32_t) noexcept
+	{
+		frame.operands[height - 1] = frame.vm->script.growMemory(frame.operands[height - 1]);
+		frame.reload();
+		return true;
+	}
+
+	// Compiles a translated function to x86-64. Values stay in the stack slots the interpreter would use, but since the height of the stack is
+	// known at every instruction, they are addressed directly.
+	// Registers: rbx = locals, r12 = operand stack, r13 = NativeFrame, r14 = memory, r15 = memory size.
+	struct WasmJitBuilder : public AssemblyBuilder
+	{
+		enum Condition : uint8_t
+		{
+			CC_B = 0x2,
+			CC_AE = 0x3,
+			CC_E = 0x4,
+			CC_NE = 0x5,
+			CC_BE = 0x6,
+			CC_A = 0x7,
+			CC_P = 0xA,
+			CC_NP = 0xB,
+			CC_L = 0xC,
+			CC_GE = 0xD,
+			CC_LE = 0xE,
+			CC_G = 0xF,
+		};
+
+		struct Fixup
+		{
+			size_t pos; // of a 32-bit value
+			uint32_t target; // instruction index
+			size_t base; // what the value is relative to
+		};
+
+		using helper_t = bool(*)(WasmVm::NativeFrame&, uint32_t, uint32_t) noexcept;
+
+		const WasmScript& script;
+		const WasmScript::CompiledFunction& fn;
+		std::vector<uint32_t> heights{}; // -1 if the instruction is unreachable
+		std::vector<size_t> labels{};
+		std::vector<Fixup> fixups{};
+		std::vector<size_t> trap_fixups{};
+		std::vector<size_t> return_fixups{};
+
+		WasmJitBuilder(const WasmScript& script, const WasmScript::CompiledFunction& fn)
+			: script(script), fn(fn)
+		{
+		}
+
+		void u8(uint8_t b)
+		{
+			m_data.emplace_back(b);
+		}
+
+		void u32(uint32_t v)
+		{
+			for (uint8_t i = 0; i != 32; i += 8)
+			{
+				u8(static_cast<uint8_t>(v >> i));
+			}
+		}
+
+		void prefixAndOpcode(uint8_t prefix, bool w, uint16_t opcode, uint8_t reg, uint8_t rm)
+		{
+			if (prefix != 0)
+			{
+				u8(prefix);
+			}
+			const uint8_t rex = (w ? 0b1000 : 0) | ((reg & 8) ? 0b0100 : 0) | ((rm & 8) ? 0b0001 : 0);
+			if (rex != 0)
+			{
+				u8(0x40 | rex);
+			}
+			if (opcode > 0xFF)
+			{
+				u8(static_cast<uint8_t>(opcode >> 8));
+			}
+			u8(static_cast<uint8_t>(opcode));
+		}
+
+		// Register operand. 'reg' can also be an opcode extension.
+		void rr(uint8_t prefix, bool w, uint16_t opcode, uint8_t reg, x64Register rm)
+		{
+			prefixAndOpcode(prefix, w, opcode, reg, rm);
+			u8(0xC0 | ((reg & 7) << 3) | (rm & 7));
+		}
+
+		// Memory operand [base + disp].
+		void rm(uint8_t prefix, bool w, uint16_t opcode, uint8_t reg, x64Register base, int32_t disp)
+		{
+			prefixAndOpcode(prefix, w, opcode, reg, base);
+			const uint8_t mod = ((disp == 0 && (base & 7) != BP) ? 0 : (disp >= -0x80 && disp < 0x80) ? 1 : 2);
+			u8((mod << 6) | ((reg & 7) << 3) | (base & 7));
+			if ((base & 7) == SP)
+			{
+				u8(0x24); // SIB without index
+			}
+			if (mod == 1)
+			{
+				u8(static_cast<uint8_t>(disp));
+			}
+			else if (mod == 2)
+			{
+				u32(static_cast<uint32_t>(disp));
+			}
+		}
+
+		void loadSlot(x64Register reg, uint32_t height, bool w)
+		{
+			rm(0, w, 0x8B, reg, R12, height * 8);
+		}
+
+		void storeSlot(x64Register reg, uint32_t height)
+		{
+			rm(0, true, 0x89, reg, R12, height * 8);
+		}
+
+		void setcc(Condition cc, x64Register reg)
+		{
+			rr(0, false, 0x0F90 | cc, 0, reg);
+		}
+
+		[[nodiscard]] size_t jmp()
+		{
+			u8(0xE9);
+			u32(0);
+			return size() - 4;
+		}
+
+		[[nodiscard]] size_t jcc(Condition cc)
+		{
+			u8(0x0F);
+			u8(0x80 | cc);
+			u32(0);
+			return size() - 4;
+		}
+
+		void patch(size_t pos, size_t base, size_t target)
+		{
+			const auto rel = static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(base));
+			memcpy(&m_data[pos], &rel, sizeof(rel));
+		}
+
+		void bind(size_t fixup)
+		{
+			patch(fixup, fixup + 4, size());
+		}
+
+		[[nodiscard]] bool jumpTo(size_t fixup, uint32_t target, uint32_t height)
+		{
+			fixups.emplace_back(Fixup{ fixup, target, fixup + 4 });
+			return reach(target, height);
+		}
+
+		[[nodiscard]] bool reach(uint32_t target, uint32_t height)
+		{
+			if (target >= heights.size()
+				|| (heights[target] != -1 && heights[target] != height)
+				)
+			{
+				return false;
+			}
+			heights[target] = height;
+			return true;
+		}
+
+		void reload()
+		{
+			rm(0, true, 0x8B, RB, R13, offsetof(WasmVm::NativeFrame, local));
+			rm(0, true, 0x8B, R12, R13, offsetof(WasmVm::NativeFrame, operands));
+			rm(0, true, 0x8B, R14, R13, offsetof(WasmVm::NativeFrame, memory));
+			rm(0, true, 0x8B, R15, R13, offsetof(WasmVm::NativeFrame, memory_size));
+		}
+
+		void callHelper(helper_t helper, uint32_t height, uint32_t arg)
+		{
+#if SOUP_WINDOWS
+			rr(0, true, 0x89, R13, RC); // mov rcx, r13
+			u8(0xBA); u32(height); // mov edx, height
+			u8(0x41); u8(0xB8); u32(arg); // mov r8d, arg
+#else
+			rr(0, true, 0x89, R13, DI); // mov rdi, r13
+			u8(0xBE); u32(height); // mov esi, height
+			u8(0xBA); u32(arg); // mov edx, arg
+#endif
+			setA(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(helper)));
+			callA();
+			rr(0, false, 0x84, RA, RA); // test al, al
+			trap_fixups.emplace_back(jcc(CC_E));
+			reload();
+		}
+
+		// Leaves the effective address in rax, trapping if it's out of bounds.
+		[[nodiscard]] bool address(uint32_t height, int64_t offset, uint8_t size)
+		{
+			if (static_cast<uint64_t>(offset) > 0x7FFF'FFFF)
+			{
+				return false;
+			}
+			loadSlot(RA, height, false); // zero-extends the 32-bit address
+			if (offset != 0)
+			{
+				rr(0, true, 0x81, 0, RA); u32(static_cast<uint32_t>(offset)); // add rax, offset
+			}
+			rm(0, true, 0x8D, RC, RA, size); // lea rcx, [rax + size]
+			rr(0, true, 0x39, R15, RC); // cmp rcx, r15
+			trap_fixups.emplace_back(jcc(CC_AE));
+			rr(0, true, 0x01, R14, RA); // add rax, r14
+			return true;
+		}
+
+		[[nodiscard]] bool load(uint32_t h, const WasmScript::Instruction& insn, uint8_t size, bool w, uint16_t opcode)
+		{
+			SOUP_RETHROW_FALSE(address(h - 1, insn.b.i64, size));
+			rm(0, w, opcode, RA, RA, 0);
+			storeSlot(RA, h - 1);
+			return true;
+		}
+
+		[[nodiscard]] bool store(uint32_t& h, const WasmScript::Instruction& insn, uint8_t size, uint8_t prefix, bool w, uint16_t opcode)
+		{
+			h -= 2;
+			SOUP_RETHROW_FALSE(address(h, insn.b.i64, size));
+			loadSlot(RC, h + 1, true);
+			rm(prefix, w, opcode, RC, RA, 0);
+			return true;
+		}
+
+		void compare(uint32_t& h, bool w, Condition cc)
+		{
+			--h;
+			loadSlot(RA, h - 1, w);
+			rm(0, w, 0x3B, RA, R12, h * 8); // cmp
+			setcc(cc, RA);
+			rr(0, false, 0x0FB6, RA, RA); // movzx eax, al
+			storeSlot(RA, h - 1);
+		}
+
+		void eqz(uint32_t h, bool w)
+		{
+			loadSlot(RA, h - 1, w);
+			rr(0, w, 0x85, RA, RA); // test
+			setcc(CC_E, RA);
+			rr(0, false, 0x0FB6, RA, RA); // movzx eax, al
+			storeSlot(RA, h - 1);
+		}
+
+		// NaN compares unordered, which sets ZF, PF and CF, so only 'above' and 'above or equal' are false for it without an additional check.
+		void compareFloat(uint32_t& h, bool dbl, Condition cc, bool swap = false)
+		{
+			--h;
+			rm(dbl ? 0xF2 : 0xF3, false, 0x0F10, 0, R12, (swap ? h : h - 1) * 8); // movss/movsd xmm0
+			rm(dbl ? 0x66 : 0, false, 0x0F2E, 0, R12, (swap ? h - 1 : h) * 8); // ucomiss/ucomisd xmm0
+			setcc(cc, RA);
+			if (cc == CC_E)
+			{
+				setcc(CC_NP, RC);
+				rr(0, false, 0x20, RC, RA); // and al, cl
+			}
+			else if (cc == CC_NE)
+			{
+				setcc(CC_P, RC);
+				rr(0, false, 0x08, RC, RA); // or al, cl
+			}
+			rr(0, false, 0x0FB6, RA, RA); // movzx eax, al
+			storeSlot(RA, h - 1);
+		}
+
+		void arithmetic(uint32_t& h, bool w, uint16_t opcode)
+		{
+			--h;
+			loadSlot(RA, h - 1, w);
+			rm(0, w, opcode, RA, R12, h * 8);
+			storeSlot(RA, h - 1);
+		}
+
+		void arithmeticFloat(uint32_t& h, bool dbl, uint16_t opcode)
+		{
+			--h;
+			rm(dbl ? 0xF2 : 0xF3, false, 0x0F10, 0, R12, (h - 1) * 8); // movss/movsd xmm0, a
+			rm(dbl ? 0xF2 : 0xF3, false, opcode, 0, R12, h * 8);
+			rm(dbl ? 0xF2 : 0xF3, false, 0x0F11, 0, R12, (h - 1) * 8); // movss/movsd a, xmm0
+		}
+
+		void shift(uint32_t& h, bool w, uint8_t ext)
+		{
+			--h;
+			loadSlot(RC, h, false);
+			loadSlot(RA, h - 1, w);
+			rr(0, w, 0xD3, ext, RA); // shl/shr/sar by cl, which x86 already takes modulo the width
+			storeSlot(RA, h - 1);
+		}
+
+		void division(uint32_t& h, bool w, bool is_signed, bool rem)
+		{
+			--h;
+			loadSlot(RA, h - 1, w);
+			loadSlot(RC, h, w);
+			rr(0, w, 0x85, RC, RC); // test ecx, ecx
+			trap_fixups.emplace_back(jcc(CC_E));
+			if (is_signed)
+			{
+				rr(0, w, 0x83, 7, RC); u8(0xFF); // cmp ecx, -1
+				const auto not_minus_one = jcc(CC_NE);
+				size_t done = -1;
+				if (rem)
+				{
+					rr(0, false, 0x31, RD, RD); // xor edx, edx
+					done = jmp();
+				}
+				else
+				{
+					// The result of INT_MIN / -1 can't be represented.
+					if (w)
+					{
+						setD(0x8000'0000'0000'0000);
+						rr(0, true, 0x39, RD, RA); // cmp rax, rdx
+					}
+					else
+					{
+						rr(0, false, 0x81, 7, RA); u32(0x8000'0000); // cmp eax, INT32_MIN
+					}
+					trap_fixups.emplace_back(jcc(CC_E));
+				}
+				bind(not_minus_one);
+				if (w)
+				{
+					u8(0x48);
+				}
+				u8(0x99); // cdq/cqo
+				rr(0, w, 0xF7, 7, RC); // idiv
+				if (done != -1)
+				{
+					bind(done);
+				}
+			}
+			else
+			{
+				rr(0, false, 0x31, RD, RD); // xor edx, edx
+				rr(0, w, 0xF7, 6, RC); // div
+			}
+			storeSlot(rem ? RD : RA, h - 1);
+		}
+
+		[[nodiscard]] bool branch(const WasmScript::Instruction& insn, uint32_t h)
+		{
+			for (uint32_t k = 0; insn.a != 0 && k != insn.arity; ++k)
+			{
+				loadSlot(RA, h - insn.arity + k, true);
+				storeSlot(RA, h - insn.arity - insn.a + k);
+			}
+			return jumpTo(jmp(), static_cast<uint32_t>(insn.b.i32), h - insn.a);
+		}
+
+		[[nodiscard]] bool compile()
+		{
+			// Prologue: Save the callee-saved registers we use, which also aligns the stack for calls.
+			const uint8_t prologue[] = {
+				0x53, // push rbx
+				0x41, 0x54, // push r12
+				0x41, 0x55, // push r13
+				0x41, 0x56, // push r14
+				0x41, 0x57, // push r15
+#if SOUP_WINDOWS
+				0x48, 0x83, 0xEC, 0x20, // sub rsp, 20h (shadow space)
+				0x49, 0x89, 0xCD, // mov r13, rcx
+#else
+				0x49, 0x89, 0xFD, // mov r13, rdi
+#endif
+			};
+			addBytes(prologue);
+			reload();
+
+			const auto& code = fn.instructions;
+			heights.resize(code.size(), -1);
+			labels.resize(code.size());
+			uint32_t h = 0;
+			bool live = true;
+			for (uint32_t i = 0; i != code.size(); ++i)
+			{
+				labels[i] = size();
+				if (heights[i] != -1)
+				{
+					SOUP_IF_UNLIKELY (live && heights[i] != h)
+					{
+						return false;
+					}
+					h = heights[i];
+					live = true;
+				}
+				if (!live)
+				{
+					continue;
+				}
+				heights[i] = h;
+
+				const WasmScript::Instruction& insn = code[i];
+				switch (insn.op)
+				{
+				default:
+					return false;
+
+				case OP_UNREACHABLE:
+					trap_fixups.emplace_back(jmp());
+					live = false;
+					break;
+
+				case OP_BR:
+					SOUP_RETHROW_FALSE(branch(insn, h));
+					live = false;
+					break;
+
+				case OP_BR_IF:
+					--h;
+					loadSlot(RA, h, false);
+					rr(0, false, 0x85, RA, RA); // test eax, eax
+					if (insn.a == 0)
+					{
+						SOUP_RETHROW_FALSE(jumpTo(jcc(CC_NE), static_cast<uint32_t>(insn.b.i32), h));
+					}
+					else
+					{
+						const auto skip = jcc(CC_E);
+						SOUP_RETHROW_FALSE(branch(insn, h));
+						bind(skip);
+					}
+					break;
+
+				case OP_BR_TABLE:
+					{
+						// The branches follow, with the default one last.
+						--h;
+						SOUP_IF_UNLIKELY (code.size() - i - 1 <= insn.a)
+						{
+							return false;
+						}
+						loadSlot(RA, h, false);
+						rr(0, false, 0x81, 7, RA); u32(insn.a); // cmp eax, num_branches
+						u8(0xB9); u32(insn.a); // mov ecx, num_branches
+						rr(0, false, 0x0F47, RA, RC); // cmova eax, ecx
+						const uint8_t dispatch[] = {
+							0x48, 0x8D, 0x0D, 0x09, 0x00, 0x00, 0x00, // lea rcx, [rip + 9] (the table)
+							0x48, 0x63, 0x04, 0x81, // movsxd rax, dword ptr [rcx + rax * 4]
+							0x48, 0x01, 0xC8, // add rax, rcx
+							0xFF, 0xE0, // jmp rax
+						};
+						addBytes(dispatch);
+						const size_t table = size();
+						for (uint32_t k = 0; k != insn.a + 1; ++k)
+						{
+							fixups.emplace_back(Fixup{ size(), i + 1 + k, table });
+							u32(0);
+							SOUP_RETHROW_FALSE(reach(i + 1 + k, h));
+						}
+						live = false;
+					}
+					break;
+
+				case OP_IF:
+					--h;
+					loadSlot(RA, h, false);
+					rr(0, false, 0x85, RA, RA); // test eax, eax
+					SOUP_RETHROW_FALSE(jumpTo(jcc(CC_E), static_cast<uint32_t>(insn.b.i32), h));
+					break;
+
+				case OP_LOOP:
+					break;
+
+				case OP_RETURN:
+					rm(0, true, 0x8B, RC, R13, offsetof(WasmVm::NativeFrame, results));
+					for (uint32_t k = 0; k != insn.a; ++k)
+					{
+						loadSlot(RA, h - insn.a + k, true);
+						rm(0, true, 0x89, RA, RC, k * 8);
+					}
+					u8(0xB8); u32(1); // mov eax, 1
+					return_fixups.emplace_back(jmp());
+					live = false;
+					break;
+
+				case OP_CALL:
+					{
+						const auto& type = script.types[script.functions[insn.a]];
+						callHelper(&WasmVm::nativeCall<&WasmVm::callFunction>, h, insn.a);
+						h = h - type.num_parameters + type.num_results;
+					}
+					break;
+
+				case OP_CALL_IMPORT:
+					{
+						const auto& type = script.types[script.function_imports[insn.a].type_index];
+						callHelper(&WasmVm::nativeCall<&WasmVm::callImport>, h, insn.a);
+						h = h - type.num_parameters + type.num_results;
+					}
+					break;
+
+				case OP_CALL_INDIRECT:
+					{
+						const auto& type = script.types[insn.a];
+						callHelper(&WasmVm::nativeCall<&WasmVm::callIndirect>, h, insn.a);
+						h = h - 1 - type.num_parameters + type.num_results;
+					}
+					break;
+
+				case OP_DROP:
+					--h;
+					break;
+
+				case OP_SELECT:
+					h -= 2;
+					loadSlot(RA, h - 1, true);
+					loadSlot(RC, h, true);
+					loadSlot(RD, h + 1, false);
+					rr(0, false, 0x85, RD, RD); // test edx, edx
+					rr(0, true, 0x0F44, RA, RC); // cmovz rax, rcx
+					storeSlot(RA, h - 1);
+					break;
+
+				case OP_LOCAL_GET:
+					rm(0, true, 0x8B, RA, RB, insn.a * 8);
+					storeSlot(RA, h++);
+					break;
+
+				case OP_LOCAL_SET:
+					loadSlot(RA, --h, true);
+					rm(0, true, 0x89, RA, RB, insn.a * 8);
+					break;
+
+				case OP_LOCAL_TEE:
+					loadSlot(RA, h - 1, true);
+					rm(0, true, 0x89, RA, RB, insn.a * 8);
+					break;
+
+				case OP_GLOBAL_GET:
+					rm(0, true, 0x8B, RC, R13, offsetof(WasmVm::NativeFrame, globals));
+					rm(0, false, 0x8B, RA, RC, insn.a * 4);
+					storeSlot(RA, h++);
+					break;
+
+				case OP_GLOBAL_SET:
+					loadSlot(RA, --h, false);
+					rm(0, true, 0x8B, RC, R13, offsetof(WasmVm::NativeFrame, globals));
+					rm(0, false, 0x89, RA, RC, insn.a * 4);
+					break;
+
+				case OP_MEMORY_SIZE:
+					rr(0, true, 0x89, R15, RA); // mov rax, r15
+					rr(0, true, 0xC1, 5, RA); u8(16); // shr rax, 16
+					storeSlot(RA, h++);
+					break;
+
+				case OP_MEMORY_GROW:
+					callHelper(&WasmVm::nativeMemoryGrow, h, 0);
+					break;
+
+				case OP_CONST:
+					if (insn.b.i64 == static_cast<int32_t>(insn.b.i64))
+					{
+						rm(0, true, 0xC7, 0, R12, h * 8); u32(static_cast<uint32_t>(insn.b.i64)); // mov qword ptr, imm32
+					}
+					else
+					{
+						setA(static_cast<uint64_t>(insn.b.i64));
+						storeSlot(RA, h);
+					}
+					++h;
+					break;
+
+				case OP_I32_LOAD: SOUP_RETHROW_FALSE(load(h, insn, 4, false, 0x8B)); break;
+				case OP_I64_LOAD: SOUP_RETHROW_FALSE(load(h, insn, 8, true, 0x8B)); break;
+				case OP_F32_LOAD: SOUP_RETHROW_FALSE(load(h, insn, 4, false, 0x8B)); break;
+				case OP_F64_LOAD: SOUP_RETHROW_FALSE(load(h, insn, 8, true, 0x8B)); break;
+				case OP_I32_LOAD8_S: SOUP_RETHROW_FALSE(load(h, insn, 1, false, 0x0FBE)); break; // movsx
+				case OP_I32_LOAD8_U: SOUP_RETHROW_FALSE(load(h, insn, 1, false, 0x0FB6)); break; // movzx
+				case OP_I32_LOAD16_S: SOUP_RETHROW_FALSE(load(h, insn, 2, false, 0x0FBF)); break;
+				case OP_I32_LOAD16_U: SOUP_RETHROW_FALSE(load(h, insn, 2, false, 0x0FB7)); break;
+				case OP_I64_LOAD8_S: SOUP_RETHROW_FALSE(load(h, insn, 1, true, 0x0FBE)); break;
+				case OP_I64_LOAD8_U: SOUP_RETHROW_FALSE(load(h, insn, 1, false, 0x0FB6)); break;
+				case OP_I64_LOAD16_S: SOUP_RETHROW_FALSE(load(h, insn, 2, true, 0x0FBF)); break;
+				case OP_I64_LOAD16_U: SOUP_RETHROW_FALSE(load(h, insn, 2, false, 0x0FB7)); break;
+				case OP_I64_LOAD32_S: SOUP_RETHROW_FALSE(load(h, insn, 4, true, 0x63)); break; // movsxd
+				case OP_I64_LOAD32_U: SOUP_RETHROW_FALSE(load(h, insn, 4, false, 0x8B)); break;
+
+				case OP_I32_STORE: SOUP_RETHROW_FALSE(store(h, insn, 4, 0, false, 0x89)); break;
+				case OP_I64_STORE: SOUP_RETHROW_FALSE(store(h, insn, 8, 0, true, 0x89)); break;
+				case OP_F32_STORE: SOUP_RETHROW_FALSE(store(h, insn, 4, 0, false, 0x89)); break;
+				case OP_F64_STORE: SOUP_RETHROW_FALSE(store(h, insn, 8, 0, true, 0x89)); break;
+				case OP_I32_STORE8: SOUP_RETHROW_FALSE(store(h, insn, 1, 0, false, 0x88)); break;
+				case OP_I32_STORE16: SOUP_RETHROW_FALSE(store(h, insn, 2, 0x66, false, 0x89)); break;
+
+				case OP_I32_EQZ: eqz(h, false); break;
+				case OP_I32_EQ: compare(h, false, CC_E); break;
+				case OP_I32_NE: compare(h, false, CC_NE); break;
+				case OP_I32_LT_S: compare(h, false, CC_L); break;
+				case OP_I32_LT_U: compare(h, false, CC_B); break;
+				case OP_I32_GT_S: compare(h, false, CC_G); break;
+				case OP_I32_GT_U: compare(h, false, CC_A); break;
+				case OP_I32_LE_S: compare(h, false, CC_LE); break;
+				case OP_I32_LE_U: compare(h, false, CC_BE); break;
+				case OP_I32_GE_S: compare(h, false, CC_GE); break;
+				case OP_I32_GE_U: compare(h, false, CC_AE); break;
+				case OP_I64_EQZ: eqz(h, true); break;
+				case OP_I64_EQ: compare(h, true, CC_E); break;
+				case OP_I64_NE: compare(h, true, CC_NE); break;
+				case OP_I64_LT_S: compare(h, true, CC_L); break;
+				case OP_I64_LT_U: compare(h, true, CC_B); break;
+				case OP_I64_GT_S: compare(h, true, CC_G); break;
+				case OP_I64_GT_U: compare(h, true, CC_A); break;
+				case OP_I64_LE_S: compare(h, true, CC_LE); break;
+				case OP_I64_LE_U: compare(h, true, CC_BE); break;
+				case OP_I64_GE_S: compare(h, true, CC_GE); break;
+				case OP_I64_GE_U: compare(h, true, CC_AE); break;
+				case OP_F32_EQ: compareFloat(h, false, CC_E); break;
+				case OP_F32_NE: compareFloat(h, false, CC_NE); break;
+				case OP_F32_LT: compareFloat(h, false, CC_A, true); break;
+				case OP_F32_GT: compareFloat(h, false, CC_A); break;
+				case OP_F32_LE: compareFloat(h, false, CC_AE, true); break;
+				case OP_F32_GE: compareFloat(h, false, CC_AE); break;
+				case OP_F64_EQ: compareFloat(h, true, CC_E); break;
+				case OP_F64_NE: compareFloat(h, true, CC_NE); break;
+				case OP_F64_LT: compareFloat(h, true, CC_A, true); break;
+				case OP_F64_GT: compareFloat(h, true, CC_A); break;
+				case OP_F64_LE: compareFloat(h, true, CC_AE, true); break;
+				case OP_F64_GE: compareFloat(h, true, CC_AE); break;
+
+				case OP_I32_POPCNT:
+					SOUP_IF_UNLIKELY (!CpuInfo::get().supportsPOPCNT())
+					{
+						return false;
+					}
+					rm(0xF3, false, 0x0FB8, RA, R12, (h - 1) * 8); // popcnt eax
+					storeSlot(RA, h - 1);
+					break;
+
+				case OP_I32_ADD: arithmetic(h, false, 0x03); break;
+				case OP_I32_SUB: arithmetic(h, false, 0x2B); break;
+				case OP_I32_MUL: arithmetic(h, false, 0x0FAF); break;
+				case OP_I32_DIV_S: division(h, false, true, false); break;
+				case OP_I32_DIV_U: division(h, false, false, false); break;
+				case OP_I32_REM_S: division(h, false, true, true); break;
+				case OP_I32_REM_U: division(h, false, false, true); break;
+				case OP_I32_AND: arithmetic(h, false, 0x23); break;
+				case OP_I32_OR: arithmetic(h, false, 0x0B); break;
+				case OP_I32_XOR: arithmetic(h, false, 0x33); break;
+				case OP_I32_SHL: shift(h, false, 4); break;
+				case OP_I32_SHR_S: shift(h, false, 7); break;
+				case OP_I32_SHR_U: shift(h, false, 5); break;
+				case OP_I64_ADD: arithmetic(h, true, 0x03); break;
+				case OP_I64_SUB: arithmetic(h, true, 0x2B); break;
+				case OP_I64_MUL: arithmetic(h, true, 0x0FAF); break;
+				case OP_I64_DIV_S: division(h, true, true, false); break;
+				case OP_I64_DIV_U: division(h, true, false, false); break;
+				case OP_I64_REM_S: division(h, true, true, true); break;
+				case OP_I64_REM_U: division(h, true, false, true); break;
+				case OP_I64_AND: arithmetic(h, true, 0x23); break;
+				case OP_I64_OR: arithmetic(h, true, 0x0B); break;
+				case OP_I64_XOR: arithmetic(h, true, 0x33); break;
+				case OP_I64_SHL: shift(h, true, 4); break;
+				case OP_I64_SHR_S: shift(h, true, 7); break;
+				case OP_I64_SHR_U: shift(h, true, 5); break;
+				case OP_F32_ADD: arithmeticFloat(h, false, 0x0F58); break;
+				case OP_F32_SUB: arithmeticFloat(h, false, 0x0F5C); break;
+				case OP_F32_MUL: arithmeticFloat(h, false, 0x0F59); break;
+				case OP_F32_DIV: arithmeticFloat(h, false, 0x0F5E); break;
+				case OP_F64_ADD: arithmeticFloat(h, true, 0x0F58); break;
+				case OP_F64_SUB: arithmeticFloat(h, true, 0x0F5C); break;
+				case OP_F64_MUL: arithmeticFloat(h, true, 0x0F59); break;
+				case OP_F64_DIV: arithmeticFloat(h, true, 0x0F5E); break;
+
+				case OP_I32_WRAP_I64:
+					break; // the lower half of an i64 already is the i32
+
+				case OP_I64_EXTEND_I32_S:
+					rm(0, true, 0x63, RA, R12, (h - 1) * 8); // movsxd rax
+					storeSlot(RA, h - 1);
+					break;
+
+				case OP_I64_EXTEND_I32_U:
+					loadSlot(RA, h - 1, false);
+					storeSlot(RA, h - 1);
+					break;
+				}
+			}
+
+			// Translated functions end with a return, so we only get here via a jump.
+			for (const auto& fixup : trap_fixups)
+			{
+				bind(fixup);
+			}
+			rr(0, false, 0x31, RA, RA); // xor eax, eax
+			for (const auto& fixup : return_fixups)
+			{
+				bind(fixup);
+			}
+			const uint8_t epilogue[] = {
+#if SOUP_WINDOWS
+				0x48, 0x83, 0xC4, 0x20, // add rsp, 20h
+#endif
+				0x41, 0x5F, // pop r15
+				0x41, 0x5E, // pop r14
+				0x41, 0x5D, // pop r13
+				0x41, 0x5C, // pop r12
+				0x5B, // pop rbx
+			};
+			addBytes(epilogue);
+			retn();
+
+			for (const auto& fixup : fixups)
+			{
+				patch(fixup.pos, fixup.base, labels[fixup.target]);
+			}
+			return true;
+		}
+	};
+#endif
+
+	bool WasmScript::compileNative(CompiledFunction& fn) SOUP_EXCAL
+	{
+		std::lock_guard lock(jit_mtx);
+#if SOUP_X86 && SOUP_BITS == 64
+		if (fn.native.load(std::memory_order_relaxed) == nullptr
+			&& !fn.native_unsupported.load(std::memory_order_relaxed)
+			&& !fn.instructions.empty()
+			&& !memory64
+			)
+		{
+			WasmJitBuilder b(*this, fn);
+			if (b.compile())
+			{
+				auto alloc = b.allocate();
+				memGuard::setAllowedAccess(alloc->addr, alloc->size, memGuard::ACC_READ | memGuard::ACC_EXEC);
+				fn.native.store(alloc.release(), std::memory_order_release);
+			}
+		}
+#endif
+		const bool res = (fn.native.load(std::memory_order_relaxed) != nullptr);
+		fn.native_unsupported.store(!res, std::memory_order_relaxed);
+		return res;
+	}
 }
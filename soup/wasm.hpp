@@ -4,9 +4,12 @@
 #include "fwd.hpp"
 #include "type_traits.hpp"
 
+#include <atomic>
+#include <mutex>
 #include <stack>
 #include <string>
 #include <unordered_map>
+#include <utility> // forward
 #include <vector>
 
 NAMESPACE_SOUP
@@ -34,6 +37,60 @@ NAMESPACE_SOUP
 		WasmValue(T ptr) : i32(static_cast<int32_t>(ptr)) {}
 	};
 
+	// Like std::stack<WasmValue>, but the values are contiguous, so the interpreter can operate on them directly.
+	class WasmValueStack
+	{
+	public:
+		std::vector<WasmValue> values{}; // only the first 'count' values are on the stack, the rest is preallocated
+		size_t count = 0;
+
+		[[nodiscard]] bool empty() const noexcept
+		{
+			return count == 0;
+		}
+
+		[[nodiscard]] size_t size() const noexcept
+		{
+			return count;
+		}
+
+		[[nodiscard]] WasmValue& top() noexcept
+		{
+			return values[count - 1];
+		}
+
+		[[nodiscard]] const WasmValue& top() const noexcept
+		{
+			return values[count - 1];
+		}
+
+		void pop() noexcept
+		{
+			--count;
+		}
+
+		void push(WasmValue value) SOUP_EXCAL
+		{
+			reserve(1);
+			values[count++] = value;
+		}
+
+		template <typename T>
+		void emplace(T&& arg) SOUP_EXCAL
+		{
+			push(WasmValue(std::forward<T>(arg)));
+		}
+
+		// Ensures that 'n' more values can be pushed without reallocating.
+		void reserve(size_t n) SOUP_EXCAL
+		{
+			if (count + n > values.size())
+			{
+				values.resize(count + n > values.size() * 2 ? count + n : values.size() * 2);
+			}
+		}
+	};
+
 	struct WasmScript
 	{
 		struct FunctionType
@@ -47,6 +104,35 @@ NAMESPACE_SOUP
 			std::string module_name;
 			std::string function_name;
 			wasm_ffi_func_t ptr;
+			uint32_t type_index;
+		};
+
+		// A function body translated at load time, so it can be executed without decoding anything.
+		struct Instruction
+		{
+			uint16_t op;
+			uint16_t arity; // number of values a branch carries
+			uint32_t a; // branch: number of values to drop, otherwise index
+			WasmValue b; // branch: target, otherwise constant or memory offset
+		};
+
+		struct CompiledFunction
+		{
+			std::vector<Instruction> instructions{}; // empty if the function can only be interpreted from bytecode
+			uint32_t type_index = 0;
+			uint32_t num_locals = 0; // not including the parameters
+			uint32_t max_stack = 0;
+
+			// VMs on different threads may run the same script, so the JIT state is atomic.
+			std::atomic_uint32_t hotness = 0; // calls and loop iterations in the interpreter
+			std::atomic_bool native_unsupported = false;
+			std::atomic<AllocRaiiVirtual*> native = nullptr; // only set by compileNative
+
+			void heatUp() noexcept
+			{
+				// Not a read-modify-write, so concurrent VMs may lose some counts, which is fine for a heuristic.
+				hotness.store(hotness.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
 		};
 
 		uint8_t* memory = nullptr;
@@ -58,8 +144,11 @@ NAMESPACE_SOUP
 		std::vector<int32_t> globals{};
 		std::unordered_map<std::string, uint32_t> export_map{};
 		std::vector<std::string> code{};
+		std::vector<CompiledFunction> compiled{}; // same indices as 'code'
 		std::vector<uint32_t> elements{};
 		bool memory64 = false;
+		uint32_t jit_threshold = 1000; // how hot a translated function has to get before it is compiled to native code, -1 to never do so
+		std::mutex jit_mtx;
 
 		~WasmScript() noexcept;
 
@@ -68,6 +157,7 @@ NAMESPACE_SOUP
 
 		[[nodiscard]] FunctionImport* getImportedFunction(const std::string& module_name, const std::string& function_name) noexcept;
 		[[nodiscard]] const std::string* getExportedFuntion(const std::string& name) const noexcept;
+		[[nodiscard]] size_t getExportedFunctionIndex(const std::string& name) const noexcept; // index into 'code', or -1 if there is no such export
 
 		[[nodiscard]] size_t allocateMemory(size_t len) noexcept;
 
@@ -94,15 +184,26 @@ NAMESPACE_SOUP
 		bool setMemory(size_t ptr, const void* src, size_t len) noexcept;
 		bool setMemory(WasmValue ptr, const void* src, size_t len) noexcept;
 
+		// Implements memory.grow: Returns the previous size in pages, or -1 on failure.
+		[[nodiscard]] WasmValue growMemory(WasmValue delta) noexcept;
+
+		// Compiles a translated function to native code, which only x86-64 is supported for. Usually, this happens automatically once the function is hot.
+		// Safe to call while other VMs are running the script.
+		bool compileNative(CompiledFunction& fn) SOUP_EXCAL;
+
 		void linkWasiPreview1() noexcept;
 
 		[[nodiscard]] size_t readUPTR(Reader& r) const noexcept;
+
+	protected:
+		[[nodiscard]] bool translate(CompiledFunction& fn, const std::string& body) const SOUP_EXCAL;
+		[[nodiscard]] bool skipImmediates(Reader& r, uint8_t op) const noexcept;
 	};
 
 	class WasmVm
 	{
 	public:
-		std::stack<WasmValue> stack;
+		WasmValueStack stack;
 		std::vector<WasmValue> locals;
 		WasmScript& script;
 
@@ -111,6 +212,7 @@ NAMESPACE_SOUP
 		{
 		}
 
+		bool run(size_t func_index) SOUP_EXCAL; // index into script.code, runs the translated function if possible
 		bool run(const std::string& data) SOUP_EXCAL;
 		bool run(Reader& r) SOUP_EXCAL;
 
@@ -125,5 +227,25 @@ NAMESPACE_SOUP
 		[[nodiscard]] bool doBranch(Reader& r, uint32_t depth, std::stack<CtrlFlowEntry>& ctrlflow) SOUP_EXCAL;
 		[[nodiscard]] bool doCall(uint32_t type_index, uint32_t function_index) SOUP_EXCAL;
 		void pushIPTR(size_t ptr) SOUP_EXCAL;
+
+		// Executes a translated function. 'frame' is where its locals are on the stack, or -1 if they are in 'locals'.
+		// The results replace everything on the stack from 'base'.
+		[[nodiscard]] bool execute(WasmScript::CompiledFunction& fn, size_t frame, size_t base) SOUP_EXCAL;
+		[[nodiscard]] bool callFunction(uint32_t function_index) SOUP_EXCAL;
+		[[nodiscard]] bool callImport(uint32_t import_index) SOUP_EXCAL;
+		[[nodiscard]] bool callIndirect(uint32_t type_index) SOUP_EXCAL; // pops the element index
+
+#if SOUP_X86 && SOUP_BITS == 64
+		struct NativeFrame;
+
+		[[nodiscard]] bool executeNative(const WasmScript::CompiledFunction& fn, size_t frame, size_t base) SOUP_EXCAL;
+
+		// Called from native code with the height of the operand stack, so the VM can be brought up-to-date first.
+		template <bool(WasmVm::*f)(uint32_t)>
+		[[nodiscard]] static bool nativeCall(NativeFrame& frame, uint32_t height, uint32_t arg) noexcept;
+		[[nodiscard]] static bool nativeMemoryGrow(NativeFrame& frame, uint32_t height, uint32_t) noexcept;
+
+		friend struct WasmJitBuilder;
+#endif
 	};
 }